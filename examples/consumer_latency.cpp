@@ -0,0 +1,156 @@
+// consumer_latency.cpp
+//
+// Paho C++ sample application to measure the latency of the consumer
+// queue, without a broker.
+//
+// A producer thread, standing in for the C library's callback thread,
+// puts timestamped events into a thread_queue, with a gap between them,
+// like a trickle of incoming messages. A consumer thread takes them out
+// and records how long each one took to get across. This is done for
+// each way of consuming:
+//
+//  - block  The consumer blocks in get(), as consume_event() does by
+//           default. The producer has to wake it for each event.
+//  - spin   The consumer spins in get_spin() before blocking, as
+//           consume_event() does after async_client::set_consumer_spin().
+//           While it spins, the producer doesn't have to wake it.
+//
+// For each one, it reports the latency percentiles and the producer's
+// cost to put an event into the queue.
+//
+// The results are written to stdout as JSON.
+//
+// USAGE:
+//     consumer_latency [events] [gap us] [spin us]
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mqtt/thread_queue.h"
+
+using namespace std;
+using namespace std::chrono;
+
+const int DFLT_N_EVENTS = 20000;
+const int DFLT_GAP_US = 50;
+const int DFLT_SPIN_US = 100;
+
+// The latencies for one way of consuming
+struct result
+{
+    string name;
+    vector<int64_t> latency;  // ns
+    int64_t putTime{0};       // ns, total
+};
+
+// Runs the producer and consumer, with the consumer taking events out of
+// the queue with the get function.
+template <typename Get>
+static result run(const string& name, int nEvents, microseconds gap, Get get)
+{
+    result res{name, vector<int64_t>(nEvents), 0};
+    mqtt::thread_queue<steady_clock::time_point> que;
+
+    thread consumer([&] {
+        steady_clock::time_point t;
+        for (int i = 0; i < nEvents; ++i) {
+            get(que, &t);
+            res.latency[i] = (steady_clock::now() - t).count();
+        }
+    });
+
+    // Busy-wait between events so the gaps are accurate
+    auto next = steady_clock::now();
+    for (int i = 0; i < nEvents; ++i) {
+        next += gap;
+        while (steady_clock::now() < next);
+
+        auto t = steady_clock::now();
+        que.put(t);
+        res.putTime += (steady_clock::now() - t).count();
+    }
+
+    consumer.join();
+    return res;
+}
+
+static int64_t percentile(const vector<int64_t>& v, double pct)
+{
+    return v[min(v.size() - 1, size_t(pct / 100.0 * v.size()))];
+}
+
+static void print_json(vector<result>& results, microseconds gap, microseconds spin)
+{
+    cout << "{\n"
+         << "  \"gap_us\": " << gap.count() << ",\n"
+         << "  \"spin_us\": " << spin.count() << ",\n"
+         << "  \"benchmarks\": [\n";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto& r = results[i];
+        auto& v = r.latency;
+        sort(v.begin(), v.end());
+
+        cout << "    {\n"
+             << "      \"name\": \"" << r.name << "\",\n"
+             << "      \"events\": " << v.size() << ",\n"
+             << "      \"latency_p50_ns\": " << percentile(v, 50) << ",\n"
+             << "      \"latency_p99_ns\": " << percentile(v, 99) << ",\n"
+             << "      \"latency_p999_ns\": " << percentile(v, 99.9) << ",\n"
+             << "      \"latency_max_ns\": " << v.back() << ",\n"
+             << "      \"put_ns\": " << r.putTime / int64_t(v.size()) << "\n"
+             << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    cout << "  ]\n}" << endl;
+}
+
+// --------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    int nEvents = (argc > 1) ? atoi(argv[1]) : DFLT_N_EVENTS;
+    auto gap = microseconds((argc > 2) ? atoi(argv[2]) : DFLT_GAP_US);
+    auto spin = microseconds((argc > 3) ? atoi(argv[3]) : DFLT_SPIN_US);
+
+    if (nEvents <= 0 || gap.count() < 0 || spin.count() <= 0) {
+        cerr << "USAGE: consumer_latency [events] [gap us] [spin us]" << endl;
+        return 1;
+    }
+
+    using queue_type = mqtt::thread_queue<steady_clock::time_point>;
+    vector<result> results;
+
+    results.push_back(run("block", nEvents, gap, [](queue_type& que, auto* t) {
+        que.get(t);
+    }));
+
+    results.push_back(run("spin", nEvents, gap, [spin](queue_type& que, auto* t) {
+        que.get_spin(t, spin);
+    }));
+
+    print_json(results, gap, spin);
+    return 0;
+}
@@ -0,0 +1,203 @@
+// encoded_file_persistence.h
+//
+// Example of user-based file persistence with a simple XOR encoding scheme,
+// shared by the sample applications.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2013-2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __encoded_file_persistence_h
+#define __encoded_file_persistence_h
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "mqtt/exception.h"
+#include "mqtt/iclient_persistence.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Example of user-based file persistence with a simple XOR encoding scheme.
+//
+// Similar to the built-in file persistence, this just creates a
+// subdirectory for the persistence data, then places each key into a
+// separate file using the key as the file name.
+//
+// With user-defined persistence, you can transform the data in any way you
+// like, such as with encryption/decryption, and you can store the data any
+// place you want, such as here with disk files, or use a local DB like
+// SQLite or a local key/value store like Redis.
+class encoded_file_persistence : virtual public mqtt::iclient_persistence
+{
+    // The top-level directory for the persistence data.
+    std::filesystem::path topDir_;
+
+    // The directory for the persistence store.
+    std::filesystem::path dir_;
+
+    // A key for encoding the data, as supplied by the user
+    std::string encodeKey_;
+
+    // Simple, in-place XOR encoding and decoding
+    void encode(std::string& s) const
+    {
+        size_t n = encodeKey_.size();
+        if (n == 0 || s.empty())
+            return;
+
+        for (size_t i = 0; i < s.size(); ++i) s[i] ^= encodeKey_[i % n];
+    }
+
+    // Gets the persistence file name for the supplied key.
+    std::filesystem::path path_name(const std::string& key) const { return dir_ / key; }
+
+public:
+    // Create the persistence object with the specified encoding key, to
+    // keep the data under the top-level directory.
+    encoded_file_persistence(
+        const std::string& encodeKey, const std::filesystem::path& topDir = "persist"
+    )
+        : topDir_(topDir), encodeKey_(encodeKey)
+    {
+    }
+
+    // "Open" the persistence store.
+    // Create a directory for persistence files, using the client ID and
+    // serverURI to make a unique directory name. Note that neither can be
+    // empty. In particular, the app can't use an empty `clientID` if it
+    // wants to use persistence. (This isn't an absolute rule for your own
+    // persistence, but you do need a way to keep data from different apps
+    // separate).
+    void open(const std::string& clientId, const std::string& serverURI) override
+    {
+        if (clientId.empty() || serverURI.empty())
+            throw mqtt::persistence_exception();
+
+        // Create a name for the persistence subdirectory for this client
+        std::string name = serverURI + "-" + clientId;
+        std::replace(name.begin(), name.end(), ':', '-');
+
+        dir_ = topDir_ / name;
+        std::filesystem::create_directories(dir_);
+    }
+
+    // Close the persistent store that was previously opened.
+    // Remove the persistence directory, if it's empty. If data is still
+    // persisted, it's left in place for the next time the store is opened.
+    void close() override
+    {
+        std::error_code ec;
+        std::filesystem::remove(dir_, ec);
+        std::filesystem::remove(dir_.parent_path(), ec);
+    }
+
+    // Clears persistence, so that it no longer contains any persisted data.
+    // Just remove all the files from the persistence directory.
+    void clear() override
+    {
+        // We could iterate through and remove each file,
+        // but this does the same thing in fewer steps.
+        if (!std::filesystem::is_empty(dir_)) {
+            std::filesystem::remove_all(dir_);
+            std::filesystem::create_directories(dir_);
+        }
+    }
+
+    // Returns whether or not data is persisted using the specified key.
+    // We just look for a file in the store directory with the same name as
+    // the key.
+    bool contains_key(const std::string& key) override
+    {
+        return std::filesystem::exists(path_name(key));
+    }
+
+    // Returns the keys in this persistent data store.
+    // We just make a collection of the file names in the store directory.
+    mqtt::string_collection keys() const override
+    {
+        mqtt::string_collection ks;
+
+        if (std::filesystem::exists(dir_)) {
+            for (const auto& entry : std::filesystem::directory_iterator(dir_)) {
+                ks.push_back(entry.path().filename().string());
+            }
+        }
+        return ks;
+    }
+
+    // Puts the specified data into the persistent store.
+    // We just encode the data and write it to a file using the key as the
+    // name of the file. The multiple buffers given here need to be written
+    // in order - and a scatter/gather like writev() would be fine. But...
+    // the data will be read back as a single buffer, so here we first
+    // concat a string so that the encoding key lines up with the data the
+    // same way it will on the read-back.
+    void put(const std::string& key, const std::vector<mqtt::string_view>& bufs) override
+    {
+        auto path = path_name(key);
+
+        std::ofstream os(path, std::ios_base::binary);
+        if (!os)
+            throw mqtt::persistence_exception();
+
+        std::string s;
+        for (const auto& b : bufs) s.append(b.data(), b.size());
+
+        encode(s);
+        os.write(s.data(), s.size());
+    }
+
+    // Gets the specified data out of the persistent store.
+    // We look for a file with the name of the key, read the contents,
+    // decode, and return it.
+    std::string get(const std::string& key) const override
+    {
+        auto path = path_name(key);
+
+        std::ifstream is(path, std::ios_base::ate | std::ios_base::binary);
+        if (!is)
+            throw mqtt::persistence_exception();
+
+        // Read the whole file into a string
+        std::streamsize sz = is.tellg();
+        if (sz == 0)
+            return std::string();
+
+        is.seekg(0);
+        std::string s(sz, '\0');
+        is.read(&s[0], sz);
+        if (is.gcount() < sz)
+            s.resize(is.gcount());
+
+        encode(s);
+        return s;
+    }
+
+    // Remove the data for the specified key.
+    // Just remove the file with the same name as the key, if found.
+    void remove(const std::string& key) override
+    {
+        auto path = path_name(key);
+        std::filesystem::remove(path);
+    }
+};
+
+#endif  // __encoded_file_persistence_h
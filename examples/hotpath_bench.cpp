@@ -0,0 +1,365 @@
+// hotpath_bench.cpp
+//
+// Paho C++ sample application to profile the cost of the library's hot
+// paths, without a broker.
+//
+// Wall-clock rates, like those from pub_speed_test, show how fast things
+// are, but not why. This runs each hot path in a tight loop and reports
+// what each operation costs:
+//
+//  - publish  Building an outgoing message, as async_client::publish() does
+//  - publish_static  The same, with a static topic string
+//  - topic_concat    Building a per-device topic by string concatenation
+//  - topic_template  Building the same topic with a topic_template
+//  - arrival  Building a message from the C library's incoming message
+//  - queue    Passing a message through a thread_queue
+//  - match    Finding the subscriptions that match a topic
+//
+// For each one, it reports the time, and the heap allocations and bytes
+// allocated, per operation. The allocations are counted by replacing the
+// global operator new for this program.
+//
+// On Linux, it also reads the CPU's hardware counters for each run, using
+// perf_event_open(), and reports the cycles, instructions, cache misses,
+// and branch misses per operation. These need access to the performance
+// counters, which may be limited by /proc/sys/kernel/perf_event_paranoid.
+// If they aren't available, they're reported as null.
+//
+// The results are written to stdout as JSON.
+//
+// USAGE:
+//     hotpath_bench [iterations] [payload size] [filters]
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "mqtt/message.h"
+#include "mqtt/thread_queue.h"
+#include "mqtt/topic_matcher.h"
+#include "mqtt/topic_template.h"
+
+using namespace std;
+using namespace std::chrono;
+
+const int DFLT_N_ITER = 200000;
+const size_t DFLT_PAYLOAD_SIZE = 256;
+const int DFLT_N_FILTERS = 1000;
+
+static const string TOPIC{"site/17/dev/temp"};
+
+/////////////////////////////////////////////////////////////////////////////
+// Allocation accounting
+
+static std::atomic<uint64_t> nAllocs{0}, nAllocBytes{0};
+
+void* operator new(size_t n)
+{
+    nAllocs.fetch_add(1, std::memory_order_relaxed);
+    nAllocBytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t n) { return ::operator new(n); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+/////////////////////////////////////////////////////////////////////////////
+// Hardware counters
+
+// A group of hardware counters for the calling thread, read together.
+// If the counters can't be opened, valid() is false and the values are
+// all zero.
+class hw_counters
+{
+public:
+    enum { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, N_COUNTERS };
+
+private:
+    int fds_[N_COUNTERS] = {-1, -1, -1, -1};
+
+public:
+    hw_counters() {
+#if defined(__linux__)
+        const uint64_t configs[N_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        for (int i = 0; i < N_COUNTERS; ++i) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = (i == 0) ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+
+            int fd = int(::syscall(__NR_perf_event_open, &attr, 0, -1, fds_[0], 0));
+            if (fd < 0) {
+                close_all();
+                return;
+            }
+            fds_[i] = fd;
+        }
+#endif
+    }
+    ~hw_counters() { close_all(); }
+
+    bool valid() const { return fds_[0] >= 0; }
+
+    void close_all() {
+#if defined(__linux__)
+        for (auto& fd : fds_) {
+            if (fd >= 0)
+                ::close(fd);
+            fd = -1;
+        }
+#endif
+    }
+
+    void start() {
+#if defined(__linux__)
+        if (valid()) {
+            ::ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    void stop(uint64_t vals[N_COUNTERS]) {
+        std::fill(vals, vals + N_COUNTERS, 0);
+#if defined(__linux__)
+        if (valid()) {
+            ::ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+            // The group read gives the count, then the values
+            uint64_t buf[N_COUNTERS + 1];
+            if (::read(fds_[0], buf, sizeof(buf)) == ssize_t(sizeof(buf))) {
+                for (int i = 0; i < N_COUNTERS; ++i) vals[i] = buf[i + 1];
+            }
+        }
+#endif
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+// The cost of one hot path
+struct result
+{
+    string name;
+    int nOps{0};
+    nanoseconds time{0};
+    uint64_t allocs{0};
+    uint64_t allocBytes{0};
+    bool hasCounters{false};
+    uint64_t counters[hw_counters::N_COUNTERS]{};
+};
+
+// Runs a hot path for a number of iterations, after a warmup, and
+// collects its costs.
+static result run(const string& name, int nOps, hw_counters& hw, const function<void()>& op)
+{
+    for (int i = 0; i < nOps / 10; ++i) op();
+
+    result res;
+    res.name = name;
+    res.nOps = nOps;
+
+    auto allocs = nAllocs.load(), allocBytes = nAllocBytes.load();
+    auto start = steady_clock::now();
+    hw.start();
+
+    for (int i = 0; i < nOps; ++i) op();
+
+    hw.stop(res.counters);
+    res.time = steady_clock::now() - start;
+    res.allocs = nAllocs.load() - allocs;
+    res.allocBytes = nAllocBytes.load() - allocBytes;
+    res.hasCounters = hw.valid();
+    return res;
+}
+
+static string per_op(uint64_t n, int nOps, bool valid = true)
+{
+    if (!valid)
+        return "null";
+    ostringstream os;
+    os << fixed << setprecision(2) << double(n) / nOps;
+    return os.str();
+}
+
+static void print_json(const vector<result>& results, size_t payloadSize, int nFilters)
+{
+    bool hasCounters = !results.empty() && results.front().hasCounters;
+
+    cout << "{\n"
+         << "  \"payload_size\": " << payloadSize << ",\n"
+         << "  \"filters\": " << nFilters << ",\n"
+         << "  \"hw_counters\": " << (hasCounters ? "true" : "false") << ",\n"
+         << "  \"benchmarks\": [\n";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        bool hw = r.hasCounters;
+        double secs = duration<double>(r.time).count();
+
+        cout << "    {\n"
+             << "      \"name\": \"" << r.name << "\",\n"
+             << "      \"ops\": " << r.nOps << ",\n"
+             << "      \"ops_per_sec\": " << uint64_t(r.nOps / secs) << ",\n"
+             << "      \"ns_per_op\": " << per_op(r.time.count(), r.nOps) << ",\n"
+             << "      \"allocs_per_op\": " << per_op(r.allocs, r.nOps) << ",\n"
+             << "      \"alloc_bytes_per_op\": " << per_op(r.allocBytes, r.nOps) << ",\n"
+             << "      \"cycles_per_op\": "
+             << per_op(r.counters[hw_counters::CYCLES], r.nOps, hw) << ",\n"
+             << "      \"instructions_per_op\": "
+             << per_op(r.counters[hw_counters::INSTRUCTIONS], r.nOps, hw) << ",\n"
+             << "      \"cache_misses_per_op\": "
+             << per_op(r.counters[hw_counters::CACHE_MISSES], r.nOps, hw) << ",\n"
+             << "      \"branch_misses_per_op\": "
+             << per_op(r.counters[hw_counters::BRANCH_MISSES], r.nOps, hw) << "\n"
+             << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    cout << "  ]\n}" << endl;
+}
+
+// --------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    int nOps = (argc > 1) ? atoi(argv[1]) : DFLT_N_ITER;
+    size_t payloadSize = size_t((argc > 2) ? atol(argv[2]) : DFLT_PAYLOAD_SIZE);
+    int nFilters = (argc > 3) ? atoi(argv[3]) : DFLT_N_FILTERS;
+
+    if (nOps <= 0 || nFilters <= 0) {
+        cerr << "USAGE: hotpath_bench [iterations] [payload size] [filters]" << endl;
+        return 1;
+    }
+
+    hw_counters hw;
+    if (!hw.valid())
+        cerr << "Hardware counters aren't available. Reporting times and allocations."
+             << endl;
+
+    const string payload(payloadSize, 'x');
+    const auto topic = mqtt::string_ref::from_static(TOPIC);
+
+    // Keeps the compiler from optimizing away the work
+    size_t sink = 0;
+    vector<result> results;
+
+    // publish: The message that async_client::publish() builds, for a
+    // literal topic
+    results.push_back(run("publish", nOps, hw, [&] {
+        auto msg = mqtt::make_message("site/17/dev/temp", payload, 1, false);
+        sink += msg->get_payload().size();
+    }));
+
+    results.push_back(run("publish_static", nOps, hw, [&] {
+        auto msg = mqtt::make_message(topic, payload, 1, false);
+        sink += msg->get_payload().size();
+    }));
+
+    // topic: Building a per-device topic
+    const string site{"north"};
+    int devId = 0;
+
+    results.push_back(run("topic_concat", nOps, hw, [&] {
+        mqtt::string_ref t{"site/" + site + "/dev/" + to_string(devId++ % 100) + "/temp"};
+        sink += t.size();
+    }));
+
+    mqtt::topic_template tmpl{"site/{site}/dev/{id}/temp"};
+    results.push_back(run("topic_template", nOps, hw, [&] {
+        auto t = tmpl(site, devId++ % 100);
+        sink += t.size();
+    }));
+
+    // arrival: The message built from the C library's incoming message
+    MQTTAsync_message cmsg = MQTTAsync_message_initializer;
+    cmsg.payload = const_cast<char*>(payload.data());
+    cmsg.payloadlen = int(payload.size());
+    cmsg.qos = 1;
+
+    results.push_back(run("arrival", nOps, hw, [&] {
+        auto msg = mqtt::message::create(string{topic.str()}, cmsg);
+        sink += msg->get_payload().size();
+    }));
+
+    // queue: Passing a message from the callback to a consumer
+    mqtt::thread_queue<mqtt::const_message_ptr> que;
+    auto qmsg = mqtt::make_message(topic, payload);
+
+    results.push_back(run("queue", nOps, hw, [&] {
+        que.put(qmsg);
+        sink += que.get()->get_qos();
+    }));
+
+    // match: Finding the handlers for an incoming topic
+    mqtt::topic_matcher<int> matcher;
+    for (int i = 0; i < nFilters; ++i) {
+        auto site = "site/" + to_string(i);
+        matcher.insert({site + "/+/temp", i});
+        if (i % 10 == 0)
+            matcher.insert({site + "/#", i});
+    }
+    matcher.insert({"+/+/+/alarm", -1});
+
+    vector<string> topics;
+    for (int i = 0; i < 64; ++i)
+        topics.push_back("site/" + to_string((i * 37) % nFilters) + "/dev/temp");
+
+    size_t iTopic = 0;
+    results.push_back(run("match", nOps, hw, [&] {
+        const auto& t = topics[iTopic++ % topics.size()];
+        for (auto it = matcher.matches(t); it != matcher.matches_end(); ++it)
+            sink += size_t(it->second);
+    }));
+
+    print_json(results, payloadSize, nFilters);
+
+    if (sink == 0)
+        cerr << "No work done" << endl;
+    return 0;
+}
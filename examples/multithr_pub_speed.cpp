@@ -0,0 +1,226 @@
+// multithr_pub_speed.cpp
+//
+// Paho C++ sample client application to measure the speed at which
+// messages can be published when several threads share one client.
+//
+// Each publisher thread sends its own messages as fast as it can, while
+// another thread keeps polling the client's connection state and connect
+// options, and the library's threads complete the delivery tokens. This
+// shows how much the publishers contend with each other and with the
+// acknowledge processing inside the client.
+//
+// If the server can't be reached, the messages are buffered off-line, so
+// this still measures the cost of the publish calls themselves.
+//
+// If the address is 'embedded', and the examples were built with the
+// embedded test broker (PAHO_BUILD_TEST_BROKER), the messages go to a
+// broker running in this process, so the test doesn't need the network.
+//
+// With the 'combine' option, the threads publish through a
+// publish_combiner, which hands the messages to the client in batches
+// from one thread at a time.
+//
+// USAGE:
+//     multithr_pub_speed [address] [threads] [messages/thread] [payload size] [qos] [combine]
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mqtt/async_client.h"
+#include "mqtt/publish_combiner.h"
+
+#if defined(PAHO_WITH_TEST_BROKER)
+    #include "embedded_broker.h"
+#endif
+
+using namespace std;
+using namespace std::chrono;
+
+const string DFLT_SERVER_ADDRESS{"mqtt://localhost:1883"};
+
+const int DFLT_N_THREADS = 4, DFLT_N_MSG = 10000, DFLT_QOS = 1;
+const size_t DFLT_PAYLOAD_SIZE = 64;
+
+const string TOPIC{"test/speed/"};
+
+// Get the current time on the steady clock
+steady_clock::time_point now() { return steady_clock::now(); }
+
+// Convert a duration to a count of microseconds
+template <class Rep, class Period>
+int64_t usec(const std::chrono::duration<Rep, Period>& dur)
+{
+    return (int64_t)duration_cast<microseconds>(dur).count();
+}
+
+// Gets a rate in messages per second
+double rate(int64_t n, int64_t us) { return us ? (1.0e6 * n / us) : 0.0; }
+
+// --------------------------------------------------------------------------
+// Publisher thread. Sends the messages, then waits for all the tokens.
+
+void publish_func(
+    mqtt::async_client& cli, mqtt::publish_combiner* comb, int id, int nMsg, size_t msgSz,
+    int qos, int64_t& pubUs
+)
+{
+    auto topic = TOPIC + to_string(id);
+    mqtt::binary payload(msgSz, 'a' + id % 26);
+
+    vector<mqtt::delivery_token_ptr> toks;
+    toks.reserve(nMsg);
+
+    auto start = now();
+    for (int i = 0; i < nMsg; ++i) {
+        if (comb)
+            toks.push_back(comb->publish(topic, payload, qos, false));
+        else
+            toks.push_back(cli.publish(topic, payload, qos, false));
+    }
+    pubUs = usec(now() - start);
+
+    if (cli.is_connected()) {
+        for (auto& tok : toks) tok->wait();
+    }
+}
+
+// --------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    string address = (argc > 1) ? string(argv[1]) : DFLT_SERVER_ADDRESS;
+    int nThr = (argc > 2) ? atoi(argv[2]) : DFLT_N_THREADS;
+    int nMsg = (argc > 3) ? atoi(argv[3]) : DFLT_N_MSG;
+    size_t msgSz = (size_t)((argc > 4) ? atol(argv[4]) : DFLT_PAYLOAD_SIZE);
+    int qos = (argc > 5) ? atoi(argv[5]) : DFLT_QOS;
+    bool combine = (argc > 6) && string(argv[6]) == "combine";
+
+#if defined(PAHO_WITH_TEST_BROKER)
+    // A broker in this process, to measure without the network
+    std::unique_ptr<mqtt::embedded_broker> broker;
+    if (address == "embedded") {
+        broker = std::make_unique<mqtt::embedded_broker>();
+        address = broker->uri();
+    }
+#endif
+
+    if (nThr < 1 || nMsg < 1) {
+        cerr << "The number of threads and messages must be positive" << endl;
+        return 1;
+    }
+
+    int64_t nTotal = int64_t(nThr) * nMsg;
+
+    cout << "Initializing for server '" << address << "'..." << flush;
+
+    auto createOpts = mqtt::create_options_builder()
+                          .server_uri(address)
+                          .send_while_disconnected(true, true)
+                          .max_buffered_messages(int(nTotal))
+                          .finalize();
+
+    mqtt::async_client cli(createOpts);
+    mqtt::publish_combiner comb(cli);
+    cout << "OK" << endl;
+
+    try {
+        cout << "\nConnecting..." << flush;
+        try {
+            auto connOpts = mqtt::connect_options_builder().clean_session().finalize();
+            cli.connect(connOpts)->wait_for(seconds(5));
+        }
+        catch (const mqtt::exception&) {
+        }
+
+        if (cli.is_connected())
+            cout << "OK" << endl;
+        else
+            cout << "Not connected. Buffering off-line." << endl;
+
+        // Poll the client state while the publishers run
+        atomic<bool> done{false};
+        int64_t nPolls = 0;
+
+        thread poller([&] {
+            while (!done) {
+                if (cli.is_connected())
+                    cli.get_connect_options();
+                ++nPolls;
+            }
+        });
+
+        cout << "\nPublishing " << nTotal << " messages from " << nThr << " threads..."
+             << flush;
+
+        vector<int64_t> pubUs(nThr, 0);
+        vector<thread> pubs;
+
+        auto start = now();
+        for (int i = 0; i < nThr; ++i)
+            pubs.emplace_back(
+                publish_func, ref(cli), combine ? &comb : nullptr, i, nMsg, msgSz, qos,
+                ref(pubUs[i])
+            );
+
+        for (auto& thr : pubs) thr.join();
+        auto end = now();
+
+        done = true;
+        poller.join();
+        cout << "OK" << endl;
+
+        int64_t maxPubUs = 0;
+        for (auto us : pubUs) maxPubUs = std::max(maxPubUs, us);
+
+        cout << "Published in    " << maxPubUs / 1000 << "ms, " << int64_t(rate(nTotal, maxPubUs))
+             << " msg/sec" << endl;
+
+        if (cli.is_connected()) {
+            auto us = usec(end - start);
+            cout << "Acknowledged in " << us / 1000 << "ms, " << int64_t(rate(nTotal, us))
+                 << " msg/sec" << endl;
+        }
+        cout << "State polls     " << nPolls << endl;
+
+        if (combine) {
+            auto st = comb.get_stats();
+            cout << "Batches         " << st.batches << ", largest " << st.maxBatch << endl;
+        }
+
+        if (cli.is_connected()) {
+            cout << "\nDisconnecting..." << flush;
+            cli.disconnect()->wait();
+            cout << "OK" << endl;
+        }
+    }
+    catch (const mqtt::exception& exc) {
+        cerr << exc.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
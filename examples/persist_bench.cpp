@@ -0,0 +1,452 @@
+// persist_bench.cpp
+//
+// Paho C++ sample application to benchmark user persistence stores.
+//
+// This drives an iclient_persistence through the same C interface that
+// the library uses, with the calls a client makes for QoS 1 and 2
+// messages:
+//
+//  - A publisher keeps a window of messages in flight. Each one is put
+//    into the store as several buffers (header, topic, message ID, and
+//    payload), and removed when it would have been acknowledged.
+//  - The client then restarts: the store is closed and reopened, the
+//    keys are listed, and each message left in flight is read back.
+//
+// For each operation, it reports the rate and the latency percentiles.
+// For the file stores, it also reports the number of fsync() calls.
+//
+// The stores are:
+//  - mem        An in-memory map
+//  - file       One file per key, like the library's default store
+//  - file-sync  The same, but each put is synced to the disk
+//  - encoded    The XOR-encoded file store from the data_publish example
+//  - zip-mem    The in-memory store, wrapped in a compressed_persistence
+//  - zip-file   The file store, wrapped in a compressed_persistence
+//
+// With 'all', each of the stores is run in turn.
+//
+// USAGE:
+//     persist_bench [store|all] [messages] [payload size] [window]
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+#include "encoded_file_persistence.h"
+#include "mqtt/compressed_persistence.h"
+#include "mqtt/exception.h"
+#include "mqtt/iclient_persistence.h"
+
+using namespace std;
+using namespace std::chrono;
+namespace fs = std::filesystem;
+
+const string DFLT_STORE{"mem"};
+const int DFLT_N_MSG = 10000, DFLT_WINDOW = 100;
+const size_t DFLT_PAYLOAD_SIZE = 256;
+
+const string CLIENT_ID{"persist_bench"}, SERVER_URI{"tcp://localhost:1883"};
+const string TOPIC{"bench/persist/data"};
+const string ENCODE_KEY{"elephant"};
+
+const fs::path PERSIST_DIR{"persist-bench"};
+
+// --------------------------------------------------------------------------
+// A store that keeps the data in memory.
+
+class mem_persistence : virtual public mqtt::iclient_persistence
+{
+    map<string, string> store_;
+
+public:
+    void open(const string&, const string&) override {}
+    void close() override {}
+    void clear() override { store_.clear(); }
+
+    bool contains_key(const string& key) override { return store_.count(key) != 0; }
+
+    mqtt::string_collection keys() const override
+    {
+        mqtt::string_collection ks;
+        for (const auto& p : store_) ks.push_back(p.first);
+        return ks;
+    }
+
+    void put(const string& key, const vector<mqtt::string_view>& bufs) override
+    {
+        string s;
+        for (const auto& b : bufs) s.append(b.data(), b.size());
+        store_[key] = std::move(s);
+    }
+
+    string get(const string& key) const override
+    {
+        auto p = store_.find(key);
+        if (p == store_.end())
+            throw mqtt::persistence_exception();
+        return p->second;
+    }
+
+    void remove(const string& key) override { store_.erase(key); }
+};
+
+// --------------------------------------------------------------------------
+// A store with one file per key, in a directory for the client, like the
+// default store in the C library. The buffers are written one after the
+// other, and optionally synced to the disk.
+
+class file_persistence : virtual public mqtt::iclient_persistence
+{
+    fs::path dir_;
+    bool sync_;
+    size_t nSync_{0};
+
+    fs::path path_name(const string& key) const { return dir_ / key; }
+
+public:
+    explicit file_persistence(bool sync) : sync_{sync} {}
+
+    bool is_sync() const { return sync_; }
+    size_t num_syncs() const { return nSync_; }
+
+    void open(const string& clientId, const string& serverURI) override
+    {
+        string name = serverURI + "-" + clientId;
+        std::replace(name.begin(), name.end(), ':', '-');
+        std::replace(name.begin(), name.end(), '/', '-');
+
+        dir_ = PERSIST_DIR / name;
+        fs::create_directories(dir_);
+    }
+
+    void close() override {}
+
+    void clear() override
+    {
+        fs::remove_all(dir_);
+        fs::create_directories(dir_);
+    }
+
+    bool contains_key(const string& key) override { return fs::exists(path_name(key)); }
+
+    mqtt::string_collection keys() const override
+    {
+        mqtt::string_collection ks;
+        for (const auto& entry : fs::directory_iterator(dir_))
+            ks.push_back(entry.path().filename().string());
+        return ks;
+    }
+
+    void put(const string& key, const vector<mqtt::string_view>& bufs) override
+    {
+        FILE* fp = fopen(path_name(key).string().c_str(), "wb");
+        if (!fp)
+            throw mqtt::persistence_exception();
+
+        bool ok = true;
+        for (const auto& b : bufs) ok = ok && fwrite(b.data(), 1, b.size(), fp) == b.size();
+
+        if (ok && sync_) {
+            ok = fflush(fp) == 0;
+#if defined(_WIN32)
+            ok = ok && _commit(_fileno(fp)) == 0;
+#else
+            ok = ok && fsync(fileno(fp)) == 0;
+#endif
+            ++nSync_;
+        }
+        if (fclose(fp) != 0 || !ok)
+            throw mqtt::persistence_exception();
+    }
+
+    string get(const string& key) const override
+    {
+        auto path = path_name(key);
+        FILE* fp = fopen(path.string().c_str(), "rb");
+        if (!fp)
+            throw mqtt::persistence_exception();
+
+        string s(size_t(fs::file_size(path)), '\0');
+        size_t n = fread(&s[0], 1, s.size(), fp);
+        fclose(fp);
+
+        if (n != s.size())
+            throw mqtt::persistence_exception();
+        return s;
+    }
+
+    void remove(const string& key) override { fs::remove(path_name(key)); }
+};
+
+// --------------------------------------------------------------------------
+// Latency statistics for one type of operation.
+
+class op_stats
+{
+    string name_;
+    vector<int64_t> ns_;
+
+public:
+    explicit op_stats(const string& name) : name_{name} {}
+
+    // Times a call to the C store, which returns a library error code.
+    template <typename F>
+    void time(F f)
+    {
+        auto start = steady_clock::now();
+        int rc = f();
+        auto ns = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+        ns_.push_back(int64_t(ns));
+        if (rc != 0)
+            throw mqtt::persistence_exception(rc, name_ + " failed");
+    }
+
+    void report()
+    {
+        if (ns_.empty())
+            return;
+
+        sort(ns_.begin(), ns_.end());
+        int64_t total = 0;
+        for (auto n : ns_) total += n;
+
+        auto pct = [this](double p) {
+            return double(ns_[min(ns_.size() - 1, size_t(p * ns_.size()))]) / 1000.0;
+        };
+
+        cout << "  " << left << setw(10) << name_ << right << setw(9) << ns_.size()
+             << setw(12) << fixed << setprecision(0)
+             << (1.0e9 * ns_.size() / max<int64_t>(total, 1))
+             << setprecision(1) << setw(10) << pct(0.50) << setw(10) << pct(0.90)
+             << setw(10) << pct(0.99) << setw(10) << (ns_.back() / 1000.0) << endl;
+    }
+};
+
+// --------------------------------------------------------------------------
+
+// Makes a JSON-ish payload of the requested size, which compresses about
+// as well as typical telemetry.
+string make_payload(size_t sz, mt19937& rng)
+{
+    string s{"{\"readings\":["};
+    while (s.size() < sz) {
+        s += "{\"t\":" + to_string(200 + rng() % 100) + ",\"h\":" + to_string(rng() % 100) +
+             ",\"ok\":true},";
+    }
+    s.resize(sz);
+    return s;
+}
+
+// --------------------------------------------------------------------------
+
+// Runs the benchmark against a store, driving it through the C interface.
+// Any store that implements iclient_persistence can be timed this way.
+void run_bench(
+    const string& name, mqtt::iclient_persistence& store, int nMsg, size_t msgSz, int window
+)
+{
+    // The same interface the C library uses to call the store
+    auto pers = mqtt::iclient_persistence::c_struct(&store);
+    void* handle = nullptr;
+
+    op_stats putStats{"put"}, removeStats{"remove"}, keysStats{"keys"},
+        containsStats{"contains"}, getStats{"get"};
+
+    mt19937 rng{42};
+    vector<string> payloads;
+    for (int i = 0; i < 16; ++i) payloads.push_back(make_payload(msgSz, rng));
+
+    if (pers.popen(&handle, CLIENT_ID.c_str(), SERVER_URI.c_str(), pers.context) != 0)
+        throw mqtt::persistence_exception("Error opening the store");
+    pers.pclear(handle);
+
+    cout << "\nPublishing " << nMsg << " messages of " << msgSz << " bytes, with " << window
+         << " in flight, through the '" << name << "' store..." << endl;
+
+    // The buffers for a PUBLISH packet, as the library persists them:
+    // the fixed header, the remaining length, the topic, the message
+    // ID, and the payload.
+
+    char hdr = char(0x32);
+    char remLen[2] = {char(0x80), char(0x02)};
+    string topic = string{char(TOPIC.size() >> 8), char(TOPIC.size() & 0xFF)} + TOPIC;
+    char msgId[2];
+
+    deque<string> inFlight;
+    auto start = steady_clock::now();
+
+    for (int i = 0; i < nMsg; ++i) {
+        int id = i % 65535 + 1;
+        msgId[0] = char(id >> 8);
+        msgId[1] = char(id & 0xFF);
+
+        const string& payload = payloads[size_t(i) % payloads.size()];
+
+        char* bufs[] = {&hdr, remLen, const_cast<char*>(topic.data()), msgId,
+                        const_cast<char*>(payload.data())};
+        int lens[] = {1, 2, int(topic.size()), 2, int(payload.size())};
+
+        string key = "s-" + to_string(id);
+        putStats.time([&] {
+            return pers.pput(handle, const_cast<char*>(key.c_str()), 5, bufs, lens);
+        });
+        inFlight.push_back(std::move(key));
+
+        if (int(inFlight.size()) > window) {
+            removeStats.time([&] {
+                return pers.premove(handle, const_cast<char*>(inFlight.front().c_str()));
+            });
+            inFlight.pop_front();
+        }
+    }
+
+    auto pubUs = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+    // Restart, and restore the messages that were still in flight
+
+    pers.pclose(handle);
+    if (pers.popen(&handle, CLIENT_ID.c_str(), SERVER_URI.c_str(), pers.context) != 0)
+        throw mqtt::persistence_exception("Error reopening the store");
+
+    start = steady_clock::now();
+
+    char** keys = nullptr;
+    int nKeys = 0;
+    keysStats.time([&] { return pers.pkeys(handle, &keys, &nKeys); });
+
+    size_t nRestored = 0;
+    for (int i = 0; i < nKeys; ++i) {
+        containsStats.time([&] { return pers.pcontainskey(handle, keys[i]); });
+
+        char* buf = nullptr;
+        int len = 0;
+        getStats.time([&] { return pers.pget(handle, keys[i], &buf, &len); });
+        if (size_t(len) == 5 + topic.size() + msgSz)
+            ++nRestored;
+
+        mqtt::persistence_free(buf);
+        mqtt::persistence_free(keys[i]);
+    }
+    mqtt::persistence_free(keys);
+
+    auto restoreUs = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+    pers.pclear(handle);
+    pers.pclose(handle);
+
+    cout << defaultfloat << setprecision(6) << "\nPublish: " << pubUs / 1000.0
+         << "ms, restore of " << nRestored << "/" << nKeys
+         << " messages: " << restoreUs / 1000.0 << "ms\n"
+         << endl;
+
+    cout << "  " << left << setw(10) << "op" << right << setw(9) << "count" << setw(12)
+         << "ops/s" << setw(10) << "p50 us" << setw(10) << "p90 us" << setw(10) << "p99 us"
+         << setw(10) << "max us" << endl;
+
+    putStats.report();
+    removeStats.report();
+    keysStats.report();
+    containsStats.report();
+    getStats.report();
+
+    // Extra statistics for the stores that keep them
+
+    auto filePers = dynamic_cast<file_persistence*>(&store);
+    if (filePers && filePers->is_sync())
+        cout << "\nfsync calls: " << filePers->num_syncs() << endl;
+
+    if (auto zipPers = dynamic_cast<mqtt::compressed_persistence*>(&store)) {
+        auto st = zipPers->get_stats();
+        cout << "\nCompressed " << st.compressed << "/" << st.puts << " puts, " << st.bytesIn
+             << " -> " << st.bytesOut << " bytes, ratio " << setprecision(2) << st.ratio()
+             << endl;
+    }
+}
+
+// --------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    string storeName = (argc > 1) ? string(argv[1]) : DFLT_STORE;
+    int nMsg = (argc > 2) ? atoi(argv[2]) : DFLT_N_MSG;
+    size_t msgSz = size_t((argc > 3) ? atol(argv[3]) : DFLT_PAYLOAD_SIZE);
+    int window = (argc > 4) ? atoi(argv[4]) : DFLT_WINDOW;
+
+    if (nMsg < 1 || window < 1 || window > 65535) {
+        cerr << "The number of messages and the window must be positive, "
+             << "and the window can't be more than 65535" << endl;
+        return 1;
+    }
+
+    // The stores that can be benchmarked, by name
+
+    mem_persistence memPers;
+    file_persistence filePers{false}, fileSyncPers{true};
+    encoded_file_persistence encodedPers{ENCODE_KEY, PERSIST_DIR};
+    mqtt::compressed_persistence zipMemPers{memPers}, zipFilePers{filePers};
+
+    const vector<pair<string, mqtt::iclient_persistence*>> stores{
+        {"mem", &memPers},         {"file", &filePers},       {"file-sync", &fileSyncPers},
+        {"encoded", &encodedPers}, {"zip-mem", &zipMemPers}, {"zip-file", &zipFilePers}
+    };
+
+    bool found = false;
+
+    try {
+        for (const auto& st : stores) {
+            if (storeName == "all" || storeName == st.first) {
+                run_bench(st.first, *st.second, nMsg, msgSz, window);
+                found = true;
+            }
+        }
+    }
+    catch (const mqtt::exception& exc) {
+        cerr << "\nError: " << exc.what() << endl;
+        return 1;
+    }
+    catch (const fs::filesystem_error& exc) {
+        cerr << "\nError: " << exc.what() << endl;
+        return 1;
+    }
+
+    fs::remove_all(PERSIST_DIR);
+
+    if (!found) {
+        cerr << "Unknown store type: " << storeName << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -3,6 +3,10 @@
 // Paho C++ sample client application to do a simple test of the speed at
 // which messages can be published.
 //
+// If the address is 'embedded', and the examples were built with the
+// embedded test broker (PAHO_BUILD_TEST_BROKER), the messages go to a
+// broker running in this process, so the test doesn't need the network.
+//
 /*******************************************************************************
  * Copyright (c) 2013-2023 Frank Pagliughi <fpagliughi@mindspring.com>
  *
@@ -25,12 +29,17 @@
 #include <cstring>
 #include <future>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <thread>
 
 #include "mqtt/async_client.h"
 #include "mqtt/thread_queue.h"
 
+#if defined(PAHO_WITH_TEST_BROKER)
+    #include "embedded_broker.h"
+#endif
+
 using namespace std;
 using namespace std::chrono;
 
@@ -80,6 +89,15 @@ int main(int argc, char* argv[])
     size_t msgSz = (size_t)((argc > 3) ? atol(argv[3]) : DFLT_PAYLOAD_SIZE);
     int qos = (argc > 4) ? atoi(argv[4]) : DFLT_QOS;
 
+#if defined(PAHO_WITH_TEST_BROKER)
+    // A broker in this process, to measure without the network
+    std::unique_ptr<mqtt::embedded_broker> broker;
+    if (address == "embedded") {
+        broker = std::make_unique<mqtt::embedded_broker>();
+        address = broker->uri();
+    }
+#endif
+
     cout << "Initializing for server '" << address << "'..." << flush;
     mqtt::async_client cli(address, "");
 
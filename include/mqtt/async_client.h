@@ -34,11 +34,14 @@
 #ifndef __mqtt_async_client_h
 #define __mqtt_async_client_h
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <functional>
-#include <list>
 #include <memory>
 #include <stdexcept>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include "MQTTAsync.h"
@@ -51,9 +54,15 @@
 #include "mqtt/iasync_client.h"
 #include "mqtt/iclient_persistence.h"
 #include "mqtt/message.h"
+#include "mqtt/message_view.h"
+#include "mqtt/payload_integrity.h"
 #include "mqtt/properties.h"
+#include "mqtt/publish_policy.h"
+#include "mqtt/publish_template.h"
 #include "mqtt/string_collection.h"
+#include "mqtt/subscription_set.h"
 #include "mqtt/thread_queue.h"
+#include "mqtt/timer_wheel.h"
 #include "mqtt/token.h"
 #include "mqtt/types.h"
 
@@ -149,6 +158,15 @@ public:
     using disconnected_handler = std::function<void(const properties&, ReasonCode)>;
     /** Handler for updating connection data before an auto-reconnect. */
     using update_connection_handler = std::function<bool(connect_data&)>;
+    /** Filter for incoming messages, before any objects are created */
+    using message_filter = std::function<bool(const message_view&)>;
+    /** Handler that can take over outgoing messages before they're sent */
+    using publish_interceptor = std::function<bool(const message&)>;
+    /** The type for an absolute deadline on an operation */
+    using deadline_type = timer_wheel::time_point;
+
+    /** The most filters in one request from sync_subscriptions() */
+    static constexpr size_t MAX_SYNC_BATCH = 256;
 
 private:
     /** Lock guard type for this class */
@@ -156,8 +174,62 @@ private:
     /** Unique lock type for this class */
     using unique_lock = std::unique_lock<std::mutex>;
 
-    /** Object monitor mutex */
+    /**
+     * The user callbacks and handlers.
+     * These are read by the C library threads on every event, so they're
+     * kept as an immutable snapshot that is replaced whenever one of them
+     * changes.
+     */
+    struct callbacks
+    {
+        /** Callback supplied by the user (if any) */
+        callback* userCallback{};
+        /** Connection handler */
+        connection_handler connHandler;
+        /** Connection lost handler */
+        connection_handler connLostHandler;
+        /** Disconnected handler */
+        disconnected_handler disconnectedHandler;
+        /** Update connect data/options */
+        update_connection_handler updateConnectionHandler;
+        /** Message handler */
+        message_handler msgHandler;
+        /** Filter for incoming messages */
+        message_filter msgFilter;
+        /** Whether connection lost events go to the user */
+        bool connLostEnabled{true};
+    };
+    /** Shared pointer to a snapshot of the callbacks */
+    using callbacks_ptr = std::shared_ptr<const callbacks>;
+
+    /** The number of shards in the table of tokens in play */
+    static constexpr size_t N_TOKEN_SHARDS = 16;
+
+    /**
+     * A shard of the table of tokens in play. Each token is assigned to a
+     * shard by its address, so publishers and the threads completing the
+     * tokens only contend when they hit the same shard.
+     */
+    struct token_shard
+    {
+        /** The lock for this shard */
+        std::mutex lock;
+        /** Tokens that are in play */
+        std::unordered_map<const token*, token_ptr> tokens;
+        /** Delivery tokens that are in play */
+        std::unordered_map<const token*, delivery_token_ptr> deliveryTokens;
+        /**
+         * Tokens that timed out before the C library responded. These are
+         * kept alive until the late response arrives, since the C library
+         * still holds a pointer to them.
+         */
+        std::unordered_map<const token*, token_ptr> expiredTokens;
+    };
+
+    /** Mutex for the connect/disconnect state */
     mutable std::mutex lock_;
+    /** Mutex to serialize updates to the callbacks */
+    std::mutex cbLock_;
     /** The underlying C-lib client. */
     MQTTAsync cli_;
     /** The options used to create the client */
@@ -166,28 +238,51 @@ private:
     int mqttVersion_;
     /** A user persistence wrapper (if any) */
     std::unique_ptr<MQTTClient_persistence> persist_{};
-    /** Callback supplied by the user (if any) */
-    callback* userCallback_{};
-    /** Connection handler */
-    connection_handler connHandler_;
-    /** Connection lost handler */
-    connection_handler connLostHandler_;
-    /** Disconnected handler */
-    disconnected_handler disconnectedHandler_;
-    /** Update connect data/options */
-    update_connection_handler updateConnectionHandler_;
-    /** Message handler */
-    message_handler msgHandler_;
-    /** Cached options from the last connect */
-    connect_options connOpts_;
+    /** The callbacks. Accessed with the atomic shared_ptr functions. */
+    callbacks_ptr callbacks_{std::make_shared<callbacks>()};
+    /**
+     * Cached options from the last connect. Accessed with the atomic
+     * shared_ptr functions, and never modified once published.
+     */
+    std::shared_ptr<connect_options> connOpts_{std::make_shared<connect_options>()};
     /** Copy of connect token (for re-connects) */
     token_ptr connTok_;
-    /** A list of tokens that are in play */
-    std::list<token_ptr> pendingTokens_;
-    /** A list of delivery tokens that are in play */
-    std::list<delivery_token_ptr> pendingDeliveryTokens_;
+    /** Whether the client is connected, as last reported by the C library */
+    std::atomic<bool> connected_{false};
+    /** The number of times the client has connected */
+    std::atomic<uint64_t> connEpoch_{0};
+    /** The tables of tokens that are in play */
+    mutable std::array<token_shard, N_TOKEN_SHARDS> shards_;
+    /** The number of incoming messages rejected by the filter */
+    std::atomic<uint64_t> nFiltered_{0};
+    /** Whether to add and check payload checksums */
+    std::atomic<bool> integrity_{false};
+    /** The number of incoming messages that failed the checksum */
+    std::atomic<uint64_t> nCorrupt_{0};
+    /** The number of delivery tokens in play */
+    std::atomic<size_t> nDeliveryTokens_{0};
+    /** Timer for operation deadlines (created on first use) */
+    std::unique_ptr<timer_wheel> timers_;
+    /** Whether the timer has been created */
+    std::atomic<bool> timersStarted_{false};
+    /**
+     * Policy for degrading publishes under load (if any). Accessed with
+     * the atomic shared_ptr functions.
+     */
+    publish_policy_ptr policy_;
+    /**
+     * Takes over outgoing messages (if any). Accessed with the atomic
+     * shared_ptr functions.
+     */
+    std::shared_ptr<const publish_interceptor> interceptor_;
+    /** Mutex for the known subscriptions */
+    mutable std::mutex subLock_;
+    /** The subscriptions that the server has accepted */
+    subscription_set subs_;
     /** A queue of messages for consumer API */
     consumer_queue_type que_;
+    /** How long a consumer spins before blocking, in nanoseconds */
+    std::atomic<int64_t> consumerSpinNs_{0};
 
     /** Callbacks from the C library */
     static void on_connected(void* context, char* cause);
@@ -201,6 +296,32 @@ private:
     static void on_delivery_complete(void* context, MQTTAsync_token tok);
     static int on_update_connection(void* context, MQTTAsync_connectData* cdata);
 
+    /** Gets the current snapshot of the callbacks */
+    callbacks_ptr get_callbacks() const { return std::atomic_load(&callbacks_); }
+    /** Replaces the callbacks with a modified copy */
+    template <typename F>
+    void update_callbacks(F&& f) {
+        guard g(cbLock_);
+        auto cbs = std::make_shared<callbacks>(*get_callbacks());
+        f(*cbs);
+        std::atomic_store(&callbacks_, callbacks_ptr{std::move(cbs)});
+    }
+    /** Records a change in the connection state */
+    void set_connected(bool on);
+    /** Adds the filters to the known subscriptions, when the server accepts them */
+    void track_subscribe(
+        const token_ptr& tok, const qos_collection& qos,
+        const std::vector<subscribe_options>& opts
+    );
+    /** Removes the filters from the known subscriptions, when unsubscribed */
+    void track_unsubscribe(const token_ptr& tok);
+
+    /** Gets the shard of the token table for a token */
+    token_shard& shard_for(const token* tok) const {
+        auto h = reinterpret_cast<uintptr_t>(tok);
+        return shards_[((h >> 4) ^ (h >> 12)) % N_TOKEN_SHARDS];
+    }
+
     /** Manage internal list of active tokens */
     friend class token;
     virtual void add_token(token_ptr tok);
@@ -209,6 +330,42 @@ private:
     virtual void remove_token(token_ptr tok) { remove_token(tok.get()); }
     void remove_token(delivery_token_ptr tok) { remove_token(tok.get()); }
 
+    /** Arms a deadline for the token, creating the timer if needed */
+    void set_deadline(token_ptr tok, const deadline_type& deadline);
+    /** Expires a token that missed its deadline */
+    void on_deadline(token_ptr tok);
+    /**
+     * Determines whether the session ends when the connection closes, in
+     * which case the C library drops any requests still in flight.
+     * @return @em true for a clean v3 session, or a v5 session with no
+     *  	   expiry interval.
+     */
+    bool session_ends_on_close() const;
+    /**
+     * Releases the tokens that timed out waiting for a response, once the
+     * C library is no longer holding them.
+     * This is called when the connection closes. Nothing is released for a
+     * client that buffers messages while disconnected, since the library
+     * keeps the buffered requests.
+     */
+    void release_expired_tokens();
+    /**
+     * Applies the publish interceptor and policy, if any, to an outgoing
+     * message. This may swap in a QoS 0 copy of the message. If the message
+     * is intercepted or dropped, the token is completed locally.
+     * @return @em true if the message should be sent, @em false if it was
+     *  	   intercepted or dropped.
+     */
+    bool apply_publish_policy(delivery_token_ptr& tok, const_message_ptr& msg);
+    /**
+     * Sends a message with the C library, adding a payload checksum if
+     * that's turned on.
+     * @return The return code from the C library.
+     */
+    int send_message(
+        const char* topic, const MQTTAsync_message& msg, MQTTAsync_responseOptions& opts
+    );
+
     /** Non-copyable */
     async_client() = delete;
     async_client(const async_client&) = delete;
@@ -219,6 +376,12 @@ private:
         if (rc != MQTTASYNC_SUCCESS)
             throw exception(rc);
     }
+    /** Gets the deadline that is a relative time from now. */
+    template <class Rep, class Period>
+    static deadline_type deadline_after(const std::chrono::duration<Rep, Period>& relTime) {
+        return timer_wheel::clock::now() +
+               std::chrono::duration_cast<timer_wheel::duration>(relTime);
+    }
     /**
      * Create an async_client that can be used to communicate with an MQTT
      * server, which allows for off-line message buffering.
@@ -335,6 +498,75 @@ public:
      * @param cb The callback functor to register with the library.
      */
     void set_message_callback(message_handler cb) /*override*/;
+    /**
+     * Sets a filter to decide which incoming messages are wanted.
+     * The filter is called from the library's thread with a view of each
+     * message, as received, before the client creates a message object
+     * for it. If the filter returns @em false, the message is freed and
+     * counted, and never reaches the callbacks or the consumer queue. So
+     * a filter should be quick, and must not block.
+     *
+     * If the filter throws an exception, the message is kept.
+     *
+     * @param filt The filter, or nullptr to keep all messages.
+     */
+    void set_message_filter(message_filter filt);
+    /**
+     * Gets the number of incoming messages that were rejected by the
+     * message filter.
+     * @return The number of messages rejected by the filter.
+     */
+    uint64_t num_filtered_messages() const noexcept {
+        return nFiltered_.load(std::memory_order_relaxed);
+    }
+/**
+ * Expose the message arrived callback for the unit tests.
+ */
+#if defined(UNIT_TESTS)
+    int message_arrived(char* topicName, int topicLen, MQTTAsync_message* msg) {
+        return on_message_arrived(this, topicName, topicLen, msg);
+    }
+    void connection_lost(const char* cause) {
+        on_connection_lost(this, const_cast<char*>(cause));
+    }
+    size_t num_expired_tokens() const {
+        size_t n = 0;
+        for (auto& shard : shards_) {
+            guard g(shard.lock);
+            n += shard.expiredTokens.size();
+        }
+        return n;
+    }
+#endif
+    /**
+     * Turns payload integrity checks on or off.
+     *
+     * When on, and connected with MQTT v5, each published message gets the
+     * CRC-32C checksum of its payload as a user property, unless it
+     * already has one. Each incoming message that has a checksum is
+     * checked before it reaches the message filter, the callbacks, or the
+     * consumer queue. A message with a bad checksum is freed and counted.
+     * Messages without a checksum are passed along.
+     *
+     * @param on Whether to add and check payload checksums.
+     * @sa payload_integrity
+     */
+    void set_payload_integrity(bool on) { integrity_.store(on, std::memory_order_relaxed); }
+    /**
+     * Determines if payload integrity checks are on.
+     * @return @em true if payload integrity checks are on.
+     */
+    bool get_payload_integrity() const noexcept {
+        return integrity_.load(std::memory_order_relaxed);
+    }
+    /**
+     * Gets the number of incoming messages that were dropped because the
+     * payload didn't match its checksum.
+     * @return The number of corrupt messages dropped.
+     */
+    uint64_t num_corrupt_messages() const noexcept {
+        return nCorrupt_.load(std::memory_order_relaxed);
+    }
     /**
      * Sets a callback to allow the application to update the connection
      * data on automatic reconnects.
@@ -524,15 +756,25 @@ public:
      * to connect to the broker.
      * @returns The last connect options that were used.
      */
-    connect_options get_connect_options() const {
-        guard g(lock_);
-        return connOpts_;
-    }
+    connect_options get_connect_options() const { return *std::atomic_load(&connOpts_); }
     /**
      * Determines if this client is currently connected to the server.
+     * This is the state last reported by the C library through the
+     * connect, disconnect, and connection lost notifications, so it
+     * doesn't need to take the library's lock.
      * @return true if connected, false otherwise.
      */
-    bool is_connected() const override { return to_bool(MQTTAsync_isConnected(cli_)); }
+    bool is_connected() const override { return connected_.load(std::memory_order_acquire); }
+    /**
+     * Gets the connection epoch.
+     * This is incremented each time the client connects or reconnects to
+     * the server, so it can be used to detect that the connection was
+     * re-established between two points in time.
+     * @return The number of times the client has connected.
+     */
+    uint64_t connection_epoch() const noexcept {
+        return connEpoch_.load(std::memory_order_acquire);
+    }
     /**
      * Publishes a message to a topic on the server
      * @param topic The topic to deliver the message to
@@ -633,6 +875,210 @@ public:
     delivery_token_ptr publish(
         const_message_ptr msg, void* userContext, iaction_listener& cb
     ) override;
+    /**
+     * Publishes a message to a topic on the server, with a deadline.
+     * If the publish has not completed by the deadline, the token is
+     * completed with a timeout error and any listener is notified of the
+     * failure. For QoS 1 and 2 this means that the acknowledgment did not
+     * arrive in time; the message itself may still be delivered.
+     * @param msg The message to deliver to the server
+     * @param deadline The time by which the publish must complete.
+     * @return token used to track and wait for the publish to complete. The
+     *  	   token will be passed to callback methods if set.
+     */
+    delivery_token_ptr publish(const_message_ptr msg, const deadline_type& deadline);
+    /**
+     * Publishes a message to a topic on the server, with a deadline.
+     * @param msg The message to deliver to the server
+     * @param deadline The time by which the publish must complete.
+     * @param userContext optional object used to pass context to the
+     *  				  callback. Use @em nullptr if not required.
+     * @param cb callback optional listener that will be notified when
+     *  		 message delivery has completed, failed, or timed out.
+     * @return token used to track and wait for the publish to complete. The
+     *  	   token will be passed to callback methods if set.
+     */
+    delivery_token_ptr publish(
+        const_message_ptr msg, const deadline_type& deadline, void* userContext,
+        iaction_listener& cb
+    );
+    /**
+     * Publishes a message to a topic on the server, with a deadline.
+     * @param topic The topic to deliver the message to
+     * @param payload the bytes to use as the message payload
+     * @param n the number of bytes in the payload
+     * @param qos the Quality of Service to deliver the message at. Valid
+     *  		  values are 0, 1 or 2.
+     * @param retained whether or not this message should be retained by the
+     *  			   server.
+     * @param deadline The time by which the publish must complete.
+     * @return token used to track and wait for the publish to complete. The
+     *  	   token will be passed to callback methods if set.
+     */
+    delivery_token_ptr publish(
+        string_ref topic, const void* payload, size_t n, int qos, bool retained,
+        const deadline_type& deadline
+    ) {
+        auto msg = message::create(std::move(topic), payload, n, qos, retained);
+        return publish(std::move(msg), deadline);
+    }
+    /**
+     * Publishes a message to a topic on the server, with a deadline.
+     * @param topic The topic to deliver the message to
+     * @param payload the bytes to use as the message payload
+     * @param qos the Quality of Service to deliver the message at. Valid
+     *  		  values are 0, 1 or 2.
+     * @param retained whether or not this message should be retained by the
+     *  			   server.
+     * @param deadline The time by which the publish must complete.
+     * @return token used to track and wait for the publish to complete. The
+     *  	   token will be passed to callback methods if set.
+     */
+    delivery_token_ptr publish(
+        string_ref topic, binary_ref payload, int qos, bool retained,
+        const deadline_type& deadline
+    ) {
+        auto msg = message::create(std::move(topic), std::move(payload), qos, retained);
+        return publish(std::move(msg), deadline);
+    }
+    /**
+     * Publishes a message to a topic on the server, with a timeout.
+     * @param msg The message to deliver to the server
+     * @param timeout The amount of time allowed for the publish to
+     *  			  complete.
+     * @return token used to track and wait for the publish to complete. The
+     *  	   token will be passed to callback methods if set.
+     */
+    template <class Rep, class Period>
+    delivery_token_ptr publish(
+        const_message_ptr msg, const std::chrono::duration<Rep, Period>& timeout
+    ) {
+        return publish(std::move(msg), deadline_after(timeout));
+    }
+    /**
+     * Publishes a message to a topic on the server, with a timeout.
+     * @param msg The message to deliver to the server
+     * @param timeout The amount of time allowed for the publish to
+     *  			  complete.
+     * @param userContext optional object used to pass context to the
+     *  				  callback. Use @em nullptr if not required.
+     * @param cb callback optional listener that will be notified when
+     *  		 message delivery has completed, failed, or timed out.
+     * @return token used to track and wait for the publish to complete. The
+     *  	   token will be passed to callback methods if set.
+     */
+    template <class Rep, class Period>
+    delivery_token_ptr publish(
+        const_message_ptr msg, const std::chrono::duration<Rep, Period>& timeout,
+        void* userContext, iaction_listener& cb
+    ) {
+        return publish(std::move(msg), deadline_after(timeout), userContext, cb);
+    }
+    /**
+     * Publishes a message to a topic on the server, with a timeout.
+     * @param topic The topic to deliver the message to
+     * @param payload the bytes to use as the message payload
+     * @param n the number of bytes in the payload
+     * @param qos the Quality of Service to deliver the message at. Valid
+     *  		  values are 0, 1 or 2.
+     * @param retained whether or not this message should be retained by the
+     *  			   server.
+     * @param timeout The amount of time allowed for the publish to
+     *  			  complete.
+     * @return token used to track and wait for the publish to complete. The
+     *  	   token will be passed to callback methods if set.
+     */
+    template <class Rep, class Period>
+    delivery_token_ptr publish(
+        string_ref topic, const void* payload, size_t n, int qos, bool retained,
+        const std::chrono::duration<Rep, Period>& timeout
+    ) {
+        return publish(std::move(topic), payload, n, qos, retained, deadline_after(timeout));
+    }
+    /**
+     * Publishes a message to a topic on the server, with a timeout.
+     * @param topic The topic to deliver the message to
+     * @param payload the bytes to use as the message payload
+     * @param qos the Quality of Service to deliver the message at. Valid
+     *  		  values are 0, 1 or 2.
+     * @param retained whether or not this message should be retained by the
+     *  			   server.
+     * @param timeout The amount of time allowed for the publish to
+     *  			  complete.
+     * @return token used to track and wait for the publish to complete. The
+     *  	   token will be passed to callback methods if set.
+     */
+    template <class Rep, class Period>
+    delivery_token_ptr publish(
+        string_ref topic, binary_ref payload, int qos, bool retained,
+        const std::chrono::duration<Rep, Period>& timeout
+    ) {
+        return publish(
+            std::move(topic), std::move(payload), qos, retained, deadline_after(timeout)
+        );
+    }
+    /**
+     * Publishes a payload using a prepared template for the topic, QoS,
+     * retained flag and properties.
+     * This is the fastest way to publish a stream of messages that differ
+     * only by payload. At QoS 0 no message object is created, so the
+     * delivery token that is returned doesn't hold a message. At QoS 1 or
+     * 2 the token gets a message built from the template, so that the
+     * publish is reported through the callback's delivery_complete().
+     * If a publish policy or interceptor is installed, the message is
+     * created and published normally, so that they can be applied.
+     * @param tmpl The publish template.
+     * @param payload The payload. This is copied by the C library before
+     *  			  the call returns.
+     * @param n The size of the payload, in bytes.
+     * @return token used to track and wait for the publish to complete.
+     */
+    delivery_token_ptr publish(const publish_template& tmpl, const void* payload, size_t n);
+    /**
+     * Publishes a payload using a prepared template for the topic, QoS,
+     * retained flag and properties.
+     * @param tmpl The publish template.
+     * @param payload The payload.
+     * @return token used to track and wait for the publish to complete.
+     */
+    delivery_token_ptr publish(const publish_template& tmpl, const binary_ref& payload) {
+        return payload ? publish(tmpl, payload.data(), payload.size())
+                       : publish(tmpl, nullptr, 0);
+    }
+    /**
+     * Sets a policy to degrade low-value publishes when the client falls
+     * behind.
+     * While the policy considers the client to be overloaded, messages for
+     * the topics that it designates are downgraded to QoS 0, sampled, or
+     * dropped. The token for a dropped message completes immediately with
+     * the publish_policy::DROPPED error code.
+     * @param policy The policy, or nullptr to publish everything as
+     *  			 requested.
+     */
+    void set_publish_policy(publish_policy_ptr policy) {
+        std::atomic_store(&policy_, std::move(policy));
+    }
+    /**
+     * Gets the policy used to degrade publishes under load.
+     * @return The publish policy, or nullptr if there is none.
+     */
+    publish_policy_ptr get_publish_policy() const { return std::atomic_load(&policy_); }
+    /**
+     * Sets a function that can take over outgoing messages before they're
+     * sent.
+     * It's called for each message published through the client. If it
+     * returns @em true, the message isn't sent, and its token completes
+     * successfully right away. This lets something like a
+     * window_aggregator absorb the messages without changing the code that
+     * publishes them.
+     * @param fn The interceptor, or nullptr to send every message.
+     */
+    void set_publish_interceptor(publish_interceptor fn) {
+        std::shared_ptr<const publish_interceptor> p;
+        if (fn)
+            p = std::make_shared<const publish_interceptor>(std::move(fn));
+        std::atomic_store(&interceptor_, std::move(p));
+    }
     /**
      * Subscribe to a topic, which may include wildcards.
      * @param topicFilter the topic to subscribe to, which can include
@@ -768,6 +1214,43 @@ public:
         const string& topicFilter, void* userContext, iaction_listener& cb,
         const properties& props = properties()
     ) override;
+    /**
+     * Brings the client's subscriptions in line with a desired set.
+     *
+     * This compares the desired set to the subscriptions that the server
+     * has accepted from this client, and sends only the difference: an
+     * unsubscribe for the filters that are no longer wanted, and a
+     * subscribe for the filters that are new or have a different QoS or
+     * options. The requests are sent in batches of up to
+     * MAX_SYNC_BATCH filters, so a large change doesn't make a huge
+     * packet.
+     *
+     * The returned token completes when all the requests complete. It
+     * fails if any of them fails, with the error of the first failure. A
+     * filter that the server refuses isn't added to the known set, so it
+     * will be tried again on the next sync.
+     *
+     * The known set is cleared when the client connects with a clean
+     * session, since the server then has no subscriptions for it.
+     *
+     * @param desired The subscriptions that the client should have.
+     * @param props The MQTT v5 properties for the requests.
+     * @return A token to track all the requests. If there is nothing to
+     *  	   do, it's already complete.
+     */
+    token_ptr sync_subscriptions(
+        const subscription_set& desired, const properties& props = properties()
+    );
+    /**
+     * Gets the subscriptions that the server has accepted from this client.
+     * These are the subscriptions made with any of the subscribe calls
+     * that haven't been unsubscribed, since the last clean session.
+     * @return A copy of the known subscriptions.
+     */
+    subscription_set get_subscriptions() const {
+        guard g(subLock_);
+        return subs_;
+    }
     /**
      * Start consuming messages.
      *
@@ -797,6 +1280,33 @@ public:
      * This will also wake up any thread waiting on the queue.
      */
     void stop_consuming() override;
+    /**
+     * Sets the consumer to busy-poll the queue before blocking.
+     *
+     * This is for an application with a core to dedicate to consuming,
+     * that wants the lowest latency. When the queue is empty,
+     * consume_event() and consume_message() spin, waiting for an event,
+     * for up to the given time before blocking. The time adapts to the
+     * traffic, as described in thread_queue::get_spin(). While the
+     * consumer is spinning, the library's callback thread doesn't need to
+     * wake it up.
+     *
+     * @param maxSpin The longest time to spin before blocking. Zero turns
+     *  			  spinning off, which is the default.
+     */
+    template <typename Rep, class Period>
+    void set_consumer_spin(const std::chrono::duration<Rep, Period>& maxSpin) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(maxSpin).count();
+        consumerSpinNs_.store(std::max<int64_t>(int64_t(ns), 0), std::memory_order_relaxed);
+    }
+    /**
+     * Gets the longest time the consumer spins before blocking.
+     * @return The longest time the consumer spins before blocking, or zero
+     *  	   if it doesn't spin.
+     */
+    std::chrono::nanoseconds get_consumer_spin() const {
+        return std::chrono::nanoseconds(consumerSpinNs_.load(std::memory_order_relaxed));
+    }
     /**
      * This clears the consumer queue, discarding any pending event.
      */
@@ -26,6 +26,8 @@
 
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
 
 #include "mqtt/types.h"
 
@@ -48,6 +50,13 @@ namespace mqtt {
  * If no value has been assigned to a reference, then it is in a default
  * "null" state. It is not safe to call any member functions on a null
  * reference, other than to check if the object is null or empty.
+ *
+ * Normally the buffer is a string owned by the reference. A reference can
+ * also adopt external memory that it doesn't own, like a memory-mapped
+ * file, a block from a pool, or memory allocated by a C library, along
+ * with a deleter to release it when the last reference goes away. This
+ * lets large payloads be published without first copying them into a
+ * string. See adopt().
  * @verbatim
  * string_ref sr;
  * if (!sr)
@@ -77,8 +86,41 @@ public:
     using pointer_type = std::shared_ptr<const blob>;
 
 private:
+    /**
+     * An external block of memory adopted by the reference.
+     * The owner keeps the memory alive, and releases it with the user's
+     * deleter. If the data is ever requested as a string, a copy is made
+     * once and kept with the block.
+     */
+    struct external
+    {
+        /** The start of the data */
+        const value_type* data;
+        /** The number of elements of data */
+        size_t size;
+        /** The owner of the memory */
+        std::shared_ptr<const void> owner;
+        /** Guards the creation of the string copy */
+        mutable std::once_flag strFlag;
+        /** A copy of the data as a string, made on demand */
+        mutable blob str;
+
+        external(const value_type* p, size_t n, std::shared_ptr<const void> o)
+            : data{p}, size{n}, owner{std::move(o)} {}
+
+        const blob& to_blob() const {
+            std::call_once(strFlag, [this] { str.assign(data, size); });
+            return str;
+        }
+    };
+
     /** Our data is a shared pointer to a const buffer */
     pointer_type data_;
+    /** An adopted external buffer, used when there is no string buffer */
+    std::shared_ptr<const external> ext_;
+
+    /** Creates a reference to an adopted buffer */
+    buffer_ref(std::shared_ptr<const external> ext) : ext_{std::move(ext)} {}
 
 public:
     /**
@@ -162,6 +204,7 @@ public:
      */
     buffer_ref& operator=(const blob& b) {
         data_.reset(new blob(b));
+        ext_.reset();
         return *this;
     }
     /**
@@ -174,6 +217,7 @@ public:
      */
     buffer_ref& operator=(blob&& b) {
         data_.reset(new blob(std::move(b)));
+        ext_.reset();
         return *this;
     }
     /**
@@ -186,6 +230,7 @@ public:
             sizeof(char) == sizeof(T), "can only use C arr with char or byte buffers"
         );
         data_.reset(new blob(reinterpret_cast<const value_type*>(cstr), strlen(cstr)));
+        ext_.reset();
         return *this;
     }
     /**
@@ -203,12 +248,88 @@ public:
             sizeof(OT) == sizeof(T), "Can only assign buffers if values the same size"
         );
         data_.reset(new blob(reinterpret_cast<const value_type*>(rhs.data()), rhs.size()));
+        ext_.reset();
         return *this;
     }
+    /**
+     * Creates a reference that adopts an external block of memory.
+     *
+     * The memory is not copied. It must remain valid and unchanged until
+     * the deleter is called, which happens when the last reference to it
+     * goes away. For example, to publish a memory-mapped file:
+     * @code
+     * auto payload = mqtt::binary_ref::adopt(
+     *     static_cast<const char*>(addr), len,
+     *     [len](const char* p) { ::munmap(const_cast<char*>(p), len); }
+     * );
+     * @endcode
+     *
+     * @param p Pointer to the start of the data.
+     * @param n The number of elements of data.
+     * @param del The deleter, called as `del(p)` to release the memory.
+     * @return A reference to the adopted buffer.
+     */
+    template <typename Deleter>
+    static buffer_ref adopt(const value_type* p, size_t n, Deleter del) {
+        std::shared_ptr<const void> owner{p, [del = std::move(del)](const void* q) mutable {
+                                              del(static_cast<const value_type*>(q));
+                                          }};
+        return buffer_ref{std::make_shared<external>(p, n, std::move(owner))};
+    }
+    /**
+     * Creates a reference to data held by a shared object.
+     *
+     * The memory is not copied. The reference holds a share of the owner
+     * until the last reference to the data goes away. This is useful for
+     * payloads that live in a user object, like a DMA buffer or a
+     * serialized message.
+     * @param owner The object that owns the data.
+     * @param p Pointer to the start of the data.
+     * @param n The number of elements of data.
+     * @return A reference to the data.
+     */
+    template <typename U>
+    static buffer_ref adopt(std::shared_ptr<U> owner, const value_type* p, size_t n) {
+        return buffer_ref{std::make_shared<external>(
+            p, n, std::shared_ptr<const void>{std::move(owner)}
+        )};
+    }
+    /**
+     * Creates a reference to a string with static storage, like a constant
+     * topic name, without copying it.
+     *
+     * Constructing a reference from a C string or a std::string makes a
+     * new buffer each time, so publishing to a literal topic allocates on
+     * every call. A static reference points at the caller's string, with
+     * no owner to allocate or count, so creating and copying it costs
+     * nothing:
+     * @code
+     * static const std::string TEMP_TOPIC{"sensors/temp"};
+     * cli.publish(mqtt::string_ref::from_static(TEMP_TOPIC), payload);
+     * @endcode
+     *
+     * The string must not be modified or destroyed while any reference to
+     * it exists, including in messages that are still being delivered, so
+     * it should normally be a global or a function-level static.
+     * @param s A string with static storage.
+     * @return A reference to the string.
+     */
+    static buffer_ref from_static(const blob& s) {
+        // The aliasing constructor with an empty owner gives a non-null
+        // pointer without a control block.
+        return buffer_ref{pointer_type{pointer_type{}, &s}};
+    }
+    /**
+     * A temporary can't be referenced as static storage.
+     */
+    static buffer_ref from_static(blob&&) = delete;
     /**
      * Clears the reference to nil.
      */
-    void reset() { data_.reset(); }
+    void reset() {
+        data_.reset();
+        ext_.reset();
+    }
     /**
      * Determines if the reference is valid.
      * If the reference is invalid then it is not safe to call @em any
@@ -216,7 +337,7 @@ public:
      * @return @em true if referring to a valid buffer, @em false if the
      *  	   reference (pointer) is null.
      */
-    explicit operator bool() const { return bool(data_); }
+    explicit operator bool() const { return bool(data_) || bool(ext_); }
     /**
      * Determines if the reference is invalid.
      * If the reference is invalid then it is not safe to call @em any
@@ -224,33 +345,49 @@ public:
      * @return @em true if the reference is null, @em false if it is
      *  	   referring to a valid buffer,
      */
-    bool is_null() const { return !data_; }
+    bool is_null() const { return !data_ && !ext_; }
     /**
      * Determines if the buffer is empty.
      * @return @em true if the buffer is empty or the reference is null,
      *  	   @em false if the buffer contains data.
      */
-    bool empty() const { return !data_ || data_->empty(); }
+    bool empty() const { return data_ ? data_->empty() : (!ext_ || ext_->size == 0); }
+    /**
+     * Determines if the reference is to an adopted, external buffer,
+     * rather than a string.
+     * @return @em true if the buffer was adopted, @em false otherwise.
+     */
+    bool is_external() const { return !data_ && ext_; }
+    /**
+     * Determines if the reference is to a static string that it doesn't
+     * own.
+     * @return @em true if the reference was created with from_static(),
+     *  	   @em false otherwise.
+     * @sa from_static()
+     */
+    bool is_static() const { return data_ && data_.use_count() == 0; }
     /**
      * Gets a const pointer to the data buffer.
      * @return A pointer to the data buffer.
      */
-    const value_type* data() const { return data_->data(); }
+    const value_type* data() const { return data_ ? data_->data() : ext_->data; }
     /**
      * Gets the size of the data buffer.
      * @return The size of the data buffer.
      */
-    size_t size() const { return data_->size(); }
+    size_t size() const { return data_ ? data_->size() : ext_->size; }
     /**
      * Gets the size of the data buffer.
      * @return The size of the data buffer.
      */
-    size_t length() const { return data_->length(); }
+    size_t length() const { return size(); }
     /**
      * Gets the data buffer as a string.
+     * For an adopted buffer, this makes a copy of the data the first time
+     * it's called, so it's best avoided for large external buffers.
      * @return The data buffer as a string.
      */
-    const blob& str() const { return *data_; }
+    const blob& str() const { return data_ ? *data_ : ext_->to_blob(); }
     /**
      * Gets the data buffer as a string.
      * @return The data buffer as a string.
@@ -261,9 +398,10 @@ public:
      * Note that the reference must be set to call this function.
      * @return The data buffer as a string.
      */
-    const char* c_str() const { return data_->c_str(); }
+    const char* c_str() const { return str().c_str(); }
     /**
      * Gets a shared pointer to the (const) data buffer.
+     * This is null for an adopted buffer.
      * @return A shared pointer to the (const) data buffer.
      */
     const pointer_type& ptr() const { return data_; }
@@ -272,7 +410,7 @@ public:
      * @param i The index into the buffer.
      * @return The value at the specified index.
      */
-    const value_type& operator[](size_t i) const { return (*data_)[i]; }
+    const value_type& operator[](size_t i) const { return data()[i]; }
 };
 
 /**
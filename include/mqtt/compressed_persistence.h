@@ -0,0 +1,185 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file compressed_persistence.h
+/// Declaration of MQTT compressed_persistence class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_compressed_persistence_h
+#define __mqtt_compressed_persistence_h
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "mqtt/iclient_persistence.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A persistence store that compresses the data before passing it on to
+ * another store.
+ *
+ * The buffers for each key are joined and compressed with a small, fast
+ * LZ77 block codec, in the style of LZ4, then handed to the inner store
+ * as a single buffer. The data is decompressed again in get(). This cuts
+ * down on the bytes written for QoS 1 and 2 messages, which helps on
+ * devices with slow or wear-limited storage, like SD cards.
+ *
+ * Compressed data is stored behind a small header: two magic bytes and a
+ * format byte. Data that is smaller than a threshold, or that doesn't get
+ * any smaller when compressed, is stored as-is, so it costs nothing.
+ * Records without the header are read back unchanged, so a store that
+ * already has records from a client that wasn't using the wrapper can
+ * still be read through it. But compressed records are only readable
+ * through this class.
+ *
+ * The compressor itself is also available through the static compress()
+ * and decompress() functions.
+ */
+class compressed_persistence : virtual public iclient_persistence
+{
+public:
+    /** The default size under which data isn't compressed */
+    static constexpr size_t DFLT_MIN_SIZE = 64;
+
+    /** Counts of the data that went through the store */
+    struct stats
+    {
+        /** The number of puts */
+        uint64_t puts{0};
+        /** The number of puts that were stored compressed */
+        uint64_t compressed{0};
+        /** The number of bytes given to the store */
+        uint64_t bytesIn{0};
+        /** The number of bytes passed on to the inner store */
+        uint64_t bytesOut{0};
+
+        /**
+         * Gets the ratio of the data size to the stored size.
+         * @return The compression ratio, or one if nothing was stored.
+         */
+        double ratio() const { return bytesOut ? double(bytesIn) / double(bytesOut) : 1.0; }
+    };
+
+private:
+    /** The store that holds the compressed data */
+    iclient_persistence& inner_;
+    /** The size under which data isn't compressed */
+    size_t minSize_;
+    /** The number of puts */
+    std::atomic<uint64_t> nPuts_{0};
+    /** The number of puts that were stored compressed */
+    std::atomic<uint64_t> nCompressed_{0};
+    /** The number of bytes given to the store */
+    std::atomic<uint64_t> nBytesIn_{0};
+    /** The number of bytes passed on to the inner store */
+    std::atomic<uint64_t> nBytesOut_{0};
+
+public:
+    /**
+     * Creates a compressing wrapper around another store.
+     * @param inner The store to hold the compressed data. This must
+     *  			outlive the wrapper.
+     * @param minSize Data smaller than this is stored uncompressed.
+     */
+    explicit compressed_persistence(iclient_persistence& inner, size_t minSize = DFLT_MIN_SIZE)
+        : inner_{inner}, minSize_{minSize} {}
+    /**
+     * Compresses a block of data.
+     * @param data The data to compress.
+     * @param n The size of the data, in bytes.
+     * @param out The compressed data is appended to this string.
+     */
+    static void compress(const char* data, size_t n, string& out);
+    /**
+     * Decompresses a block of data that was created with compress().
+     * @param data The compressed data.
+     * @param n The size of the compressed data, in bytes.
+     * @param origSize The size of the original data.
+     * @return The original data.
+     * @throw persistence_exception if the data is corrupt, or the original
+     *  	  size is more than the compressed data could hold, or larger
+     *  	  than the largest MQTT packet.
+     */
+    static string decompress(const char* data, size_t n, size_t origSize);
+    /**
+     * Gets the inner store.
+     * @return A reference to the inner store.
+     */
+    iclient_persistence& get_inner() { return inner_; }
+    /**
+     * Gets the counts of the data that went through the store.
+     * @return The counts of the data that went through the store.
+     */
+    stats get_stats() const;
+    /**
+     * Opens the inner store.
+     * @param clientId The identifier string for the client.
+     * @param serverURI The server to which the client is connected.
+     */
+    void open(const string& clientId, const string& serverURI) override {
+        inner_.open(clientId, serverURI);
+    }
+    /**
+     * Closes the inner store.
+     */
+    void close() override { inner_.close(); }
+    /**
+     * Clears the inner store.
+     */
+    void clear() override { inner_.clear(); }
+    /**
+     * Determines if the inner store has data for the key.
+     * @param key The key to find
+     * @return @em true if the key exists, @em false if not.
+     */
+    bool contains_key(const string& key) override { return inner_.contains_key(key); }
+    /**
+     * Gets the keys in the inner store.
+     * @return A collection of the keys in the store.
+     */
+    string_collection keys() const override { return inner_.keys(); }
+    /**
+     * Compresses the data and puts it into the inner store.
+     * @param key The key.
+     * @param bufs The data to store
+     */
+    void put(const string& key, const std::vector<string_view>& bufs) override;
+    /**
+     * Gets the data from the inner store and decompresses it.
+     * @param key The key
+     * @return The original data associated with the key.
+     * @throw persistence_exception if the stored data is corrupt.
+     */
+    string get(const string& key) const override;
+    /**
+     * Removes the data for the key from the inner store.
+     * @param key The key
+     */
+    void remove(const string& key) override { inner_.remove(key); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_compressed_persistence_h
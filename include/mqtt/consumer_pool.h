@@ -0,0 +1,292 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file consumer_pool.h
+/// Declaration of MQTT consumer_pool class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_consumer_pool_h
+#define __mqtt_consumer_pool_h
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "mqtt/event.h"
+#include "mqtt/thread_queue.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+class async_client;
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A pool of consumer threads that grows and shrinks with the load.
+ *
+ * The pool reads events from a client's consumer queue, or any
+ * thread_queue of events, and runs a handler on each one from a set of
+ * worker threads. Rather than sizing the pool by hand for the peak load,
+ * it's given a minimum and maximum number of workers, and a monitor
+ * thread adjusts the count as it goes.
+ *
+ * Each interval, the monitor looks at:
+ *  @li The depth of the queue.
+ *  @li The dwell time: how long an event waits in the queue, estimated
+ *  	from the depth and the rate that the workers drain it.
+ *  @li The utilization: the fraction of the workers' time spent in the
+ *  	handler.
+ *  @li The CPU usage of the process, as a fraction of all the cores.
+ *
+ * A worker is added when the queue is backed up, by depth or dwell time,
+ * for a number of intervals in a row, unless the CPU is already busy, in
+ * which case more threads wouldn't help. A worker is removed when the
+ * queue is empty and the workers are mostly idle, for a longer run of
+ * intervals. The different run lengths give the scaling some hysteresis,
+ * so that the pool doesn't flap around a threshold.
+ *
+ * The worker counts and scaling decisions are reported in the metrics,
+ * and can be sent to a callback as they happen.
+ *
+ * For a client, the consumer must be started before the pool:
+ * @code
+ * cli.start_consuming();
+ * mqtt::consumer_pool pool{cli, [](const mqtt::event& ev) {
+ *     if (auto msg = ev.get_message_if())
+ *         process(*msg);
+ * }};
+ * @endcode
+ *
+ * The handler can be called from several threads at once, so events are
+ * handled in parallel, and not necessarily in order.
+ */
+class consumer_pool
+{
+public:
+    /** The handler run on each event by the workers */
+    using handler_type = std::function<void(const event&)>;
+    /** The type used for times */
+    using duration = std::chrono::milliseconds;
+
+    /** The settings for the pool */
+    struct options
+    {
+        /** The fewest workers to keep */
+        size_t minWorkers{1};
+        /** The most workers to run */
+        size_t maxWorkers{4};
+        /** How often the monitor checks the load */
+        duration interval{250};
+        /** The queue depth that counts as backed up */
+        size_t highDepth{100};
+        /** The dwell time that counts as backed up */
+        duration maxDwell{100};
+        /** The utilization below which the workers count as idle */
+        double lowUtil{0.3};
+        /** The CPU usage, 0 to 1, above which no workers are added */
+        double maxCpu{0.9};
+        /** The intervals in a row backed up before adding a worker */
+        int upPeriods{2};
+        /** The intervals in a row idle before removing a worker */
+        int downPeriods{8};
+    };
+
+    /** A scaling decision */
+    enum class decision
+    {
+        /** No change */
+        NONE,
+        /** A worker was added */
+        SCALE_UP,
+        /** A worker was removed */
+        SCALE_DOWN,
+        /** A worker was needed, but the CPU was too busy */
+        CPU_LIMITED
+    };
+
+    /** The state of the pool */
+    struct metrics
+    {
+        /** The number of workers */
+        size_t workers{0};
+        /** The depth of the queue, at the last check */
+        size_t queueDepth{0};
+        /** The estimated dwell time, at the last check */
+        duration dwell{0};
+        /** The utilization of the workers, over the last interval */
+        double utilization{0.0};
+        /** The CPU usage of the process, over the last interval */
+        double cpu{0.0};
+        /** The number of events handled */
+        uint64_t processed{0};
+        /** The number of events where the handler threw */
+        uint64_t errors{0};
+        /** The number of workers added */
+        uint64_t scaleUps{0};
+        /** The number of workers removed */
+        uint64_t scaleDowns{0};
+        /** The number of times a worker was held back by the CPU */
+        uint64_t cpuLimited{0};
+        /** The last scaling decision */
+        decision lastDecision{decision::NONE};
+    };
+
+    /** A callback for the scaling decisions */
+    using scale_handler = std::function<void(decision, const metrics&)>;
+
+private:
+    /** Lock guard type for this class */
+    using guard = std::lock_guard<std::mutex>;
+    /** Unique lock type for this class */
+    using unique_lock = std::unique_lock<std::mutex>;
+    /** The clock for the measurements */
+    using clock = std::chrono::steady_clock;
+
+    /** A worker thread */
+    struct worker
+    {
+        std::thread thr;
+        std::atomic<bool> done{false};
+    };
+
+    /** Reads an event, waiting up to the timeout */
+    std::function<bool(event*, duration)> fetch_;
+    /** Gets the queue depth */
+    std::function<size_t()> depth_;
+    /** Whether the source is closed and empty */
+    std::function<bool()> done_;
+    /** The user handler */
+    handler_type handler_;
+    /** The settings */
+    const options opts_;
+
+    /** Object monitor mutex */
+    mutable std::mutex lock_;
+    /** Signaled to stop the monitor */
+    std::condition_variable stopCond_;
+    /** Whether the pool is stopping */
+    std::atomic<bool> stop_{false};
+    /** The worker threads */
+    std::list<std::unique_ptr<worker>> workers_;
+    /** The number of workers asked to exit */
+    std::atomic<int> nRetire_{0};
+    /** The callback for the scaling decisions */
+    scale_handler scaleHandler_;
+    /** The current metrics */
+    metrics metrics_;
+    /** The thread watching the load */
+    std::thread monitorThr_;
+
+    /** The counters updated by the workers */
+    std::atomic<uint64_t> nProcessed_{0};
+    std::atomic<uint64_t> nErrors_{0};
+    std::atomic<int64_t> busyNanos_{0};
+
+    /** Non-copyable */
+    consumer_pool(const consumer_pool&) = delete;
+    consumer_pool& operator=(const consumer_pool&) = delete;
+
+    /** Starts the threads */
+    void start();
+    /** Adds a worker. Must hold the lock. */
+    void add_worker();
+    /** Joins the workers that have exited. Must hold the lock. */
+    void reap_workers();
+    /** The worker thread function */
+    void run_worker(worker* w);
+    /** The monitor thread function */
+    void run_monitor();
+    /** Whether a worker should exit rather than take another event */
+    bool should_retire();
+
+public:
+    /**
+     * Creates a pool reading from a client's consumer queue, with the
+     * default settings.
+     * @param cli The client, which must have started consuming.
+     * @param handler The handler to run on each event.
+     */
+    consumer_pool(async_client& cli, handler_type handler);
+    /**
+     * Creates a pool reading from a client's consumer queue.
+     * @param cli The client, which must have started consuming.
+     * @param handler The handler to run on each event.
+     * @param opts The settings for the pool.
+     * @throw std::invalid_argument if the worker limits aren't valid.
+     */
+    consumer_pool(async_client& cli, handler_type handler, const options& opts);
+    /**
+     * Creates a pool reading from a queue of events, with the default
+     * settings.
+     * @param que The queue. It must outlive the pool.
+     * @param handler The handler to run on each event.
+     */
+    consumer_pool(thread_queue<event>& que, handler_type handler);
+    /**
+     * Creates a pool reading from a queue of events.
+     * @param que The queue. It must outlive the pool.
+     * @param handler The handler to run on each event.
+     * @param opts The settings for the pool.
+     * @throw std::invalid_argument if the worker limits aren't valid.
+     */
+    consumer_pool(thread_queue<event>& que, handler_type handler, const options& opts);
+    /**
+     * Stops the pool.
+     */
+    ~consumer_pool();
+    /**
+     * Gets the settings for the pool.
+     * @return The settings for the pool.
+     */
+    const options& get_options() const { return opts_; }
+    /**
+     * Sets a callback for the scaling decisions. It's called from the
+     * monitor thread each time a worker is added or removed, or held back
+     * by the CPU usage.
+     * @param cb The callback.
+     */
+    void set_scale_handler(scale_handler cb);
+    /**
+     * Gets the number of workers.
+     * @return The number of workers.
+     */
+    size_t num_workers() const;
+    /**
+     * Gets the current state of the pool.
+     * @return The current state of the pool.
+     */
+    metrics get_metrics() const;
+    /**
+     * Stops the pool. Each worker finishes the event it's handling, and
+     * the threads are joined. Events left in the queue stay there.
+     */
+    void stop();
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_consumer_pool_h
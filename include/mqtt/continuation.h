@@ -0,0 +1,243 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file continuation.h
+/// Declaration of the MQTT continuation class for token completions.
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_continuation_h
+#define __mqtt_continuation_h
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mqtt {
+
+class token;
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A move-only callable that is run when a token completes.
+ *
+ * This is a type-erased wrapper around any callable that can be invoked
+ * with a reference to the completed token, like a lambda taking
+ * `mqtt::token&`. Small callables, such as lambdas that capture a few
+ * pointers or references, are stored inline in the object itself, so
+ * attaching them to a token does not touch the heap. Larger ones are
+ * moved to a heap allocation.
+ */
+class continuation
+{
+    /** The size of the inline buffer */
+    static constexpr size_t BUF_SIZE = 4 * sizeof(void*);
+    /** The alignment of the inline buffer */
+    static constexpr size_t BUF_ALIGN = alignof(std::max_align_t);
+
+    /** The type-specific operations on the stored callable */
+    struct ops
+    {
+        /** Invokes the callable */
+        void (*invoke)(void* obj, token& tok);
+        /** Moves the callable from 'src' into 'dst', destroying 'src' */
+        void (*relocate)(void* dst, void* src) noexcept;
+        /** Destroys the callable */
+        void (*destroy)(void* obj) noexcept;
+    };
+
+    /** Storage for the callable, or a pointer to it */
+    alignas(BUF_ALIGN) unsigned char buf_[BUF_SIZE];
+    /** Operations for the stored callable, or nullptr if empty */
+    const ops* ops_{nullptr};
+
+    /** Operations for a callable held in the inline buffer */
+    template <class F>
+    static const ops* inline_ops() {
+        static constexpr ops o{
+            [](void* obj, token& tok) { (*static_cast<F*>(obj))(tok); },
+            [](void* dst, void* src) noexcept {
+                ::new (dst) F(std::move(*static_cast<F*>(src)));
+                static_cast<F*>(src)->~F();
+            },
+            [](void* obj) noexcept { static_cast<F*>(obj)->~F(); }
+        };
+        return &o;
+    }
+    /** Operations for a callable held on the heap */
+    template <class F>
+    static const ops* heap_ops() {
+        static constexpr ops o{
+            [](void* obj, token& tok) { (**static_cast<F**>(obj))(tok); },
+            [](void* dst, void* src) noexcept {
+                *static_cast<F**>(dst) = *static_cast<F**>(src);
+            },
+            [](void* obj) noexcept { delete *static_cast<F**>(obj); }
+        };
+        return &o;
+    }
+
+public:
+    /**
+     * Determines whether a callable of the specified type will be stored
+     * inline, without a heap allocation.
+     * @return @em true if the callable fits in the inline buffer.
+     */
+    template <class F>
+    static constexpr bool is_inline() {
+        return sizeof(F) <= BUF_SIZE && alignof(F) <= BUF_ALIGN &&
+               std::is_nothrow_move_constructible<F>::value;
+    }
+    /**
+     * Creates an empty continuation.
+     */
+    continuation() noexcept {}
+    /**
+     * Creates a continuation from a callable.
+     * @param fn A callable that can be invoked with a reference to a token.
+     */
+    template <
+        class F, class Fn = std::decay_t<F>,
+        typename = std::enable_if_t<!std::is_same<Fn, continuation>::value>>
+    continuation(F&& fn) {
+        if constexpr (is_inline<Fn>()) {
+            ::new (static_cast<void*>(buf_)) Fn(std::forward<F>(fn));
+            ops_ = inline_ops<Fn>();
+        }
+        else {
+            *reinterpret_cast<Fn**>(buf_) = new Fn(std::forward<F>(fn));
+            ops_ = heap_ops<Fn>();
+        }
+    }
+    /**
+     * Move constructor.
+     * @param other The continuation to move into this one. It is left
+     *  			empty.
+     */
+    continuation(continuation&& other) noexcept : ops_{other.ops_} {
+        if (ops_) {
+            ops_->relocate(buf_, other.buf_);
+            other.ops_ = nullptr;
+        }
+    }
+    /**
+     * Destroys the continuation and the callable it holds.
+     */
+    ~continuation() { reset(); }
+    /**
+     * Move assignment.
+     * @param rhs The continuation to move into this one. It is left empty.
+     * @return A reference to this object.
+     */
+    continuation& operator=(continuation&& rhs) noexcept {
+        if (&rhs != this) {
+            reset();
+            if (rhs.ops_) {
+                rhs.ops_->relocate(buf_, rhs.buf_);
+                ops_ = rhs.ops_;
+                rhs.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+    /**
+     * Destroys the callable, leaving the continuation empty.
+     */
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(buf_);
+            ops_ = nullptr;
+        }
+    }
+    /**
+     * Determines if the continuation holds a callable.
+     * @return @em true if there is a callable, @em false if empty.
+     */
+    explicit operator bool() const { return ops_ != nullptr; }
+    /**
+     * Invokes the callable.
+     * The continuation must not be empty.
+     * @param tok The completed token.
+     */
+    void operator()(token& tok) { ops_->invoke(buf_, tok); }
+};
+
+/**
+ * A continuation bound to the token that it should be run against.
+ *
+ * This is what gets handed to an executor. It holds a reference to the
+ * token, so it remains valid for as long as the task is kept around.
+ */
+class continuation_task
+{
+    /** The continuation */
+    continuation fn_;
+    /** The token that completed */
+    std::shared_ptr<token> tok_;
+
+public:
+    /**
+     * Creates a task.
+     * @param fn The continuation.
+     * @param tok The token that completed.
+     */
+    continuation_task(continuation&& fn, std::shared_ptr<token> tok)
+        : fn_{std::move(fn)}, tok_{std::move(tok)} {}
+    /**
+     * Gets the token that completed.
+     * @return The token that completed.
+     */
+    const std::shared_ptr<token>& get_token() const { return tok_; }
+    /**
+     * Runs the continuation against the token.
+     */
+    void operator()() {
+        if (fn_ && tok_)
+            fn_(*tok_);
+    }
+};
+
+/**
+ * Interface for something that can run token continuations off of the
+ * thread that completed the token.
+ *
+ * By default a continuation is run inline, from the thread that completed
+ * the token (usually one of the C library's threads). An executor can
+ * queue it up to run elsewhere, such as an application thread or a pool.
+ */
+class executor
+{
+public:
+    /**
+     * Virtual base destructor.
+     */
+    virtual ~executor() {}
+    /**
+     * Arranges for the task to be run.
+     * @param task The task to run.
+     */
+    virtual void execute(continuation_task task) = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_continuation_h
@@ -24,6 +24,7 @@
 #ifndef __mqtt_delivery_token_h
 #define __mqtt_delivery_token_h
 
+#include <chrono>
 #include <memory>
 
 #include "MQTTAsync.h"
@@ -43,6 +44,8 @@ class delivery_token : public token
 {
     /** The message being tracked. */
     const_message_ptr msg_;
+    /** When the message was sent (only tracked for a publish policy) */
+    std::chrono::steady_clock::time_point sendTime_{};
 
     /** Client has special access. */
     friend class async_client;
@@ -0,0 +1,401 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file failover_client.h
+/// Declaration of MQTT failover_client class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_failover_client_h
+#define __mqtt_failover_client_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mqtt/async_client.h"
+#include "mqtt/create_options.h"
+#include "mqtt/message.h"
+#include "mqtt/thread_queue.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Pairs up the copies of messages received by two sessions subscribed to
+ * the same topics, so that each message is only delivered once.
+ *
+ * Messages from the active session are delivered right away. Messages
+ * from the standby are held back until the active session's copy shows
+ * up, at which point the standby copy is dropped. If the active session
+ * is lost before its copy arrives, the held messages are released when
+ * the standby is promoted. After a promotion, late copies of messages
+ * that were already delivered by the old active session are dropped.
+ *
+ * Copies are matched by topic and payload, and only within the overlap
+ * window. Identical messages that are published repeatedly are matched
+ * one-for-one, so none of them are lost.
+ *
+ * This isn't thread-safe. It's used by the failover_client under its
+ * own lock.
+ */
+class overlap_filter
+{
+public:
+    /** The clock used for the overlap window */
+    using clock = std::chrono::steady_clock;
+    /** The type for the overlap window */
+    using duration = std::chrono::milliseconds;
+
+private:
+    /** A message seen from one of the sessions */
+    struct entry
+    {
+        /** When the message arrived */
+        clock::time_point time;
+        /** The index of the session that received it */
+        size_t src;
+        /** The message */
+        const_message_ptr msg;
+    };
+
+    /** A message from the standby, held back */
+    struct held
+    {
+        /** When the message arrived */
+        clock::time_point time;
+        /** The index of the session that received it */
+        size_t src;
+        /** The hash of the message */
+        size_t hash;
+        /** The message, or nullptr once it's been matched */
+        const_message_ptr msg;
+    };
+
+    /** How long to look for a matching copy */
+    duration window_;
+    /** Messages delivered from the active session, by hash */
+    std::unordered_multimap<size_t, entry> delivered_;
+    /** The delivered messages, in order of arrival, to expire them */
+    std::deque<std::pair<clock::time_point, size_t>> order_;
+    /** Messages from the standby, waiting for the active copy */
+    std::deque<held> pending_;
+    /** The sequence number of the message at the front of pending_ */
+    uint64_t pendingBase_{0};
+    /** The held messages, by hash, to their sequence numbers */
+    std::unordered_multimap<size_t, uint64_t> pendingIdx_;
+    /** The number of held messages that haven't been matched */
+    size_t nPending_{0};
+    /** The number of duplicate copies that were dropped */
+    uint64_t nDuplicates_{0};
+
+    /** Gets the hash of a message's topic and payload */
+    static size_t hash(const message& msg);
+    /** Determines if two messages have the same topic and payload */
+    static bool same(const message& a, const message& b);
+    /** Removes the entries older than the window */
+    void expire(clock::time_point now);
+    /** Records a delivered message */
+    void record(size_t h, clock::time_point now, size_t src, const_message_ptr msg);
+    /** Removes a copy delivered from another session, if there is one */
+    bool take_delivered(size_t h, const message& msg, size_t src);
+    /** Holds back a message from the standby */
+    void hold(size_t h, clock::time_point now, size_t src, const_message_ptr msg);
+    /** Removes the oldest held message */
+    void pop_pending();
+    /** Removes a matching standby copy, if there is one */
+    bool take_pending(size_t h, const message& msg);
+
+public:
+    /**
+     * Creates a filter.
+     * @param window How long to look for the matching copy of a message.
+     */
+    explicit overlap_filter(duration window) : window_{window} {}
+    /**
+     * Adds a message received by one of the sessions.
+     * @param msg The message.
+     * @param src The index of the session that received it.
+     * @param active Whether that session is the active one.
+     * @return @em true if the message should be delivered now, @em false
+     *  	   if it's a duplicate or is being held back.
+     */
+    bool add(const_message_ptr msg, size_t src, bool active);
+    /**
+     * Releases the messages being held back from the standby session,
+     * when it's promoted to active.
+     * @return The messages that were never delivered by the old active
+     *  	   session, in order of arrival.
+     */
+    std::vector<const_message_ptr> promote();
+    /**
+     * Gets the number of standby messages being held back.
+     * @return The number of standby messages being held back.
+     */
+    size_t num_pending() const { return nPending_; }
+    /**
+     * Gets the number of duplicate copies that were dropped.
+     * @return The number of duplicate copies that were dropped.
+     */
+    uint64_t num_duplicates() const { return nDuplicates_; }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A client with a warm standby connection for fast failover.
+ *
+ * Recovering a lost connection means waiting for the connection lost
+ * callback, then setting up the TCP and TLS connection, sending CONNECT,
+ * and subscribing again, which can take seconds against a distant
+ * broker. This keeps a second client connected and subscribed at all
+ * times, either to an alternate server or to the same one with a
+ * different session (client ID). When the active connection is lost,
+ * the standby is promoted by swapping an index, so publishing and
+ * consuming resume as soon as the loss is noticed. The lost client
+ * reconnects in the background (if its connect options ask for automatic
+ * reconnect) and becomes the new standby.
+ *
+ * Both sessions receive the same messages, so they're merged through an
+ * overlap_filter, and the app gets each message once from a single
+ * queue. Publishing goes through the active client only.
+ *
+ * The failover_client owns both clients and installs its own connection
+ * and message callbacks on them, so the app shouldn't set those.
+ */
+class failover_client
+{
+public:
+    /** The type for the overlap window */
+    using duration = overlap_filter::duration;
+
+    /** The default overlap window for matching duplicate messages */
+    static constexpr duration DFLT_OVERLAP = std::chrono::seconds(2);
+
+    /** How long the destructor waits for each client to disconnect */
+    static constexpr duration DISCONNECT_TIMEOUT = std::chrono::seconds(1);
+
+private:
+    /** Lock guard type for this class */
+    using guard = std::lock_guard<std::mutex>;
+
+    /** Object monitor mutex */
+    std::mutex lock_;
+    /** Merges the messages from the two sessions */
+    overlap_filter filter_;
+    /** The subscriptions to keep on both sessions */
+    std::vector<std::pair<string, int>> subs_;
+    /** The queue of incoming messages for the app */
+    thread_queue<const_message_ptr> que_;
+    /** The index of the active client */
+    std::atomic<size_t> active_{0};
+    /** The number of times the standby was promoted */
+    std::atomic<uint64_t> nFailovers_{0};
+    /**
+     * The primary client. The clients are declared after the state that
+     * their callbacks use, so that they're destroyed before it.
+     */
+    async_client primary_;
+    /** The standby client */
+    async_client standby_;
+
+    /** Non-copyable */
+    failover_client(const failover_client&) = delete;
+    failover_client& operator=(const failover_client&) = delete;
+
+    /** Gets the client at the index */
+    async_client& cli(size_t i) { return i ? standby_ : primary_; }
+    /** Makes the client at the index the active one */
+    void promote(size_t i);
+    /** Callback when one of the clients (re)connects */
+    void on_connected(size_t i);
+    /** Callback when one of the clients loses its connection */
+    void on_connection_lost(size_t i);
+    /** Callback when one of the clients receives a message */
+    void on_message(size_t i, const_message_ptr msg);
+
+public:
+    /**
+     * Creates a client with a warm standby.
+     * @param primary The options to create the primary client.
+     * @param standby The options to create the standby client. If this is
+     *  			  the same server as the primary, it must use a
+     *  			  different client ID.
+     * @param overlap How long to look for the duplicate copy of a message
+     *  			  from the other session.
+     */
+    failover_client(
+        const create_options& primary, const create_options& standby,
+        duration overlap = DFLT_OVERLAP
+    );
+    /**
+     * Destructor.
+     */
+    ~failover_client();
+    /**
+     * Connects both clients.
+     * The standby connects in the background. If it connects before the
+     * primary does, it's promoted right away.
+     * @param primaryOpts The connect options for the primary client.
+     * @param standbyOpts The connect options for the standby client.
+     * @return The token for the primary client's connection.
+     */
+    token_ptr connect(const connect_options& primaryOpts, const connect_options& standbyOpts);
+    /**
+     * Disconnects both clients.
+     * @return The token for the active client's disconnect.
+     */
+    token_ptr disconnect();
+    /**
+     * Determines if the active client is connected.
+     * @return @em true if the active client is connected.
+     */
+    bool is_connected() const {
+        return active_.load() ? standby_.is_connected() : primary_.is_connected();
+    }
+    /**
+     * Gets the index of the active client: zero for the primary and one for
+     * the standby.
+     * @return The index of the active client.
+     */
+    size_t active_index() const { return active_.load(); }
+    /**
+     * Gets the active client.
+     * @return A reference to the active client.
+     */
+    async_client& active() { return cli(active_.load()); }
+    /**
+     * Gets the primary client.
+     * @return A reference to the primary client.
+     */
+    async_client& get_primary() { return primary_; }
+    /**
+     * Gets the standby client.
+     * @return A reference to the standby client.
+     */
+    async_client& get_standby() { return standby_; }
+    /**
+     * Subscribes to a topic on both clients.
+     * The subscription is remembered and made again each time either
+     * client connects.
+     * @param topicFilter The topic filter.
+     * @param qos The quality of service for the subscription.
+     * @return The token for the active client's subscription, or nullptr
+     *  	   if it isn't connected. In that case, the subscription is made
+     *  	   when it connects.
+     */
+    token_ptr subscribe(const string& topicFilter, int qos);
+    /**
+     * Unsubscribes from a topic on both clients.
+     * @param topicFilter The topic filter.
+     * @return The token for the active client's request, or nullptr if it
+     *  	   isn't connected.
+     */
+    token_ptr unsubscribe(const string& topicFilter);
+    /**
+     * Gets the subscriptions kept on both sessions.
+     * @return The topic filters and their QoS.
+     */
+    std::vector<std::pair<string, int>> get_subscriptions();
+    /**
+     * Publishes a message through the active client.
+     * @param msg The message to publish.
+     * @return The delivery token for the message.
+     */
+    delivery_token_ptr publish(const_message_ptr msg) {
+        return active().publish(std::move(msg));
+    }
+    /**
+     * Publishes a message through the active client.
+     * @param topic The topic.
+     * @param payload The message payload.
+     * @param qos The quality of service for the message.
+     * @param retained Whether the broker should retain the message.
+     * @return The delivery token for the message.
+     */
+    delivery_token_ptr publish(
+        string_ref topic, binary_ref payload, int qos = message::DFLT_QOS,
+        bool retained = message::DFLT_RETAINED
+    ) {
+        return publish(message::create(std::move(topic), std::move(payload), qos, retained));
+    }
+    /**
+     * Stops consuming messages.
+     * This closes the queue of incoming messages. Any messages already in
+     * it can still be read, but nothing more is added, and any thread
+     * waiting in consume_message() is released.
+     */
+    void stop_consuming() { que_.close(); }
+    /**
+     * Determines if the queue of incoming messages has been closed.
+     * @return @em true if the queue has been closed, @em false otherwise.
+     */
+    bool consumer_closed() const { return que_.closed(); }
+    /**
+     * Reads the next message from either session, blocking until one
+     * arrives.
+     * @return The next message, or nullptr if the consumer was stopped
+     *  	   and there are no more messages.
+     */
+    const_message_ptr consume_message() {
+        const_message_ptr msg;
+        que_.get(&msg);
+        return msg;
+    }
+    /**
+     * Reads the next message, if one is ready.
+     * @param msg Gets the message, if there is one.
+     * @return @em true if a message was read.
+     */
+    bool try_consume_message(const_message_ptr* msg) { return que_.try_get(msg); }
+    /**
+     * Reads the next message, waiting up to the specified time for one to
+     * arrive.
+     * @param msg Gets the message, if there is one.
+     * @param relTime The maximum time to wait.
+     * @return @em true if a message was read.
+     */
+    template <typename Rep, class Period>
+    bool try_consume_message_for(
+        const_message_ptr* msg, const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        return que_.try_get_for(msg, relTime);
+    }
+    /**
+     * Gets the number of times the standby was promoted.
+     * @return The number of failovers.
+     */
+    uint64_t num_failovers() const { return nFailovers_.load(); }
+    /**
+     * Gets the number of duplicate messages that were dropped.
+     * @return The number of duplicate messages that were dropped.
+     */
+    uint64_t num_duplicates();
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_failover_client_h
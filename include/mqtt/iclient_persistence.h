@@ -91,6 +91,15 @@ public:
     /** Smart/shared pointer to a const object of this class. */
     using const_ptr_t = std::shared_ptr<const iclient_persistence>;
 
+    /**
+     * Gets the C library's persistence interface for a store.
+     * This is what the client hands to the C library, so it can also be
+     * used to drive a store the same way the library does, such as to
+     * test or benchmark it.
+     * @param store The store.
+     * @return The C persistence struct, which calls into the store.
+     */
+    static MQTTClient_persistence c_struct(iclient_persistence* store);
     /**
      * Virtual destructor.
      */
@@ -0,0 +1,181 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file json_view.h
+/// Declaration of MQTT json_view class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_json_view_h
+#define __mqtt_json_view_h
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A lazy, read-only view of a JSON value, such as a message payload.
+ *
+ * Nothing is parsed up front. Each lookup scans just enough of the text
+ * to find the requested member or element, skipping over the values that
+ * aren't needed, and returns another view into the same buffer. So
+ * pulling a few fields out of a payload doesn't allocate any memory or
+ * build a document tree.
+ *
+ * @code
+ * auto js = msg->get_payload_json();
+ * double temp = js["reading"]["temp"].get_double().value_or(0.0);
+ * auto id = js.find("device.id").get_string();
+ * @endcode
+ *
+ * The view doesn't own the text, so it must not outlive the buffer it
+ * refers to (for a payload, the message). The scanner is lenient: it
+ * finds values in well-formed JSON, but doesn't fully validate it. A
+ * lookup in malformed text just fails to find the value.
+ *
+ * Strings are returned as they appear in the text, without decoding
+ * any escape sequences. Use unescape() to get the decoded string, when
+ * needed.
+ */
+class json_view
+{
+public:
+    /** The types of JSON values */
+    enum value_type {
+        NONE,       ///< Not a value (missing or malformed)
+        OBJECT,     ///< An object
+        ARRAY,      ///< An array
+        STRING,     ///< A string
+        NUMBER,     ///< A number
+        BOOLEAN,    ///< true or false
+        NULL_VALUE  ///< null
+    };
+
+private:
+    /** The text of the value, without surrounding whitespace */
+    std::string_view val_;
+
+public:
+    /**
+     * Creates an empty view, which refers to no value.
+     */
+    json_view() {}
+    /**
+     * Creates a view of the JSON value in the text.
+     * @param text The text of a JSON value, which may have surrounding
+     *  		   whitespace.
+     */
+    explicit json_view(std::string_view text);
+    /**
+     * Gets the type of the value.
+     * @return The type of the value, or NONE if this view doesn't refer to
+     *  	   a value.
+     */
+    value_type type() const;
+    /**
+     * Determines if the view refers to a value.
+     * @return @em true if the view refers to a value.
+     */
+    bool exists() const { return !val_.empty(); }
+    /**
+     * Determines if the view refers to a value.
+     * @return @em true if the view refers to a value.
+     */
+    explicit operator bool() const { return exists(); }
+    /**
+     * Gets the raw text of the value.
+     * @return The raw text of the value.
+     */
+    std::string_view raw() const { return val_; }
+    /**
+     * Looks up a member of an object.
+     * @param key The name of the member.
+     * @return A view of the member's value, or an empty view if this isn't
+     *  	   an object or has no such member.
+     */
+    json_view operator[](std::string_view key) const;
+    /**
+     * Looks up a member of an object.
+     * @param key The name of the member.
+     * @return A view of the member's value, or an empty view if this isn't
+     *  	   an object or has no such member.
+     */
+    json_view operator[](const char* key) const { return (*this)[std::string_view{key}]; }
+    /**
+     * Looks up an element of an array.
+     * @param idx The index of the element.
+     * @return A view of the element, or an empty view if this isn't an
+     *  	   array or the index is out of range.
+     */
+    json_view operator[](size_t idx) const;
+    /**
+     * Looks up a nested value by a path of member names and array indexes
+     * separated by dots, like "readings.0.temp".
+     * @param path The path to the value.
+     * @return A view of the value, or an empty view if it isn't found.
+     */
+    json_view find(std::string_view path) const;
+    /**
+     * Gets the number of members of an object or elements of an array.
+     * @return The number of members or elements, or zero for other types.
+     */
+    size_t size() const;
+    /**
+     * Gets the value of a string, as it appears in the text.
+     * @return The contents of the string, without the quotes, or nothing
+     *  	   if the value isn't a string.
+     */
+    std::optional<std::string_view> get_string() const;
+    /**
+     * Gets the value of a number.
+     * @return The value of the number, or nothing if the value isn't a
+     *  	   number.
+     */
+    std::optional<double> get_double() const;
+    /**
+     * Gets the value of an integer.
+     * @return The value of the integer, or nothing if the value isn't a
+     *  	   number or isn't an integer.
+     */
+    std::optional<int64_t> get_int() const;
+    /**
+     * Gets the value of a boolean.
+     * @return The value of the boolean, or nothing if the value isn't
+     *  	   @em true or @em false.
+     */
+    std::optional<bool> get_bool() const;
+    /**
+     * Decodes the escape sequences in a string value.
+     * Unlike the other accessors, this allocates the resulting string.
+     * @return The decoded string, or an empty string if the value isn't a
+     *  	   string.
+     */
+    string unescape() const;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_json_view_h
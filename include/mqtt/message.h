@@ -30,6 +30,7 @@
 #include "MQTTAsync.h"
 #include "mqtt/buffer_ref.h"
 #include "mqtt/exception.h"
+#include "mqtt/json_view.h"
 #include "mqtt/platform.h"
 #include "mqtt/properties.h"
 
@@ -279,6 +280,17 @@ public:
      * Gets the payload as a string
      */
     const string& get_payload_str() const { return payload_ ? payload_.str() : EMPTY_STR; }
+    /**
+     * Gets a lazy JSON view of the payload.
+     * Fields are found by scanning the payload in place when they're
+     * looked up, without copying the payload or building a document.
+     * The view must not outlive the message.
+     * @return A JSON view of the payload.
+     */
+    json_view get_payload_json() const {
+        return payload_ ? json_view{std::string_view{payload_.data(), payload_.size()}}
+                        : json_view{};
+    }
     /**
      * Returns the quality of service for this message.
      * @return The quality of service for this message.
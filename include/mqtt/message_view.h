@@ -0,0 +1,144 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file message_view.h
+/// Declaration of MQTT message_view class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_message_view_h
+#define __mqtt_message_view_h
+
+#include <string_view>
+
+#include "MQTTAsync.h"
+#include "mqtt/properties.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A read-only view of an incoming message, as it was received by the C
+ * library.
+ *
+ * This refers directly to the library's buffers for the topic, payload,
+ * and properties, without copying anything. It's handed to a message
+ * filter to decide whether a message is wanted before the client creates
+ * a message object for it. The view is only valid for the duration of
+ * the filter call.
+ */
+class message_view
+{
+    /** The topic */
+    std::string_view topic_;
+    /** The C message */
+    const MQTTAsync_message& msg_;
+
+    /** Gets the properties as the C library wants them */
+    MQTTProperties* c_props() const { return const_cast<MQTTProperties*>(&msg_.properties); }
+
+public:
+    /**
+     * Creates a view of a message from the C library.
+     * @param topic The topic.
+     * @param msg The C message.
+     */
+    message_view(std::string_view topic, const MQTTAsync_message& msg)
+        : topic_{topic}, msg_{msg} {}
+    /**
+     * Gets the topic of the message.
+     * @return The topic of the message.
+     */
+    std::string_view get_topic() const { return topic_; }
+    /**
+     * Gets the payload of the message.
+     * @return The payload of the message.
+     */
+    std::string_view get_payload() const {
+        return msg_.payload && msg_.payloadlen > 0
+                   ? std::string_view{static_cast<const char*>(msg_.payload),
+                                      size_t(msg_.payloadlen)}
+                   : std::string_view{};
+    }
+    /**
+     * Gets the quality of service of the message.
+     * @return The quality of service of the message.
+     */
+    int get_qos() const { return msg_.qos; }
+    /**
+     * Determines if the message was retained.
+     * @return @em true if the message was retained.
+     */
+    bool is_retained() const { return msg_.retained != 0; }
+    /**
+     * Determines if the message is a duplicate of one that may have been
+     * received before.
+     * @return @em true if the message is a duplicate.
+     */
+    bool is_duplicate() const { return msg_.dup != 0; }
+    /**
+     * Determines if the message has a property.
+     * @param c The property code.
+     * @return @em true if the message has the property.
+     */
+    bool has_property(property::code c) const {
+        return MQTTProperties_hasProperty(c_props(), MQTTPropertyCodes(c)) != 0;
+    }
+    /**
+     * Gets the value of a string property, like the content type or the
+     * response topic.
+     * @param c The property code.
+     * @return The value of the property, or an empty view if the message
+     *  	   doesn't have it.
+     */
+    std::string_view get_string_property(property::code c) const {
+        const MQTTProperty* prop = MQTTProperties_getProperty(c_props(), MQTTPropertyCodes(c));
+        if (!prop || !prop->value.data.data)
+            return std::string_view{};
+        return std::string_view{prop->value.data.data, size_t(prop->value.data.len)};
+    }
+    /**
+     * Gets the value of the first user property with the specified name.
+     * @param name The name of the user property.
+     * @return The value of the user property, or an empty view if the
+     *  	   message doesn't have it.
+     */
+    std::string_view get_user_property(std::string_view name) const {
+        for (int i = 0; i < msg_.properties.count; ++i) {
+            const MQTTProperty& prop = msg_.properties.array[i];
+            if (prop.identifier == MQTTPROPERTY_CODE_USER_PROPERTY &&
+                name ==
+                    std::string_view{prop.value.data.data, size_t(prop.value.data.len)}) {
+                return std::string_view{prop.value.value.data, size_t(prop.value.value.len)};
+            }
+        }
+        return std::string_view{};
+    }
+    /**
+     * Gets the underlying C message struct.
+     * @return The underlying C message struct.
+     */
+    const MQTTAsync_message& c_struct() const { return msg_; }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_message_view_h
@@ -0,0 +1,350 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file ordered_stage.h
+/// Implementation of the template class 'ordered_stage', a processing
+/// stage that runs a transform on incoming messages in parallel while
+/// keeping the results in order for each key.
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_ordered_stage_h
+#define __mqtt_ordered_stage_h
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "mqtt/message.h"
+#include "mqtt/properties.h"
+#include "mqtt/thread_queue.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A processing stage that fans incoming messages out to a pool of worker
+ * threads to be transformed, then hands the results to a sink in the
+ * order the messages arrived, per key.
+ *
+ * This is meant for CPU-heavy work on consumed messages, like decoding
+ * payloads, that would otherwise be serialized on the consumer thread.
+ * Each message is assigned a key (by default its topic), and a sequence
+ * number within that key. The results for each key are held in a bounded
+ * reorder buffer until all the earlier ones are done, so results for any
+ * one key always reach the sink in order, while different keys proceed
+ * independently.
+ *
+ * When a key has the maximum number of messages in flight, put() blocks
+ * until the oldest one for that key is delivered to the sink. This keeps
+ * memory bounded if one key gets far ahead of the sink.
+ *
+ * The sink is called from the worker threads. It is never called
+ * concurrently for the same key, but may be called concurrently for
+ * different keys.
+ *
+ * @code
+ * mqtt::ordered_stage<reading> stage{4, decode, store};
+ * while (auto msg = cli.consume_message())
+ *     stage.put(msg);
+ * stage.close();
+ * @endcode
+ *
+ * @tparam R The type of the result of the transform.
+ */
+template <typename R>
+class ordered_stage
+{
+public:
+    /** The type of the result of the transform */
+    using result_type = R;
+    /** The transform run on each message by the workers */
+    using transform_type = std::function<R(const_message_ptr)>;
+    /** The sink that receives each message and its result, in order */
+    using sink_type = std::function<void(const_message_ptr, R)>;
+    /** The function that gets the ordering key for a message */
+    using key_function = std::function<string(const message&)>;
+
+    /** The default maximum number of messages in flight for a key */
+    static constexpr size_t DFLT_MAX_REORDER = 64;
+
+private:
+    /** Lock guard type for this class */
+    using guard = std::lock_guard<std::mutex>;
+    /** Unique lock type for this class */
+    using unique_lock = std::unique_lock<std::mutex>;
+
+    /** A slot in a reorder buffer */
+    struct slot
+    {
+        /** The message */
+        const_message_ptr msg;
+        /** The result, if the transform succeeded */
+        std::optional<R> res;
+        /** Whether the worker is done with the message */
+        bool ready{false};
+    };
+
+    /** The sequencing state for a single key */
+    struct key_state
+    {
+        /** The next sequence number to assign */
+        uint64_t nextSeq{0};
+        /** The next sequence number to hand to the sink */
+        uint64_t nextEmit{0};
+        /** Whether a worker is currently handing results to the sink */
+        bool emitting{false};
+        /** The number of producers waiting for room in the buffer */
+        size_t nWaiters{0};
+        /** The key, as held by the map */
+        const string* key{nullptr};
+        /** The reorder buffer, indexed by sequence number */
+        std::vector<slot> slots;
+    };
+
+    /** A unit of work for the pool */
+    struct job
+    {
+        /** The message */
+        const_message_ptr msg;
+        /** The state of the message's key */
+        key_state* ks{nullptr};
+        /** The sequence number of the message within its key */
+        uint64_t seq{0};
+    };
+
+    /** Object monitor mutex */
+    std::mutex lock_;
+    /** Signaled when a reorder buffer has room */
+    std::condition_variable spaceCond_;
+    /** The user transform */
+    transform_type xform_;
+    /** The user sink */
+    sink_type sink_;
+    /** The key function */
+    key_function keyFn_;
+    /** The size of each reorder buffer */
+    size_t maxReorder_;
+    /** The sequencing state for the keys with messages in flight */
+    std::unordered_map<string, key_state> keys_;
+    /** The number of transforms that threw an exception */
+    uint64_t nErrors_{0};
+    /** The work queue */
+    thread_queue<job> jobs_;
+    /** The worker threads */
+    std::vector<std::thread> workers_;
+
+    /** Non-copyable */
+    ordered_stage(const ordered_stage&) = delete;
+    ordered_stage& operator=(const ordered_stage&) = delete;
+
+    /** The worker thread function */
+    void run() {
+        job jb;
+        while (jobs_.get(&jb)) {
+            std::optional<R> res;
+            try {
+                res.emplace(xform_(jb.msg));
+            }
+            catch (...) {
+            }
+            complete(jb, std::move(res));
+        }
+    }
+
+    /**
+     * Places the result for a message into its reorder buffer, then hands
+     * any results that are now in order to the sink. Only one thread at a
+     * time drains the buffer for a key; others just deposit their results.
+     */
+    void complete(job& jb, std::optional<R>&& res) {
+        key_state& ks = *jb.ks;
+        unique_lock g(lock_);
+
+        if (!res)
+            ++nErrors_;
+
+        slot& s = ks.slots[jb.seq % maxReorder_];
+        s.msg = std::move(jb.msg);
+        s.res = std::move(res);
+        s.ready = true;
+
+        if (ks.emitting)
+            return;
+
+        ks.emitting = true;
+        for (;;) {
+            slot& next = ks.slots[ks.nextEmit % maxReorder_];
+            if (!next.ready)
+                break;
+
+            auto msg = std::move(next.msg);
+            auto val = std::move(next.res);
+            next.ready = false;
+            next.res.reset();
+            ++ks.nextEmit;
+            spaceCond_.notify_all();
+
+            if (val) {
+                g.unlock();
+                try {
+                    sink_(std::move(msg), std::move(*val));
+                }
+                catch (...) {
+                }
+                g.lock();
+            }
+        }
+        ks.emitting = false;
+
+        // Drop the state for keys that have gone idle. A producer waiting
+        // for room still holds a reference to it, though.
+        if (ks.nextEmit == ks.nextSeq && ks.nWaiters == 0)
+            keys_.erase(keys_.find(*ks.key));
+    }
+
+public:
+    /**
+     * Creates the stage and starts the worker threads.
+     * @param nWorkers The number of worker threads.
+     * @param xform The transform to run on each message.
+     * @param sink The sink for the results.
+     * @param keyFn The function to get the ordering key for a message.
+     * @param maxReorder The maximum number of messages in flight for any
+     *  				 one key.
+     */
+    ordered_stage(
+        size_t nWorkers, transform_type xform, sink_type sink,
+        key_function keyFn = by_topic(), size_t maxReorder = DFLT_MAX_REORDER
+    )
+        : xform_{std::move(xform)},
+          sink_{std::move(sink)},
+          keyFn_{std::move(keyFn)},
+          maxReorder_{maxReorder ? maxReorder : 1} {
+        if (nWorkers == 0)
+            nWorkers = 1;
+        for (size_t i = 0; i < nWorkers; ++i) workers_.emplace_back(&ordered_stage::run, this);
+    }
+    /**
+     * Closes the stage, waiting for all the messages that were put into
+     * it to reach the sink.
+     */
+    ~ordered_stage() { close(); }
+    /**
+     * Gets a key function that orders messages by topic.
+     * @return A key function that orders messages by topic.
+     */
+    static key_function by_topic() {
+        return [](const message& msg) { return msg.get_topic(); };
+    }
+    /**
+     * Gets a key function that orders messages by the value of an MQTT v5
+     * user property, like a device ID. Messages without the property are
+     * ordered by topic.
+     * @param name The name of the user property.
+     * @return A key function that orders messages by the user property.
+     */
+    static key_function by_user_property(const string& name) {
+        return [name](const message& msg) {
+            const auto& props = msg.get_properties();
+            size_t n = props.count(property::USER_PROPERTY);
+            for (size_t i = 0; i < n; ++i) {
+                auto kv = get<string_pair>(props, property::USER_PROPERTY, i);
+                if (std::get<0>(kv) == name)
+                    return std::get<1>(kv);
+            }
+            return msg.get_topic();
+        };
+    }
+    /**
+     * Puts a message into the stage.
+     * This blocks if the message's key already has the maximum number of
+     * messages in flight.
+     * @param msg The message.
+     * @throw queue_closed if the stage was closed.
+     */
+    void put(const_message_ptr msg) {
+        if (!msg)
+            return;
+
+        auto key = keyFn_(*msg);
+        unique_lock g(lock_);
+
+        if (jobs_.closed())
+            throw queue_closed{};
+
+        // The state is only erased when the key has nothing in flight and
+        // no producers waiting, so it's still valid after waiting for space.
+        auto p = keys_.try_emplace(std::move(key)).first;
+        auto& ks = p->second;
+        if (ks.slots.empty()) {
+            ks.slots.resize(maxReorder_);
+            ks.key = &p->first;
+        }
+
+        if (ks.nextSeq - ks.nextEmit >= maxReorder_) {
+            ++ks.nWaiters;
+            spaceCond_.wait(g, [this, &ks] {
+                return ks.nextSeq - ks.nextEmit < maxReorder_;
+            });
+            --ks.nWaiters;
+        }
+
+        uint64_t seq = ks.nextSeq++;
+        g.unlock();
+
+        jobs_.put(job{std::move(msg), &ks, seq});
+    }
+    /**
+     * Closes the stage, waiting for all the messages that were put into
+     * it to reach the sink, and stops the worker threads.
+     */
+    void close() {
+        jobs_.close();
+        for (auto& thr : workers_) {
+            if (thr.joinable())
+                thr.join();
+        }
+    }
+    /**
+     * Gets the number of workers in the pool.
+     * @return The number of workers in the pool.
+     */
+    size_t num_workers() const { return workers_.size(); }
+    /**
+     * Gets the number of messages for which the transform threw an
+     * exception. These messages are skipped, and don't reach the sink.
+     * @return The number of failed transforms.
+     */
+    uint64_t num_errors() {
+        guard g(lock_);
+        return nErrors_;
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_ordered_stage_h
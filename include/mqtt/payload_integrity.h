@@ -0,0 +1,144 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file payload_integrity.h
+/// Checksums to detect corrupted message payloads
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_payload_integrity_h
+#define __mqtt_payload_integrity_h
+
+#include <cstddef>
+#include <cstdint>
+
+#include "MQTTAsync.h"
+#include "mqtt/message_view.h"
+#include "mqtt/properties.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Computes the CRC-32C (Castagnoli) checksum of a block of data.
+ *
+ * This uses the CPU's CRC instructions, if it has them: SSE 4.2 on x86-64,
+ * checked at run time, or the ARMv8 CRC extension, if the library was
+ * built for a CPU with it. Otherwise it uses a table-driven software
+ * version.
+ *
+ * The checksum can be computed in pieces, by passing the result for the
+ * first part of the data as the starting value for the rest.
+ *
+ * @param data The data.
+ * @param n The number of bytes of data.
+ * @param crc The checksum of any preceding data, or zero to start.
+ * @return The checksum.
+ */
+uint32_t crc32c(const void* data, size_t n, uint32_t crc = 0) noexcept;
+
+/**
+ * Computes the CRC-32C checksum of a block of data in software, without
+ * the CPU's CRC instructions.
+ * This gives the same results as crc32c(), just more slowly.
+ * @param data The data.
+ * @param n The number of bytes of data.
+ * @param crc The checksum of any preceding data, or zero to start.
+ * @return The checksum.
+ */
+uint32_t crc32c_sw(const void* data, size_t n, uint32_t crc = 0) noexcept;
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Checksums to detect payloads corrupted along the way.
+ *
+ * MQTT relies on TCP to keep the data intact, which it does well enough on
+ * a single hop. But a payload can still be damaged by a flaky link that
+ * gets past the TCP checksum, or by a bridge or gateway that mangles it.
+ *
+ * This attaches the CRC-32C of the payload to a message as an MQTT v5 user
+ * property, named "crc32c", with the value in eight hex digits. The
+ * receiver computes the checksum again and compares. Messages without the
+ * property, like those from other publishers, can't be checked.
+ *
+ * The client does this automatically when payload integrity is turned on,
+ * with async_client::set_payload_integrity(). These functions can be used
+ * to do it by hand.
+ */
+class payload_integrity
+{
+public:
+    /** The name of the user property with the checksum */
+    static constexpr const char* PROPERTY_NAME = "crc32c";
+    /** The number of characters in the checksum value */
+    static constexpr size_t VALUE_LEN = 8;
+
+    /** The result of checking a message */
+    enum result
+    {
+        /** The message has no checksum */
+        UNCHECKED,
+        /** The checksum matches the payload */
+        VALID,
+        /** The checksum doesn't match the payload */
+        CORRUPT
+    };
+
+    /**
+     * Formats a checksum as the value of the user property.
+     * @param crc The checksum.
+     * @param buf A buffer for the value, at least VALUE_LEN characters. It
+     *  		  isn't NUL-terminated.
+     */
+    static void format(uint32_t crc, char* buf) noexcept;
+    /**
+     * Adds the checksum for a payload to a set of properties.
+     * @param props The properties.
+     * @param payload The payload.
+     * @param n The size of the payload, in bytes.
+     */
+    static void add(properties& props, const void* payload, size_t n);
+    /**
+     * Adds the checksum for a payload to a set of C properties.
+     * @param props The C properties.
+     * @param payload The payload.
+     * @param n The size of the payload, in bytes.
+     */
+    static void add(MQTTProperties& props, const void* payload, size_t n);
+    /**
+     * Determines if a set of properties already has a checksum.
+     * @param props The C properties.
+     * @return @em true if the properties have a checksum, @em false if not.
+     */
+    static bool has_checksum(const MQTTProperties& props) noexcept;
+    /**
+     * Checks the payload of a message against its checksum.
+     * @param msg A view of the message.
+     * @return Whether the message has a checksum, and if so, whether it
+     *  	   matches the payload.
+     */
+    static result check(const message_view& msg) noexcept;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_payload_integrity_h
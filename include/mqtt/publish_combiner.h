@@ -0,0 +1,195 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file publish_combiner.h
+/// Declaration of MQTT publish_combiner class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_publish_combiner_h
+#define __mqtt_publish_combiner_h
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+
+#include "mqtt/delivery_token.h"
+#include "mqtt/iasync_client.h"
+#include "mqtt/message.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A front-end for publishing from many threads through a single client,
+ * using flat combining.
+ *
+ * When many threads publish through a client at the same time, they all
+ * contend for the locks inside the client and the C library, and the
+ * throughput collapses as more threads are added. With the combiner, each
+ * thread posts its request to a shared list, and whichever thread gets the
+ * combiner lock sends the whole batch of pending requests to the client
+ * on behalf of the others. The rest spin briefly, then sleep, until their
+ * own request has been sent. So only one thread at a time calls into the
+ * client, and its locks and data stay hot in that thread's cache.
+ *
+ * A thread only acts as the combiner for a few batches, so that its own
+ * call can return under a steady load. Then it hands the role to one of
+ * the threads with a request still pending. Sleeping threads are woken
+ * individually, when their request is done or they're to take over.
+ *
+ * Each call blocks only until its message has been handed to the client,
+ * not until it is delivered. The returned token can be used to wait for
+ * delivery, as usual. An error from the client is thrown from the call
+ * that made the request, in the thread that made it.
+ *
+ * @code
+ * mqtt::publish_combiner pub{cli};
+ * // In each producer thread:
+ * auto tok = pub.publish(mqtt::make_message(topic, payload, 1, false));
+ * @endcode
+ */
+class publish_combiner
+{
+public:
+    /** The default number of times to spin before sleeping */
+    static constexpr unsigned DFLT_SPIN_COUNT = 64;
+    /** The most batches a thread sends before handing off the combiner */
+    static constexpr unsigned MAX_PASSES = 4;
+
+    /** Statistics about the batches sent by the combiner */
+    struct stats
+    {
+        /** The number of messages sent */
+        uint64_t messages{0};
+        /** The number of batches sent */
+        uint64_t batches{0};
+        /** The largest batch */
+        uint64_t maxBatch{0};
+    };
+
+private:
+    /** Lock guard type for this class */
+    using guard = std::lock_guard<std::mutex>;
+    /** Unique lock type for this class */
+    using unique_lock = std::unique_lock<std::mutex>;
+
+    /** A publish request. This lives on the requesting thread's stack. */
+    struct request
+    {
+        /** The message to send */
+        const_message_ptr msg;
+        /** The token from the client */
+        delivery_token_ptr tok;
+        /** The error from the client, if any */
+        std::exception_ptr err;
+        /** The next request in the pending list */
+        request* next{nullptr};
+        /** Set when the request has been sent */
+        std::atomic<bool> done{false};
+        /** Whether the thread is sleeping (guarded by waitLock_) */
+        bool sleeping{false};
+        /** Set when the thread should take over as the combiner (guarded by waitLock_) */
+        bool handoff{false};
+        /** Signals the sleeping thread */
+        std::condition_variable cond;
+    };
+
+    /** The client */
+    iasync_client& cli_;
+    /** The number of times to spin before sleeping */
+    unsigned spinCount_;
+    /** The pending requests, most recent first */
+    std::atomic<request*> head_{nullptr};
+    /** Held by the thread acting as the combiner */
+    std::mutex combLock_;
+    /** Whether a thread is acting as the combiner (set to false under waitLock_) */
+    std::atomic<bool> busy_{false};
+    /** Mutex for sleeping threads */
+    std::mutex waitLock_;
+    /** The counters */
+    std::atomic<uint64_t> nMessages_{0}, nBatches_{0}, maxBatch_{0};
+
+    /** Non-copyable */
+    publish_combiner(const publish_combiner&) = delete;
+    publish_combiner& operator=(const publish_combiner&) = delete;
+
+    /**
+     * Sends the pending requests, for up to MAX_PASSES batches. Called
+     * with the combiner lock.
+     */
+    void combine();
+    /**
+     * Gives up the combiner role, waking a thread with a pending request
+     * to take it over. Called with the combiner lock.
+     */
+    void hand_off();
+
+public:
+    /**
+     * Creates a combiner for publishing through a client.
+     * @param cli The client. This must outlive the combiner.
+     * @param spinCount The number of times a waiting thread checks for its
+     *  				request to complete before going to sleep.
+     */
+    explicit publish_combiner(iasync_client& cli, unsigned spinCount = DFLT_SPIN_COUNT)
+        : cli_(cli), spinCount_(spinCount) {}
+    /**
+     * Publishes a message through the client.
+     * This blocks until the message has been handed to the client, either
+     * by this thread, or by another one that is combining requests.
+     * @param msg The message to publish.
+     * @return The token to track the delivery of the message.
+     * @throw exception if the client rejected the message.
+     */
+    delivery_token_ptr publish(const_message_ptr msg);
+    /**
+     * Publishes a message through the client.
+     * @param topic The topic to deliver the message to.
+     * @param payload The payload for the message.
+     * @param qos The quality of service for the message.
+     * @param retained Whether the message should be retained.
+     * @return The token to track the delivery of the message.
+     * @throw exception if the client rejected the message.
+     */
+    delivery_token_ptr publish(
+        string_ref topic, binary_ref payload, int qos = message::DFLT_QOS,
+        bool retained = message::DFLT_RETAINED
+    ) {
+        return publish(message::create(std::move(topic), std::move(payload), qos, retained));
+    }
+    /**
+     * Gets the client.
+     * @return A reference to the client.
+     */
+    iasync_client& get_client() { return cli_; }
+    /**
+     * Gets a snapshot of the batch statistics.
+     * @return The batch statistics.
+     */
+    stats get_stats() const;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_publish_combiner_h
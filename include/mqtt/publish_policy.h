@@ -0,0 +1,259 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file publish_policy.h
+/// Declaration of the MQTT publish_policy class for load shedding.
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_publish_policy_h
+#define __mqtt_publish_policy_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#include "mqtt/message.h"
+#include "mqtt/topic.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A policy to degrade outgoing traffic gracefully when the client falls
+ * behind.
+ *
+ * The policy is a list of rules for designated low-value topics. Each
+ * rule has a topic filter and an action to take for matching messages
+ * while the client is overloaded: downgrade them to QoS 0, keep only one
+ * out of every N of them, or drop them entirely. Topics that don't match
+ * any rule are treated as critical and are always published as
+ * requested. The first rule that matches a topic is the one that applies.
+ *
+ * The client is considered overloaded when the number of outstanding
+ * deliveries reaches the backlog limit, or when the average time to
+ * complete a delivery reaches the latency limit. Either limit can be
+ * left disabled.
+ *
+ * The rules and limits should be set up before the policy is installed
+ * in a client. After that, the policy can be used from any thread.
+ */
+class publish_policy
+{
+public:
+    /** Smart/shared pointer to an object of this class */
+    using ptr_t = std::shared_ptr<publish_policy>;
+    /** Smart/shared pointer to a const object of this class */
+    using const_ptr_t = std::shared_ptr<const publish_policy>;
+    /** The type for the latency limit and measurements */
+    using duration = std::chrono::microseconds;
+
+    /**
+     * The return code for the token of a message that the policy dropped.
+     * It's outside the range of the C library's error codes, so a shed
+     * message can't be mistaken for a full offline buffer
+     * (MQTTASYNC_MAX_BUFFERED_MESSAGES).
+     */
+    static constexpr int DROPPED = -1000;
+
+    /** What to do with a low-value message while overloaded */
+    enum shed_mode {
+        DOWNGRADE,  ///< Publish at QoS 0
+        SAMPLE,     ///< Publish one message out of every N, drop the rest
+        SHED        ///< Drop the message
+    };
+
+    /** The decision for a single message */
+    enum decision {
+        PUBLISH,       ///< Publish the message as is
+        PUBLISH_QOS0,  ///< Publish the message at QoS 0
+        DROP           ///< Don't publish the message
+    };
+
+    /** Counts of the decisions made by the policy */
+    struct metrics
+    {
+        /** Messages published as requested */
+        uint64_t published{0};
+        /** Messages downgraded to QoS 0 */
+        uint64_t downgraded{0};
+        /** Messages dropped by sampling */
+        uint64_t sampledOut{0};
+        /** Messages shed entirely */
+        uint64_t shed{0};
+    };
+
+private:
+    /** A rule for a set of low-value topics */
+    struct rule
+    {
+        /** The topics to which the rule applies */
+        topic_filter filter;
+        /** What to do while overloaded */
+        shed_mode mode;
+        /** For sampling, the one-in-N rate */
+        unsigned sampleRate;
+        /** For sampling, the number of messages seen while overloaded */
+        std::atomic<uint64_t> count{0};
+
+        rule(const string& filt, shed_mode m, unsigned n)
+            : filter{filt}, mode{m}, sampleRate{n ? n : 1} {}
+    };
+
+    /** The rules, in order. A deque, since the rules aren't movable. */
+    std::deque<rule> rules_;
+    /** The number of outstanding deliveries considered overloaded */
+    size_t maxBacklog_{0};
+    /** The average delivery latency considered overloaded */
+    duration maxLatency_{0};
+    /** Moving average of the delivery latency, in microseconds */
+    std::atomic<int64_t> latency_{0};
+
+    /** The counters */
+    std::atomic<uint64_t> published_{0}, downgraded_{0}, sampledOut_{0}, shed_{0};
+
+    /** Finds the rule for the topic, if any */
+    rule* find_rule(const string& topic);
+
+public:
+    /**
+     * Creates a policy with no rules and no limits.
+     * This publishes everything as requested.
+     */
+    publish_policy() {}
+    /**
+     * Creates a shared policy object.
+     * @return A shared pointer to a new policy.
+     */
+    static ptr_t create() { return std::make_shared<publish_policy>(); }
+    /**
+     * Sets the number of outstanding deliveries at which the client is
+     * considered overloaded.
+     * @param n The backlog limit, or zero to disable it.
+     * @return A reference to this object.
+     */
+    publish_policy& max_backlog(size_t n) {
+        maxBacklog_ = n;
+        return *this;
+    }
+    /**
+     * Sets the average delivery latency at which the client is considered
+     * overloaded.
+     * @param d The latency limit, or zero to disable it.
+     * @return A reference to this object.
+     */
+    template <class Rep, class Period>
+    publish_policy& max_latency(const std::chrono::duration<Rep, Period>& d) {
+        maxLatency_ = std::chrono::duration_cast<duration>(d);
+        return *this;
+    }
+    /**
+     * Adds a rule to downgrade matching messages to QoS 0 while the client
+     * is overloaded.
+     * @param filter The topic filter for the low-value topics.
+     * @return A reference to this object.
+     */
+    publish_policy& downgrade(const string& filter) {
+        rules_.emplace_back(filter, DOWNGRADE, 1);
+        return *this;
+    }
+    /**
+     * Adds a rule to keep only one out of every @em n matching messages
+     * while the client is overloaded.
+     * @param filter The topic filter for the low-value topics.
+     * @param n The sampling rate.
+     * @return A reference to this object.
+     */
+    publish_policy& sample(const string& filter, unsigned n) {
+        rules_.emplace_back(filter, SAMPLE, n);
+        return *this;
+    }
+    /**
+     * Adds a rule to drop matching messages while the client is
+     * overloaded.
+     * @param filter The topic filter for the low-value topics.
+     * @return A reference to this object.
+     */
+    publish_policy& shed(const string& filter) {
+        rules_.emplace_back(filter, SHED, 0);
+        return *this;
+    }
+    /**
+     * Gets the backlog limit.
+     * @return The backlog limit, or zero if disabled.
+     */
+    size_t get_max_backlog() const { return maxBacklog_; }
+    /**
+     * Gets the latency limit.
+     * @return The latency limit, or zero if disabled.
+     */
+    duration get_max_latency() const { return maxLatency_; }
+    /**
+     * Gets the moving average of the delivery latency.
+     * @return The average time to complete a delivery.
+     */
+    duration get_latency() const {
+        return duration{latency_.load(std::memory_order_relaxed)};
+    }
+    /**
+     * Determines if the client would be considered overloaded.
+     * @param backlog The number of outstanding deliveries.
+     * @return @em true if either limit has been reached.
+     */
+    bool is_overloaded(size_t backlog) const {
+        return (maxBacklog_ != 0 && backlog >= maxBacklog_) ||
+               (maxLatency_.count() != 0 && get_latency() >= maxLatency_);
+    }
+    /**
+     * Decides what to do with an outgoing message, and counts the
+     * decision.
+     * @param msg The message.
+     * @param backlog The number of outstanding deliveries.
+     * @return The decision for the message.
+     */
+    decision decide(const message& msg, size_t backlog);
+    /**
+     * Updates the latency average with a completed delivery.
+     * The client only reports QoS 1 and 2 deliveries, since a QoS 0
+     * publish completes as soon as it's written, and would hide the
+     * acknowledgment delay that signals an overload.
+     * @param latency The time taken to complete the delivery.
+     */
+    void on_delivered(duration latency);
+    /**
+     * Gets a snapshot of the decision counts.
+     * @return The decision counts.
+     */
+    metrics get_metrics() const;
+    /**
+     * Resets the decision counts to zero.
+     */
+    void reset_metrics();
+};
+
+/** Smart/shared pointer to a publish policy */
+using publish_policy_ptr = publish_policy::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_publish_policy_h
@@ -0,0 +1,149 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file publish_template.h
+/// Declaration of MQTT publish_template class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_publish_template_h
+#define __mqtt_publish_template_h
+
+#include "MQTTAsync.h"
+#include "mqtt/buffer_ref.h"
+#include "mqtt/message.h"
+#include "mqtt/properties.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A prepared set of publish parameters for sending a stream of messages
+ * that differ only in their payload.
+ *
+ * The topic, QoS, retained flag, and MQTT v5 properties are validated and
+ * laid out in the C message struct once, when the template is created.
+ * Each publish through the template then just fills in the payload
+ * pointer and length on a copy of that struct, without creating a
+ * message object or copying the properties on the C++ side.
+ *
+ * @code
+ * mqtt::publish_template tmpl{
+ *     "sensors/temp", 1, false,
+ *     {{mqtt::property::CONTENT_TYPE, "application/json"},
+ *      {mqtt::property::MESSAGE_EXPIRY_INTERVAL, 60}}
+ * };
+ * for (const auto& rec : records)
+ *     cli.publish(tmpl, rec.data(), rec.size());
+ * @endcode
+ *
+ * The template must outlive any publish call that uses it, but not the
+ * operation itself, since the C library copies what it needs before the
+ * call returns.
+ */
+class publish_template
+{
+    /** Initializer for the C struct (from the C library) */
+    static constexpr MQTTAsync_message DFLT_C_STRUCT MQTTAsync_message_initializer;
+
+    /** The topic */
+    string_ref topic_;
+    /** The properties */
+    properties props_;
+    /** The prepared C message struct, with no payload */
+    MQTTAsync_message msg_{DFLT_C_STRUCT};
+
+    /** The client has special access. */
+    friend class async_client;
+
+public:
+    /**
+     * Creates a template for publishing on the specified topic.
+     * @param topic The topic.
+     * @param qos The quality of service for the messages.
+     * @param retained Whether the messages should be retained.
+     * @param props The MQTT v5 properties for the messages.
+     * @throw exception if the QoS is invalid.
+     */
+    publish_template(
+        string_ref topic, int qos = message::DFLT_QOS, bool retained = message::DFLT_RETAINED,
+        const properties& props = properties()
+    );
+    /**
+     * Creates a template for publishing on the specified topic.
+     * @param topic The topic.
+     * @param qos The quality of service for the messages.
+     * @param retained Whether the messages should be retained.
+     * @param props The MQTT v5 properties for the messages.
+     * @throw exception if the QoS is invalid.
+     */
+    publish_template(string_ref topic, int qos, bool retained, properties&& props);
+    /**
+     * Copy constructor.
+     * @param other The other template.
+     */
+    publish_template(const publish_template& other);
+    /**
+     * Copy assignment.
+     * @param rhs The other template.
+     * @return A reference to this object.
+     */
+    publish_template& operator=(const publish_template& rhs);
+/**
+ * Expose the underlying C struct for the unit tests.
+ */
+#if defined(UNIT_TESTS)
+    const MQTTAsync_message& c_struct() const { return msg_; }
+#endif
+    /**
+     * Gets the topic for the messages.
+     * @return The topic string for the messages.
+     */
+    const string& get_topic() const { return topic_.str(); }
+    /**
+     * Gets the quality of service for the messages.
+     * @return The quality of service for the messages.
+     */
+    int get_qos() const { return msg_.qos; }
+    /**
+     * Determines if the messages will be retained.
+     * @return @em true if the messages will be retained.
+     */
+    bool is_retained() const { return to_bool(msg_.retained); }
+    /**
+     * Gets the properties for the messages.
+     * @return The properties for the messages.
+     */
+    const properties& get_properties() const { return props_; }
+    /**
+     * Creates a full message from the template.
+     * This is only needed when a message object is required, since it
+     * copies the properties.
+     * @param payload The payload for the message.
+     * @return A message with the template's parameters and the payload.
+     */
+    message_ptr to_message(binary_ref payload) const {
+        return message::create(topic_, std::move(payload), get_qos(), is_retained(), props_);
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_publish_template_h
@@ -0,0 +1,502 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file stream_ops.h
+/// Composable operators to process the stream of messages from the
+/// consumer queue.
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_stream_ops_h
+#define __mqtt_stream_ops_h
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mqtt/message.h"
+#include "mqtt/topic.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/**
+ * Operators to process a stream of consumed messages.
+ *
+ * The operators are chained together with the '|' operator into a
+ * pipeline, then the pipeline is bound to a final function (the sink) to
+ * create a single, fused stage object. Each operator becomes a layer of
+ * that object, and a value is passed from one layer to the next with a
+ * direct, inlineable call. There are no intermediate queues, threads, or
+ * virtual calls.
+ *
+ * @code
+ * auto pipeline = mqtt::ops::filter_topic("sensors/+/temp")
+ *               | mqtt::ops::map([](const mqtt::const_message_ptr& msg) {
+ *                     return std::stod(msg->to_string());
+ *                 })
+ *               | mqtt::ops::batch(100, std::chrono::milliseconds(50));
+ *
+ * // Run the loop on this thread until the consumer is stopped.
+ * mqtt::ops::run(cli, pipeline, [](std::vector<double> temps) {
+ *     store(temps);
+ * });
+ * @endcode
+ *
+ * Each stage object is for a single thread. To spread the work over
+ * several threads, run the same pipeline on each of them. Each gets its
+ * own stage, pulling from the shared consumer queue.
+ *
+ * A stage has three operations:
+ *   @li push(value) - Passes a value into the stage.
+ *   @li tick(now) - Lets the time-based operators close any windows or
+ *   	 batches that have expired.
+ *   @li finish() - Flushes any partial batches at the end of the stream.
+ */
+namespace ops {
+
+/** The clock used for the time-based operators */
+using clock = std::chrono::steady_clock;
+/** The type for the time-based operator intervals */
+using duration = clock::duration;
+
+/** The base for all operators, to identify them for chaining */
+struct op_base
+{
+};
+
+/** Determines if a type is a stream operator */
+template <typename T>
+using is_op = std::is_base_of<op_base, std::decay_t<T>>;
+
+// --------------------------------------------------------------------------
+// Stages
+
+/**
+ * The final stage of a pipeline, which hands each value to a function.
+ */
+template <typename F>
+class sink_stage
+{
+    F fn_;
+
+public:
+    explicit sink_stage(F fn) : fn_{std::move(fn)} {}
+
+    template <typename T>
+    void push(T&& val) {
+        fn_(std::forward<T>(val));
+    }
+    void tick(clock::time_point) {}
+    void finish() {}
+};
+
+/** A stage that passes along the values that match a predicate. */
+template <typename Pred, typename Next>
+class filter_stage
+{
+    Pred pred_;
+    Next next_;
+
+public:
+    filter_stage(Pred pred, Next next) : pred_{std::move(pred)}, next_{std::move(next)} {}
+
+    template <typename T>
+    void push(T&& val) {
+        if (pred_(val))
+            next_.push(std::forward<T>(val));
+    }
+    void tick(clock::time_point now) { next_.tick(now); }
+    void finish() { next_.finish(); }
+};
+
+/** A stage that passes along the result of a function on each value. */
+template <typename F, typename Next>
+class map_stage
+{
+    F fn_;
+    Next next_;
+
+public:
+    map_stage(F fn, Next next) : fn_{std::move(fn)}, next_{std::move(next)} {}
+
+    template <typename T>
+    void push(T&& val) {
+        next_.push(fn_(std::forward<T>(val)));
+    }
+    void tick(clock::time_point now) { next_.tick(now); }
+    void finish() { next_.finish(); }
+};
+
+/**
+ * A stage that collects values into batches, passing a batch along when
+ * it's full or when its oldest value has waited for the maximum time.
+ */
+template <typename T, typename Next>
+class batch_stage
+{
+    size_t maxSize_;
+    duration maxAge_;
+    std::vector<T> buf_;
+    clock::time_point first_;
+    Next next_;
+
+    void emit() {
+        std::vector<T> out;
+        out.reserve(maxSize_);
+        out.swap(buf_);
+        next_.push(std::move(out));
+    }
+
+public:
+    batch_stage(size_t maxSize, duration maxAge, Next next)
+        : maxSize_{maxSize ? maxSize : 1}, maxAge_{maxAge}, next_{std::move(next)} {
+        buf_.reserve(maxSize_);
+    }
+
+    template <typename U>
+    void push(U&& val) {
+        if (buf_.empty() && maxAge_.count() > 0)
+            first_ = clock::now();
+        buf_.push_back(std::forward<U>(val));
+        if (buf_.size() >= maxSize_)
+            emit();
+    }
+    void tick(clock::time_point now) {
+        if (!buf_.empty() && maxAge_.count() > 0 && now - first_ >= maxAge_)
+            emit();
+        next_.tick(now);
+    }
+    void finish() {
+        if (!buf_.empty())
+            emit();
+        next_.finish();
+    }
+};
+
+/**
+ * A stage that collects the values that arrive within each fixed time
+ * window, passing them along when the window closes. A window opens with
+ * the first value after the previous one closed, so no empty windows are
+ * passed along.
+ */
+template <typename T, typename Next>
+class tumbling_stage
+{
+    duration window_;
+    std::vector<T> buf_;
+    clock::time_point end_;
+    Next next_;
+
+    void roll(clock::time_point now) {
+        if (!buf_.empty() && now >= end_) {
+            std::vector<T> out;
+            out.swap(buf_);
+            next_.push(std::move(out));
+        }
+    }
+
+public:
+    tumbling_stage(duration window, Next next) : window_{window}, next_{std::move(next)} {}
+
+    template <typename U>
+    void push(U&& val) {
+        auto now = clock::now();
+        roll(now);
+        if (buf_.empty())
+            end_ = now + window_;
+        buf_.push_back(std::forward<U>(val));
+    }
+    void tick(clock::time_point now) {
+        roll(now);
+        next_.tick(now);
+    }
+    void finish() {
+        if (!buf_.empty()) {
+            next_.push(std::move(buf_));
+            buf_.clear();
+        }
+        next_.finish();
+    }
+};
+
+/**
+ * A stage that passes along the last @em n values, each time @em step
+ * new values have arrived. Partial windows at the start and end of the
+ * stream are not passed along.
+ */
+template <typename T, typename Next>
+class sliding_stage
+{
+    size_t size_;
+    size_t step_;
+    size_t count_{0};
+    std::deque<T> buf_;
+    Next next_;
+
+public:
+    sliding_stage(size_t n, size_t step, Next next)
+        : size_{n ? n : 1}, step_{step ? step : 1}, next_{std::move(next)} {}
+
+    template <typename U>
+    void push(U&& val) {
+        buf_.push_back(std::forward<U>(val));
+        if (buf_.size() > size_)
+            buf_.pop_front();
+        if (buf_.size() == size_ && ++count_ % step_ == 0)
+            next_.push(std::vector<T>(buf_.begin(), buf_.end()));
+    }
+    void tick(clock::time_point now) { next_.tick(now); }
+    void finish() { next_.finish(); }
+};
+
+// --------------------------------------------------------------------------
+// Operators
+//
+// Each operator knows the type of value it produces for a given input
+// type, and how to bind itself in front of the next stage.
+
+/** Operator to pass along the values that match a predicate */
+template <typename Pred>
+struct filter_op : op_base
+{
+    Pred pred;
+
+    template <typename In>
+    using output = In;
+
+    template <typename In, typename Next>
+    auto bind(Next next) const {
+        return filter_stage<Pred, Next>{pred, std::move(next)};
+    }
+};
+
+/** Operator to transform each value */
+template <typename F>
+struct map_op : op_base
+{
+    F fn;
+
+    template <typename In>
+    using output = std::decay_t<std::invoke_result_t<F&, In&&>>;
+
+    template <typename In, typename Next>
+    auto bind(Next next) const {
+        return map_stage<F, Next>{fn, std::move(next)};
+    }
+};
+
+/** Operator to collect values into batches by size or time */
+struct batch_op : op_base
+{
+    size_t maxSize;
+    duration maxAge;
+
+    template <typename In>
+    using output = std::vector<In>;
+
+    template <typename In, typename Next>
+    auto bind(Next next) const {
+        return batch_stage<In, Next>{maxSize, maxAge, std::move(next)};
+    }
+};
+
+/** Operator to collect values into fixed time windows */
+struct tumbling_op : op_base
+{
+    duration window;
+
+    template <typename In>
+    using output = std::vector<In>;
+
+    template <typename In, typename Next>
+    auto bind(Next next) const {
+        return tumbling_stage<In, Next>{window, std::move(next)};
+    }
+};
+
+/** Operator for a sliding window over the last N values */
+struct sliding_op : op_base
+{
+    size_t size;
+    size_t step;
+
+    template <typename In>
+    using output = std::vector<In>;
+
+    template <typename In, typename Next>
+    auto bind(Next next) const {
+        return sliding_stage<In, Next>{size, step, std::move(next)};
+    }
+};
+
+/** Two operators chained together */
+template <typename A, typename B>
+struct chain_op : op_base
+{
+    A first;
+    B second;
+
+    template <typename In>
+    using output = typename B::template output<typename A::template output<In>>;
+
+    template <typename In, typename Next>
+    auto bind(Next next) const {
+        using mid_type = typename A::template output<In>;
+        return first.template bind<In>(second.template bind<mid_type>(std::move(next)));
+    }
+};
+
+/**
+ * Chains two operators into a pipeline.
+ * @param a The first operator.
+ * @param b The operator that gets the output of the first.
+ * @return The combined operator.
+ */
+template <
+    typename A, typename B,
+    typename = std::enable_if_t<is_op<A>::value && is_op<B>::value>>
+chain_op<std::decay_t<A>, std::decay_t<B>> operator|(A&& a, B&& b) {
+    return {{}, std::forward<A>(a), std::forward<B>(b)};
+}
+
+// --------------------------------------------------------------------------
+// Operator factories
+
+/**
+ * Passes along the values for which the predicate returns @em true.
+ * @param pred The predicate.
+ * @return The operator.
+ */
+template <typename Pred>
+filter_op<std::decay_t<Pred>> filter(Pred&& pred) {
+    return {{}, std::forward<Pred>(pred)};
+}
+
+/**
+ * Passes along the messages with topics that match a topic filter.
+ * This must be applied to the messages, before they are mapped to
+ * something else.
+ * @param filt The topic filter, which may contain wildcards.
+ * @return The operator.
+ */
+inline auto filter_topic(const string& filt) {
+    return filter([tf = topic_filter{filt}](const const_message_ptr& msg) {
+        return msg && tf.matches(msg->get_topic());
+    });
+}
+
+/**
+ * Passes along the result of a function applied to each value.
+ * @param fn The function.
+ * @return The operator.
+ */
+template <typename F>
+map_op<std::decay_t<F>> map(F&& fn) {
+    return {{}, std::forward<F>(fn)};
+}
+
+/**
+ * Collects values into batches, passed along as vectors. A batch is
+ * passed along when it reaches the maximum size, or when its oldest
+ * value has waited for the maximum time.
+ * @param maxSize The maximum number of values in a batch.
+ * @param maxAge The maximum time to hold a value, or zero to only batch
+ *  			 by size.
+ * @return The operator.
+ */
+template <class Rep = int64_t, class Period = std::milli>
+batch_op batch(
+    size_t maxSize, const std::chrono::duration<Rep, Period>& maxAge = std::chrono::milliseconds(0)
+) {
+    return {{}, maxSize, std::chrono::duration_cast<duration>(maxAge)};
+}
+
+/**
+ * Collects the values that arrive within fixed, non-overlapping, time
+ * windows, passed along as vectors.
+ * @param window The length of the windows.
+ * @return The operator.
+ */
+template <class Rep, class Period>
+tumbling_op tumbling(const std::chrono::duration<Rep, Period>& window) {
+    return {{}, std::chrono::duration_cast<duration>(window)};
+}
+
+/**
+ * Passes along the last @em n values as a vector, each time @em step new
+ * values arrive.
+ * @param n The number of values in the window.
+ * @param step The number of values between windows.
+ * @return The operator.
+ */
+inline sliding_op sliding(size_t n, size_t step = 1) { return {{}, n, step}; }
+
+// --------------------------------------------------------------------------
+// Running a pipeline
+
+/**
+ * Binds a pipeline to a sink function, creating the fused stage.
+ * @tparam In The type of the values that will be pushed into the stage.
+ * @param op The pipeline.
+ * @param fn The function to receive the output of the pipeline.
+ * @return The stage object.
+ */
+template <typename In = const_message_ptr, typename Op, typename F>
+auto make_stage(const Op& op, F fn) {
+    return op.template bind<In>(sink_stage<F>{std::move(fn)});
+}
+
+/**
+ * Runs a pipeline over the messages from a client's consumer queue, on
+ * the calling thread.
+ * This returns when the consumer is stopped and the queue is drained,
+ * after flushing any partial batches. Null messages, which signal a lost
+ * connection, are not passed into the pipeline.
+ * @param cli The client. It must have already started consuming.
+ * @param op The pipeline.
+ * @param fn The function to receive the output of the pipeline.
+ * @param tickTime How often to check for expired windows and batches
+ *  			   while waiting for messages.
+ */
+template <typename Client, typename Op, typename F>
+void run(
+    Client& cli, const Op& op, F fn,
+    duration tickTime = std::chrono::milliseconds(10)
+) {
+    auto stage = make_stage<const_message_ptr>(op, std::move(fn));
+    const_message_ptr msg;
+
+    while (!cli.consumer_done()) {
+        if (cli.try_consume_message_for(&msg, tickTime) && msg)
+            stage.push(std::move(msg));
+        stage.tick(clock::now());
+    }
+    stage.finish();
+}
+
+}  // namespace ops
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_stream_ops_h
@@ -175,6 +175,22 @@ public:
     void set_retain_handling(RetainHandling retainHandling) {
         opts_.retainHandling = (unsigned char)retainHandling;
     }
+    /**
+     * Compares two sets of subscribe options.
+     * @param rhs The other options.
+     * @return @em true if all the options are the same, @em false if not.
+     */
+    bool operator==(const subscribe_options& rhs) const {
+        return get_no_local() == rhs.get_no_local() &&
+               get_retain_as_published() == rhs.get_retain_as_published() &&
+               opts_.retainHandling == rhs.opts_.retainHandling;
+    }
+    /**
+     * Compares two sets of subscribe options.
+     * @param rhs The other options.
+     * @return @em true if any of the options differ, @em false if not.
+     */
+    bool operator!=(const subscribe_options& rhs) const { return !(*this == rhs); }
 };
 
 /** Smart/shared pointer to a subscribe options object. */
@@ -0,0 +1,172 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file subscription_cover.h
+/// Declaration of MQTT subscription_cover class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_subscription_cover_h
+#define __mqtt_subscription_cover_h
+
+#include <vector>
+
+#include "mqtt/message.h"
+#include "mqtt/properties.h"
+#include "mqtt/subscription_set.h"
+#include "mqtt/topic_matcher.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The smallest set of subscriptions that covers a set of overlapping
+ * filters.
+ *
+ * An application often ends up with subscriptions that overlap, like
+ * `a/#` and `a/b/+`. The second is redundant, since every topic that it
+ * matches is also matched by the first. But the server may send a copy of
+ * a message for each matching subscription, wasting bandwidth, and the
+ * application has to sort out the duplicates.
+ *
+ * This takes the logical subscriptions that the application wants, and
+ * works out the covering set: the filters that aren't subsumed by any
+ * other. Only those need to be sent to the server. A filter is only
+ * subsumed by one with the same subscribe options, and each covering
+ * filter takes the highest QoS of the filters that it covers.
+ *
+ * When a message arrives, matches() gives all the logical filters that
+ * it matches, so it can be dispatched to each of them once.
+ *
+ * Filters that overlap without one subsuming the other, like `a/+/c` and
+ * `a/b/+`, both stay in the covering set, and a message on `a/b/c` can
+ * still arrive twice. With MQTT v5, each covering filter can be
+ * subscribed with its own subscription identifier, from
+ * subscription_id(). The server then tags each copy with the identifiers
+ * of the subscriptions that it's for, and is_duplicate() can pick out the
+ * extra copies.
+ *
+ * @code
+ * mqtt::subscription_cover cover{wanted};
+ * for (const auto& sub : cover.cover()) {
+ *     mqtt::properties props{
+ *         {mqtt::property::SUBSCRIPTION_IDENTIFIER, cover.subscription_id(sub.first)}
+ *     };
+ *     cli.subscribe(sub.first, sub.second.qos, sub.second.opts, props);
+ * }
+ * ...
+ * if (!cover.is_duplicate(*msg)) {
+ *     for (const auto& filter : cover.matches(msg->get_topic()))
+ *         dispatch(filter, msg);
+ * }
+ * @endcode
+ *
+ * The object is immutable once created, so it can be shared by several
+ * threads.
+ */
+class subscription_cover
+{
+    /** The logical subscriptions */
+    subscription_set subs_;
+    /** The covering subscriptions */
+    subscription_set cover_;
+    /** The logical filters, for matching topics */
+    topic_matcher<int> logical_;
+    /** The covering filters, mapped to their subscription identifiers */
+    topic_matcher<int> coverIds_;
+
+public:
+    /**
+     * Works out the covering set for some logical subscriptions.
+     * @param subs The logical subscriptions.
+     */
+    explicit subscription_cover(const subscription_set& subs);
+    /**
+     * Determines if one filter subsumes another: that every topic matched
+     * by the specific filter is also matched by the general one.
+     * A filter subsumes itself.
+     * @param general The more general filter.
+     * @param specific The more specific filter.
+     * @return @em true if the general filter subsumes the specific one,
+     *  	   @em false if not.
+     */
+    static bool subsumes(const string& general, const string& specific);
+    /**
+     * Gets the logical subscriptions.
+     * @return The logical subscriptions.
+     */
+    const subscription_set& logical() const { return subs_; }
+    /**
+     * Gets the covering subscriptions. These are the ones to send to the
+     * server.
+     * @return The covering subscriptions.
+     */
+    const subscription_set& cover() const { return cover_; }
+    /**
+     * Gets the number of logical subscriptions that aren't needed on the
+     * server, since they're covered by others.
+     * @return The number of redundant subscriptions.
+     */
+    size_t num_redundant() const { return subs_.size() - cover_.size(); }
+    /**
+     * Gets the subscription identifier for a covering filter.
+     * The filters are numbered from one, in order.
+     * @param filter A filter from the covering set.
+     * @return The subscription identifier, or zero if the filter isn't in
+     *  	   the covering set.
+     */
+    int subscription_id(const string& filter) const;
+    /**
+     * Gets the logical filters that match a topic.
+     * @param topic The topic of a message.
+     * @return The logical filters that match the topic, in order, each
+     *  	   listed once.
+     */
+    std::vector<string> matches(const string& topic) const;
+    /**
+     * Determines if an incoming copy of a message is a duplicate.
+     *
+     * Of the covering filters that match the topic, the one with the
+     * lowest identifier is chosen to deliver the message. A copy is a
+     * duplicate if it carries subscription identifiers, but not that one.
+     * A copy with no identifiers can't be checked, and isn't considered a
+     * duplicate.
+     *
+     * @param topic The topic of the message.
+     * @param props The properties of the message.
+     * @return @em true if the copy is a duplicate and should be dropped,
+     *  	   @em false if it should be dispatched.
+     */
+    bool is_duplicate(const string& topic, const properties& props) const;
+    /**
+     * Determines if an incoming copy of a message is a duplicate.
+     * @param msg The message.
+     * @return @em true if the copy is a duplicate and should be dropped,
+     *  	   @em false if it should be dispatched.
+     */
+    bool is_duplicate(const message& msg) const {
+        return is_duplicate(msg.get_topic(), msg.get_properties());
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_subscription_cover_h
@@ -0,0 +1,184 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file subscription_set.h
+/// Declaration of MQTT subscription_set class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_subscription_set_h
+#define __mqtt_subscription_set_h
+
+#include <map>
+#include <vector>
+
+#include "mqtt/string_collection.h"
+#include "mqtt/subscribe_options.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A set of subscriptions: topic filters, each with a QoS and options.
+ *
+ * This describes the subscriptions that a client has, or should have.
+ * The client keeps one of these with the subscriptions that the server
+ * has accepted, and given a set of the subscriptions that the
+ * application wants, it can work out the difference between the two, and
+ * send just the changes.
+ *
+ * The set is ordered by the filters, so two sets can be compared in
+ * linear time.
+ */
+class subscription_set
+{
+public:
+    /** The QoS and options for a subscription */
+    struct entry
+    {
+        /** The quality of service */
+        int qos{0};
+        /** The MQTT v5 subscribe options */
+        subscribe_options opts;
+    };
+
+    /** The type of the underlying map of filters to entries */
+    using map_type = std::map<string, entry>;
+    /** Iterator over the subscriptions */
+    using const_iterator = map_type::const_iterator;
+
+    /** The changes needed to go from one set to another */
+    struct changes;
+
+private:
+    /** The subscriptions */
+    map_type subs_;
+
+public:
+    /**
+     * Creates an empty set.
+     */
+    subscription_set() {}
+    /**
+     * Creates a set of filters, all with the same QoS and options.
+     * @param filters The topic filters.
+     * @param qos The quality of service for the filters.
+     * @param opts The subscribe options for the filters.
+     */
+    subscription_set(
+        const string_collection& filters, int qos,
+        const subscribe_options& opts = subscribe_options{}
+    );
+    /**
+     * Adds a subscription, or replaces the QoS and options of an existing
+     * one.
+     * @param filter The topic filter.
+     * @param qos The quality of service.
+     * @param opts The subscribe options.
+     * @return A reference to this set.
+     */
+    subscription_set& add(
+        const string& filter, int qos, const subscribe_options& opts = subscribe_options{}
+    ) {
+        subs_[filter] = entry{qos, opts};
+        return *this;
+    }
+    /**
+     * Removes a subscription.
+     * @param filter The topic filter.
+     * @return @em true if the filter was in the set, @em false if not.
+     */
+    bool remove(const string& filter) { return subs_.erase(filter) != 0; }
+    /**
+     * Determines if the set has a filter.
+     * @param filter The topic filter.
+     * @return @em true if the filter is in the set, @em false if not.
+     */
+    bool contains(const string& filter) const { return subs_.count(filter) != 0; }
+    /**
+     * Gets the QoS and options for a filter.
+     * @param filter The topic filter.
+     * @return A pointer to the entry for the filter, or nullptr if it's not
+     *  	   in the set.
+     */
+    const entry* find(const string& filter) const {
+        auto it = subs_.find(filter);
+        return (it == subs_.end()) ? nullptr : &it->second;
+    }
+    /**
+     * Gets the number of subscriptions in the set.
+     * @return The number of subscriptions in the set.
+     */
+    size_t size() const { return subs_.size(); }
+    /**
+     * Determines if the set is empty.
+     * @return @em true if the set is empty, @em false otherwise.
+     */
+    bool empty() const { return subs_.empty(); }
+    /**
+     * Removes all the subscriptions.
+     */
+    void clear() { subs_.clear(); }
+    /**
+     * Gets an iterator to the first subscription.
+     * @return An iterator to the first subscription.
+     */
+    const_iterator begin() const { return subs_.begin(); }
+    /**
+     * Gets an iterator past the last subscription.
+     * @return An iterator past the last subscription.
+     */
+    const_iterator end() const { return subs_.end(); }
+    /**
+     * Works out the changes needed to go from this set to another.
+     * A filter that's in both sets, but with a different QoS or options,
+     * is subscribed again, which replaces the subscription on the server.
+     * @param desired The set of subscriptions wanted.
+     * @return The subscriptions to make and the filters to unsubscribe.
+     */
+    changes diff(const subscription_set& desired) const;
+    /**
+     * Applies changes to the set.
+     * @param chg The changes.
+     */
+    void apply(const changes& chg);
+};
+
+/**
+ * The changes needed to go from one set of subscriptions to another.
+ */
+struct subscription_set::changes
+{
+    /** The subscriptions to make, new or changed */
+    subscription_set subscribe;
+    /** The filters to unsubscribe */
+    std::vector<string> unsubscribe;
+
+    /**
+     * Determines if there are no changes.
+     * @return @em true if there are no changes, @em false otherwise.
+     */
+    bool empty() const { return subscribe.empty() && unsubscribe.empty(); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_subscription_set_h
@@ -26,6 +26,8 @@
 #define __mqtt_thread_queue_h
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <limits>
@@ -33,6 +35,10 @@
 #include <queue>
 #include <thread>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+#endif
+
 namespace mqtt {
 
 /**
@@ -76,6 +82,12 @@ public:
  * be left in the queue. This is especially useful when creating queues of
  * shared pointers, as the "dead" part of the queue will not hold onto a
  * reference count after the item has been removed from the queue.
+ * @par
+ * The queue keeps track of the threads that are blocked on it, and only
+ * signals a condition variable when someone is waiting on it. So a
+ * producer doesn't pay for a wakeup (a system call on most platforms)
+ * when the consumer is busy, or is polling the queue with try_get() or
+ * spinning in get_spin().
  *
  * @tparam T The type of the items to be held in the queue.
  * @tparam Container The type of the underlying container to use. It must
@@ -106,6 +118,17 @@ private:
     size_type cap_{MAX_CAPACITY};
     /** Whether the queue is closed */
     bool closed_{false};
+    /** The number of threads waiting for an item */
+    size_t nGetWaiters_{0};
+    /** The number of threads waiting for space */
+    size_t nPutWaiters_{0};
+    /**
+     * Whether there's an item available, or the queue is closed. This can
+     * be read without the lock, so that get_spin() can poll it.
+     */
+    std::atomic<bool> ready_{false};
+    /** The current spin time for get_spin(), in nanoseconds */
+    std::atomic<int64_t> spinNs_{0};
 
     /** The actual STL container to hold data */
     std::queue<T, Container> que_;
@@ -117,6 +140,62 @@ private:
 
     /** Checks if the queue is done (unsafe) */
     bool is_done() const { return closed_ && que_.empty(); }
+    /** Updates the ready flag after the queue changes (unsafe) */
+    void update_ready() { ready_.store(!que_.empty() || closed_, std::memory_order_release); }
+    /** Adds an item to the queue and wakes a consumer, if any (unsafe) */
+    void push(value_type&& val) {
+        que_.emplace(std::move(val));
+        ready_.store(true, std::memory_order_release);
+        if (nGetWaiters_ != 0)
+            notEmptyCond_.notify_one();
+    }
+    /** Removes the next item from the queue and wakes a producer, if any (unsafe) */
+    value_type pop() {
+        value_type val = std::move(que_.front());
+        que_.pop();
+        update_ready();
+        if (nPutWaiters_ != 0)
+            notFullCond_.notify_one();
+        return val;
+    }
+    /** Waits on a condition, keeping count of the waiting threads (unsafe) */
+    template <typename Wait>
+    static auto counted_wait(size_t& nWaiters, Wait wait) {
+        ++nWaiters;
+        try {
+            auto res = wait();
+            --nWaiters;
+            return res;
+        }
+        catch (...) {
+            --nWaiters;
+            throw;
+        }
+    }
+    /** Blocks until there's space in the queue, or it's closed (unsafe) */
+    void wait_not_full(unique_guard& g) {
+        counted_wait(nPutWaiters_, [&] {
+            notFullCond_.wait(g, [this] { return que_.size() < cap_ || closed_; });
+            return true;
+        });
+    }
+    /** Blocks until there's an item in the queue, or it's closed (unsafe) */
+    void wait_not_empty(unique_guard& g) {
+        counted_wait(nGetWaiters_, [&] {
+            notEmptyCond_.wait(g, [this] { return !que_.empty() || closed_; });
+            return true;
+        });
+    }
+    /** Hints to the CPU that the thread is spinning */
+    static void cpu_relax() noexcept {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_ia32_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+        asm volatile("yield");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+#endif
+    }
 
 public:
     /**
@@ -177,6 +256,7 @@ public:
     void close() {
         guard g{lock_};
         closed_ = true;
+        update_ready();
         notFullCond_.notify_all();
         notEmptyCond_.notify_all();
     }
@@ -208,6 +288,7 @@ public:
     void clear() {
         guard g{lock_};
         while (!que_.empty()) que_.pop();
+        update_ready();
         notFullCond_.notify_all();
     }
     /**
@@ -218,12 +299,12 @@ public:
      */
     void put(value_type val) {
         unique_guard g{lock_};
-        notFullCond_.wait(g, [this] { return que_.size() < cap_ || closed_; });
+        if (que_.size() >= cap_ && !closed_)
+            wait_not_full(g);
         if (closed_)
             throw queue_closed{};
 
-        que_.emplace(std::move(val));
-        notEmptyCond_.notify_one();
+        push(std::move(val));
     }
     /**
      * Non-blocking attempt to place an item into the queue.
@@ -236,8 +317,7 @@ public:
         if (que_.size() >= cap_ || closed_)
             return false;
 
-        que_.emplace(std::move(val));
-        notEmptyCond_.notify_one();
+        push(std::move(val));
         return true;
     }
     /**
@@ -252,14 +332,15 @@ public:
     template <typename Rep, class Period>
     bool try_put_for(value_type val, const std::chrono::duration<Rep, Period>& relTime) {
         unique_guard g{lock_};
-        bool to = !notFullCond_.wait_for(g, relTime, [this] {
-            return que_.size() < cap_ || closed_;
+        bool to = !counted_wait(nPutWaiters_, [&] {
+            return notFullCond_.wait_for(g, relTime, [this] {
+                return que_.size() < cap_ || closed_;
+            });
         });
         if (to || closed_)
             return false;
 
-        que_.emplace(std::move(val));
-        notEmptyCond_.notify_one();
+        push(std::move(val));
         return true;
     }
     /**
@@ -277,15 +358,16 @@ public:
         value_type val, const std::chrono::time_point<Clock, Duration>& absTime
     ) {
         unique_guard g{lock_};
-        bool to = !notFullCond_.wait_until(g, absTime, [this] {
-            return que_.size() < cap_ || closed_;
+        bool to = !counted_wait(nPutWaiters_, [&] {
+            return notFullCond_.wait_until(g, absTime, [this] {
+                return que_.size() < cap_ || closed_;
+            });
         });
 
         if (to || closed_)
             return false;
 
-        que_.emplace(std::move(val));
-        notEmptyCond_.notify_one();
+        push(std::move(val));
         return true;
     }
     /**
@@ -299,13 +381,12 @@ public:
             return false;
 
         unique_guard g{lock_};
-        notEmptyCond_.wait(g, [this] { return !que_.empty() || closed_; });
+        if (que_.empty() && !closed_)
+            wait_not_empty(g);
         if (que_.empty())  // We must be done
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop();
         return true;
     }
     /**
@@ -316,14 +397,12 @@ public:
      */
     value_type get() {
         unique_guard g{lock_};
-        notEmptyCond_.wait(g, [this] { return !que_.empty() || closed_; });
+        if (que_.empty() && !closed_)
+            wait_not_empty(g);
         if (que_.empty())  // We must be done
             throw queue_closed{};
 
-        value_type val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
-        return val;
+        return pop();
     }
     /**
      * Attempts to remove a value from the queue without blocking.
@@ -341,9 +420,7 @@ public:
         if (que_.empty())
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop();
         return true;
     }
     /**
@@ -362,14 +439,16 @@ public:
             return false;
 
         unique_guard g{lock_};
-        notEmptyCond_.wait_for(g, relTime, [this] { return !que_.empty() || closed_; });
+        counted_wait(nGetWaiters_, [&] {
+            return notEmptyCond_.wait_for(g, relTime, [this] {
+                return !que_.empty() || closed_;
+            });
+        });
 
         if (que_.empty())
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop();
         return true;
     }
     /**
@@ -390,13 +469,71 @@ public:
             return false;
 
         unique_guard g{lock_};
-        notEmptyCond_.wait_until(g, absTime, [this] { return !que_.empty() || closed_; });
+        counted_wait(nGetWaiters_, [&] {
+            return notEmptyCond_.wait_until(g, absTime, [this] {
+                return !que_.empty() || closed_;
+            });
+        });
         if (que_.empty())
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop();
+        return true;
+    }
+    /**
+     * Retrieve a value from the queue, spinning for a while before
+     * blocking.
+     *
+     * This is for a consumer with a core to itself, that wants the lowest
+     * latency. When the queue is empty, it polls the queue, without the
+     * lock, for up to the spin time. If nothing arrives, it blocks like
+     * get(). Since the thread isn't waiting on the queue while it spins,
+     * producers don't need to wake it.
+     *
+     * The spin time adapts to the traffic. It starts at @em maxSpin. Each
+     * time the consumer has to block, the spin time doubles if an item
+     * arrives soon after, since a bit more spinning would have caught it,
+     * and halves if it doesn't, down to 1/16 of @em maxSpin.
+     *
+     * @param val Pointer to a variable to receive the value.
+     * @param maxSpin The longest time to spin before blocking.
+     * @return @em true if a value was removed from the queue, @em false if
+     *  	   the queue is closed and empty.
+     */
+    template <typename Rep, class Period>
+    bool get_spin(value_type* val, const std::chrono::duration<Rep, Period>& maxSpin) {
+        using namespace std::chrono;
+
+        if (!val)
+            return false;
+
+        const int64_t maxNs = int64_t(duration_cast<nanoseconds>(maxSpin).count());
+        int64_t spinNs = spinNs_.load(std::memory_order_relaxed);
+        if (spinNs <= 0 || spinNs > maxNs)
+            spinNs = maxNs;
+
+        if (!ready_.load(std::memory_order_acquire) && spinNs > 0) {
+            const auto end = steady_clock::now() + nanoseconds(spinNs);
+            do {
+                cpu_relax();
+            } while (!ready_.load(std::memory_order_acquire) && steady_clock::now() < end);
+        }
+
+        unique_guard g{lock_};
+        if (que_.empty() && !closed_) {
+            auto start = steady_clock::now();
+            wait_not_empty(g);
+
+            if (steady_clock::now() - start < maxSpin)
+                spinNs = std::min(maxNs, 2 * spinNs);
+            else
+                spinNs = std::max(maxNs / 16, spinNs / 2);
+            spinNs_.store(spinNs, std::memory_order_relaxed);
+        }
+        if (que_.empty())  // We must be done
+            return false;
+
+        *val = pop();
         return true;
     }
 };
@@ -0,0 +1,201 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file timer_wheel.h
+/// Declaration of the MQTT timer_wheel class for operation deadlines.
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_timer_wheel_h
+#define __mqtt_timer_wheel_h
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mqtt/token.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A hierarchical timer wheel that tracks deadlines for outstanding
+ * tokens.
+ *
+ * This lets a client put a deadline on any number of in-flight operations
+ * using a single background thread, rather than parking a thread in a
+ * timed wait for each one. Tokens are linked intrusively into the wheel,
+ * so arming and cancelling a deadline are constant-time operations that
+ * don't allocate.
+ *
+ * The wheel has four levels of 64 slots each. With the default resolution
+ * of one millisecond, the lowest level covers the next 64ms, and the
+ * wheel as a whole covers about 4.6 hours. Entries further out than that
+ * are parked in the top level and re-inserted as the wheel turns.
+ *
+ * While a token is armed, the wheel holds a reference to it. When its
+ * deadline passes, the token is removed from the wheel and handed to the
+ * expiry handler from the wheel's thread. Cancelling the deadline simply
+ * drops the token from the wheel.
+ */
+class timer_wheel
+{
+public:
+    /** The clock used for deadlines */
+    using clock = std::chrono::steady_clock;
+    /** A point in time for a deadline */
+    using time_point = clock::time_point;
+    /** The type for the timer resolution */
+    using duration = clock::duration;
+    /** Handler for tokens that reach their deadline */
+    using expiry_handler = std::function<void(token_ptr)>;
+
+    /** The default resolution (length of a tick) for the timer */
+    static constexpr duration DFLT_RESOLUTION = std::chrono::milliseconds(1);
+
+private:
+    /** Lock guard type for this class. */
+    using guard = std::lock_guard<std::mutex>;
+    /** Unique lock type for this class. */
+    using unique_lock = std::unique_lock<std::mutex>;
+
+    /** The number of bits of a tick count handled by each level */
+    static constexpr unsigned SLOT_BITS = 6;
+    /** The number of slots in each level */
+    static constexpr size_t N_SLOTS = size_t(1) << SLOT_BITS;
+    /** Mask to get a slot index from a tick count */
+    static constexpr uint64_t SLOT_MASK = N_SLOTS - 1;
+    /** The number of levels in the wheel */
+    static constexpr size_t N_LEVELS = 4;
+    /** The number of ticks covered by the whole wheel */
+    static constexpr uint64_t MAX_TICKS = uint64_t(1) << (SLOT_BITS * N_LEVELS);
+    /** Tick value to indicate that the thread has nothing to wait for */
+    static constexpr uint64_t NO_TICK = std::numeric_limits<uint64_t>::max();
+
+    /** Object monitor mutex */
+    mutable std::mutex lock_;
+    /** Signals the timer thread when the next deadline moves closer */
+    std::condition_variable cond_;
+    /** The handler for expired tokens */
+    expiry_handler handler_;
+    /** The length of a tick */
+    duration resolution_;
+    /** The time at tick zero */
+    time_point start_;
+    /** The last tick that was processed */
+    uint64_t now_{0};
+    /** The tick at which the timer thread will next wake up */
+    uint64_t wakeTick_{NO_TICK};
+    /** The number of armed tokens */
+    size_t count_{0};
+    /** Whether the timer thread should exit */
+    bool stop_{false};
+    /** The heads of the token list for each slot in each level */
+    token* slots_[N_LEVELS][N_SLOTS]{};
+    /** The timer thread */
+    std::thread thr_;
+
+    /** Non-copyable */
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+
+    /** Converts a time point to a tick count, rounding up */
+    uint64_t to_ticks(const time_point& tp) const;
+    /** Converts a tick count back to a time point */
+    time_point to_time(uint64_t tick) const {
+        return start_ + resolution_ * static_cast<duration::rep>(tick);
+    }
+    /** Links a token into the slot for its expiry, no earlier than 'base' */
+    void link(token* tok, uint64_t base);
+    /** Unlinks a token from its slot */
+    void unlink(token* tok);
+    /** Re-inserts all the tokens in a slot after the wheel turns */
+    void cascade(size_t level, size_t idx);
+    /** Moves the wheel forward, collecting the tokens that expired */
+    void advance(uint64_t tick, std::vector<token_ptr>& expired);
+    /** Gets the next tick at which the thread has work to do */
+    uint64_t next_tick() const;
+    /** The timer thread function */
+    void run();
+
+public:
+    /**
+     * Creates a timer wheel and starts its thread.
+     * @param handler The handler to call with each token that reaches its
+     *  			  deadline. This is called from the timer thread.
+     * @param resolution The length of a single tick of the timer.
+     */
+    explicit timer_wheel(expiry_handler handler, duration resolution = DFLT_RESOLUTION);
+    /**
+     * Stops the timer thread and releases any tokens still in the wheel.
+     */
+    ~timer_wheel();
+    /**
+     * Gets the resolution of the timer.
+     * @return The length of a single tick of the timer.
+     */
+    duration resolution() const { return resolution_; }
+    /**
+     * Arms a deadline for the token.
+     * If the token already has a deadline, it is replaced.
+     * @param tok The token.
+     * @param deadline The time at which the token should be expired.
+     */
+    void schedule(token_ptr tok, const time_point& deadline);
+    /**
+     * Arms a deadline for the token, relative to the current time.
+     * @param tok The token.
+     * @param relTime The amount of time until the token should be expired.
+     */
+    template <class Rep, class Period>
+    void schedule(token_ptr tok, const std::chrono::duration<Rep, Period>& relTime) {
+        schedule(
+            std::move(tok), clock::now() + std::chrono::duration_cast<duration>(relTime)
+        );
+    }
+    /**
+     * Cancels the deadline for the token, if it has one.
+     * @param tok The token.
+     * @return @em true if the token was in the wheel, @em false otherwise.
+     */
+    bool cancel(token* tok);
+    /**
+     * Gets the number of tokens that currently have a deadline armed.
+     * @return The number of tokens in the wheel.
+     */
+    size_t size() const {
+        guard g(lock_);
+        return count_;
+    }
+    /**
+     * Determines if there are no deadlines armed.
+     * @return @em true if the wheel is empty, @em false otherwise.
+     */
+    bool empty() const { return size() == 0; }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_timer_wheel_h
@@ -27,12 +27,14 @@
 
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <thread>
 #include <vector>
 
 #include "MQTTAsync.h"
 #include "mqtt/buffer_ref.h"
+#include "mqtt/continuation.h"
 #include "mqtt/exception.h"
 #include "mqtt/iaction_listener.h"
 #include "mqtt/properties.h"
@@ -50,7 +52,7 @@ class iasync_client;
  * Provides a mechanism for tracking the completion of an asynchronous
  * action.
  */
-class token
+class token : public std::enable_shared_from_this<token>
 {
 public:
     /** Smart/shared pointer to an object of this class */
@@ -101,6 +103,48 @@ private:
     size_t nExpected_;
     /** Whether the action has yet to complete */
     bool complete_;
+    /** Whether the action was failed locally when its deadline passed */
+    bool timedOut_{false};
+
+    /**
+     * Intrusive link used while the token has a deadline armed in a
+     * client's timer wheel. The wheel holds a reference to the token until
+     * it either expires or is cancelled.
+     */
+    struct deadline_link
+    {
+        /** The wheel's reference to the token */
+        ptr_t self;
+        /** The previous token in the slot */
+        token* prev{nullptr};
+        /** The next token in the slot */
+        token* next{nullptr};
+        /** The tick at which the token expires */
+        uint64_t expiry{0};
+        /** The slot holding the token, or -1 if not in the wheel */
+        int slot{-1};
+    };
+    /** The deadline link (guarded by the timer wheel) */
+    deadline_link deadline_;
+
+    /** A continuation waiting for the action to complete */
+    struct pending_continuation
+    {
+        /** The callable */
+        continuation fn;
+        /** The executor to run it, or nullptr to run it inline */
+        executor* exec{nullptr};
+    };
+    /** The continuations waiting for the action to complete */
+    struct continuation_list
+    {
+        /** The first one, kept inline in the token */
+        pending_continuation first;
+        /** Any others, in the order they were added */
+        std::vector<pending_continuation> more;
+    };
+    /** The continuations to run on completion */
+    continuation_list conts_;
 
     /** Connection response (null if not available) */
     std::unique_ptr<connect_response> connRsp_;
@@ -112,6 +156,7 @@ private:
     /** Client and token-related options have special access */
     friend class async_client;
     friend class mock_async_client;
+    friend class timer_wheel;
 
     friend class connect_options;
     friend class response_options;
@@ -172,12 +217,69 @@ private:
      */
     void on_failure(MQTTAsync_failureData* rsp);
     void on_failure5(MQTTAsync_failureData5* rsp);
+    /**
+     * Completes the action locally with a timeout error, if it has not
+     * already completed. This is called when the deadline for the action
+     * passes, and fires the failure callback of any registered listener.
+     * @return @em true if the token was expired by this call, @em false if
+     *  	   it had already completed.
+     */
+    bool on_timeout();
+    /**
+     * Adds a continuation to run when the action completes, or runs it
+     * now if the action has already completed.
+     * @param fn The continuation.
+     * @param exec The executor to run it, or nullptr to run it inline.
+     */
+    void add_continuation(continuation&& fn, executor* exec);
+    /**
+     * Runs a single continuation for the completed token.
+     * @param pc The continuation.
+     */
+    void run_continuation(pending_continuation& pc);
+    /**
+     * Runs the continuations that were taken from the token when it
+     * completed.
+     * @param conts The continuations.
+     */
+    void run_continuations(continuation_list& conts);
+    /**
+     * Completes a token that depends on a continuation, signaling any
+     * waiters and running its own continuations.
+     * This does nothing if the token has already completed.
+     * @param rc The return code.
+     * @param reasonCode The MQTT v5 reason code.
+     * @param errMsg The error message, if any.
+     */
+    void complete_dependent(int rc, ReasonCode reasonCode, const string& errMsg);
+    /**
+     * A token for the next step of a then() pipeline. It holds the step's
+     * callable, so the continuation on the previous token only needs a
+     * pointer to it, and one allocation covers both.
+     */
+    template <class F>
+    class dependent_token;
+    /**
+     * Adds the next step of a then() pipeline.
+     * @param fn The continuation.
+     * @param exec The executor to run it, or nullptr to run it inline.
+     * @return The token for the step.
+     */
+    template <class F>
+    ptr_t add_dependent(F&& fn, executor* exec) {
+        using dep_t = dependent_token<std::decay_t<F>>;
+        auto next = std::make_shared<dep_t>(*this, std::forward<F>(fn));
+        add_continuation(continuation([next](token& tok) { next->run(tok); }), exec);
+        return next;
+    }
 
     /**
      * Check the current return code and throw an exception if it is not a
      * success code.
      */
     void check_ret() const {
+        if (timedOut_)
+            throw timeout_error();
         if (rc_ != MQTTASYNC_SUCCESS || reasonCode_ >= 0x80)
             throw exception(rc_, reasonCode_, errMsg_);
     }
@@ -378,6 +480,15 @@ public:
      * @return @em true if the transaction has completed, @em false if not.
      */
     virtual bool is_complete() const { return complete_; }
+    /**
+     * Returns whether the action was failed locally because it did not
+     * complete before its deadline.
+     * @return @em true if the action timed out, @em false if not.
+     */
+    bool is_timed_out() const {
+        guard g(lock_);
+        return timedOut_;
+    }
     /**
      * Determines if the reference is valid.
      * If the reference is invalid then it is not safe to call @em any
@@ -410,6 +521,77 @@ public:
         guard g(lock_);
         userContext_ = userContext;
     }
+    /**
+     * Adds the next step of a pipeline, to run if the action completes
+     * successfully.
+     *
+     * The continuation is any callable that takes a reference to the
+     * token, like `[](mqtt::token& tok) {...}`. It runs after any action
+     * listener, from the thread that completes the token, before waiting
+     * threads are released. If the action has already completed, the
+     * continuation is run immediately.
+     *
+     * This returns a new token that completes when the continuation
+     * returns, so steps can be chained, like `tok->then(a)->then(b)`,
+     * where @em b only runs after @em a has finished without error. If
+     * this action fails, the continuation is skipped and the new token
+     * fails with the same result. If the continuation throws, the new
+     * token fails with the exception's message.
+     *
+     * Each step costs a heap allocation for its token, which also holds
+     * the callable. To just react to the completion, on_complete() is
+     * cheaper, as it doesn't create a token.
+     *
+     * @param fn The continuation.
+     * @return A token that completes when the continuation finishes.
+     */
+    template <class F>
+    ptr_t then(F&& fn) {
+        return add_dependent(std::forward<F>(fn), nullptr);
+    }
+    /**
+     * Adds the next step of a pipeline, to be run by an executor if the
+     * action completes successfully.
+     * @param fn The continuation.
+     * @param exec The executor to run the continuation. It must outlive
+     *  		   the token.
+     * @return A token that completes when the continuation finishes.
+     */
+    template <class F>
+    ptr_t then(F&& fn, executor& exec) {
+        return add_dependent(std::forward<F>(fn), &exec);
+    }
+    /**
+     * Adds a continuation to run when the action completes, whether it
+     * succeeds or fails.
+     * The continuation can check the result from the token. It is stored
+     * in the token, without a heap allocation if it's small enough to fit
+     * the continuation's inline buffer, such as a lambda capturing a few
+     * references. Like then(), it runs from the thread that completes the
+     * token, or immediately if the action has already completed. Anything
+     * it throws is discarded.
+     * @param fn The continuation.
+     * @return A reference to this token, so that several continuations
+     *  	   can be added in a row.
+     */
+    template <class F>
+    token& on_complete(F&& fn) {
+        add_continuation(continuation(std::forward<F>(fn)), nullptr);
+        return *this;
+    }
+    /**
+     * Adds a continuation to be run by an executor when the action
+     * completes, whether it succeeds or fails.
+     * @param fn The continuation.
+     * @param exec The executor to run the continuation. It must outlive
+     *  		   the token.
+     * @return A reference to this token.
+     */
+    template <class F>
+    token& on_complete(F&& fn, executor& exec) {
+        add_continuation(continuation(std::forward<F>(fn)), &exec);
+        return *this;
+    }
     /**
      * Sets the number of results expected.
      * This is only required for subscribe many() with < MQTTv5
@@ -515,6 +697,52 @@ using token_ptr = token::ptr_t;
 /** Smart/shared pointer to a const token object */
 using const_token_ptr = token::const_ptr_t;
 
+/////////////////////////////////////////////////////////////////////////////
+
+template <class F>
+class token::dependent_token : public token
+{
+    /** The step in the pipeline */
+    F fn_;
+
+public:
+    /**
+     * Creates the token for the next step.
+     * @param prev The previous token in the pipeline.
+     * @param fn The callable for the step.
+     */
+    template <class G>
+    dependent_token(const token& prev, G&& fn)
+        : token(prev.type_, *prev.cli_), fn_(std::forward<G>(fn)) {}
+    /**
+     * Runs the step when the previous token completes, then completes
+     * this token with the result. If the previous token failed, the step
+     * is skipped and this one fails with the same result. If it throws,
+     * this one fails with the exception's message.
+     * @param prev The previous token in the pipeline.
+     */
+    void run(token& prev) {
+        if (!prev) {
+            complete_dependent(
+                prev.get_return_code(), prev.get_reason_code(), prev.get_error_message()
+            );
+            return;
+        }
+        try {
+            fn_(prev);
+        }
+        catch (const std::exception& exc) {
+            complete_dependent(MQTTASYNC_FAILURE, ReasonCode::SUCCESS, exc.what());
+            return;
+        }
+        catch (...) {
+            complete_dependent(MQTTASYNC_FAILURE, ReasonCode::SUCCESS, string());
+            return;
+        }
+        complete_dependent(MQTTASYNC_SUCCESS, ReasonCode::SUCCESS, string());
+    }
+};
+
 /////////////////////////////////////////////////////////////////////////////
 }  // namespace mqtt
 
@@ -325,15 +325,13 @@ public:
             // If we're at the end of the topic fields, we either have a value,
             // or need to move on to the next node to search.
             if (snode.fields_.empty()) {
+                // A '#' also matches the parent topic
+                if ((child = snode.node_->children.find("#")) != map_end) {
+                    nodes_.push_back({child->second.get(), snode.fields_});
+                }
                 pval_ = snode.node_->content.get();
-                if (!pval_) {
-                    // ...but a '#' matches the parent topic
-                    if ((child = snode.node_->children.find("#")) != map_end) {
-                        pval_ = child->second->content.get();
-                        return;
-                    }
+                if (!pval_)
                     this->next();
-                }
                 return;
             }
 
@@ -358,9 +356,11 @@ public:
 
                 // Look for a terminating match
                 if ((child = snode.node_->children.find("#")) != map_end) {
-                    // By definition, a '#' is a terminating leaf
+                    // By definition, a '#' is a terminating leaf. It may be
+                    // empty, though, if its value was removed.
                     pval_ = child->second->content.get();
-                    return;
+                    if (pval_)
+                        return;
                 }
             }
 
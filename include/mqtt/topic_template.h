@@ -0,0 +1,201 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file topic_template.h
+/// Declaration of MQTT topic_template class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_topic_template_h
+#define __mqtt_topic_template_h
+
+#include <charconv>
+#include <initializer_list>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "mqtt/buffer_ref.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A precompiled pattern for building topic names from a few arguments.
+ *
+ * The pattern has named placeholders in braces, like
+ * `site/{site}/dev/{id}/temp`. It's parsed and checked once, when the
+ * template is created. Formatting then writes the literal text and the
+ * arguments straight into one buffer, sized exactly, and hands it back as
+ * a string_ref that can be passed to publish() without another copy.
+ *
+ * The buffers come from a small pool. When the last reference to a topic
+ * goes away, its buffer goes back to the pool to be reused, so after a
+ * warmup, formatting a topic only allocates the reference count.
+ *
+ * Optionally, the template can cache the topics it formats, keyed by
+ * the arguments. For a fixed set of devices, a repeated topic then costs
+ * a lookup, and no allocations at all. The cache keeps the most recently
+ * used topics, up to the given size.
+ *
+ * The arguments are given in the order that their placeholders first
+ * appear in the pattern. A placeholder can appear more than once. An
+ * argument can't contain a level separator or a wildcard, so it can't
+ * change the shape of the topic.
+ *
+ * @code
+ * mqtt::topic_template tmpl{"site/{site}/dev/{id}/temp"};
+ * cli.publish(tmpl("north", 42), payload);
+ * @endcode
+ *
+ * Copies of a template share the same pool and cache. A template can be
+ * used from several threads at once.
+ */
+class topic_template
+{
+    /** A piece of the pattern */
+    struct part
+    {
+        /** The literal text, if not a placeholder */
+        string text;
+        /** The argument index of a placeholder, or -1 for literal text */
+        int arg;
+    };
+    /** The pool and cache, shared by copies of the template */
+    struct state;
+
+    /** The pattern */
+    string pattern_;
+    /** The parsed pattern */
+    std::vector<part> parts_;
+    /** The placeholder names, in argument order */
+    std::vector<string> names_;
+    /** The number of characters of literal text */
+    size_t literalLen_{0};
+    /** The pool and cache */
+    std::shared_ptr<state> state_;
+
+    /** Gets the text for an argument */
+    static std::string_view arg_view(std::string_view s, char*) { return s; }
+    static std::string_view arg_view(const char* s, char*) { return s; }
+    static std::string_view arg_view(const string& s, char*) { return s; }
+    static std::string_view arg_view(const string_ref& s, char*) {
+        return std::string_view{s.data(), s.size()};
+    }
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    static std::string_view arg_view(T v, char* buf) {
+        auto res = std::to_chars(buf, buf + MAX_INT_LEN, v);
+        return std::string_view{buf, size_t(res.ptr - buf)};
+    }
+
+public:
+    /** The most characters in a formatted integer argument */
+    static constexpr size_t MAX_INT_LEN = 24;
+    /** The default number of buffers to keep in the pool */
+    static constexpr size_t DFLT_POOL_SIZE = 64;
+
+    /**
+     * Creates a template from a pattern.
+     * @param pattern The topic pattern, with placeholders like `{name}`.
+     * @param cacheSize The number of formatted topics to cache, or zero
+     *  				for no cache.
+     * @throw std::invalid_argument if the pattern isn't valid.
+     */
+    explicit topic_template(const string& pattern, size_t cacheSize = 0);
+    /**
+     * Gets the pattern.
+     * @return The pattern.
+     */
+    const string& pattern() const { return pattern_; }
+    /**
+     * Gets the number of arguments that the pattern takes.
+     * @return The number of arguments that the pattern takes.
+     */
+    size_t num_args() const { return names_.size(); }
+    /**
+     * Gets the placeholder names, in the order of the arguments.
+     * @return The placeholder names.
+     */
+    const std::vector<string>& arg_names() const { return names_; }
+    /**
+     * Formats a topic.
+     * @param args The arguments, in the order of the placeholders.
+     * @param n The number of arguments.
+     * @return A reference to the topic.
+     * @throw std::invalid_argument if the number of arguments is wrong, or
+     *  	  an argument contains a '/', '+', '#', or NUL character.
+     */
+    string_ref format(const std::string_view* args, size_t n) const;
+    /**
+     * Formats a topic.
+     * @param args The arguments, in the order of the placeholders.
+     * @return A reference to the topic.
+     * @throw std::invalid_argument if the arguments aren't valid.
+     */
+    string_ref format(std::initializer_list<std::string_view> args) const {
+        return format(args.begin(), args.size());
+    }
+    /**
+     * Formats a topic from arguments of mixed types.
+     * The arguments can be strings, or integers, which are written in
+     * decimal without allocating.
+     * @param args The arguments, in the order of the placeholders.
+     * @return A reference to the topic.
+     * @throw std::invalid_argument if the arguments aren't valid.
+     */
+    template <typename... Args>
+    string_ref operator()(const Args&... args) const {
+        [[maybe_unused]] char bufs[sizeof...(Args) + 1][MAX_INT_LEN];
+        [[maybe_unused]] size_t i = 0;
+        std::string_view views[sizeof...(Args) + 1] = {arg_view(args, bufs[i++])...};
+        return format(views, sizeof...(Args));
+    }
+    /**
+     * Formats a topic, appending it to a caller's string.
+     * This doesn't use the pool or the cache, so a reused string can
+     * hold the topic with no allocations.
+     * @param out The string to append the topic to.
+     * @param args The arguments, in the order of the placeholders.
+     * @param n The number of arguments.
+     * @throw std::invalid_argument if the arguments aren't valid.
+     */
+    void format_to(string& out, const std::string_view* args, size_t n) const;
+    /**
+     * Gets the number of topics in the cache.
+     * @return The number of topics in the cache.
+     */
+    size_t cache_size() const;
+    /**
+     * Gets the number of times a topic was found in the cache.
+     * @return The number of cache hits.
+     */
+    size_t cache_hits() const;
+    /**
+     * Gets the number of buffers waiting in the pool.
+     * @return The number of buffers waiting in the pool.
+     */
+    size_t pool_size() const;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_topic_template_h
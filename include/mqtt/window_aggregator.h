@@ -0,0 +1,279 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file window_aggregator.h
+/// Declaration of MQTT window_aggregator class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_window_aggregator_h
+#define __mqtt_window_aggregator_h
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "mqtt/iasync_client.h"
+#include "mqtt/message.h"
+#include "mqtt/topic.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Aggregates numeric samples over fixed time windows, and publishes one
+ * summary message per topic for each window.
+ *
+ * This is meant for edge devices that sample much faster than anyone
+ * upstream needs to see. Rather than publishing each sample, the app
+ * hands them to the aggregator, which keeps a running minimum, maximum,
+ * sum, count, and last value for each topic. At the end of each window, a
+ * single timer thread publishes a summary for each topic that had any
+ * samples, then starts the next window.
+ *
+ * The windows are aligned to multiples of the window length on the system
+ * clock, so a one-minute window closes on the minute. Aggregators in
+ * different processes, or in the same one after a restart, close their
+ * windows at the same times.
+ *
+ * An app that already publishes each sample doesn't have to change how it
+ * publishes them. It can name the topics to aggregate, and install the
+ * aggregator on the client as a publish interceptor:
+ * @code
+ * mqtt::window_aggregator agg{cli, 60s};
+ * agg.aggregate("sensors/#");
+ * cli.set_publish_interceptor(agg.interceptor());
+ * // ...
+ * cli.publish("sensors/temp", std::to_string(val));  // Goes to the aggregator
+ * @endcode
+ *
+ * By default the summary is published on the same topic as the samples,
+ * with a small JSON payload, like:
+ * @code
+ * {"min":20.1,"max":20.9,"mean":20.46,"last":20.5,"count":1000}
+ * @endcode
+ * A different format can be supplied when the aggregator is created.
+ *
+ * Topics that go a whole window without a sample are dropped from the
+ * table, so it only holds the topics that are active.
+ */
+class window_aggregator
+{
+public:
+    /** The clock used for the windows */
+    using clock = std::chrono::steady_clock;
+    /** The type for the window length */
+    using duration = std::chrono::milliseconds;
+
+    /** The summary of the samples for a topic over one window */
+    struct summary
+    {
+        /** The smallest sample */
+        double min{0.0};
+        /** The largest sample */
+        double max{0.0};
+        /** The sum of the samples */
+        double sum{0.0};
+        /** The most recent sample */
+        double last{0.0};
+        /** The number of samples */
+        uint64_t count{0};
+
+        /**
+         * Gets the mean of the samples.
+         * @return The mean of the samples, or zero if there are none.
+         */
+        double mean() const { return count ? (sum / double(count)) : 0.0; }
+    };
+
+    /** Function to create the summary message for a topic */
+    using format_function = std::function<message_ptr(const string& topic, const summary&)>;
+    /** Function that takes over outgoing messages for the aggregator */
+    using interceptor_function = std::function<bool(const message&)>;
+
+private:
+    /** Lock guard type for this class */
+    using guard = std::lock_guard<std::mutex>;
+    /** Unique lock type for this class */
+    using unique_lock = std::unique_lock<std::mutex>;
+
+    /** The client */
+    iasync_client& cli_;
+    /** The window length */
+    duration window_;
+    /** The function to create the summary messages */
+    format_function fmt_;
+    /** Object monitor mutex */
+    std::mutex lock_;
+    /** Signaled to stop the timer thread */
+    std::condition_variable cond_;
+    /** The current window for each active topic */
+    std::unordered_map<string, summary> windows_;
+    /** The topics to take over from the client's publishes */
+    std::vector<topic_filter> filters_;
+    /** Whether the aggregator was stopped */
+    bool stopped_{false};
+    /** The number of samples added */
+    uint64_t nSamples_{0};
+    /** The number of summaries published */
+    uint64_t nSummaries_{0};
+    /** The number of summaries the client rejected */
+    uint64_t nErrors_{0};
+    /** Serializes flushes from the timer and the app */
+    std::mutex flushLock_;
+    /** The timer thread */
+    std::thread thr_;
+
+    /** Non-copyable */
+    window_aggregator(const window_aggregator&) = delete;
+    window_aggregator& operator=(const window_aggregator&) = delete;
+
+    /** The timer thread function */
+    void run();
+    /**
+     * Gets the index of the window boundary after the current time,
+     * counting windows from the system clock's epoch.
+     */
+    int64_t next_edge() const;
+
+public:
+    /**
+     * Creates an aggregator and starts its timer.
+     * @param cli The client to publish the summaries. This must outlive
+     *  		  the aggregator.
+     * @param window The length of each window.
+     * @param qos The quality of service for the summaries.
+     * @param retained Whether the summaries should be retained.
+     */
+    window_aggregator(
+        iasync_client& cli, duration window, int qos = message::DFLT_QOS,
+        bool retained = message::DFLT_RETAINED
+    );
+    /**
+     * Creates an aggregator with a custom summary format, and starts its
+     * timer.
+     * @param cli The client to publish the summaries. This must outlive
+     *  		  the aggregator.
+     * @param window The length of each window.
+     * @param fmt The function to create the summary messages. If it returns
+     *  		  nullptr, nothing is published for that topic.
+     */
+    window_aggregator(iasync_client& cli, duration window, format_function fmt);
+    /**
+     * Stops the timer and publishes any partial window.
+     */
+    ~window_aggregator();
+    /**
+     * Gets a format function that publishes summaries as JSON.
+     * @param qos The quality of service for the summaries.
+     * @param retained Whether the summaries should be retained.
+     * @param topicSuffix A string to append to the topic of the samples to
+     *  				  get the topic of the summaries.
+     * @return A function to create the summary messages.
+     */
+    static format_function json_format(
+        int qos = message::DFLT_QOS, bool retained = message::DFLT_RETAINED,
+        const string& topicSuffix = string()
+    );
+    /**
+     * Adds a sample for a topic to the current window.
+     * @param topic The topic.
+     * @param val The sample value.
+     */
+    void add(const string& topic, double val);
+    /**
+     * Adds a message with a numeric payload to the current window.
+     * This lets an app that publishes each sample as a message switch
+     * over to the aggregator without changing how it creates the samples.
+     * @param msg The message.
+     * @return @em true if the payload was a number and was added, @em false
+     *  	   if it wasn't, and the message was ignored.
+     */
+    bool add(const message& msg);
+    /**
+     * Adds topics for intercept() to take over.
+     * @param topicFilter A topic filter, which may have wildcards.
+     */
+    void aggregate(const string& topicFilter);
+    /**
+     * Takes over an outgoing message, if it's for one of the aggregated
+     * topics and has a numeric payload.
+     * The summaries that the aggregator publishes itself are never taken.
+     * @param msg The message.
+     * @return @em true if the message was added to the current window,
+     *  	   and shouldn't be sent, @em false if it should be sent as
+     *  	   usual.
+     */
+    bool intercept(const message& msg);
+    /**
+     * Gets a function to install as the client's publish interceptor, so
+     * that samples published through the client go to the aggregator.
+     * The interceptor must be removed from the client before the
+     * aggregator is destroyed.
+     * @return A function that calls intercept().
+     */
+    interceptor_function interceptor() {
+        return [this](const message& msg) { return intercept(msg); };
+    }
+    /**
+     * Closes the current window early, publishing the summaries.
+     */
+    void flush();
+    /**
+     * Stops the timer and publishes any partial window.
+     * No more samples should be added after this.
+     */
+    void stop();
+    /**
+     * Gets the length of each window.
+     * @return The length of each window.
+     */
+    duration get_window() const { return window_; }
+    /**
+     * Gets the number of topics with samples in the current window.
+     * @return The number of active topics.
+     */
+    size_t num_topics();
+    /**
+     * Gets the number of samples added.
+     * @return The number of samples added.
+     */
+    uint64_t num_samples();
+    /**
+     * Gets the number of summaries published.
+     * @return The number of summaries published.
+     */
+    uint64_t num_summaries();
+    /**
+     * Gets the number of summaries that the client failed to publish.
+     * @return The number of failed summaries.
+     */
+    uint64_t num_errors();
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_window_aggregator_h
@@ -19,6 +19,7 @@
 
 #include "mqtt/async_client.h"
 
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
 #include <cstdio>
@@ -67,13 +68,7 @@ void async_client::create()
         );
     }
     else {
-        persist_.reset(new MQTTClient_persistence{
-            *userp, &iclient_persistence::persistence_open,
-            &iclient_persistence::persistence_close, &iclient_persistence::persistence_put,
-            &iclient_persistence::persistence_get, &iclient_persistence::persistence_remove,
-            &iclient_persistence::persistence_keys, &iclient_persistence::persistence_clear,
-            &iclient_persistence::persistence_containskey
-        });
+        persist_.reset(new MQTTClient_persistence{iclient_persistence::c_struct(*userp)});
 
         rc = MQTTAsync_createWithOptions(
             &cli_, serverURI.c_str(), clientId.c_str(), MQTTCLIENT_PERSISTENCE_USER,
@@ -82,9 +77,24 @@ void async_client::create()
     }
     if (rc != MQTTASYNC_SUCCESS)
         throw exception(rc);
+
+    // Track the connection state whether or not the app installs any
+    // callbacks of its own.
+    MQTTAsync_setConnected(cli_, this, &async_client::on_connected);
+    MQTTAsync_setConnectionLostCallback(cli_, this, &async_client::on_connection_lost);
 }
 
-async_client::~async_client() { MQTTAsync_destroy(&cli_); }
+async_client::~async_client()
+{
+    // Destroying the C client fails any requests still pending, which
+    // removes their tokens, and cancels their deadlines. So the timer has
+    // to outlive it. It's stopped afterwards, before the members that it
+    // expires tokens into.
+    MQTTAsync_destroy(&cli_);
+
+    timersStarted_.store(false, std::memory_order_release);
+    timers_.reset();
+}
 
 // --------------------------------------------------------------------------
 // Class static callbacks.
@@ -106,13 +116,21 @@ void async_client::on_connected(void* context, char* cause)
         return;
 
     async_client* cli = static_cast<async_client*>(context);
+    cli->set_connected(true);
 
-    auto tok = cli->connTok_;
-    if (tok)
+    // The connect token may have already been completed by the response
+    // to the connect request.
+    token_ptr tok;
+    {
+        guard g(cli->lock_);
+        tok = cli->connTok_;
+    }
+    if (tok && !tok->is_complete())
         tok->on_success(nullptr);
 
-    callback* cb = cli->userCallback_;
-    auto& connHandler = cli->connHandler_;
+    auto cbs = cli->get_callbacks();
+    callback* cb = cbs->userCallback;
+    auto& connHandler = cbs->connHandler;
     auto& que = cli->que_;
 
     if (cb || connHandler || que) {
@@ -150,9 +168,15 @@ void async_client::on_connection_lost(void* context, char* cause)
         return;
 
     async_client* cli = static_cast<async_client*>(context);
+    cli->set_connected(false);
+    cli->release_expired_tokens();
+
+    auto cbs = cli->get_callbacks();
+    if (!cbs->connLostEnabled)
+        return;
 
-    callback* cb = cli->userCallback_;
-    auto& connLostHandler = cli->connLostHandler_;
+    callback* cb = cbs->userCallback;
+    auto& connLostHandler = cbs->connLostHandler;
     auto& que = cli->que_;
 
     if (cb || connLostHandler || que) {
@@ -184,8 +208,11 @@ void async_client::on_disconnected(
         return;
 
     async_client* cli = static_cast<async_client*>(context);
+    cli->set_connected(false);
+    cli->release_expired_tokens();
 
-    auto& disconnectedHandler = cli->disconnectedHandler_;
+    auto cbs = cli->get_callbacks();
+    auto& disconnectedHandler = cbs->disconnectedHandler;
     auto& que = cli->que_;
 
     if (disconnectedHandler || que) {
@@ -215,13 +242,42 @@ int async_client::on_message_arrived(
         return to_int(true);
 
     async_client* cli = static_cast<async_client*>(context);
-    callback* cb = cli->userCallback_;
+    auto cbs = cli->get_callbacks();
+    callback* cb = cbs->userCallback;
     auto& que = cli->que_;
-    auto& msgHandler = cli->msgHandler_;
+    auto& msgHandler = cbs->msgHandler;
 
     if (cb || que || msgHandler) {
         size_t len = (topicLen == 0) ? strlen(topicName) : size_t(topicLen);
 
+        // A corrupt payload is dropped before anything else sees it
+        if (cli->integrity_.load(std::memory_order_relaxed) &&
+            payload_integrity::check(message_view{std::string_view{topicName, len}, *msg}) ==
+                payload_integrity::CORRUPT) {
+            cli->nCorrupt_.fetch_add(1, std::memory_order_relaxed);
+            MQTTAsync_freeMessage(&msg);
+            MQTTAsync_free(topicName);
+            return to_int(true);
+        }
+
+        // Screen the message against the raw C buffers, before creating
+        // any objects for it.
+        if (cbs->msgFilter) {
+            bool keep = true;
+            try {
+                keep = cbs->msgFilter(message_view{std::string_view{topicName, len}, *msg});
+            }
+            catch (...) {
+            }
+
+            if (!keep) {
+                cli->nFiltered_.fetch_add(1, std::memory_order_relaxed);
+                MQTTAsync_freeMessage(&msg);
+                MQTTAsync_free(topicName);
+                return to_int(true);
+            }
+        }
+
         string topic{topicName, len};
         auto m = message::create(std::move(topic), *msg);
 
@@ -251,7 +307,8 @@ int async_client::on_update_connection(void* context, MQTTAsync_connectData* cda
 {
     if (context) {
         async_client* cli = static_cast<async_client*>(context);
-        auto& updateConnection = cli->updateConnectionHandler_;
+        auto cbs = cli->get_callbacks();
+        auto& updateConnection = cbs->updateConnectionHandler;
 
         if (updateConnection) {
             connect_data data(*cdata);
@@ -288,19 +345,85 @@ int async_client::on_update_connection(void* context, MQTTAsync_connectData* cda
 // --------------------------------------------------------------------------
 // Private methods
 
+// Each new connection bumps the epoch before it's marked as connected, so
+// anyone who sees the connected state also sees the new epoch.
+
+void async_client::set_connected(bool on)
+{
+    if (on && !connected_.load(std::memory_order_relaxed)) {
+        connEpoch_.fetch_add(1, std::memory_order_release);
+
+        // A clean session starts with no subscriptions on the server
+        auto opts = std::atomic_load(&connOpts_);
+        if (opts->opts_.cleansession || opts->opts_.cleanstart) {
+            guard g(subLock_);
+            subs_.clear();
+        }
+    }
+    connected_.store(on, std::memory_order_release);
+}
+
+// The known subscriptions are updated from the completion of each
+// request, so they only hold the filters that the server accepted. The
+// requested QoS is kept, rather than the one granted, so that a later
+// sync doesn't keep asking again for a QoS the server won't give.
+
+void async_client::track_subscribe(
+    const token_ptr& tok, const qos_collection& qos,
+    const std::vector<subscribe_options>& opts
+)
+{
+    tok->on_complete([this, qos, opts](token& t) {
+        if (!t)
+            return;
+
+        auto topics = t.get_topics();
+        std::vector<ReasonCode> rcs;
+        try {
+            rcs = t.get_subscribe_response().get_reason_codes();
+        }
+        catch (...) {
+        }
+
+        guard g(subLock_);
+        for (size_t i = 0; i < topics->size() && i < qos.size(); ++i) {
+            if (i < rcs.size() && rcs[i] >= ReasonCode::UNSPECIFIED_ERROR)
+                continue;
+            subs_.add(
+                (*topics)[i], qos[i], (i < opts.size()) ? opts[i] : subscribe_options{}
+            );
+        }
+    });
+}
+
+void async_client::track_unsubscribe(const token_ptr& tok)
+{
+    tok->on_complete([this](token& t) {
+        if (!t)
+            return;
+
+        auto topics = t.get_topics();
+        guard g(subLock_);
+        for (size_t i = 0; i < topics->size(); ++i) subs_.remove((*topics)[i]);
+    });
+}
+
 void async_client::add_token(token_ptr tok)
 {
     if (tok) {
-        guard g(lock_);
-        pendingTokens_.push_back(tok);
+        auto& shard = shard_for(tok.get());
+        guard g(shard.lock);
+        shard.tokens.emplace(tok.get(), tok);
     }
 }
 
 void async_client::add_token(delivery_token_ptr tok)
 {
     if (tok) {
-        guard g(lock_);
-        pendingDeliveryTokens_.push_back(tok);
+        auto& shard = shard_for(tok.get());
+        guard g(shard.lock);
+        shard.deliveryTokens.emplace(tok.get(), tok);
+        nDeliveryTokens_.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
@@ -312,56 +435,142 @@ void async_client::remove_token(token* tok)
     if (!tok)
         return;
 
-    guard g(lock_);
-    for (auto p = pendingDeliveryTokens_.begin(); p != pendingDeliveryTokens_.end(); ++p) {
-        if (p->get() == tok) {
-            delivery_token_ptr dtok = *p;
-            pendingDeliveryTokens_.erase(p);
-
-            // If there's a user callback registered, we can now call
-            // delivery_complete()
-
-            if (userCallback_) {
-                const_message_ptr msg = dtok->get_message();
-                if (msg && msg->get_qos() > 0) {
-                    callback* cb = userCallback_;
-                    g.unlock();
-                    cb->delivery_complete(dtok);
-                }
-            }
-            return;
+    if (timersStarted_.load(std::memory_order_acquire))
+        timers_->cancel(tok);
+
+    auto& shard = shard_for(tok);
+    guard g(shard.lock);
+
+    auto dp = shard.deliveryTokens.find(tok);
+    if (dp != shard.deliveryTokens.end()) {
+        delivery_token_ptr dtok = std::move(dp->second);
+        shard.deliveryTokens.erase(dp);
+        nDeliveryTokens_.fetch_sub(1, std::memory_order_relaxed);
+        g.unlock();
+
+        auto policy = get_publish_policy();
+        if (policy && dtok->sendTime_ != std::chrono::steady_clock::time_point{}) {
+            policy->on_delivered(
+                std::chrono::duration_cast<publish_policy::duration>(
+                    std::chrono::steady_clock::now() - dtok->sendTime_
+                )
+            );
         }
-    }
-    for (auto p = pendingTokens_.begin(); p != pendingTokens_.end(); ++p) {
-        if (p->get() == tok) {
-            pendingTokens_.erase(p);
-            return;
+
+        // If there's a user callback registered, we can now call
+        // delivery_complete()
+
+        callback* cb = get_callbacks()->userCallback;
+        if (cb && !dtok->is_timed_out()) {
+            const_message_ptr msg = dtok->get_message();
+            if (msg && msg->get_qos() > 0)
+                cb->delivery_complete(dtok);
         }
+        return;
     }
+    if (shard.tokens.erase(tok) == 0)
+        shard.expiredTokens.erase(tok);
 }
 
 // --------------------------------------------------------------------------
-// Callback management
+// Deadlines
 
-void async_client::set_callback(callback& cb)
+void async_client::set_deadline(token_ptr tok, const deadline_type& deadline)
 {
-    {
+    if (!timersStarted_.load(std::memory_order_acquire)) {
         guard g(lock_);
-        userCallback_ = &cb;
+        if (!timers_) {
+            timers_ = std::make_unique<timer_wheel>([this](token_ptr tok) {
+                on_deadline(std::move(tok));
+            });
+            timersStarted_.store(true, std::memory_order_release);
+        }
     }
-    int rc = MQTTAsync_setConnected(cli_, this, &async_client::on_connected);
+    timers_->schedule(std::move(tok), deadline);
+}
 
-    if (rc == MQTTASYNC_SUCCESS) {
-        MQTTAsync_setCallbacks(
-            cli_, this, &async_client::on_connection_lost, &async_client::on_message_arrived,
-            nullptr /*&async_client::on_delivery_complete*/
-        );
+// Called from the timer thread when a token reaches its deadline.
+//
+// The token is failed with a timeout and dropped from the pending tables,
+// but the C library still has its address as the context for the
+// response callbacks. So we park it until the late response (if any)
+// releases it through remove_token().
+void async_client::on_deadline(token_ptr tok)
+{
+    if (!tok || !tok->on_timeout())
+        return;
+
+    token* ptok = tok.get();
+    auto& shard = shard_for(ptok);
+    guard g(shard.lock);
+
+    auto dp = shard.deliveryTokens.find(ptok);
+    if (dp != shard.deliveryTokens.end()) {
+        shard.deliveryTokens.erase(dp);
+        nDeliveryTokens_.fetch_sub(1, std::memory_order_relaxed);
+        shard.expiredTokens.emplace(ptok, std::move(tok));
+        return;
     }
-    else {
-        MQTTAsync_setConnected(cli_, nullptr, nullptr);
 
-        guard g(lock_);
-        userCallback_ = nullptr;
+    auto p = shard.tokens.find(ptok);
+    if (p != shard.tokens.end()) {
+        shard.tokens.erase(p);
+        shard.expiredTokens.emplace(ptok, std::move(tok));
+    }
+}
+
+// The C library drops a session's requests when it ends, calling the
+// failure callback of each one, so by the time the connection is reported
+// closed, it no longer holds any of the expired tokens, and they can all be
+// released. For a session that outlives the connection, the library keeps
+// the requests and still responds to them after a reconnect, so those
+// tokens must be kept until it does. The same goes for a client that
+// buffers publishes while offline, since the buffered requests survive the
+// loss of the connection, even for a clean session. Those tokens are only
+// released when the library reports them, or the client is destroyed.
+
+bool async_client::session_ends_on_close() const
+{
+    auto opts = std::atomic_load(&connOpts_);
+    if (mqttVersion_ < MQTTVERSION_5)
+        return opts->opts_.cleansession != 0;
+
+    const auto& props = opts->get_properties();
+    return !props.contains(property::SESSION_EXPIRY_INTERVAL) ||
+           get<uint32_t>(props, property::SESSION_EXPIRY_INTERVAL) == 0;
+}
+
+void async_client::release_expired_tokens()
+{
+    if (createOpts_.get_send_while_disconnected() || !session_ends_on_close())
+        return;
+
+    for (auto& shard : shards_) {
+        std::unordered_map<const token*, token_ptr> expired;
+        {
+            guard g(shard.lock);
+            expired.swap(shard.expiredTokens);
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+// Callback management
+
+void async_client::set_callback(callback& cb)
+{
+    update_callbacks([&cb](callbacks& cbs) {
+        cbs.userCallback = &cb;
+        cbs.connLostEnabled = true;
+    });
+
+    int rc = MQTTAsync_setCallbacks(
+        cli_, this, &async_client::on_connection_lost, &async_client::on_message_arrived,
+        nullptr /*&async_client::on_delivery_complete*/
+    );
+
+    if (rc != MQTTASYNC_SUCCESS) {
+        update_callbacks([](callbacks& cbs) { cbs.userCallback = nullptr; });
         throw exception(rc);
     }
 }
@@ -371,9 +580,12 @@ void async_client::disable_callbacks()
     // TODO: It would be nice to disable callbacks at the C library level,
     // but the setCallback function currently does not accept a nullptr for
     // the "message arrived" parameter. So, for now we send it an empty
-    // lambda function.
+    // lambda function. The connection lost callback stays installed to
+    // track the connection state, but no longer reaches the app.
+    update_callbacks([](callbacks& cbs) { cbs.connLostEnabled = false; });
+
     int rc = MQTTAsync_setCallbacks(
-        cli_, this, nullptr,
+        cli_, this, &async_client::on_connection_lost,
         [](void*, char*, int, MQTTAsync_message*) -> int { return to_int(true); }, nullptr
     );
 
@@ -383,13 +595,16 @@ void async_client::disable_callbacks()
 
 void async_client::set_connected_handler(connection_handler cb)
 {
-    connHandler_ = cb;
+    update_callbacks([&cb](callbacks& cbs) { cbs.connHandler = std::move(cb); });
     check_ret(::MQTTAsync_setConnected(cli_, this, &async_client::on_connected));
 }
 
 void async_client::set_connection_lost_handler(connection_handler cb)
 {
-    connLostHandler_ = cb;
+    update_callbacks([&cb](callbacks& cbs) {
+        cbs.connLostHandler = std::move(cb);
+        cbs.connLostEnabled = true;
+    });
     check_ret(
         ::MQTTAsync_setConnectionLostCallback(cli_, this, &async_client::on_connection_lost)
     );
@@ -397,21 +612,26 @@ void async_client::set_connection_lost_handler(connection_handler cb)
 
 void async_client::set_disconnected_handler(disconnected_handler cb)
 {
-    disconnectedHandler_ = cb;
+    update_callbacks([&cb](callbacks& cbs) { cbs.disconnectedHandler = std::move(cb); });
     check_ret(::MQTTAsync_setDisconnected(cli_, this, &async_client::on_disconnected));
 }
 
 void async_client::set_message_callback(message_handler cb)
 {
-    msgHandler_ = cb;
+    update_callbacks([&cb](callbacks& cbs) { cbs.msgHandler = std::move(cb); });
     check_ret(
         ::MQTTAsync_setMessageArrivedCallback(cli_, this, &async_client::on_message_arrived)
     );
 }
 
+void async_client::set_message_filter(message_filter filt)
+{
+    update_callbacks([&filt](callbacks& cbs) { cbs.msgFilter = std::move(filt); });
+}
+
 void async_client::set_update_connection_handler(update_connection_handler cb)
 {
-    updateConnectionHandler_ = cb;
+    update_callbacks([&cb](callbacks& cbs) { cbs.updateConnectionHandler = std::move(cb); });
     check_ret(
         ::MQTTAsync_setUpdateConnectOptions(cli_, this, &async_client::on_update_connection)
     );
@@ -434,29 +654,45 @@ token_ptr async_client::connect(connect_options opts)
     else
         opts.opts_.cleansession = 0;
 
+    auto tok = token::create(token::Type::CONNECT, *this);
+    tok->on_complete([this](token& t) {
+        if (t.get_return_code() == MQTTASYNC_SUCCESS)
+            set_connected(true);
+    });
+    add_token(tok);
+
+    opts.set_token(tok);
+
     // TODO: If connTok_ is non-null, there could be a pending connect
     // which might complete after creating/assigning a new one. If that
     // happened, the callback would have the context address of the previous
     // token which was destroyed. So for now, keep the old one alive within
     // this function, and check the behavior of the C library...
-    auto tmpTok = connTok_;
-    connTok_ = token::create(token::Type::CONNECT, *this);
-    add_token(connTok_);
-
-    opts.set_token(connTok_);
+    //
+    // The same goes for the previous options, since the C library keeps
+    // pointers into them.
+    auto copts = std::make_shared<connect_options>(std::move(opts));
+    token_ptr tmpTok;
+    {
+        guard g(lock_);
+        tmpTok = std::move(connTok_);
+        connTok_ = tok;
+    }
+    auto tmpOpts = std::atomic_exchange(&connOpts_, copts);
 
-    // TODO: Lock!
-    connOpts_ = std::move(opts);
-    int rc = MQTTAsync_connect(cli_, &connOpts_.opts_);
+    int rc = MQTTAsync_connect(cli_, &copts->opts_);
 
     if (rc != MQTTASYNC_SUCCESS) {
-        remove_token(connTok_);
-        connTok_.reset();
+        remove_token(tok);
+        guard g(lock_);
+        if (connTok_ == tok)
+            connTok_.reset();
         throw exception(rc);
     }
 
     UNUSED(tmpTok);
-    return connTok_;
+    UNUSED(tmpOpts);
+    return tok;
 }
 
 token_ptr async_client::connect(connect_options opts, void* userContext, iaction_listener& cb)
@@ -470,24 +706,38 @@ token_ptr async_client::connect(connect_options opts, void* userContext, iaction
     else
         opts.opts_.cleansession = 0;
 
-    // Keep the old connTok_ alive (see above)
-    auto tmpTok = connTok_;
-    connTok_ = token::create(token::Type::CONNECT, *this, userContext, cb);
-    add_token(connTok_);
+    auto tok = token::create(token::Type::CONNECT, *this, userContext, cb);
+    tok->on_complete([this](token& t) {
+        if (t.get_return_code() == MQTTASYNC_SUCCESS)
+            set_connected(true);
+    });
+    add_token(tok);
+
+    opts.set_token(tok);
 
-    opts.set_token(connTok_);
+    // Keep the old connTok_ and options alive (see above)
+    auto copts = std::make_shared<connect_options>(std::move(opts));
+    token_ptr tmpTok;
+    {
+        guard g(lock_);
+        tmpTok = std::move(connTok_);
+        connTok_ = tok;
+    }
+    auto tmpOpts = std::atomic_exchange(&connOpts_, copts);
 
-    connOpts_ = std::move(opts);
-    int rc = MQTTAsync_connect(cli_, &connOpts_.opts_);
+    int rc = MQTTAsync_connect(cli_, &copts->opts_);
 
     if (rc != MQTTASYNC_SUCCESS) {
-        remove_token(connTok_);
-        connTok_.reset();
+        remove_token(tok);
+        guard g(lock_);
+        if (connTok_ == tok)
+            connTok_.reset();
         throw exception(rc);
     }
 
     UNUSED(tmpTok);
-    return connTok_;
+    UNUSED(tmpOpts);
+    return tok;
 }
 
 // --------------------------------------------------------------------------
@@ -495,7 +745,11 @@ token_ptr async_client::connect(connect_options opts, void* userContext, iaction
 
 token_ptr async_client::reconnect()
 {
-    auto tok = connTok_;
+    token_ptr tok;
+    {
+        guard g(lock_);
+        tok = connTok_;
+    }
 
     if (!tok)
         throw exception(MQTTASYNC_FAILURE, "Can't reconnect before a successful connect");
@@ -522,6 +776,12 @@ token_ptr async_client::reconnect()
 token_ptr async_client::disconnect(disconnect_options opts)
 {
     auto tok = token::create(token::Type::DISCONNECT, *this);
+    tok->on_complete([this](token& t) {
+        if (t.get_return_code() == MQTTASYNC_SUCCESS) {
+            set_connected(false);
+            release_expired_tokens();
+        }
+    });
     add_token(tok);
 
     opts.set_token(tok, mqttVersion_);
@@ -539,6 +799,12 @@ token_ptr async_client::disconnect(disconnect_options opts)
 token_ptr async_client::disconnect(int timeout, void* userContext, iaction_listener& cb)
 {
     auto tok = token::create(token::Type::DISCONNECT, *this, userContext, cb);
+    tok->on_complete([this](token& t) {
+        if (t.get_return_code() == MQTTASYNC_SUCCESS) {
+            set_connected(false);
+            release_expired_tokens();
+        }
+    });
     add_token(tok);
 
     disconnect_options opts(timeout);
@@ -566,13 +832,13 @@ delivery_token_ptr async_client::get_pending_delivery_token(int msgID) const
     // msgID and signal it, indicating completion.
 
     if (msgID > 0) {
-        guard g(lock_);
-        const auto it = std::find_if(
-            pendingDeliveryTokens_.cbegin(), pendingDeliveryTokens_.cend(),
-            [msgID](const auto& t) { return t->get_message_id() == msgID; }
-        );
-        if (it != pendingDeliveryTokens_.end())
-            return *it;
+        for (auto& shard : shards_) {
+            guard g(shard.lock);
+            for (const auto& t : shard.deliveryTokens) {
+                if (t.second->get_message_id() == msgID)
+                    return t.second;
+            }
+        }
     }
     return delivery_token_ptr();
 }
@@ -580,10 +846,12 @@ delivery_token_ptr async_client::get_pending_delivery_token(int msgID) const
 std::vector<delivery_token_ptr> async_client::get_pending_delivery_tokens() const
 {
     std::vector<delivery_token_ptr> toks;
-    guard g(lock_);
-    for (const auto& t : pendingDeliveryTokens_) {
-        if (t->get_message_id() > 0) {
-            toks.push_back(t);
+    for (auto& shard : shards_) {
+        guard g(shard.lock);
+        for (const auto& t : shard.deliveryTokens) {
+            if (t.second->get_message_id() > 0) {
+                toks.push_back(t.second);
+            }
         }
     }
     return toks;
@@ -622,12 +890,13 @@ delivery_token_ptr async_client::publish(
 delivery_token_ptr async_client::publish(const_message_ptr msg)
 {
     auto tok = delivery_token::create(*this, msg);
+    if (!apply_publish_policy(tok, msg))
+        return tok;
     add_token(tok);
 
     delivery_response_options rspOpts(tok, mqttVersion_);
 
-    int rc =
-        MQTTAsync_sendMessage(cli_, msg->get_topic().c_str(), &(msg->msg_), &rspOpts.opts_);
+    int rc = send_message(msg->get_topic().c_str(), msg->msg_, rspOpts.opts_);
 
     if (rc == MQTTASYNC_SUCCESS) {
         tok->set_message_id(rspOpts.opts_.token);
@@ -645,12 +914,13 @@ delivery_token_ptr async_client::publish(
 )
 {
     delivery_token_ptr tok = delivery_token::create(*this, msg, userContext, cb);
+    if (!apply_publish_policy(tok, msg))
+        return tok;
     add_token(tok);
 
     delivery_response_options rspOpts(tok, mqttVersion_);
 
-    int rc =
-        MQTTAsync_sendMessage(cli_, msg->get_topic().c_str(), &(msg->msg_), &rspOpts.opts_);
+    int rc = send_message(msg->get_topic().c_str(), msg->msg_, rspOpts.opts_);
 
     if (rc == MQTTASYNC_SUCCESS) {
         tok->set_message_id(rspOpts.opts_.token);
@@ -663,6 +933,173 @@ delivery_token_ptr async_client::publish(
     return tok;
 }
 
+delivery_token_ptr async_client::publish(const_message_ptr msg, const deadline_type& deadline)
+{
+    auto tok = delivery_token::create(*this, msg);
+    if (!apply_publish_policy(tok, msg))
+        return tok;
+    add_token(tok);
+    set_deadline(tok, deadline);
+
+    delivery_response_options rspOpts(tok, mqttVersion_);
+
+    int rc = send_message(msg->get_topic().c_str(), msg->msg_, rspOpts.opts_);
+
+    if (rc == MQTTASYNC_SUCCESS) {
+        tok->set_message_id(rspOpts.opts_.token);
+    }
+    else {
+        remove_token(tok);
+        throw exception(rc);
+    }
+
+    return tok;
+}
+
+delivery_token_ptr async_client::publish(
+    const_message_ptr msg, const deadline_type& deadline, void* userContext,
+    iaction_listener& cb
+)
+{
+    delivery_token_ptr tok = delivery_token::create(*this, msg, userContext, cb);
+    if (!apply_publish_policy(tok, msg))
+        return tok;
+    add_token(tok);
+    set_deadline(tok, deadline);
+
+    delivery_response_options rspOpts(tok, mqttVersion_);
+
+    int rc = send_message(msg->get_topic().c_str(), msg->msg_, rspOpts.opts_);
+
+    if (rc == MQTTASYNC_SUCCESS) {
+        tok->set_message_id(rspOpts.opts_.token);
+    }
+    else {
+        remove_token(tok);
+        throw exception(rc);
+    }
+
+    return tok;
+}
+
+delivery_token_ptr async_client::publish(
+    const publish_template& tmpl, const void* payload, size_t n
+)
+{
+    if (get_publish_policy() || std::atomic_load(&interceptor_)) {
+        binary_ref buf(static_cast<const binary_ref::value_type*>(payload), n);
+        return publish(tmpl.to_message(std::move(buf)));
+    }
+
+    // A QoS 0 publish is never reported through delivery_complete(), so
+    // only a QoS 1 or 2 token needs a message to hand to the callback.
+    delivery_token_ptr tok;
+    if (tmpl.get_qos() == 0) {
+        tok = delivery_token::create(*this);
+    }
+    else {
+        binary_ref buf(static_cast<const binary_ref::value_type*>(payload), n);
+        tok = delivery_token::create(*this, tmpl.to_message(std::move(buf)));
+    }
+    add_token(tok);
+
+    MQTTAsync_responseOptions opts = MQTTAsync_responseOptions_initializer;
+    if (mqttVersion_ < MQTTVERSION_5) {
+        opts.onSuccess = &delivery_token::on_success;
+        opts.onFailure = &delivery_token::on_failure;
+    }
+    else {
+        opts.onSuccess5 = &delivery_token::on_success5;
+        opts.onFailure5 = &delivery_token::on_failure5;
+    }
+    opts.context = tok.get();
+
+    MQTTAsync_message msg = tmpl.msg_;
+    msg.payload = const_cast<void*>(payload);
+    msg.payloadlen = int(n);
+
+    int rc = send_message(tmpl.topic_.c_str(), msg, opts);
+
+    if (rc == MQTTASYNC_SUCCESS) {
+        tok->set_message_id(opts.token);
+    }
+    else {
+        remove_token(tok);
+        throw exception(rc);
+    }
+
+    return tok;
+}
+
+// The checksum is added to a copy of the C properties just for the send,
+// since the C library makes its own copy of them. The message itself,
+// which the delivery token holds, is left as it was.
+
+int async_client::send_message(
+    const char* topic, const MQTTAsync_message& msg, MQTTAsync_responseOptions& opts
+)
+{
+    if (!integrity_.load(std::memory_order_relaxed) || mqttVersion_ < MQTTVERSION_5 ||
+        payload_integrity::has_checksum(msg.properties)) {
+        auto* cmsg = const_cast<MQTTAsync_message*>(&msg);
+        return MQTTAsync_sendMessage(cli_, topic, cmsg, &opts);
+    }
+
+    MQTTAsync_message cmsg = msg;
+    cmsg.properties = MQTTProperties_copy(&msg.properties);
+    payload_integrity::add(cmsg.properties, msg.payload, size_t(msg.payloadlen));
+
+    int rc = MQTTAsync_sendMessage(cli_, topic, &cmsg, &opts);
+    MQTTProperties_free(&cmsg.properties);
+    return rc;
+}
+
+// An interceptor can take over a message before anything else happens to
+// it. Under an overloaded condition, the policy can downgrade a low-value
+// message to QoS 0, so it doesn't take an in-flight slot or a persisted
+// record, or drop it entirely.
+
+bool async_client::apply_publish_policy(delivery_token_ptr& tok, const_message_ptr& msg)
+{
+    auto icpt = std::atomic_load(&interceptor_);
+    if (icpt && (*icpt)(*msg)) {
+        tok->on_success(nullptr);
+        return false;
+    }
+
+    auto policy = get_publish_policy();
+    if (!policy)
+        return true;
+
+    size_t backlog = nDeliveryTokens_.load(std::memory_order_relaxed);
+
+    switch (policy->decide(*msg, backlog)) {
+        case publish_policy::PUBLISH:
+            break;
+
+        case publish_policy::PUBLISH_QOS0: {
+            auto m = std::make_shared<message>(*msg);
+            m->set_qos(0);
+            msg = std::move(m);
+            tok->set_message(msg);
+            break;
+        }
+
+        case publish_policy::DROP: {
+            MQTTAsync_failureData rsp{};
+            rsp.code = publish_policy::DROPPED;
+            rsp.message = "Message dropped by publish policy";
+            tok->on_failure(&rsp);
+            return false;
+        }
+    }
+
+    // Only acknowledged deliveries feed the latency average.
+    if (msg->get_qos() > 0)
+        tok->sendTime_ = std::chrono::steady_clock::now();
+    return true;
+}
+
 // --------------------------------------------------------------------------
 // Subscribe
 
@@ -674,6 +1111,7 @@ token_ptr async_client::subscribe(
 {
     auto tok = token::create(token::Type::SUBSCRIBE, *this, topicFilter);
     tok->set_num_expected(0);  // Indicates non-array response for single val
+    track_subscribe(tok, {qos}, {opts});
     add_token(tok);
 
     auto rspOpts = response_options_builder(mqttVersion_)
@@ -700,6 +1138,7 @@ token_ptr async_client::subscribe(
 {
     auto tok = token::create(token::Type::SUBSCRIBE, *this, topicFilter, userContext, cb);
     tok->set_num_expected(0);
+    track_subscribe(tok, {qos}, {opts});
     add_token(tok);
 
     auto rspOpts = response_options_builder(mqttVersion_)
@@ -732,6 +1171,7 @@ token_ptr async_client::subscribe(
 
     auto tok = token::create(token::Type::SUBSCRIBE, *this, topicFilters);
     tok->set_num_expected(n);
+    track_subscribe(tok, qos, opts);
     add_token(tok);
 
     auto rspOpts = response_options_builder(mqttVersion_)
@@ -767,6 +1207,7 @@ token_ptr async_client::subscribe(
 
     auto tok = token::create(token::Type::SUBSCRIBE, *this, topicFilters, userContext, cb);
     tok->set_num_expected(n);
+    track_subscribe(tok, qos, opts);
     add_token(tok);
 
     auto rspOpts = response_options_builder(mqttVersion_)
@@ -795,6 +1236,7 @@ token_ptr async_client::
 {
     auto tok = token::create(token::Type::UNSUBSCRIBE, *this, topicFilter);
     tok->set_num_expected(0);  // Indicates non-array response for single val
+    track_unsubscribe(tok);
     add_token(tok);
 
     auto rspOpts =
@@ -818,6 +1260,7 @@ token_ptr async_client::unsubscribe(
 
     auto tok = token::create(token::Type::UNSUBSCRIBE, *this, topicFilters);
     tok->set_num_expected(n);
+    track_unsubscribe(tok);
     add_token(tok);
 
     auto rspOpts =
@@ -842,6 +1285,7 @@ token_ptr async_client::unsubscribe(
 
     auto tok = token::create(token::Type::UNSUBSCRIBE, *this, topicFilters, userContext, cb);
     tok->set_num_expected(n);
+    track_unsubscribe(tok);
     add_token(tok);
 
     auto rspOpts =
@@ -863,6 +1307,7 @@ token_ptr async_client::unsubscribe(
 )
 {
     auto tok = token::create(token::Type::UNSUBSCRIBE, *this, topicFilter, userContext, cb);
+    track_unsubscribe(tok);
     add_token(tok);
 
     auto rspOpts =
@@ -878,6 +1323,125 @@ token_ptr async_client::unsubscribe(
     return tok;
 }
 
+// --------------------------------------------------------------------------
+// Subscription sync
+
+// Each batch is an ordinary subscribe or unsubscribe, which updates the
+// known subscriptions as it completes. The aggregate token is completed
+// by whichever batch finishes last. The unsubscribes go first, so that a
+// filter isn't briefly missing if it's replaced.
+
+token_ptr async_client::sync_subscriptions(
+    const subscription_set& desired, const properties& props /*=properties()*/
+)
+{
+    subscription_set::changes chg;
+    {
+        guard g(subLock_);
+        chg = subs_.diff(desired);
+    }
+
+    auto topics = std::make_shared<string_collection>();
+    for (const auto& filter : chg.unsubscribe) topics->push_back(filter);
+    for (const auto& sub : chg.subscribe) topics->push_back(sub.first);
+
+    auto typ = chg.subscribe.empty() ? token::Type::UNSUBSCRIBE : token::Type::SUBSCRIBE;
+    auto tok = token::create(typ, *this, topics);
+    add_token(tok);
+
+    if (chg.empty()) {
+        tok->on_success(nullptr);
+        return tok;
+    }
+
+    // Split the changes into batches
+    struct batch
+    {
+        string_collection_ptr topics{std::make_shared<string_collection>()};
+        qos_collection qos;
+        std::vector<subscribe_options> opts;
+    };
+    std::vector<batch> unsubs, subs;
+
+    for (const auto& filter : chg.unsubscribe) {
+        if (unsubs.empty() || unsubs.back().topics->size() == MAX_SYNC_BATCH)
+            unsubs.emplace_back();
+        unsubs.back().topics->push_back(filter);
+    }
+    for (const auto& sub : chg.subscribe) {
+        if (subs.empty() || subs.back().topics->size() == MAX_SYNC_BATCH)
+            subs.emplace_back();
+        subs.back().topics->push_back(sub.first);
+        subs.back().qos.push_back(sub.second.qos);
+        subs.back().opts.push_back(sub.second.opts);
+    }
+
+    // The state shared by the batches. The count holds one extra for the
+    // loop sending the batches, so the aggregate can't complete before
+    // they're all out.
+    struct sync_state
+    {
+        std::mutex lock;
+        size_t nPending;
+        int rc{MQTTASYNC_SUCCESS};
+        ReasonCode reasonCode{ReasonCode::SUCCESS};
+        string errMsg;
+    };
+    auto st = std::make_shared<sync_state>();
+    st->nPending = unsubs.size() + subs.size() + 1;
+
+    auto done = [st, tok](int rc, ReasonCode reasonCode, const string& errMsg) {
+        unique_lock g(st->lock);
+        if (st->rc == MQTTASYNC_SUCCESS && st->reasonCode < ReasonCode::UNSPECIFIED_ERROR) {
+            st->rc = rc;
+            st->reasonCode = reasonCode;
+            st->errMsg = errMsg;
+        }
+        if (--st->nPending != 0)
+            return;
+        g.unlock();
+
+        if (st->rc == MQTTASYNC_SUCCESS && st->reasonCode < ReasonCode::UNSPECIFIED_ERROR) {
+            tok->on_success(nullptr);
+        }
+        else {
+            MQTTAsync_failureData5 rsp{};
+            rsp.code = st->rc;
+            rsp.reasonCode = MQTTReasonCodes(st->reasonCode);
+            rsp.message = st->errMsg.empty() ? nullptr : st->errMsg.c_str();
+            tok->on_failure5(&rsp);
+        }
+    };
+
+    auto on_batch = [done](token& t) {
+        done(t.get_return_code(), t.get_reason_code(), t.get_error_message());
+    };
+
+    size_t nSent = 0;
+    try {
+        for (auto& b : unsubs) {
+            unsubscribe(b.topics, props)->on_complete(on_batch);
+            ++nSent;
+        }
+        for (auto& b : subs) {
+            subscribe(b.topics, b.qos, b.opts, props)->on_complete(on_batch);
+            ++nSent;
+        }
+    }
+    catch (const exception& exc) {
+        if (nSent == 0) {
+            remove_token(tok.get());
+            throw;
+        }
+        // Account for the batches that weren't sent
+        for (size_t i = nSent; i < unsubs.size() + subs.size(); ++i)
+            done(exc.get_return_code(), ReasonCode::SUCCESS, exc.get_message());
+    }
+
+    done(MQTTASYNC_SUCCESS, ReasonCode::SUCCESS, string{});
+    return tok;
+}
+
 // --------------------------------------------------------------------------
 
 void async_client::start_consuming()
@@ -890,9 +1454,9 @@ void async_client::start_consuming()
     disable_callbacks();
 
     // TODO: Should we replace user callback?
-    // userCallback_ = nullptr;
 
     que_.reset(new thread_queue<event>);
+    update_callbacks([](callbacks& cbs) { cbs.connLostEnabled = true; });
 
     int rc = MQTTAsync_setCallbacks(
         cli_, this, &async_client::on_connection_lost, &async_client::on_message_arrived,
@@ -921,6 +1485,14 @@ void async_client::stop_consuming()
 event async_client::consume_event()
 {
     event evt;
+    auto spinNs = consumerSpinNs_.load(std::memory_order_relaxed);
+
+    if (spinNs > 0) {
+        if (!que_->get_spin(&evt, std::chrono::nanoseconds(spinNs)))
+            evt = event{shutdown_event{}};
+        return evt;
+    }
+
     try {
         evt = que_->get();
     }
@@ -0,0 +1,314 @@
+// compressed_persistence.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/compressed_persistence.h"
+
+#include <array>
+#include <cstring>
+
+#include "mqtt/exception.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The header in front of the stored data: two magic bytes, then the
+// format. Records without the magic bytes, like those written before the
+// wrapper was used, are passed through as-is.
+constexpr char MAGIC[] = {char(0xB5), 'z'};
+constexpr size_t MAGIC_LEN = sizeof(MAGIC);
+constexpr size_t HDR_LEN = MAGIC_LEN + 1;
+
+// The formats, for version 1 of the header
+constexpr char RAW = 0;
+constexpr char LZ = 1;
+
+// The largest size of data to accept from a record, which is the largest
+// MQTT packet.
+constexpr size_t MAX_DATA_SIZE = 268435455;
+
+// A match sequence can expand by no more than this
+constexpr size_t MAX_RATIO = 255;
+
+// The block format is a series of sequences, like LZ4. Each starts with
+// a token byte holding the literal length in the high nibble and the
+// match length (less MIN_MATCH) in the low one. A nibble of 15 means the
+// length continues in the following bytes, 255 at a time. Then come the
+// literals, the 2-byte little-endian match offset, and any extra match
+// length bytes. The last sequence has only literals.
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr size_t LAST_LITERALS = 5;
+constexpr int HASH_BITS = 12;
+
+inline uint32_t read32(const char* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline size_t hash4(uint32_t v) { return size_t((v * 2654435761u) >> (32 - HASH_BITS)); }
+
+void put_len(size_t n, string& out)
+{
+    for (; n >= 255; n -= 255) out.push_back(char(255));
+    out.push_back(char(n));
+}
+
+void put_sequence(const char* lit, size_t nlit, size_t off, size_t mlen, string& out)
+{
+    size_t mcode = mlen ? mlen - MIN_MATCH : 0;
+    out.push_back(char(((nlit < 15 ? nlit : 15) << 4) | (mcode < 15 ? mcode : 15)));
+    if (nlit >= 15)
+        put_len(nlit - 15, out);
+    out.append(lit, nlit);
+
+    if (mlen) {
+        out.push_back(char(off & 0xFF));
+        out.push_back(char(off >> 8));
+        if (mcode >= 15)
+            put_len(mcode - 15, out);
+    }
+}
+
+// Reads a length continuation, returning false if the input runs out.
+bool get_len(const unsigned char*& p, const unsigned char* end, size_t& n)
+{
+    unsigned char c;
+    do {
+        if (p >= end)
+            return false;
+        c = *p++;
+        n += c;
+    } while (c == 255);
+    return true;
+}
+
+void put_varint(size_t n, string& out)
+{
+    for (; n >= 0x80; n >>= 7) out.push_back(char((n & 0x7F) | 0x80));
+    out.push_back(char(n));
+}
+
+bool has_magic(const char* p, size_t n)
+{
+    return n >= MAGIC_LEN && std::memcmp(p, MAGIC, MAGIC_LEN) == 0;
+}
+
+bool get_varint(const char*& p, const char* end, size_t& n)
+{
+    n = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char c = static_cast<unsigned char>(*p++);
+        n |= size_t(c & 0x7F) << shift;
+        if (!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+// --------------------------------------------------------------------------
+
+// The match finder keeps the last position of each hashed 4-byte sequence
+// in a small table on the stack. It only finds the most recent candidate
+// for each hash, which is what keeps it fast.
+
+void compressed_persistence::compress(const char* data, size_t n, string& out)
+{
+    out.reserve(out.size() + n + n / 255 + 16);
+
+    size_t anchor = 0;
+    if (n > MIN_MATCH + LAST_LITERALS) {
+        std::array<uint32_t, size_t(1) << HASH_BITS> table;
+        table.fill(UINT32_MAX);
+
+        size_t limit = n - LAST_LITERALS;
+        size_t i = 0;
+        while (i + MIN_MATCH <= limit) {
+            uint32_t seq = read32(data + i);
+            size_t h = hash4(seq);
+            size_t cand = table[h];
+            table[h] = uint32_t(i);
+
+            if (cand == UINT32_MAX || i - cand > MAX_OFFSET || read32(data + cand) != seq) {
+                ++i;
+                continue;
+            }
+
+            size_t mlen = MIN_MATCH;
+            while (i + mlen < limit && data[cand + mlen] == data[i + mlen]) ++mlen;
+
+            put_sequence(data + anchor, i - anchor, i - cand, mlen, out);
+            i += mlen;
+            anchor = i;
+        }
+    }
+    put_sequence(data + anchor, n - anchor, 0, 0, out);
+}
+
+// The original size comes from the stored data, so it's checked before
+// reserving space for it.
+
+string compressed_persistence::decompress(const char* data, size_t n, size_t origSize)
+{
+    if (origSize > MAX_DATA_SIZE || origSize > MAX_RATIO * (n + 1))
+        throw persistence_exception("Corrupt compressed data");
+
+    string out;
+    out.reserve(origSize);
+
+    auto p = reinterpret_cast<const unsigned char*>(data);
+    auto end = p + n;
+
+    while (p < end) {
+        unsigned tok = *p++;
+
+        size_t nlit = tok >> 4;
+        if (nlit == 15 && !get_len(p, end, nlit))
+            throw persistence_exception("Corrupt compressed data");
+        if (nlit > size_t(end - p) || out.size() + nlit > origSize)
+            throw persistence_exception("Corrupt compressed data");
+
+        out.append(reinterpret_cast<const char*>(p), nlit);
+        p += nlit;
+
+        if (p == end)
+            break;
+
+        if (end - p < 2)
+            throw persistence_exception("Corrupt compressed data");
+        size_t off = size_t(p[0]) | (size_t(p[1]) << 8);
+        p += 2;
+
+        size_t mlen = tok & 0x0F;
+        if (mlen == 15 && !get_len(p, end, mlen))
+            throw persistence_exception("Corrupt compressed data");
+        mlen += MIN_MATCH;
+
+        if (off == 0 || off > out.size() || out.size() + mlen > origSize)
+            throw persistence_exception("Corrupt compressed data");
+
+        // The match can overlap the bytes it's producing, so it's copied
+        // a byte at a time.
+        size_t from = out.size() - off;
+        for (size_t i = 0; i < mlen; ++i) out.push_back(out[from + i]);
+    }
+
+    if (out.size() != origSize)
+        throw persistence_exception("Corrupt compressed data");
+    return out;
+}
+
+compressed_persistence::stats compressed_persistence::get_stats() const
+{
+    stats st;
+    st.puts = nPuts_.load(std::memory_order_relaxed);
+    st.compressed = nCompressed_.load(std::memory_order_relaxed);
+    st.bytesIn = nBytesIn_.load(std::memory_order_relaxed);
+    st.bytesOut = nBytesOut_.load(std::memory_order_relaxed);
+    return st;
+}
+
+// Small data is passed through without joining the buffers. Otherwise the
+// buffers are joined to compress them as one block, and the result is kept
+// only if it came out smaller. Uncompressed data only needs a header if it
+// happens to start with the magic bytes.
+
+void compressed_persistence::put(const string& key, const std::vector<string_view>& bufs)
+{
+    static const char rawHdr[] = {MAGIC[0], MAGIC[1], RAW};
+
+    size_t n = 0;
+    for (const auto& b : bufs) n += b.size();
+
+    ++nPuts_;
+    nBytesIn_ += n;
+
+    if (n >= minSize_) {
+        string data;
+        data.reserve(n);
+        for (const auto& b : bufs) data.append(b.data(), b.size());
+
+        string out{MAGIC, MAGIC_LEN};
+        out.push_back(LZ);
+        put_varint(n, out);
+        compress(data.data(), n, out);
+
+        if (out.size() < n) {
+            inner_.put(key, {string_view{out}});
+            ++nCompressed_;
+            nBytesOut_ += out.size();
+            return;
+        }
+    }
+
+    // The first two bytes may be split across buffers
+    char first[MAGIC_LEN];
+    size_t nfirst = 0;
+    for (const auto& b : bufs) {
+        for (size_t i = 0; i < b.size() && nfirst < MAGIC_LEN; ++i) first[nfirst++] = b[i];
+    }
+
+    if (!has_magic(first, nfirst)) {
+        inner_.put(key, bufs);
+        nBytesOut_ += n;
+        return;
+    }
+
+    std::vector<string_view> rawBufs;
+    rawBufs.reserve(bufs.size() + 1);
+    rawBufs.emplace_back(rawHdr, HDR_LEN);
+    rawBufs.insert(rawBufs.end(), bufs.begin(), bufs.end());
+
+    inner_.put(key, rawBufs);
+    nBytesOut_ += n + HDR_LEN;
+}
+
+string compressed_persistence::get(const string& key) const
+{
+    string s = inner_.get(key);
+    if (!has_magic(s.data(), s.size()))
+        return s;
+
+    if (s.size() < HDR_LEN)
+        throw persistence_exception("Corrupt compression header");
+
+    if (s[MAGIC_LEN] == RAW) {
+        s.erase(0, HDR_LEN);
+        return s;
+    }
+
+    if (s[MAGIC_LEN] != LZ)
+        throw persistence_exception("Unknown compression format");
+
+    const char *p = s.data() + HDR_LEN, *end = s.data() + s.size();
+    size_t origSize;
+    if (!get_varint(p, end, origSize))
+        throw persistence_exception("Corrupt compressed data");
+
+    return decompress(p, size_t(end - p), origSize);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,301 @@
+// consumer_pool.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/consumer_pool.h"
+
+#include <ctime>
+#include <stdexcept>
+
+#include "mqtt/async_client.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// How long a worker waits for an event before checking whether to exit
+constexpr auto FETCH_TIMEOUT = std::chrono::milliseconds(100);
+
+void check_options(const consumer_pool::options& opts)
+{
+    if (opts.minWorkers == 0 || opts.maxWorkers < opts.minWorkers)
+        throw std::invalid_argument("Bad consumer pool worker limits");
+    if (opts.interval.count() <= 0)
+        throw std::invalid_argument("Bad consumer pool interval");
+}
+
+}  // namespace
+
+// --------------------------------------------------------------------------
+
+consumer_pool::consumer_pool(async_client& cli, handler_type handler)
+    : consumer_pool(cli, std::move(handler), options{})
+{
+}
+
+consumer_pool::consumer_pool(
+    async_client& cli, handler_type handler, const options& opts
+)
+    : fetch_{[&cli](event* evt, duration d) { return cli.try_consume_event_for(evt, d); }},
+      depth_{[&cli] { return cli.consumer_queue_size(); }},
+      done_{[&cli] { return cli.consumer_done(); }},
+      handler_{std::move(handler)},
+      opts_{opts}
+{
+    check_options(opts_);
+    start();
+}
+
+consumer_pool::consumer_pool(thread_queue<event>& que, handler_type handler)
+    : consumer_pool(que, std::move(handler), options{})
+{
+}
+
+consumer_pool::consumer_pool(
+    thread_queue<event>& que, handler_type handler, const options& opts
+)
+    : fetch_{[&que](event* evt, duration d) { return que.try_get_for(evt, d); }},
+      depth_{[&que] { return que.size(); }},
+      done_{[&que] { return que.done(); }},
+      handler_{std::move(handler)},
+      opts_{opts}
+{
+    check_options(opts_);
+    start();
+}
+
+consumer_pool::~consumer_pool() { stop(); }
+
+void consumer_pool::start()
+{
+    guard g{lock_};
+    metrics_.workers = opts_.minWorkers;
+    for (size_t i = 0; i < opts_.minWorkers; ++i) add_worker();
+    monitorThr_ = std::thread(&consumer_pool::run_monitor, this);
+}
+
+void consumer_pool::add_worker()
+{
+    auto w = std::make_unique<worker>();
+    w->thr = std::thread(&consumer_pool::run_worker, this, w.get());
+    workers_.push_back(std::move(w));
+}
+
+void consumer_pool::reap_workers()
+{
+    for (auto it = workers_.begin(); it != workers_.end();) {
+        if ((*it)->done) {
+            (*it)->thr.join();
+            it = workers_.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+// A worker exits to scale down by claiming one of the pending
+// retirements, so exactly as many workers exit as were asked to.
+
+bool consumer_pool::should_retire()
+{
+    int n = nRetire_.load();
+    while (n > 0) {
+        if (nRetire_.compare_exchange_weak(n, n - 1))
+            return true;
+    }
+    return false;
+}
+
+void consumer_pool::run_worker(worker* w)
+{
+    event evt;
+
+    while (!stop_ && !should_retire()) {
+        if (!fetch_(&evt, FETCH_TIMEOUT)) {
+            if (done_()) {
+                // Every worker is on its way out, so any pending
+                // retirements can no longer be claimed.
+                nRetire_ = 0;
+                break;
+            }
+            continue;
+        }
+
+        auto t = clock::now();
+        try {
+            handler_(evt);
+        }
+        catch (...) {
+            ++nErrors_;
+        }
+        busyNanos_ += std::chrono::nanoseconds(clock::now() - t).count();
+        ++nProcessed_;
+        evt = event{};
+    }
+    w->done = true;
+}
+
+// Each interval, the monitor measures the load and decides whether to
+// add or remove a worker. The dwell time is estimated from Little's law,
+// as the depth over the rate that the queue is drained. If nothing was
+// drained, but the queue isn't empty, the workers are stuck, and the
+// dwell is at least the interval.
+
+void consumer_pool::run_monitor()
+{
+    using namespace std::chrono;
+
+    const double ncores = std::max(1u, std::thread::hardware_concurrency());
+
+    auto last = clock::now();
+    auto lastCpu = std::clock();
+    uint64_t lastProcessed = 0;
+    int64_t lastBusy = 0;
+    int nBacklog = 0, nIdle = 0;
+
+    unique_lock g{lock_};
+
+    while (!stop_) {
+        stopCond_.wait_for(g, opts_.interval, [this] { return bool(stop_); });
+        if (stop_)
+            break;
+
+        reap_workers();
+
+        auto now = clock::now();
+        auto cpuNow = std::clock();
+        double secs = duration_cast<nanoseconds>(now - last).count() / 1.0e9;
+
+        uint64_t processed = nProcessed_;
+        int64_t busy = busyNanos_;
+        size_t depth = depth_();
+        size_t nworkers = workers_.size();
+        nworkers -= std::min(nworkers, size_t(std::max(0, nRetire_.load())));
+
+        double rate = (processed - lastProcessed) / secs;
+        double util = (busy - lastBusy) / (1.0e9 * secs * std::max<size_t>(1, nworkers));
+        double cpu = (double(cpuNow - lastCpu) / CLOCKS_PER_SEC) / (secs * ncores);
+
+        duration dwell{0};
+        if (rate > 0.0)
+            dwell = duration_cast<duration>(std::chrono::duration<double>(depth / rate));
+        else if (depth > 0)
+            dwell = opts_.interval;
+
+        last = now;
+        lastCpu = cpuNow;
+        lastProcessed = processed;
+        lastBusy = busy;
+
+        bool backlog = depth > 0 && (depth >= opts_.highDepth || dwell > opts_.maxDwell);
+        bool idle = depth == 0 && util < opts_.lowUtil;
+
+        nBacklog = backlog ? nBacklog + 1 : 0;
+        nIdle = idle ? nIdle + 1 : 0;
+
+        auto dec = decision::NONE;
+
+        if (!done_()) {
+            if (nBacklog >= opts_.upPeriods && nworkers < opts_.maxWorkers) {
+                nBacklog = 0;
+                if (cpu < opts_.maxCpu) {
+                    add_worker();
+                    ++nworkers;
+                    ++metrics_.scaleUps;
+                    dec = decision::SCALE_UP;
+                }
+                else {
+                    ++metrics_.cpuLimited;
+                    dec = decision::CPU_LIMITED;
+                }
+            }
+            else if (nIdle >= opts_.downPeriods && nworkers > opts_.minWorkers) {
+                nIdle = 0;
+                ++nRetire_;
+                --nworkers;
+                ++metrics_.scaleDowns;
+                dec = decision::SCALE_DOWN;
+            }
+        }
+
+        metrics_.workers = nworkers;
+        metrics_.queueDepth = depth;
+        metrics_.dwell = dwell;
+        metrics_.utilization = util;
+        metrics_.cpu = cpu;
+
+        if (dec != decision::NONE) {
+            metrics_.lastDecision = dec;
+            if (scaleHandler_) {
+                // The callback runs unlocked, so it can query the pool
+                auto cb = scaleHandler_;
+                auto m = metrics_;
+                m.processed = processed;
+                m.errors = nErrors_;
+                g.unlock();
+                cb(dec, m);
+                g.lock();
+            }
+        }
+    }
+}
+
+void consumer_pool::set_scale_handler(scale_handler cb)
+{
+    guard g{lock_};
+    scaleHandler_ = std::move(cb);
+}
+
+size_t consumer_pool::num_workers() const
+{
+    guard g{lock_};
+    return metrics_.workers;
+}
+
+consumer_pool::metrics consumer_pool::get_metrics() const
+{
+    guard g{lock_};
+    auto m = metrics_;
+    m.processed = nProcessed_;
+    m.errors = nErrors_;
+    return m;
+}
+
+void consumer_pool::stop()
+{
+    {
+        guard g{lock_};
+        if (stop_)
+            return;
+        stop_ = true;
+    }
+    stopCond_.notify_all();
+
+    if (monitorThr_.joinable())
+        monitorThr_.join();
+
+    for (auto& w : workers_) w->thr.join();
+    workers_.clear();
+
+    guard g{lock_};
+    metrics_.workers = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
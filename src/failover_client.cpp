@@ -0,0 +1,365 @@
+// failover_client.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/failover_client.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+//								overlap_filter
+/////////////////////////////////////////////////////////////////////////////
+
+size_t overlap_filter::hash(const message& msg)
+{
+    size_t h = std::hash<string>{}(msg.get_topic());
+    size_t hp = std::hash<string>{}(msg.get_payload_str());
+    return h ^ (hp + 0x9e3779b9 + (h << 6) + (h >> 2));
+}
+
+bool overlap_filter::same(const message& a, const message& b)
+{
+    return a.get_topic() == b.get_topic() && a.get_payload_str() == b.get_payload_str();
+}
+
+// The delivered entries that were already matched are gone from the map
+// by the time their place in the order queue expires, so the search for
+// them just comes up empty.
+
+void overlap_filter::expire(clock::time_point now)
+{
+    auto cutoff = now - window_;
+
+    while (!order_.empty() && order_.front().first < cutoff) {
+        auto [tm, h] = order_.front();
+        order_.pop_front();
+
+        auto rng = delivered_.equal_range(h);
+        for (auto p = rng.first; p != rng.second; ++p) {
+            if (p->second.time == tm) {
+                delivered_.erase(p);
+                break;
+            }
+        }
+    }
+
+    while (!pending_.empty() && pending_.front().time < cutoff) pop_pending();
+}
+
+void overlap_filter::record(
+    size_t h, clock::time_point now, size_t src, const_message_ptr msg
+)
+{
+    delivered_.emplace(h, entry{now, src, std::move(msg)});
+    order_.emplace_back(now, h);
+}
+
+bool overlap_filter::take_delivered(size_t h, const message& msg, size_t src)
+{
+    auto rng = delivered_.equal_range(h);
+    for (auto p = rng.first; p != rng.second; ++p) {
+        if (p->second.src != src && same(*p->second.msg, msg)) {
+            delivered_.erase(p);
+            ++nDuplicates_;
+            return true;
+        }
+    }
+    return false;
+}
+
+// The held messages are indexed by hash to their sequence numbers, which
+// give their place in the pending queue. A matched message is left in the
+// queue as an empty slot, so the others don't move, and is dropped when it
+// reaches the front.
+
+void overlap_filter::hold(size_t h, clock::time_point now, size_t src, const_message_ptr msg)
+{
+    pendingIdx_.emplace(h, pendingBase_ + pending_.size());
+    pending_.push_back(held{now, src, h, std::move(msg)});
+    ++nPending_;
+}
+
+void overlap_filter::pop_pending()
+{
+    const auto& e = pending_.front();
+    if (e.msg) {
+        auto rng = pendingIdx_.equal_range(e.hash);
+        for (auto p = rng.first; p != rng.second; ++p) {
+            if (p->second == pendingBase_) {
+                pendingIdx_.erase(p);
+                break;
+            }
+        }
+        --nPending_;
+    }
+    pending_.pop_front();
+    ++pendingBase_;
+}
+
+bool overlap_filter::take_pending(size_t h, const message& msg)
+{
+    auto rng = pendingIdx_.equal_range(h);
+    for (auto p = rng.first; p != rng.second; ++p) {
+        auto& e = pending_[size_t(p->second - pendingBase_)];
+        if (same(*e.msg, msg)) {
+            e.msg.reset();
+            pendingIdx_.erase(p);
+            --nPending_;
+            ++nDuplicates_;
+
+            while (!pending_.empty() && !pending_.front().msg) {
+                pending_.pop_front();
+                ++pendingBase_;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool overlap_filter::add(const_message_ptr msg, size_t src, bool active)
+{
+    if (!msg)
+        return false;
+
+    auto now = clock::now();
+    expire(now);
+
+    size_t h = hash(*msg);
+
+    // A copy of a message that the other session already delivered
+    if (take_delivered(h, *msg, src))
+        return false;
+
+    if (active) {
+        // The standby copy, if it already arrived, can be dropped.
+        // Otherwise remember this one to match it later.
+        if (!take_pending(h, *msg))
+            record(h, now, src, std::move(msg));
+        return true;
+    }
+
+    hold(h, now, src, std::move(msg));
+    return false;
+}
+
+std::vector<const_message_ptr> overlap_filter::promote()
+{
+    auto now = clock::now();
+    std::vector<const_message_ptr> msgs;
+    msgs.reserve(nPending_);
+
+    for (auto& e : pending_) {
+        if (e.msg) {
+            msgs.push_back(e.msg);
+            record(e.hash, now, e.src, std::move(e.msg));
+        }
+    }
+    pendingBase_ += pending_.size();
+    pending_.clear();
+    pendingIdx_.clear();
+    nPending_ = 0;
+    return msgs;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//								failover_client
+/////////////////////////////////////////////////////////////////////////////
+
+failover_client::failover_client(
+    const create_options& primary, const create_options& standby,
+    duration overlap /*=DFLT_OVERLAP*/
+)
+    : filter_{overlap}, primary_{primary}, standby_{standby}
+{
+    for (size_t i = 0; i < 2; ++i) {
+        auto& c = cli(i);
+        c.set_connected_handler([this, i](const string&) { on_connected(i); });
+        c.set_connection_lost_handler([this, i](const string&) { on_connection_lost(i); });
+        c.set_message_callback([this, i](const_message_ptr msg) {
+            on_message(i, std::move(msg));
+        });
+    }
+}
+
+// The handlers capture this object and reach across to the other client,
+// so both clients are silenced and disconnected here, before either one is
+// destroyed. The members go in reverse order, so without this a late
+// callback on the primary would land on a standby that's already gone.
+
+failover_client::~failover_client()
+{
+    for (size_t i = 0; i < 2; ++i) {
+        auto& c = cli(i);
+        try {
+            c.set_connected_handler(nullptr);
+            c.set_connection_lost_handler(nullptr);
+            c.disable_callbacks();
+        }
+        catch (const exception&) {
+        }
+    }
+
+    // The disconnect completes on the same C library thread that runs the
+    // callbacks, so once it's done none of them are still in flight.
+    for (size_t i = 0; i < 2; ++i) {
+        try {
+            cli(i).disconnect()->wait_for(DISCONNECT_TIMEOUT);
+        }
+        catch (const exception&) {
+        }
+    }
+    que_.close();
+}
+
+// Held messages are queued under the lock so they go out ahead of any
+// that the new active client delivers after the swap.
+
+void failover_client::promote(size_t i)
+{
+    guard g(lock_);
+    if (active_.load() == i)
+        return;
+
+    active_.store(i);
+    ++nFailovers_;
+
+    for (auto& msg : filter_.promote()) que_.try_put(std::move(msg));
+}
+
+// A client that connects while the active one is down takes over. The
+// subscriptions are always made again, since the session may be new.
+
+void failover_client::on_connected(size_t i)
+{
+    std::vector<std::pair<string, int>> subs;
+    {
+        guard g(lock_);
+        subs = subs_;
+    }
+
+    for (const auto& sub : subs) {
+        try {
+            cli(i).subscribe(sub.first, sub.second);
+        }
+        catch (const exception&) {
+        }
+    }
+
+    if (i != active_.load() && !cli(1 - i).is_connected())
+        promote(i);
+}
+
+void failover_client::on_connection_lost(size_t i)
+{
+    if (i == active_.load() && cli(1 - i).is_connected())
+        promote(1 - i);
+}
+
+void failover_client::on_message(size_t i, const_message_ptr msg)
+{
+    guard g(lock_);
+    // The queue is unbounded, so this only fails once it's closed
+    if (filter_.add(msg, i, i == active_.load()))
+        que_.try_put(std::move(msg));
+}
+
+token_ptr failover_client::connect(
+    const connect_options& primaryOpts, const connect_options& standbyOpts
+)
+{
+    standby_.connect(standbyOpts);
+    return primary_.connect(primaryOpts);
+}
+
+// Errors from the standby are ignored here. It isn't what the app is
+// using, and it's brought back in line whenever it reconnects.
+
+token_ptr failover_client::disconnect()
+{
+    size_t act = active_.load();
+    try {
+        cli(1 - act).disconnect();
+    }
+    catch (const exception&) {
+    }
+    return cli(act).disconnect();
+}
+
+token_ptr failover_client::subscribe(const string& topicFilter, int qos)
+{
+    {
+        guard g(lock_);
+        auto p = std::find_if(subs_.begin(), subs_.end(), [&topicFilter](const auto& sub) {
+            return sub.first == topicFilter;
+        });
+        if (p != subs_.end())
+            p->second = qos;
+        else
+            subs_.emplace_back(topicFilter, qos);
+    }
+
+    size_t act = active_.load();
+    try {
+        if (cli(1 - act).is_connected())
+            cli(1 - act).subscribe(topicFilter, qos);
+    }
+    catch (const exception&) {
+    }
+    return cli(act).is_connected() ? cli(act).subscribe(topicFilter, qos) : token_ptr{};
+}
+
+token_ptr failover_client::unsubscribe(const string& topicFilter)
+{
+    {
+        guard g(lock_);
+        subs_.erase(
+            std::remove_if(
+                subs_.begin(), subs_.end(),
+                [&topicFilter](const auto& sub) { return sub.first == topicFilter; }
+            ),
+            subs_.end()
+        );
+    }
+
+    size_t act = active_.load();
+    try {
+        if (cli(1 - act).is_connected())
+            cli(1 - act).unsubscribe(topicFilter);
+    }
+    catch (const exception&) {
+    }
+    return cli(act).is_connected() ? cli(act).unsubscribe(topicFilter) : token_ptr{};
+}
+
+std::vector<std::pair<string, int>> failover_client::get_subscriptions()
+{
+    guard g(lock_);
+    return subs_;
+}
+
+uint64_t failover_client::num_duplicates()
+{
+    guard g(lock_);
+    return filter_.num_duplicates();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
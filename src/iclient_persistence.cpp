@@ -172,6 +172,21 @@ int iclient_persistence::persistence_containskey(void* handle, char* key)
     return MQTTCLIENT_PERSISTENCE_ERROR;
 }
 
+MQTTClient_persistence iclient_persistence::c_struct(iclient_persistence* store)
+{
+    return MQTTClient_persistence{
+        store,
+        &iclient_persistence::persistence_open,
+        &iclient_persistence::persistence_close,
+        &iclient_persistence::persistence_put,
+        &iclient_persistence::persistence_get,
+        &iclient_persistence::persistence_remove,
+        &iclient_persistence::persistence_keys,
+        &iclient_persistence::persistence_clear,
+        &iclient_persistence::persistence_containskey
+    };
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // end namespace mqtt
 }  // namespace mqtt
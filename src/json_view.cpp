@@ -0,0 +1,368 @@
+// json_view.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/json_view.h"
+
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+using size_type = std::string_view::size_type;
+constexpr size_type npos = std::string_view::npos;
+
+bool is_ws(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+size_type skip_ws(std::string_view s, size_type i)
+{
+    while (i < s.size() && is_ws(s[i])) ++i;
+    return i;
+}
+
+// Gets the position just past the string that starts at 'i', which must
+// be the opening quote.
+size_type skip_string(std::string_view s, size_type i)
+{
+    for (++i; i < s.size(); ++i) {
+        if (s[i] == '\\')
+            ++i;
+        else if (s[i] == '"')
+            return i + 1;
+    }
+    return npos;
+}
+
+// Gets the position just past the value that starts at 'i'. For objects
+// and arrays, this just balances the brackets, skipping over strings.
+size_type skip_value(std::string_view s, size_type i)
+{
+    if (i >= s.size())
+        return npos;
+
+    switch (s[i]) {
+        case '"':
+            return skip_string(s, i);
+
+        case '{':
+        case '[': {
+            int depth = 0;
+            while (i < s.size()) {
+                char c = s[i];
+                if (c == '"') {
+                    if ((i = skip_string(s, i)) == npos)
+                        return npos;
+                    continue;
+                }
+                if (c == '{' || c == '[')
+                    ++depth;
+                else if ((c == '}' || c == ']') && --depth == 0)
+                    return i + 1;
+                ++i;
+            }
+            return npos;
+        }
+
+        default: {
+            // A number or literal runs to the next delimiter
+            size_type j = i;
+            while (j < s.size() && s[j] != ',' && s[j] != '}' && s[j] != ']' && !is_ws(s[j]))
+                ++j;
+            return (j > i) ? j : npos;
+        }
+    }
+}
+
+// Calls fn(key, valueStart, valueEnd) for each member of an object, or
+// fn({}, valueStart, valueEnd) for each element of an array, until it
+// returns true.
+template <typename F>
+bool scan(std::string_view s, F fn)
+{
+    if (s.size() < 2 || (s[0] != '{' && s[0] != '['))
+        return false;
+
+    bool isObj = (s[0] == '{');
+    char close = isObj ? '}' : ']';
+    size_type i = skip_ws(s, 1);
+
+    if (i < s.size() && s[i] == close)
+        return false;
+
+    while (i < s.size()) {
+        std::string_view key;
+        if (isObj) {
+            if (s[i] != '"')
+                return false;
+            size_type kend = skip_string(s, i);
+            if (kend == npos)
+                return false;
+            key = s.substr(i + 1, kend - i - 2);
+            i = skip_ws(s, kend);
+            if (i >= s.size() || s[i] != ':')
+                return false;
+            i = skip_ws(s, i + 1);
+        }
+
+        size_type vend = skip_value(s, i);
+        if (vend == npos)
+            return false;
+
+        if (fn(key, i, vend))
+            return true;
+
+        i = skip_ws(s, vend);
+        if (i >= s.size() || s[i] != ',')
+            return false;
+        i = skip_ws(s, i + 1);
+    }
+    return false;
+}
+
+}  // namespace
+
+// --------------------------------------------------------------------------
+
+json_view::json_view(std::string_view text)
+{
+    size_type beg = skip_ws(text, 0);
+    size_type end = skip_value(text, beg);
+    if (end != npos)
+        val_ = text.substr(beg, end - beg);
+}
+
+json_view::value_type json_view::type() const
+{
+    if (val_.empty())
+        return NONE;
+
+    switch (val_[0]) {
+        case '{':
+            return OBJECT;
+        case '[':
+            return ARRAY;
+        case '"':
+            return STRING;
+        case 't':
+        case 'f':
+            return (val_ == "true" || val_ == "false") ? BOOLEAN : NONE;
+        case 'n':
+            return (val_ == "null") ? NULL_VALUE : NONE;
+        default:
+            return (val_[0] == '-' || (val_[0] >= '0' && val_[0] <= '9')) ? NUMBER : NONE;
+    }
+}
+
+json_view json_view::operator[](std::string_view key) const
+{
+    json_view v;
+    if (type() == OBJECT) {
+        scan(val_, [&](std::string_view k, size_type beg, size_type end) {
+            if (k != key)
+                return false;
+            v.val_ = val_.substr(beg, end - beg);
+            return true;
+        });
+    }
+    return v;
+}
+
+json_view json_view::operator[](size_t idx) const
+{
+    json_view v;
+    if (type() == ARRAY) {
+        size_t n = 0;
+        scan(val_, [&](std::string_view, size_type beg, size_type end) {
+            if (n++ != idx)
+                return false;
+            v.val_ = val_.substr(beg, end - beg);
+            return true;
+        });
+    }
+    return v;
+}
+
+json_view json_view::find(std::string_view path) const
+{
+    json_view v = *this;
+    while (v && !path.empty()) {
+        size_type dot = path.find('.');
+        auto name = path.substr(0, dot);
+        path = (dot == npos) ? std::string_view{} : path.substr(dot + 1);
+
+        if (v.type() == ARRAY) {
+            size_t idx = 0;
+            auto res = std::from_chars(name.data(), name.data() + name.size(), idx);
+            if (res.ec != std::errc() || res.ptr != name.data() + name.size())
+                return json_view{};
+            v = v[idx];
+        }
+        else {
+            v = v[name];
+        }
+    }
+    return v;
+}
+
+size_t json_view::size() const
+{
+    size_t n = 0;
+    scan(val_, [&n](std::string_view, size_type, size_type) {
+        ++n;
+        return false;
+    });
+    return n;
+}
+
+std::optional<std::string_view> json_view::get_string() const
+{
+    if (type() != STRING || val_.size() < 2)
+        return std::nullopt;
+    return val_.substr(1, val_.size() - 2);
+}
+
+// The number is copied to a small buffer on the stack to terminate it
+// for strtod(), which still handles more compilers than from_chars()
+// does for floating point.
+
+std::optional<double> json_view::get_double() const
+{
+    char buf[64];
+    if (type() != NUMBER || val_.size() >= sizeof(buf))
+        return std::nullopt;
+
+    std::memcpy(buf, val_.data(), val_.size());
+    buf[val_.size()] = '\0';
+
+    char* end = nullptr;
+    double d = std::strtod(buf, &end);
+    if (end != buf + val_.size())
+        return std::nullopt;
+    return d;
+}
+
+std::optional<int64_t> json_view::get_int() const
+{
+    if (type() != NUMBER)
+        return std::nullopt;
+
+    int64_t n = 0;
+    auto res = std::from_chars(val_.data(), val_.data() + val_.size(), n);
+    if (res.ec != std::errc() || res.ptr != val_.data() + val_.size())
+        return std::nullopt;
+    return n;
+}
+
+std::optional<bool> json_view::get_bool() const
+{
+    if (val_ == "true")
+        return true;
+    if (val_ == "false")
+        return false;
+    return std::nullopt;
+}
+
+string json_view::unescape() const
+{
+    auto sv = get_string();
+    if (!sv)
+        return string{};
+
+    string s;
+    s.reserve(sv->size());
+
+    for (size_type i = 0; i < sv->size(); ++i) {
+        char c = (*sv)[i];
+        if (c != '\\' || i + 1 >= sv->size()) {
+            s.push_back(c);
+            continue;
+        }
+
+        switch (c = (*sv)[++i]) {
+            case 'b':
+                s.push_back('\b');
+                break;
+            case 'f':
+                s.push_back('\f');
+                break;
+            case 'n':
+                s.push_back('\n');
+                break;
+            case 'r':
+                s.push_back('\r');
+                break;
+            case 't':
+                s.push_back('\t');
+                break;
+            case 'u': {
+                // Encode the code point as UTF-8. Surrogate pairs are
+                // combined when both halves are present.
+                auto hex4 = [&sv](size_type pos, unsigned& cp) {
+                    if (pos + 4 > sv->size())
+                        return false;
+                    auto res = std::from_chars(sv->data() + pos, sv->data() + pos + 4, cp, 16);
+                    return res.ec == std::errc() && res.ptr == sv->data() + pos + 4;
+                };
+                unsigned cp = 0;
+                if (!hex4(i + 1, cp)) {
+                    s.push_back('u');
+                    break;
+                }
+                i += 4;
+                unsigned lo = 0;
+                if (cp >= 0xD800 && cp < 0xDC00 && i + 2 < sv->size() &&
+                    (*sv)[i + 1] == '\\' && (*sv)[i + 2] == 'u' && hex4(i + 3, lo) &&
+                    lo >= 0xDC00 && lo < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    i += 6;
+                }
+                if (cp < 0x80) {
+                    s.push_back(char(cp));
+                }
+                else if (cp < 0x800) {
+                    s.push_back(char(0xC0 | (cp >> 6)));
+                    s.push_back(char(0x80 | (cp & 0x3F)));
+                }
+                else if (cp < 0x10000) {
+                    s.push_back(char(0xE0 | (cp >> 12)));
+                    s.push_back(char(0x80 | ((cp >> 6) & 0x3F)));
+                    s.push_back(char(0x80 | (cp & 0x3F)));
+                }
+                else {
+                    s.push_back(char(0xF0 | (cp >> 18)));
+                    s.push_back(char(0x80 | ((cp >> 12) & 0x3F)));
+                    s.push_back(char(0x80 | ((cp >> 6) & 0x3F)));
+                    s.push_back(char(0x80 | (cp & 0x3F)));
+                }
+                break;
+            }
+            default:
+                // Covers \" \\ and \/
+                s.push_back(c);
+                break;
+        }
+    }
+    return s;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,237 @@
+// payload_integrity.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/payload_integrity.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define PAHO_MQTTPP_CRC32C_SSE42
+    #include <cpuid.h>
+    #include <nmmintrin.h>
+#elif defined(_M_X64) && defined(_MSC_VER)
+    #define PAHO_MQTTPP_CRC32C_SSE42
+    #include <intrin.h>
+    #include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    #define PAHO_MQTTPP_CRC32C_ARM
+    #include <arm_acle.h>
+#endif
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The reflected Castagnoli polynomial
+constexpr uint32_t POLY = 0x82F63B78;
+
+// The tables for the slicing-by-8 software version, built at compile
+// time. Table 0 is the usual byte-at-a-time table; table k gives the
+// effect of a byte followed by k zero bytes.
+
+struct crc_tables
+{
+    uint32_t t[8][256]{};
+
+    constexpr crc_tables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int j = 0; j < 8; ++j) crc = (crc >> 1) ^ ((crc & 1) ? POLY : 0);
+            t[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k)
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+        }
+    }
+};
+
+constexpr crc_tables TABLES{};
+
+uint32_t load_le32(const uint8_t* p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+           (uint32_t(p[3]) << 24);
+}
+
+// Computes the raw CRC in software, without the initial and final
+// inversions.
+uint32_t crc_sw(uint32_t crc, const uint8_t* p, size_t n)
+{
+    const auto& t = TABLES.t;
+
+    while (n >= 8) {
+        uint32_t lo = load_le32(p) ^ crc, hi = load_le32(p + 4);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^
+              t[4][lo >> 24] ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+              t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        p += 8;
+        n -= 8;
+    }
+    while (n--) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+#if defined(PAHO_MQTTPP_CRC32C_SSE42)
+
+    #if !defined(_MSC_VER)
+__attribute__((target("sse4.2")))
+    #endif
+uint32_t crc_hw(uint32_t crc, const uint8_t* p, size_t n)
+{
+    while (n > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        --n;
+    }
+
+    uint64_t crc64 = crc;
+    while (n >= 8) {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        crc64 = _mm_crc32_u64(crc64, v);
+        p += 8;
+        n -= 8;
+    }
+
+    crc = uint32_t(crc64);
+    while (n--) crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+
+bool have_hw()
+{
+    #if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+    #else
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (ecx & bit_SSE4_2) != 0;
+    #endif
+}
+
+#elif defined(PAHO_MQTTPP_CRC32C_ARM)
+
+uint32_t crc_hw(uint32_t crc, const uint8_t* p, size_t n)
+{
+    while (n > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+        crc = __crc32cb(crc, *p++);
+        --n;
+    }
+    while (n >= 8) {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        crc = __crc32cd(crc, v);
+        p += 8;
+        n -= 8;
+    }
+    while (n--) crc = __crc32cb(crc, *p++);
+    return crc;
+}
+
+bool have_hw() { return true; }
+
+#endif
+
+}  // namespace
+
+// --------------------------------------------------------------------------
+
+uint32_t crc32c(const void* data, size_t n, uint32_t crc /*=0*/) noexcept
+{
+#if defined(PAHO_MQTTPP_CRC32C_SSE42) || defined(PAHO_MQTTPP_CRC32C_ARM)
+    static const bool hw = have_hw();
+    if (hw)
+        return ~crc_hw(~crc, static_cast<const uint8_t*>(data), n);
+#endif
+    return ~crc_sw(~crc, static_cast<const uint8_t*>(data), n);
+}
+
+uint32_t crc32c_sw(const void* data, size_t n, uint32_t crc /*=0*/) noexcept
+{
+    return ~crc_sw(~crc, static_cast<const uint8_t*>(data), n);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// payload_integrity
+
+void payload_integrity::format(uint32_t crc, char* buf) noexcept
+{
+    static constexpr char HEX[] = "0123456789abcdef";
+    for (int i = int(VALUE_LEN) - 1; i >= 0; --i) {
+        buf[i] = HEX[crc & 0xF];
+        crc >>= 4;
+    }
+}
+
+void payload_integrity::add(properties& props, const void* payload, size_t n)
+{
+    char buf[VALUE_LEN];
+    format(crc32c(payload, n), buf);
+    props.add(property{property::USER_PROPERTY, PROPERTY_NAME, string{buf, VALUE_LEN}});
+}
+
+void payload_integrity::add(MQTTProperties& props, const void* payload, size_t n)
+{
+    char buf[VALUE_LEN];
+    format(crc32c(payload, n), buf);
+
+    // The C library copies the name and value
+    MQTTProperty prop{};
+    prop.identifier = MQTTPROPERTY_CODE_USER_PROPERTY;
+    prop.value.data.data = const_cast<char*>(PROPERTY_NAME);
+    prop.value.data.len = int(std::strlen(PROPERTY_NAME));
+    prop.value.value.data = buf;
+    prop.value.value.len = int(VALUE_LEN);
+    ::MQTTProperties_add(&props, &prop);
+}
+
+bool payload_integrity::has_checksum(const MQTTProperties& props) noexcept
+{
+    const size_t len = std::strlen(PROPERTY_NAME);
+
+    for (int i = 0; i < props.count; ++i) {
+        const MQTTProperty& prop = props.array[i];
+        if (prop.identifier == MQTTPROPERTY_CODE_USER_PROPERTY &&
+            size_t(prop.value.data.len) == len &&
+            std::memcmp(prop.value.data.data, PROPERTY_NAME, len) == 0)
+            return true;
+    }
+    return false;
+}
+
+payload_integrity::result payload_integrity::check(const message_view& msg) noexcept
+{
+    if (!has_checksum(msg.c_struct().properties))
+        return UNCHECKED;
+
+    auto val = msg.get_user_property(PROPERTY_NAME);
+    auto payload = msg.get_payload();
+
+    char buf[VALUE_LEN];
+    format(crc32c(payload.data(), payload.size()), buf);
+
+    return (val == std::string_view{buf, VALUE_LEN}) ? VALID : CORRUPT;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,147 @@
+// publish_combiner.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/publish_combiner.h"
+
+#include <thread>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+// The pending list is a lock-free stack, so each batch is taken all at
+// once, then reversed to send the requests in the order they were made.
+// Each thread has at most one request pending, so its own messages are
+// always sent in order.
+//
+// Once a request is marked done, its thread may return and destroy it, so
+// the combiner must not touch it after that. A sleeping thread can't
+// return until it gets the wait lock, so the combiner can still signal it
+// while holding the lock. Only the combiner completes requests, so the
+// ones in the pending list stay valid while it holds the combiner lock.
+
+void publish_combiner::combine()
+{
+    request* batch;
+    for (unsigned i = 0; i < MAX_PASSES; ++i) {
+        batch = head_.exchange(nullptr, std::memory_order_acquire);
+        if (!batch)
+            break;
+
+        request* fifo = nullptr;
+        while (batch) {
+            request* next = batch->next;
+            batch->next = fifo;
+            fifo = batch;
+            batch = next;
+        }
+
+        uint64_t n = 0;
+        for (request* req = fifo; req; req = req->next) {
+            try {
+                req->tok = cli_.publish(std::move(req->msg));
+            }
+            catch (...) {
+                req->err = std::current_exception();
+            }
+            ++n;
+        }
+
+        nMessages_.fetch_add(n, std::memory_order_relaxed);
+        nBatches_.fetch_add(1, std::memory_order_relaxed);
+        if (n > maxBatch_.load(std::memory_order_relaxed))
+            maxBatch_.store(n, std::memory_order_relaxed);
+
+        // Mark the batch done, waking just the threads that are asleep
+        guard g(waitLock_);
+        while (fifo) {
+            request* next = fifo->next;
+            bool sleeping = fifo->sleeping;
+            fifo->done.store(true, std::memory_order_release);
+            if (sleeping)
+                fifo->cond.notify_one();
+            fifo = next;
+        }
+    }
+}
+
+void publish_combiner::hand_off()
+{
+    guard g(waitLock_);
+    busy_.store(false);
+
+    if (request* req = head_.load(std::memory_order_acquire)) {
+        req->handoff = true;
+        if (req->sleeping)
+            req->cond.notify_one();
+    }
+}
+
+delivery_token_ptr publish_combiner::publish(const_message_ptr msg)
+{
+    request req;
+    req.msg = std::move(msg);
+
+    req.next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(
+        req.next, &req, std::memory_order_release, std::memory_order_relaxed
+    ));
+
+    unsigned nSpin = 0;
+    while (!req.done.load(std::memory_order_acquire)) {
+        if (combLock_.try_lock()) {
+            busy_.store(true);
+            combine();
+            hand_off();
+            combLock_.unlock();
+        }
+        else if (nSpin < spinCount_) {
+            ++nSpin;
+            std::this_thread::yield();
+        }
+        else {
+            // Sleep until the request is done, or this thread is to take
+            // over as the combiner. If there's no combiner, try to be it.
+            unique_lock g(waitLock_);
+            req.sleeping = true;
+            req.cond.wait(g, [this, &req] {
+                return req.done.load(std::memory_order_acquire) || req.handoff ||
+                       !busy_.load();
+            });
+            req.sleeping = false;
+            req.handoff = false;
+        }
+    }
+
+    if (req.err)
+        std::rethrow_exception(req.err);
+
+    return std::move(req.tok);
+}
+
+publish_combiner::stats publish_combiner::get_stats() const
+{
+    stats st;
+    st.messages = nMessages_.load(std::memory_order_relaxed);
+    st.batches = nBatches_.load(std::memory_order_relaxed);
+    st.maxBatch = maxBatch_.load(std::memory_order_relaxed);
+    return st;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
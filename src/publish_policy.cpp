@@ -0,0 +1,98 @@
+// publish_policy.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/publish_policy.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+publish_policy::rule* publish_policy::find_rule(const string& topic)
+{
+    for (auto& r : rules_) {
+        if (r.filter.matches(topic))
+            return &r;
+    }
+    return nullptr;
+}
+
+publish_policy::decision publish_policy::decide(const message& msg, size_t backlog)
+{
+    rule* r = nullptr;
+
+    if (!rules_.empty() && is_overloaded(backlog))
+        r = find_rule(msg.get_topic());
+
+    if (!r) {
+        published_.fetch_add(1, std::memory_order_relaxed);
+        return PUBLISH;
+    }
+
+    switch (r->mode) {
+        case DOWNGRADE:
+            if (msg.get_qos() == 0)
+                break;
+            downgraded_.fetch_add(1, std::memory_order_relaxed);
+            return PUBLISH_QOS0;
+
+        case SAMPLE:
+            if (r->count.fetch_add(1, std::memory_order_relaxed) % r->sampleRate == 0)
+                break;
+            sampledOut_.fetch_add(1, std::memory_order_relaxed);
+            return DROP;
+
+        case SHED:
+            shed_.fetch_add(1, std::memory_order_relaxed);
+            return DROP;
+    }
+
+    published_.fetch_add(1, std::memory_order_relaxed);
+    return PUBLISH;
+}
+
+// Exponential moving average with a weight of 1/8 for the new sample.
+// Concurrent updates may occasionally lose a sample, which is fine for a
+// load indicator.
+
+void publish_policy::on_delivered(duration latency)
+{
+    int64_t avg = latency_.load(std::memory_order_relaxed);
+    avg += (int64_t(latency.count()) - avg) / 8;
+    latency_.store(avg, std::memory_order_relaxed);
+}
+
+publish_policy::metrics publish_policy::get_metrics() const
+{
+    metrics m;
+    m.published = published_.load(std::memory_order_relaxed);
+    m.downgraded = downgraded_.load(std::memory_order_relaxed);
+    m.sampledOut = sampledOut_.load(std::memory_order_relaxed);
+    m.shed = shed_.load(std::memory_order_relaxed);
+    return m;
+}
+
+void publish_policy::reset_metrics()
+{
+    published_ = 0;
+    downgraded_ = 0;
+    sampledOut_ = 0;
+    shed_ = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
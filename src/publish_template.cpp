@@ -0,0 +1,63 @@
+// publish_template.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/publish_template.h"
+
+#include <utility>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+publish_template::publish_template(
+    string_ref topic, int qos, bool retained, const properties& props /*=properties()*/
+)
+    : publish_template(std::move(topic), qos, retained, properties(props))
+{
+}
+
+publish_template::publish_template(
+    string_ref topic, int qos, bool retained, properties&& props
+)
+    : topic_(topic ? std::move(topic) : string_ref(string())), props_(std::move(props))
+{
+    message::validate_qos(qos);
+    msg_.qos = qos;
+    msg_.retained = to_int(retained);
+    msg_.properties = props_.c_struct();
+}
+
+publish_template::publish_template(const publish_template& other)
+    : topic_(other.topic_), props_(other.props_), msg_(other.msg_)
+{
+    msg_.properties = props_.c_struct();
+}
+
+publish_template& publish_template::operator=(const publish_template& rhs)
+{
+    if (&rhs != this) {
+        topic_ = rhs.topic_;
+        props_ = rhs.props_;
+        msg_ = rhs.msg_;
+        msg_.properties = props_.c_struct();
+    }
+    return *this;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,151 @@
+// subscription_cover.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/subscription_cover.h"
+
+#include <algorithm>
+
+#include "mqtt/topic.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+// To find the filters that might subsume another, the filter is matched
+// against the others as if it were a topic, with its wildcards taken as
+// plain text. That finds every filter that subsumes it, along with a few
+// that don't, like 'a/+' for 'a/#', so each candidate is then checked
+// properly with subsumes().
+
+subscription_cover::subscription_cover(const subscription_set& subs) : subs_{subs}
+{
+    for (const auto& sub : subs_) logical_.insert({sub.first, 0});
+
+    // The filters subsumed by another with the same options
+    std::vector<string> redundant;
+
+    for (const auto& sub : subs_) {
+        bool covered = false;
+        for (auto it = logical_.matches(sub.first); it != logical_.matches_cend(); ++it) {
+            const auto& filter = it->first;
+            if (filter != sub.first && subsumes(filter, sub.first) &&
+                subs_.find(filter)->opts == sub.second.opts) {
+                covered = true;
+                break;
+            }
+        }
+        if (covered)
+            redundant.push_back(sub.first);
+        else
+            cover_.add(sub.first, sub.second.qos, sub.second.opts);
+    }
+
+    int id = 0;
+    for (const auto& sub : cover_) coverIds_.insert({sub.first, ++id});
+
+    // Raise the QoS of each covering filter to the highest of the ones
+    // that it covers.
+    for (const auto& filter : redundant) {
+        auto ent = subs_.find(filter);
+        for (auto it = coverIds_.matches(filter); it != coverIds_.matches_cend(); ++it) {
+            auto cov = cover_.find(it->first);
+            if (cov->opts == ent->opts && cov->qos < ent->qos &&
+                subsumes(it->first, filter))
+                cover_.add(it->first, ent->qos, cov->opts);
+        }
+    }
+}
+
+// The fields are compared in turn. A '#' in the general filter takes
+// everything after it, including the parent level, while a '+' takes
+// any one level, but not a '#'. Wildcards in the first field don't
+// match topics starting with '$', so they don't subsume a filter that
+// names one.
+
+bool subscription_cover::subsumes(const string& general, const string& specific)
+{
+    if (general == specific)
+        return true;
+
+    auto gen = topic::split(general);
+    auto spec = topic::split(specific);
+
+    for (size_t i = 0; i < gen.size(); ++i) {
+        const auto& g = gen[i];
+
+        if (i == 0 && (g == "#" || g == "+") && !spec.empty() && !spec[0].empty() &&
+            spec[0][0] == '$')
+            return false;
+
+        if (g == "#")
+            return true;
+
+        if (i >= spec.size())
+            return false;
+
+        const auto& s = spec[i];
+
+        if (g == "+") {
+            if (s == "#")
+                return false;
+        }
+        else if (g != s) {
+            return false;
+        }
+    }
+    return gen.size() == spec.size();
+}
+
+int subscription_cover::subscription_id(const string& filter) const
+{
+    auto it = coverIds_.find(filter);
+    return (it != coverIds_.end()) ? it->second : 0;
+}
+
+std::vector<string> subscription_cover::matches(const string& topic) const
+{
+    std::vector<string> filters;
+    for (auto it = logical_.matches(topic); it != logical_.matches_cend(); ++it)
+        filters.push_back(it->first);
+    std::sort(filters.begin(), filters.end());
+    return filters;
+}
+
+bool subscription_cover::is_duplicate(const string& topic, const properties& props) const
+{
+    size_t n = props.count(property::SUBSCRIPTION_IDENTIFIER);
+    if (n == 0)
+        return false;
+
+    int first = 0;
+    for (auto it = coverIds_.matches(topic); it != coverIds_.matches_cend(); ++it) {
+        if (first == 0 || it->second < first)
+            first = it->second;
+    }
+    if (first == 0)
+        return false;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (int(get<uint32_t>(props, property::SUBSCRIPTION_IDENTIFIER, i)) == first)
+            return false;
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
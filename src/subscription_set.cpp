@@ -0,0 +1,69 @@
+// subscription_set.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/subscription_set.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+subscription_set::subscription_set(
+    const string_collection& filters, int qos, const subscribe_options& opts
+)
+{
+    for (size_t i = 0; i < filters.size(); ++i) add(filters[i], qos, opts);
+}
+
+// Both maps are ordered by filter, so the diff is a single merge pass
+// over the two of them.
+
+subscription_set::changes subscription_set::diff(const subscription_set& desired) const
+{
+    changes chg;
+
+    auto cur = subs_.begin();
+    auto want = desired.subs_.begin();
+
+    while (cur != subs_.end() || want != desired.subs_.end()) {
+        if (want == desired.subs_.end() ||
+            (cur != subs_.end() && cur->first < want->first)) {
+            chg.unsubscribe.push_back(cur->first);
+            ++cur;
+        }
+        else if (cur == subs_.end() || want->first < cur->first) {
+            chg.subscribe.subs_.emplace_hint(chg.subscribe.subs_.end(), *want);
+            ++want;
+        }
+        else {
+            if (cur->second.qos != want->second.qos || cur->second.opts != want->second.opts)
+                chg.subscribe.subs_.emplace_hint(chg.subscribe.subs_.end(), *want);
+            ++cur;
+            ++want;
+        }
+    }
+    return chg;
+}
+
+void subscription_set::apply(const changes& chg)
+{
+    for (const auto& filter : chg.unsubscribe) subs_.erase(filter);
+    for (const auto& sub : chg.subscribe) subs_[sub.first] = sub.second;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,286 @@
+// timer_wheel.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/timer_wheel.h"
+
+#include <algorithm>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+timer_wheel::timer_wheel(expiry_handler handler, duration resolution /*=DFLT_RESOLUTION*/)
+    : handler_{std::move(handler)},
+      resolution_{std::max(resolution, duration{1})},
+      start_{clock::now()}
+{
+    thr_ = std::thread(&timer_wheel::run, this);
+}
+
+timer_wheel::~timer_wheel()
+{
+    {
+        guard g(lock_);
+        stop_ = true;
+    }
+    cond_.notify_one();
+    thr_.join();
+
+    // Release the references held for any tokens still in the wheel.
+    std::vector<token_ptr> toks;
+    {
+        guard g(lock_);
+        for (auto& level : slots_) {
+            for (auto& head : level) {
+                while (head) {
+                    token* tok = head;
+                    unlink(tok);
+                    toks.push_back(std::move(tok->deadline_.self));
+                }
+            }
+        }
+        count_ = 0;
+    }
+}
+
+// --------------------------------------------------------------------------
+// Private, unsynchronized, helpers
+
+uint64_t timer_wheel::to_ticks(const time_point& tp) const
+{
+    if (tp <= start_)
+        return 0;
+
+    auto rel = tp - start_;
+    return uint64_t((rel + resolution_ - duration{1}) / resolution_);
+}
+
+// Insert the token into the slot of the lowest level that can hold its
+// expiry. The slot is taken from the bits of the expiry tick for that
+// level, so the slot is cascaded down (or fired) just as the wheel
+// reaches it.
+
+void timer_wheel::link(token* tok, uint64_t base)
+{
+    auto& dl = tok->deadline_;
+    uint64_t expiry = std::max(dl.expiry, base);
+    uint64_t delta = expiry - now_;
+
+    // Park anything beyond the range of the wheel in the top level. It
+    // will be re-inserted, with its real expiry, when that slot cascades.
+    if (delta >= MAX_TICKS)
+        expiry = now_ + MAX_TICKS - 1;
+
+    size_t level = 0;
+    while (level < N_LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1))))
+        ++level;
+
+    size_t idx = size_t((expiry >> (SLOT_BITS * level)) & SLOT_MASK);
+    token*& head = slots_[level][idx];
+
+    dl.slot = int(level * N_SLOTS + idx);
+    dl.prev = nullptr;
+    dl.next = head;
+    if (head)
+        head->deadline_.prev = tok;
+    head = tok;
+}
+
+void timer_wheel::unlink(token* tok)
+{
+    auto& dl = tok->deadline_;
+    token*& head = slots_[dl.slot / N_SLOTS][dl.slot % N_SLOTS];
+
+    if (dl.prev)
+        dl.prev->deadline_.next = dl.next;
+    else
+        head = dl.next;
+
+    if (dl.next)
+        dl.next->deadline_.prev = dl.prev;
+
+    dl.prev = dl.next = nullptr;
+    dl.slot = -1;
+}
+
+void timer_wheel::cascade(size_t level, size_t idx)
+{
+    token* tok = slots_[level][idx];
+    slots_[level][idx] = nullptr;
+
+    while (tok) {
+        token* next = tok->deadline_.next;
+        link(tok, now_);
+        tok = next;
+    }
+}
+
+void timer_wheel::advance(uint64_t tick, std::vector<token_ptr>& expired)
+{
+    // With nothing in the wheel, there's no reason to turn it tick by tick.
+    if (count_ == 0) {
+        now_ = std::max(now_, tick);
+        return;
+    }
+
+    while (now_ < tick) {
+        ++now_;
+        size_t idx = size_t(now_ & SLOT_MASK);
+
+        // When the lowest level wraps, pull the next slot down from the
+        // level above, and so on up the wheel.
+        if (idx == 0) {
+            for (size_t level = 1; level < N_LEVELS; ++level) {
+                size_t li = size_t((now_ >> (SLOT_BITS * level)) & SLOT_MASK);
+                cascade(level, li);
+                if (li != 0)
+                    break;
+            }
+        }
+
+        token* tok = slots_[0][idx];
+        slots_[0][idx] = nullptr;
+
+        while (tok) {
+            token* next = tok->deadline_.next;
+            auto& dl = tok->deadline_;
+
+            if (dl.expiry <= now_) {
+                dl.prev = dl.next = nullptr;
+                dl.slot = -1;
+                expired.push_back(std::move(dl.self));
+                --count_;
+            }
+            else {
+                link(tok, now_ + 1);
+            }
+            tok = next;
+        }
+    }
+}
+
+// Find the next tick that needs attention: either a non-empty slot in the
+// lowest level, or the point where that level wraps and the next level
+// cascades down.
+
+uint64_t timer_wheel::next_tick() const
+{
+    if (count_ == 0)
+        return NO_TICK;
+
+    for (uint64_t tick = now_ + 1;; ++tick) {
+        if ((tick & SLOT_MASK) == 0 || slots_[0][tick & SLOT_MASK])
+            return tick;
+    }
+}
+
+// --------------------------------------------------------------------------
+// Timer thread
+
+void timer_wheel::run()
+{
+    std::vector<token_ptr> expired;
+    unique_lock g(lock_);
+
+    while (!stop_) {
+        wakeTick_ = next_tick();
+
+        if (wakeTick_ == NO_TICK)
+            cond_.wait(g);
+        else
+            cond_.wait_until(g, to_time(wakeTick_));
+
+        if (stop_)
+            break;
+
+        auto now = clock::now();
+        if (now <= start_)
+            continue;
+
+        advance(uint64_t((now - start_) / resolution_), expired);
+
+        if (!expired.empty()) {
+            wakeTick_ = NO_TICK;
+            g.unlock();
+
+            for (auto& tok : expired) {
+                try {
+                    handler_(std::move(tok));
+                }
+                catch (...) {
+                }
+            }
+            expired.clear();
+            g.lock();
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+// Public API
+
+void timer_wheel::schedule(token_ptr tok, const time_point& deadline)
+{
+    if (!tok)
+        return;
+
+    token* p = tok.get();
+    token_ptr prev;
+    guard g(lock_);
+
+    auto& dl = p->deadline_;
+    if (dl.slot >= 0)
+        unlink(p);
+    else
+        ++count_;
+
+    prev = std::move(dl.self);
+    dl.self = std::move(tok);
+    dl.expiry = to_ticks(deadline);
+    link(p, now_ + 1);
+
+    // Only wake the timer thread if it would otherwise sleep past the
+    // new deadline.
+    if (std::max(dl.expiry, now_ + 1) < wakeTick_) {
+        wakeTick_ = 0;
+        cond_.notify_one();
+    }
+}
+
+bool timer_wheel::cancel(token* tok)
+{
+    if (!tok)
+        return false;
+
+    // The wheel's reference is released after the lock, in case it's the
+    // last one.
+    token_ptr self;
+    guard g(lock_);
+
+    auto& dl = tok->deadline_;
+    if (dl.slot < 0)
+        return false;
+
+    unlink(tok);
+    self = std::move(dl.self);
+    --count_;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
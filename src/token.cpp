@@ -111,6 +111,12 @@ void token::on_failure5(void* context, MQTTAsync_failureData5* rsp)
 void token::on_success(MQTTAsync_successData* rsp)
 {
     unique_lock g(lock_);
+    if (timedOut_) {
+        // A late response only releases the client's hold on the token
+        g.unlock();
+        cli_->remove_token(this);
+        return;
+    }
     iaction_listener* listener = listener_;
 
     if (rsp) {
@@ -137,11 +143,13 @@ void token::on_success(MQTTAsync_successData* rsp)
 
     rc_ = MQTTASYNC_SUCCESS;
     complete_ = true;
+    auto conts = std::move(conts_);
     g.unlock();
 
-    // Note: callback always completes before the object is signaled.
+    // Note: callbacks always complete before the object is signaled.
     if (listener)
         listener->on_success(*this);
+    run_continuations(conts);
     cond_.notify_all();
 
     cli_->remove_token(this);
@@ -153,6 +161,12 @@ void token::on_success(MQTTAsync_successData* rsp)
 void token::on_success5(MQTTAsync_successData5* rsp)
 {
     unique_lock g(lock_);
+    if (timedOut_) {
+        // A late response only releases the client's hold on the token
+        g.unlock();
+        cli_->remove_token(this);
+        return;
+    }
     iaction_listener* listener = listener_;
     if (rsp) {
         msgId_ = rsp->token;
@@ -178,11 +192,13 @@ void token::on_success5(MQTTAsync_successData5* rsp)
     }
     rc_ = MQTTASYNC_SUCCESS;
     complete_ = true;
+    auto conts = std::move(conts_);
     g.unlock();
 
-    // Note: callback always completes before the object is signaled.
+    // Note: callbacks always complete before the object is signaled.
     if (listener)
         listener->on_success(*this);
+    run_continuations(conts);
     cond_.notify_all();
 
     cli_->remove_token(this);
@@ -194,6 +210,12 @@ void token::on_success5(MQTTAsync_successData5* rsp)
 void token::on_failure(MQTTAsync_failureData* rsp)
 {
     unique_lock g(lock_);
+    if (timedOut_) {
+        // A late response only releases the client's hold on the token
+        g.unlock();
+        cli_->remove_token(this);
+        return;
+    }
     iaction_listener* listener = listener_;
     if (rsp) {
         msgId_ = rsp->token;
@@ -207,11 +229,13 @@ void token::on_failure(MQTTAsync_failureData* rsp)
         rc_ = -1;
     }
     complete_ = true;
+    auto conts = std::move(conts_);
     g.unlock();
 
-    // Note: callback always completes before the object is signaled.
+    // Note: callbacks always complete before the object is signaled.
     if (listener)
         listener->on_failure(*this);
+    run_continuations(conts);
     cond_.notify_all();
 
     cli_->remove_token(this);
@@ -223,6 +247,12 @@ void token::on_failure(MQTTAsync_failureData* rsp)
 void token::on_failure5(MQTTAsync_failureData5* rsp)
 {
     unique_lock g(lock_);
+    if (timedOut_) {
+        // A late response only releases the client's hold on the token
+        g.unlock();
+        cli_->remove_token(this);
+        return;
+    }
     iaction_listener* listener = listener_;
     if (rsp) {
         msgId_ = rsp->token;
@@ -235,16 +265,122 @@ void token::on_failure5(MQTTAsync_failureData5* rsp)
         rc_ = -1;
     }
     complete_ = true;
+    auto conts = std::move(conts_);
     g.unlock();
 
-    // Note: callback always completes before the object is signaled.
+    // Note: callbacks always complete before the object is signaled.
     if (listener)
         listener->on_failure(*this);
+    run_continuations(conts);
     cond_.notify_all();
 
     cli_->remove_token(this);
 }
 
+//
+// Local failure when the deadline for the action passes
+//
+bool token::on_timeout()
+{
+    unique_lock g(lock_);
+    if (complete_)
+        return false;
+
+    iaction_listener* listener = listener_;
+    rc_ = MQTTASYNC_FAILURE;
+    errMsg_ = "Timeout";
+    timedOut_ = true;
+    complete_ = true;
+    auto conts = std::move(conts_);
+    g.unlock();
+
+    // Note: callbacks always complete before the object is signaled.
+    if (listener)
+        listener->on_failure(*this);
+    run_continuations(conts);
+    cond_.notify_all();
+
+    return true;
+}
+
+// --------------------------------------------------------------------------
+// Continuations
+
+void token::run_continuation(pending_continuation& pc)
+{
+    if (!pc.fn)
+        return;
+
+    // An executor needs to keep the token alive until the task runs. If
+    // the token isn't shared (i.e. it's on the stack), run it here.
+    if (pc.exec) {
+        if (auto self = weak_from_this().lock()) {
+            pc.exec->execute(continuation_task{std::move(pc.fn), std::move(self)});
+            return;
+        }
+    }
+
+    // Don't let a failing continuation unwind into the library thread.
+    try {
+        pc.fn(*this);
+    }
+    catch (...) {
+    }
+}
+
+void token::run_continuations(continuation_list& conts)
+{
+    if (!conts.first.fn)
+        return;
+
+    run_continuation(conts.first);
+    for (auto& pc : conts.more) run_continuation(pc);
+}
+
+void token::add_continuation(continuation&& fn, executor* exec)
+{
+    if (!fn)
+        return;
+
+    pending_continuation pc{std::move(fn), exec};
+    unique_lock g{lock_};
+
+    if (!complete_) {
+        if (!conts_.first.fn)
+            conts_.first = std::move(pc);
+        else
+            conts_.more.push_back(std::move(pc));
+        return;
+    }
+
+    g.unlock();
+    run_continuation(pc);
+}
+
+void token::complete_dependent(int rc, ReasonCode reasonCode, const string& errMsg)
+{
+    unique_lock g{lock_};
+    if (complete_)
+        return;
+
+    iaction_listener* listener = listener_;
+    rc_ = rc;
+    reasonCode_ = reasonCode;
+    errMsg_ = errMsg;
+    complete_ = true;
+    auto conts = std::move(conts_);
+    g.unlock();
+
+    if (listener) {
+        if (rc == MQTTASYNC_SUCCESS && reasonCode < 0x80)
+            listener->on_success(*this);
+        else
+            listener->on_failure(*this);
+    }
+    run_continuations(conts);
+    cond_.notify_all();
+}
+
 // --------------------------------------------------------------------------
 // API
 
@@ -252,6 +388,7 @@ void token::reset()
 {
     guard g(lock_);
     complete_ = false;
+    timedOut_ = false;
     rc_ = MQTTASYNC_SUCCESS;
     reasonCode_ = ReasonCode::SUCCESS;
     errMsg_.clear();
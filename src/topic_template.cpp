@@ -0,0 +1,270 @@
+// topic_template.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/topic_template.h"
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The longest topic MQTT allows
+constexpr size_t MAX_TOPIC_LEN = 65535;
+
+// Buffers bigger than this aren't kept in the pool
+constexpr size_t MAX_POOLED_CAPACITY = 1024;
+
+bool valid_name_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_';
+}
+
+}  // namespace
+
+// --------------------------------------------------------------------------
+
+// The pool hands out buffers through a shared pointer whose deleter puts
+// them back. The deleter only holds a weak pointer to the pool, since the
+// cache holds topics from the pool. If the pool is gone, the buffer is
+// just deleted.
+
+struct topic_template::state : std::enable_shared_from_this<topic_template::state>
+{
+    using cache_list = std::list<string>;
+
+    std::mutex lock;
+
+    // The pool of free buffers
+    std::vector<std::unique_ptr<string>> pool;
+
+    // The cache: a list of keys, most recently used first, and a map of
+    // the keys to the topics and their places in the list.
+    size_t cacheSize;
+    cache_list keys;
+    std::unordered_map<string, std::pair<string_ref, cache_list::iterator>> cache;
+    // A reused buffer for building the cache keys
+    string key;
+    size_t nHits{0};
+
+    explicit state(size_t sz) : cacheSize{sz} {}
+
+    std::unique_ptr<string> get_buffer() {
+        std::lock_guard<std::mutex> g(lock);
+        if (pool.empty())
+            return std::make_unique<string>();
+        auto buf = std::move(pool.back());
+        pool.pop_back();
+        return buf;
+    }
+
+    void put_buffer(string* buf) {
+        std::unique_ptr<string> p{buf};
+        if (p->capacity() > MAX_POOLED_CAPACITY)
+            return;
+
+        std::lock_guard<std::mutex> g(lock);
+        if (pool.size() < DFLT_POOL_SIZE)
+            pool.push_back(std::move(p));
+    }
+
+    string_ref make_ref(std::unique_ptr<string> buf) {
+        auto del = [wp = weak_from_this()](const string* p) {
+            auto* buf = const_cast<string*>(p);
+            if (auto self = wp.lock())
+                self->put_buffer(buf);
+            else
+                delete buf;
+        };
+        return string_ref{string_ref::pointer_type{buf.release(), std::move(del)}};
+    }
+};
+
+// --------------------------------------------------------------------------
+
+topic_template::topic_template(const string& pattern, size_t cacheSize /*=0*/)
+    : pattern_{pattern}, state_{std::make_shared<state>(cacheSize)}
+{
+    if (pattern.empty())
+        throw std::invalid_argument("Empty topic template");
+
+    string text;
+    size_t i = 0, n = pattern.size();
+
+    while (i < n) {
+        char c = pattern[i];
+
+        if (c == '+' || c == '#' || c == '\0')
+            throw std::invalid_argument("Wildcard in topic template: " + pattern);
+        if (c == '}')
+            throw std::invalid_argument("Unmatched '}' in topic template: " + pattern);
+
+        if (c != '{') {
+            text.push_back(c);
+            ++i;
+            continue;
+        }
+
+        auto end = pattern.find('}', i);
+        if (end == string::npos)
+            throw std::invalid_argument("Unmatched '{' in topic template: " + pattern);
+
+        string name = pattern.substr(i + 1, end - i - 1);
+        if (name.empty())
+            throw std::invalid_argument("Empty placeholder in topic template: " + pattern);
+        if (!std::all_of(name.begin(), name.end(), valid_name_char))
+            throw std::invalid_argument("Bad placeholder in topic template: " + pattern);
+
+        if (!text.empty()) {
+            literalLen_ += text.size();
+            parts_.push_back(part{std::move(text), -1});
+            text.clear();
+        }
+
+        auto it = std::find(names_.begin(), names_.end(), name);
+        int arg = int(it - names_.begin());
+        if (it == names_.end())
+            names_.push_back(std::move(name));
+
+        parts_.push_back(part{string{}, arg});
+        i = end + 1;
+    }
+
+    if (!text.empty()) {
+        literalLen_ += text.size();
+        parts_.push_back(part{std::move(text), -1});
+    }
+
+    if (literalLen_ > MAX_TOPIC_LEN)
+        throw std::invalid_argument("Topic template is too long");
+}
+
+void topic_template::format_to(string& out, const std::string_view* args, size_t n) const
+{
+    if (n != names_.size())
+        throw std::invalid_argument(
+            "Topic template '" + pattern_ + "' takes " + std::to_string(names_.size()) +
+            " arguments"
+        );
+
+    for (size_t i = 0; i < n; ++i) {
+        if (args[i].find_first_of(string{"/+#\0", 4}) != std::string_view::npos)
+            throw std::invalid_argument("Bad topic argument: '" + string{args[i]} + "'");
+    }
+
+    size_t len = literalLen_;
+    for (const auto& p : parts_) {
+        if (p.arg >= 0)
+            len += args[p.arg].size();
+    }
+    if (len > MAX_TOPIC_LEN)
+        throw std::invalid_argument("Formatted topic is too long");
+
+    out.reserve(out.size() + len);
+    for (const auto& p : parts_) {
+        if (p.arg < 0)
+            out += p.text;
+        else
+            out.append(args[p.arg].data(), args[p.arg].size());
+    }
+}
+
+// With the cache, the arguments are joined into a key, separated by NUL
+// characters, which can't appear in an argument. The key is built in a
+// reused buffer, so a hit doesn't allocate.
+
+string_ref topic_template::format(const std::string_view* args, size_t n) const
+{
+    auto& st = *state_;
+
+    if (st.cacheSize > 0) {
+        std::lock_guard<std::mutex> g(st.lock);
+        st.key.clear();
+        for (size_t i = 0; i < n; ++i) {
+            st.key.append(args[i].data(), args[i].size());
+            st.key.push_back('\0');
+        }
+
+        auto it = st.cache.find(st.key);
+        if (it != st.cache.end()) {
+            ++st.nHits;
+            st.keys.splice(st.keys.begin(), st.keys, it->second.second);
+            return it->second.first;
+        }
+    }
+
+    auto buf = st.get_buffer();
+    buf->clear();
+    format_to(*buf, args, n);
+    auto topic = st.make_ref(std::move(buf));
+
+    if (st.cacheSize > 0) {
+        // An evicted topic is released outside the lock, since its buffer
+        // goes back to the pool.
+        string_ref evicted;
+        std::lock_guard<std::mutex> g(st.lock);
+
+        // Rebuild the key, since another thread may have used the buffer
+        string key;
+        for (size_t i = 0; i < n; ++i) {
+            key.append(args[i].data(), args[i].size());
+            key.push_back('\0');
+        }
+
+        if (st.cache.find(key) == st.cache.end()) {
+            st.keys.push_front(key);
+            st.cache.emplace(std::move(key), std::make_pair(topic, st.keys.begin()));
+
+            if (st.cache.size() > st.cacheSize) {
+                auto old = st.cache.find(st.keys.back());
+                evicted = std::move(old->second.first);
+                st.cache.erase(old);
+                st.keys.pop_back();
+            }
+        }
+    }
+    return topic;
+}
+
+size_t topic_template::cache_size() const
+{
+    std::lock_guard<std::mutex> g(state_->lock);
+    return state_->cache.size();
+}
+
+size_t topic_template::cache_hits() const
+{
+    std::lock_guard<std::mutex> g(state_->lock);
+    return state_->nHits;
+}
+
+size_t topic_template::pool_size() const
+{
+    std::lock_guard<std::mutex> g(state_->lock);
+    return state_->pool.size();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
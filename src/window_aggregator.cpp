@@ -0,0 +1,281 @@
+// window_aggregator.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/window_aggregator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The aggregator that is publishing summaries from this thread, so its own
+// messages aren't intercepted.
+thread_local const window_aggregator* flushing = nullptr;
+
+// Marks the thread as publishing for an aggregator, for a scope
+struct flush_scope
+{
+    const window_aggregator* prev;
+
+    explicit flush_scope(const window_aggregator* agg) : prev{flushing} { flushing = agg; }
+    ~flush_scope() { flushing = prev; }
+};
+
+}  // namespace
+
+// --------------------------------------------------------------------------
+
+window_aggregator::window_aggregator(
+    iasync_client& cli, duration window, int qos /*=DFLT_QOS*/,
+    bool retained /*=DFLT_RETAINED*/
+)
+    : window_aggregator(cli, window, json_format(qos, retained))
+{
+}
+
+window_aggregator::window_aggregator(iasync_client& cli, duration window, format_function fmt)
+    : cli_(cli), window_(window.count() > 0 ? window : duration(1)), fmt_(std::move(fmt))
+{
+    thr_ = std::thread(&window_aggregator::run, this);
+}
+
+window_aggregator::~window_aggregator() { stop(); }
+
+window_aggregator::format_function window_aggregator::json_format(
+    int qos /*=DFLT_QOS*/, bool retained /*=DFLT_RETAINED*/,
+    const string& topicSuffix /*=string()*/
+)
+{
+    message::validate_qos(qos);
+
+    return [qos, retained, topicSuffix](const string& topic, const summary& sum) {
+        char buf[192];
+        int n = snprintf(
+            buf, sizeof(buf),
+            "{\"min\":%.10g,\"max\":%.10g,\"mean\":%.10g,\"last\":%.10g,\"count\":%llu}",
+            sum.min, sum.max, sum.mean(), sum.last, (unsigned long long)sum.count
+        );
+        return message::create(
+            topic + topicSuffix, buf, size_t(n < 0 ? 0 : n), qos, retained
+        );
+    };
+}
+
+int64_t window_aggregator::next_edge() const
+{
+    auto t = std::chrono::system_clock::now().time_since_epoch();
+    return int64_t(std::chrono::duration_cast<duration>(t) / window_) + 1;
+}
+
+// The timer fires on multiples of the window on the system clock. The time
+// to each boundary is found from the system clock, but waited out on the
+// steady clock, so a clock adjustment only moves the next boundary. The
+// wait can end just short of the boundary, so the one after it is never
+// taken before the one that was waited for. If a flush runs long, the
+// windows that were missed are skipped rather than published empty.
+
+void window_aggregator::run()
+{
+    using namespace std::chrono;
+
+    int64_t edge = next_edge();
+    unique_lock g(lock_);
+
+    while (!stopped_) {
+        auto sysEdge = system_clock::time_point{duration_cast<system_clock::duration>(
+            window_ * edge
+        )};
+        auto next = clock::now() + (sysEdge - system_clock::now());
+
+        if (cond_.wait_until(g, next, [this] { return stopped_; }))
+            break;
+
+        g.unlock();
+        flush();
+        g.lock();
+
+        edge = std::max(edge + 1, next_edge());
+    }
+}
+
+void window_aggregator::add(const string& topic, double val)
+{
+    if (std::isnan(val))
+        return;
+
+    guard g(lock_);
+    auto& sum = windows_[topic];
+    if (sum.count == 0) {
+        sum.min = sum.max = sum.sum = val;
+    }
+    else {
+        if (val < sum.min)
+            sum.min = val;
+        if (val > sum.max)
+            sum.max = val;
+        sum.sum += val;
+    }
+    sum.last = val;
+    ++sum.count;
+    ++nSamples_;
+}
+
+bool window_aggregator::add(const message& msg)
+{
+    const auto& payload = msg.get_payload_str();
+    if (payload.empty())
+        return false;
+
+    const char* s = payload.c_str();
+    char* end = nullptr;
+    double val = std::strtod(s, &end);
+
+    if (end == s)
+        return false;
+    while (std::isspace(static_cast<unsigned char>(*end))) ++end;
+    if (*end != '\0')
+        return false;
+
+    add(msg.get_topic(), val);
+    return true;
+}
+
+void window_aggregator::aggregate(const string& topicFilter)
+{
+    topic_filter filt{topicFilter};
+    guard g(lock_);
+    filters_.push_back(std::move(filt));
+}
+
+bool window_aggregator::intercept(const message& msg)
+{
+    if (flushing == this)
+        return false;
+
+    {
+        guard g(lock_);
+        if (stopped_)
+            return false;
+
+        const auto& topic = msg.get_topic();
+        auto p = std::find_if(filters_.begin(), filters_.end(), [&topic](const auto& f) {
+            return f.matches(topic);
+        });
+        if (p == filters_.end())
+            return false;
+    }
+    return add(msg);
+}
+
+// The table entries are reset rather than erased, so a topic that is
+// sampled steadily keeps its slot. Only the topics that went a whole
+// window without a sample are removed.
+
+void window_aggregator::flush()
+{
+    guard fg(flushLock_);
+    std::vector<std::pair<string, summary>> sums;
+    {
+        guard g(lock_);
+        sums.reserve(windows_.size());
+        for (auto p = windows_.begin(); p != windows_.end();) {
+            if (p->second.count == 0) {
+                p = windows_.erase(p);
+                continue;
+            }
+            sums.emplace_back(p->first, p->second);
+            p->second.count = 0;
+            ++p;
+        }
+    }
+
+    // Keep the summaries from being intercepted
+    flush_scope scope{this};
+
+    uint64_t nPub = 0, nErr = 0;
+    for (const auto& s : sums) {
+        try {
+            auto msg = fmt_(s.first, s.second);
+            if (msg) {
+                cli_.publish(std::move(msg));
+                ++nPub;
+            }
+        }
+        catch (const std::exception&) {
+            ++nErr;
+        }
+    }
+
+    guard g(lock_);
+    nSummaries_ += nPub;
+    nErrors_ += nErr;
+}
+
+void window_aggregator::stop()
+{
+    {
+        guard g(lock_);
+        if (stopped_)
+            return;
+        stopped_ = true;
+    }
+    cond_.notify_all();
+    if (thr_.joinable())
+        thr_.join();
+    flush();
+}
+
+size_t window_aggregator::num_topics()
+{
+    guard g(lock_);
+    size_t n = 0;
+    for (const auto& p : windows_) {
+        if (p.second.count != 0)
+            ++n;
+    }
+    return n;
+}
+
+uint64_t window_aggregator::num_samples()
+{
+    guard g(lock_);
+    return nSamples_;
+}
+
+uint64_t window_aggregator::num_summaries()
+{
+    guard g(lock_);
+    return nSummaries_;
+}
+
+uint64_t window_aggregator::num_errors()
+{
+    guard g(lock_);
+    return nErrors_;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
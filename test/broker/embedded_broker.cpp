@@ -0,0 +1,1105 @@
+// embedded_broker.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "embedded_broker.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <deque>
+#include <set>
+#include <tuple>
+
+#include "mqtt/exception.h"
+#include "mqtt/topic.h"
+
+#if !defined(MSG_NOSIGNAL)
+    #define MSG_NOSIGNAL 0
+#endif
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The MQTT control packet types
+enum packet_type : uint8_t {
+    CONNECT = 1,
+    CONNACK,
+    PUBLISH,
+    PUBACK,
+    PUBREC,
+    PUBREL,
+    PUBCOMP,
+    SUBSCRIBE,
+    SUBACK,
+    UNSUBSCRIBE,
+    UNSUBACK,
+    PINGREQ,
+    PINGRESP,
+    DISCONNECT
+};
+
+// The v5 properties the broker looks at
+constexpr uint32_t PROP_SUBSCRIPTION_ID = 0x0B;
+constexpr uint32_t PROP_SESSION_EXPIRY = 0x11;
+constexpr uint32_t PROP_ASSIGNED_CLIENT_ID = 0x12;
+constexpr uint32_t PROP_WILL_DELAY = 0x18;
+constexpr uint32_t PROP_TOPIC_ALIAS = 0x23;
+
+// The most messages kept for an offline persistent session
+constexpr size_t MAX_QUEUED = 10000;
+
+// The most that a client can send in one packet
+constexpr uint32_t MAX_PACKET_SIZE = 256 * 1024 * 1024;
+
+// How long a new connection has to send CONNECT
+constexpr int CONNECT_TIMEOUT_MS = 10000;
+
+// Reads the fields of a packet, remembering if it ran off the end.
+class reader
+{
+    const string& s_;
+    size_t pos_;
+    bool ok_{true};
+
+public:
+    explicit reader(const string& s, size_t pos = 0) : s_{s}, pos_{pos} {}
+
+    bool ok() const { return ok_; }
+    size_t pos() const { return pos_; }
+    size_t left() const { return ok_ ? s_.size() - pos_ : 0; }
+
+    uint8_t byte() {
+        if (pos_ >= s_.size()) {
+            ok_ = false;
+            return 0;
+        }
+        return uint8_t(s_[pos_++]);
+    }
+    uint16_t u16() {
+        uint16_t hi = byte();
+        return uint16_t((hi << 8) | byte());
+    }
+    uint32_t u32() {
+        uint32_t hi = u16();
+        return (hi << 16) | u16();
+    }
+    uint32_t varint() {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) {
+            uint8_t b = byte();
+            v |= uint32_t(b & 0x7F) << (7 * i);
+            if (!(b & 0x80))
+                return v;
+        }
+        ok_ = false;
+        return 0;
+    }
+    string bytes(size_t n) {
+        if (n > left()) {
+            ok_ = false;
+            return string{};
+        }
+        auto s = s_.substr(pos_, n);
+        pos_ += n;
+        return s;
+    }
+    string str() { return bytes(u16()); }
+};
+
+// Reads a v5 property list, calling fn(id, raw, val) for each property,
+// where 'raw' is the whole encoded property, and 'val' is the value of
+// the integer types.
+template <typename F>
+bool read_props(reader& r, F fn)
+{
+    uint32_t len = r.varint();
+    if (!r.ok() || len > r.left())
+        return false;
+
+    string data = r.bytes(len);
+    reader pr{data};
+
+    while (pr.ok() && pr.left() > 0) {
+        size_t beg = pr.pos();
+        uint32_t id = pr.varint(), val = 0;
+
+        switch (id) {
+            case 0x01:
+            case 0x17:
+            case 0x19:
+            case 0x24:
+            case 0x25:
+            case 0x28:
+            case 0x29:
+            case 0x2A:
+                val = pr.byte();
+                break;
+            case 0x13:
+            case 0x21:
+            case 0x22:
+            case 0x23:
+                val = pr.u16();
+                break;
+            case 0x02:
+            case 0x11:
+            case 0x18:
+            case 0x27:
+                val = pr.u32();
+                break;
+            case 0x0B:
+                val = pr.varint();
+                break;
+            case 0x03:
+            case 0x08:
+            case 0x09:
+            case 0x12:
+            case 0x15:
+            case 0x16:
+            case 0x1A:
+            case 0x1C:
+            case 0x1F:
+                pr.str();
+                break;
+            case 0x26:
+                pr.str();
+                pr.str();
+                break;
+            default:
+                return false;
+        }
+        if (!pr.ok())
+            return false;
+        fn(id, data.substr(beg, pr.pos() - beg), val);
+    }
+    return pr.ok();
+}
+
+void put_u16(string& s, unsigned v)
+{
+    s.push_back(char((v >> 8) & 0xFF));
+    s.push_back(char(v & 0xFF));
+}
+
+void put_varint(string& s, size_t v)
+{
+    do {
+        char b = char(v & 0x7F);
+        v >>= 7;
+        if (v)
+            b |= char(0x80);
+        s.push_back(b);
+    } while (v);
+}
+
+void put_str(string& s, const string& v)
+{
+    put_u16(s, unsigned(v.size()));
+    s += v;
+}
+
+string packet(unsigned hdr, const string& body)
+{
+    string p;
+    p.reserve(body.size() + 5);
+    p.push_back(char(hdr));
+    put_varint(p, body.size());
+    p += body;
+    return p;
+}
+
+string ack_packet(unsigned hdr, uint16_t id)
+{
+    string b;
+    put_u16(b, id);
+    return packet(hdr, b);
+}
+
+// A filter may only have '#' as the whole last level, and '+' as a whole
+// level.
+bool valid_filter(const string& filter)
+{
+    if (filter.empty())
+        return false;
+
+    auto fields = topic::split(filter);
+    for (size_t i = 0; i < fields.size(); ++i) {
+        const auto& fld = fields[i];
+        if (fld.find('#') != string::npos && (fld != "#" || i + 1 != fields.size()))
+            return false;
+        if (fld.find('+') != string::npos && fld != "+")
+            return false;
+    }
+    return true;
+}
+
+// Wildcards at the first level don't match the '$' topics
+bool system_topic_excluded(const string& filter, const string& topic)
+{
+    return !topic.empty() && topic[0] == '$' && (filter[0] == '+' || filter[0] == '#');
+}
+
+bool read_full(int sock, char* buf, size_t n)
+{
+    while (n > 0) {
+        auto ret = ::recv(sock, buf, n, 0);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+        buf += ret;
+        n -= size_t(ret);
+    }
+    return true;
+}
+
+bool write_full(int sock, const char* buf, size_t n)
+{
+    while (n > 0) {
+        auto ret = ::send(sock, buf, n, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+        buf += ret;
+        n -= size_t(ret);
+    }
+    return true;
+}
+
+bool read_packet(int sock, uint8_t& hdr, string& body)
+{
+    char c;
+    if (!read_full(sock, &c, 1))
+        return false;
+    hdr = uint8_t(c);
+
+    uint32_t len = 0;
+    for (int i = 0;; ++i) {
+        if (i == 4 || !read_full(sock, &c, 1))
+            return false;
+        len |= uint32_t(c & 0x7F) << (7 * i);
+        if (!(c & 0x80))
+            break;
+    }
+    if (len > MAX_PACKET_SIZE)
+        return false;
+
+    body.resize(len);
+    return len == 0 || read_full(sock, &body[0], len);
+}
+
+void set_timeout(int sock, int ms)
+{
+    timeval tv{};
+    tv.tv_sec = ms / 1000;
+    tv.tv_usec = (ms % 1000) * 1000;
+    ::setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+}  // namespace
+
+/////////////////////////////////////////////////////////////////////////////
+
+struct embedded_broker::pub_msg
+{
+    string topic;
+    string payload;
+    // The v5 properties to forward, encoded, without the length
+    string props;
+    int qos{0};
+    bool retain{false};
+};
+
+struct embedded_broker::connection
+{
+    int sock;
+    std::thread thr;
+    std::atomic<bool> done{false};
+    std::mutex writeLock;
+    // These are only changed by the connection's own thread
+    std::shared_ptr<session> sess;
+    std::shared_ptr<pub_msg> will;
+
+    explicit connection(int s) : sock{s} {}
+    ~connection() { ::close(sock); }
+
+    bool send(const string& pkt) {
+        std::lock_guard<std::mutex> g(writeLock);
+        if (write_full(sock, pkt.data(), pkt.size()))
+            return true;
+        drop();
+        return false;
+    }
+    void drop() { ::shutdown(sock, SHUT_RDWR); }
+};
+
+struct embedded_broker::session
+{
+    struct out_msg
+    {
+        std::shared_ptr<pub_msg> msg;
+        int qos;
+        bool retain;
+        std::vector<uint32_t> subIds;
+        // Whether PUBREC was received, for QoS 2
+        bool released{false};
+    };
+
+    string clientId;
+    int version{4};
+    // Whether the session outlives the connection
+    bool keep{false};
+    std::shared_ptr<connection> conn;
+    std::map<string, subscription> subs;
+    uint16_t lastId{0};
+    // Outgoing QoS 1 and 2 messages waiting to be acknowledged
+    std::map<uint16_t, out_msg> inflight;
+    // Incoming QoS 2 messages waiting for PUBREL
+    std::set<uint16_t> qos2In;
+    // Messages that arrived while the client was away
+    std::deque<out_msg> queued;
+};
+
+namespace {
+
+string encode_publish(
+    int version, uint16_t id, bool dup, const string& topic, const string& payload,
+    const string& fwdProps, int qos, bool retain, const std::vector<uint32_t>& subIds
+)
+{
+    string b;
+    b.reserve(topic.size() + payload.size() + fwdProps.size() + 16);
+    put_str(b, topic);
+    if (qos > 0)
+        put_u16(b, id);
+
+    if (version >= 5) {
+        string props = fwdProps;
+        for (auto sid : subIds) {
+            props.push_back(char(PROP_SUBSCRIPTION_ID));
+            put_varint(props, sid);
+        }
+        put_varint(b, props.size());
+        b += props;
+    }
+    b += payload;
+
+    unsigned hdr =
+        (PUBLISH << 4) | (dup ? 0x08 : 0) | (unsigned(qos) << 1) | (retain ? 1 : 0);
+    return packet(hdr, b);
+}
+
+}  // namespace
+
+// --------------------------------------------------------------------------
+
+embedded_broker::embedded_broker(uint16_t port /*=0*/)
+{
+    listenSock_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSock_ < 0)
+        throw exception(MQTTASYNC_FAILURE, "Can't create the broker socket");
+
+    int on = 1;
+    ::setsockopt(listenSock_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+
+    socklen_t len = sizeof(addr);
+    if (::bind(listenSock_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listenSock_, 64) < 0 ||
+        ::getsockname(listenSock_, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+        ::close(listenSock_);
+        throw exception(MQTTASYNC_FAILURE, "Can't listen on the broker port");
+    }
+
+    port_ = ntohs(addr.sin_port);
+    running_ = true;
+    acceptThr_ = std::thread(&embedded_broker::accept_loop, this);
+}
+
+embedded_broker::~embedded_broker() { stop(); }
+
+string embedded_broker::uri() const { return "tcp://127.0.0.1:" + std::to_string(port_); }
+
+// The accept loop polls so that it can notice when the broker stops, and
+// can clean up after the connections that closed in the meantime.
+
+void embedded_broker::accept_loop()
+{
+    while (running_) {
+        pollfd pfd{listenSock_, POLLIN, 0};
+        int rc = ::poll(&pfd, 1, 100);
+
+        reap_connections(false);
+        if (rc <= 0 || !running_)
+            continue;
+
+        int sock = ::accept(listenSock_, nullptr, nullptr);
+        if (sock < 0)
+            continue;
+
+        int on = 1;
+        ::setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+#if defined(SO_NOSIGPIPE)
+        ::setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+        auto conn = std::make_shared<connection>(sock);
+        {
+            guard g(lock_);
+            conns_.push_back(conn);
+            ++stats_.connections;
+        }
+        conn->thr = std::thread(&embedded_broker::serve, this, conn);
+    }
+}
+
+void embedded_broker::reap_connections(bool all)
+{
+    std::vector<std::shared_ptr<connection>> done;
+    {
+        guard g(lock_);
+        for (auto p = conns_.begin(); p != conns_.end();) {
+            if (all || (*p)->done) {
+                done.push_back(*p);
+                p = conns_.erase(p);
+            }
+            else {
+                ++p;
+            }
+        }
+    }
+    for (auto& conn : done) {
+        if (conn->thr.joinable())
+            conn->thr.join();
+    }
+}
+
+void embedded_broker::stop()
+{
+    if (!running_.exchange(false))
+        return;
+
+    if (acceptThr_.joinable())
+        acceptThr_.join();
+
+    ::close(listenSock_);
+    listenSock_ = -1;
+
+    disconnect_clients();
+    reap_connections(true);
+}
+
+void embedded_broker::disconnect_clients()
+{
+    guard g(lock_);
+    for (auto& conn : conns_) conn->drop();
+}
+
+void embedded_broker::send_all(outbox& out)
+{
+    for (auto& pkt : out) pkt.first->send(pkt.second);
+}
+
+// --------------------------------------------------------------------------
+
+void embedded_broker::serve(std::shared_ptr<connection> conn)
+{
+    uint8_t hdr = 0;
+    string body;
+
+    set_timeout(conn->sock, CONNECT_TIMEOUT_MS);
+
+    if (read_packet(conn->sock, hdr, body) && (hdr >> 4) == CONNECT &&
+        on_connect(conn, body)) {
+        bool ok = true;
+        while (ok && read_packet(conn->sock, hdr, body)) {
+            switch (hdr >> 4) {
+                case PUBLISH:
+                    ok = on_publish(conn, hdr, body);
+                    break;
+
+                case PUBACK:
+                case PUBREC:
+                case PUBREL:
+                case PUBCOMP:
+                    ok = on_ack(conn, uint8_t(hdr >> 4), body);
+                    break;
+
+                case SUBSCRIBE:
+                    ok = on_subscribe(conn, body);
+                    break;
+
+                case UNSUBSCRIBE:
+                    ok = on_unsubscribe(conn, body);
+                    break;
+
+                case PINGREQ:
+                    ok = conn->send(packet(PINGRESP << 4, string{}));
+                    break;
+
+                case DISCONNECT:
+                    // A v5 client can ask for its will to be sent anyway
+                    if (body.empty() || body[0] != 0x04)
+                        conn->will.reset();
+                    ok = false;
+                    break;
+
+                default:
+                    ok = false;
+                    break;
+            }
+        }
+    }
+
+    on_close(conn);
+    conn->drop();
+    conn->done = true;
+}
+
+bool embedded_broker::on_connect(const std::shared_ptr<connection>& conn, const string& body)
+{
+    reader r{body};
+    string proto = r.str();
+    uint8_t level = r.byte();
+
+    int version = 0;
+    if (proto == "MQTT" && (level == 4 || level == 5))
+        version = level;
+    else if (proto == "MQIsdp" && level == 3)
+        version = 3;
+
+    if (!r.ok())
+        return false;
+
+    if (version == 0) {
+        // Unacceptable protocol version
+        conn->send(packet(CONNACK << 4, string{'\0', '\x01'}));
+        return false;
+    }
+
+    uint8_t flags = r.byte();
+    uint16_t keepAlive = r.u16();
+    bool clean = (flags & 0x02) != 0;
+
+    uint32_t expiry = 0;
+    if (version == 5 && !read_props(r, [&expiry](uint32_t id, const string&, uint32_t val) {
+            if (id == PROP_SESSION_EXPIRY)
+                expiry = val;
+        }))
+        return false;
+
+    string clientId = r.str();
+
+    std::shared_ptr<pub_msg> will;
+    if (flags & 0x04) {
+        will = std::make_shared<pub_msg>();
+        if (version == 5 && !read_props(r, [&will](uint32_t id, const string& raw, uint32_t) {
+                if (id != PROP_WILL_DELAY)
+                    will->props += raw;
+            }))
+            return false;
+        will->topic = r.str();
+        will->payload = r.str();
+        will->qos = (flags >> 3) & 0x03;
+        will->retain = (flags & 0x20) != 0;
+    }
+    if (flags & 0x80)
+        r.str();
+    if (flags & 0x40)
+        r.str();
+
+    if (!r.ok())
+        return false;
+
+    if (clientId.empty() && version < 5 && !clean) {
+        // Identifier rejected
+        conn->send(packet(CONNACK << 4, string{'\0', '\x02'}));
+        return false;
+    }
+
+    bool keep = (version == 5) ? (expiry != 0) : !clean;
+    bool assigned = false, present = false;
+    std::shared_ptr<connection> old;
+    outbox out;
+    {
+        guard g(lock_);
+
+        if (clientId.empty()) {
+            clientId = "auto-" + std::to_string(++nAssigned_);
+            assigned = true;
+        }
+
+        std::shared_ptr<session> sess;
+        auto it = sessions_.find(clientId);
+        if (it != sessions_.end()) {
+            sess = it->second;
+            old = std::move(sess->conn);
+            if (clean) {
+                remove_session(*sess);
+                sess.reset();
+            }
+        }
+
+        if (sess) {
+            present = true;
+        }
+        else {
+            sess = std::make_shared<session>();
+            sess->clientId = clientId;
+            sessions_[clientId] = sess;
+        }
+
+        sess->version = version;
+        sess->keep = keep;
+        sess->conn = conn;
+        conn->sess = sess;
+        conn->will = std::move(will);
+
+        string ack;
+        ack.push_back(char(present ? 1 : 0));
+        ack.push_back(0);
+        if (version == 5) {
+            string props;
+            if (assigned) {
+                props.push_back(char(PROP_ASSIGNED_CLIENT_ID));
+                put_str(props, clientId);
+            }
+            put_varint(ack, props.size());
+            ack += props;
+        }
+        out.emplace_back(conn, packet(CONNACK << 4, ack));
+
+        // Pick up where the session left off
+        for (const auto& p : sess->inflight) {
+            const auto& m = p.second;
+            if (m.released)
+                out.emplace_back(conn, ack_packet((PUBREL << 4) | 0x02, p.first));
+            else
+                out.emplace_back(
+                    conn, encode_publish(
+                              version, p.first, true, m.msg->topic, m.msg->payload,
+                              m.msg->props, m.qos, m.retain, m.subIds
+                          )
+                );
+        }
+
+        auto queued = std::move(sess->queued);
+        sess->queued.clear();
+        for (auto& m : queued)
+            deliver(*sess, m.msg, m.qos, m.retain, std::move(m.subIds), out);
+    }
+
+    if (old)
+        old->drop();
+
+    set_timeout(conn->sock, keepAlive * 1500);
+    send_all(out);
+    return true;
+}
+
+bool embedded_broker::on_publish(
+    const std::shared_ptr<connection>& conn, uint8_t hdr, const string& body
+)
+{
+    int qos = (hdr >> 1) & 0x03;
+    if (qos == 3)
+        return false;
+
+    auto& sess = conn->sess;
+    auto msg = std::make_shared<pub_msg>();
+
+    reader r{body};
+    msg->topic = r.str();
+    uint16_t id = (qos > 0) ? r.u16() : 0;
+
+    auto fwdProp = [&msg](uint32_t pid, const string& raw, uint32_t) {
+        if (pid != PROP_TOPIC_ALIAS && pid != PROP_SUBSCRIPTION_ID)
+            msg->props += raw;
+    };
+    if (sess->version == 5 && !read_props(r, fwdProp))
+        return false;
+
+    if (!r.ok() || msg->topic.empty() || msg->topic.find_first_of("+#") != string::npos)
+        return false;
+
+    msg->payload = body.substr(r.pos());
+    msg->qos = qos;
+    msg->retain = (hdr & 0x01) != 0;
+
+    outbox out;
+    {
+        guard g(lock_);
+        // A resent QoS 2 message that was already routed
+        bool dup = (qos == 2) && !sess->qos2In.insert(id).second;
+        if (!dup) {
+            ++stats_.messagesIn;
+            route(msg, sess.get(), out);
+        }
+    }
+
+    if (qos == 1)
+        out.emplace_back(conn, ack_packet(PUBACK << 4, id));
+    else if (qos == 2)
+        out.emplace_back(conn, ack_packet(PUBREC << 4, id));
+
+    send_all(out);
+    return true;
+}
+
+bool embedded_broker::on_ack(
+    const std::shared_ptr<connection>& conn, uint8_t type, const string& body
+)
+{
+    reader r{body};
+    uint16_t id = r.u16();
+    if (!r.ok())
+        return false;
+
+    auto& sess = conn->sess;
+    string reply;
+    {
+        guard g(lock_);
+        switch (type) {
+            case PUBACK:
+            case PUBCOMP:
+                sess->inflight.erase(id);
+                break;
+
+            case PUBREC: {
+                // A v5 error code ends the exchange
+                if (body.size() > 2 && uint8_t(body[2]) >= 0x80) {
+                    sess->inflight.erase(id);
+                    break;
+                }
+                auto it = sess->inflight.find(id);
+                if (it != sess->inflight.end())
+                    it->second.released = true;
+                reply = ack_packet((PUBREL << 4) | 0x02, id);
+                break;
+            }
+
+            case PUBREL:
+                sess->qos2In.erase(id);
+                reply = ack_packet(PUBCOMP << 4, id);
+                break;
+        }
+    }
+    return reply.empty() || conn->send(reply);
+}
+
+bool embedded_broker::on_subscribe(
+    const std::shared_ptr<connection>& conn, const string& body
+)
+{
+    auto& sess = conn->sess;
+    bool v5 = sess->version == 5;
+
+    reader r{body};
+    uint16_t id = r.u16();
+
+    uint32_t subId = 0;
+    if (v5 && !read_props(r, [&subId](uint32_t pid, const string&, uint32_t val) {
+            if (pid == PROP_SUBSCRIPTION_ID)
+                subId = val;
+        }))
+        return false;
+
+    std::vector<std::pair<string, uint8_t>> reqs;
+    while (r.ok() && r.left() > 0) {
+        string filter = r.str();
+        uint8_t opts = r.byte();
+        reqs.emplace_back(std::move(filter), opts);
+    }
+    if (!r.ok() || reqs.empty())
+        return false;
+
+    string ack;
+    put_u16(ack, id);
+    if (v5)
+        ack.push_back(0);
+
+    outbox out;
+    {
+        guard g(lock_);
+
+        std::vector<std::tuple<std::shared_ptr<pub_msg>, int>> retained;
+
+        for (const auto& req : reqs) {
+            const string& filter = req.first;
+            uint8_t opts = req.second;
+            int qos = opts & 0x03;
+            bool shared = filter.compare(0, 7, "$share/") == 0;
+
+            if (qos == 3 || shared || !valid_filter(filter)) {
+                ack.push_back(char(v5 ? (shared ? 0x9E : 0x8F) : 0x80));
+                continue;
+            }
+
+            subscription sub;
+            sub.qos = qos;
+            if (v5) {
+                sub.noLocal = (opts & 0x04) != 0;
+                sub.retainAsPublished = (opts & 0x08) != 0;
+                sub.subId = subId;
+            }
+            int retainHandling = v5 ? ((opts >> 4) & 0x03) : 0;
+
+            bool existed = sess->subs.count(filter) != 0;
+            sess->subs[filter] = sub;
+
+            auto it = subs_.find(filter);
+            if (it != subs_.end())
+                it->second[sess.get()] = sub;
+            else
+                subs_.insert({filter, {{sess.get(), sub}}});
+
+            ack.push_back(char(qos));
+
+            if (retainHandling == 0 || (retainHandling == 1 && !existed)) {
+                topic_filter tf{filter};
+                for (const auto& p : retained_) {
+                    if (!system_topic_excluded(filter, p.first) && tf.matches(p.first))
+                        retained.emplace_back(p.second, std::min(p.second->qos, qos));
+                }
+            }
+        }
+
+        out.emplace_back(conn, packet(SUBACK << 4, ack));
+
+        std::vector<uint32_t> subIds;
+        if (subId)
+            subIds.push_back(subId);
+
+        for (const auto& m : retained)
+            deliver(*sess, std::get<0>(m), std::get<1>(m), true, subIds, out);
+    }
+
+    send_all(out);
+    return true;
+}
+
+bool embedded_broker::on_unsubscribe(
+    const std::shared_ptr<connection>& conn, const string& body
+)
+{
+    auto& sess = conn->sess;
+    bool v5 = sess->version == 5;
+
+    reader r{body};
+    uint16_t id = r.u16();
+
+    if (v5 && !read_props(r, [](uint32_t, const string&, uint32_t) {}))
+        return false;
+
+    std::vector<string> filters;
+    while (r.ok() && r.left() > 0) filters.push_back(r.str());
+    if (!r.ok() || filters.empty())
+        return false;
+
+    string ack;
+    put_u16(ack, id);
+    if (v5)
+        ack.push_back(0);
+    {
+        guard g(lock_);
+        for (const auto& filter : filters) {
+            bool had = remove_subscription(*sess, filter);
+            if (v5)
+                ack.push_back(char(had ? 0x00 : 0x11));
+        }
+        subs_.prune();
+    }
+    return conn->send(packet(UNSUBACK << 4, ack));
+}
+
+void embedded_broker::on_close(const std::shared_ptr<connection>& conn)
+{
+    outbox out;
+    {
+        guard g(lock_);
+        auto sess = std::move(conn->sess);
+        if (sess && sess->conn == conn) {
+            sess->conn.reset();
+            if (!sess->keep)
+                remove_session(*sess);
+        }
+        if (conn->will) {
+            ++stats_.messagesIn;
+            route(conn->will, nullptr, out);
+            conn->will.reset();
+        }
+    }
+    send_all(out);
+}
+
+// --------------------------------------------------------------------------
+
+// A subscriber gets one copy of a message, even if several of its
+// filters match, at the highest QoS of those filters.
+
+void embedded_broker::route(
+    const std::shared_ptr<pub_msg>& msg, const session* from, outbox& out
+)
+{
+    if (msg->retain) {
+        if (msg->payload.empty())
+            retained_.erase(msg->topic);
+        else
+            retained_[msg->topic] = msg;
+    }
+
+    struct target
+    {
+        int qos{0};
+        bool retain{false};
+        std::vector<uint32_t> subIds;
+    };
+    std::map<session*, target> targets;
+
+    for (auto it = subs_.matches(msg->topic); it != subs_.matches_end(); ++it) {
+        if (system_topic_excluded(it->first, msg->topic))
+            continue;
+
+        for (const auto& p : it->second) {
+            const auto& sub = p.second;
+            if (sub.noLocal && p.first == from)
+                continue;
+
+            auto& t = targets[p.first];
+            t.qos = std::max(t.qos, std::min(msg->qos, sub.qos));
+            t.retain = t.retain || (msg->retain && sub.retainAsPublished);
+            if (sub.subId)
+                t.subIds.push_back(sub.subId);
+        }
+    }
+
+    for (auto& p : targets)
+        deliver(
+            *p.first, msg, p.second.qos, p.second.retain, std::move(p.second.subIds), out
+        );
+}
+
+void embedded_broker::deliver(
+    session& sess, const std::shared_ptr<pub_msg>& msg, int qos, bool retain,
+    std::vector<uint32_t> subIds, outbox& out
+)
+{
+    if (!sess.conn) {
+        if (qos > 0 && sess.keep && sess.queued.size() < MAX_QUEUED)
+            sess.queued.push_back(session::out_msg{msg, qos, retain, std::move(subIds)});
+        return;
+    }
+
+    uint16_t id = 0;
+    if (qos > 0) {
+        if (sess.inflight.size() >= 65535)
+            return;
+        do {
+            if (++sess.lastId == 0)
+                sess.lastId = 1;
+        } while (sess.inflight.count(sess.lastId));
+        id = sess.lastId;
+    }
+
+    out.emplace_back(
+        sess.conn, encode_publish(
+                       sess.version, id, false, msg->topic, msg->payload, msg->props, qos,
+                       retain, subIds
+                   )
+    );
+    ++stats_.messagesOut;
+
+    if (qos > 0)
+        sess.inflight.emplace(id, session::out_msg{msg, qos, retain, std::move(subIds)});
+}
+
+// The filter may be the session's own copy, so it's erased from the
+// session last.
+bool embedded_broker::remove_subscription(session& sess, const string& filter)
+{
+    auto sub = sess.subs.find(filter);
+    if (sub == sess.subs.end())
+        return false;
+
+    auto it = subs_.find(filter);
+    if (it != subs_.end()) {
+        it->second.erase(&sess);
+        if (it->second.empty())
+            subs_.remove(filter);
+    }
+    sess.subs.erase(sub);
+    return true;
+}
+
+void embedded_broker::remove_session(session& sess)
+{
+    while (!sess.subs.empty()) remove_subscription(sess, sess.subs.begin()->first);
+    subs_.prune();
+
+    auto it = sessions_.find(sess.clientId);
+    if (it != sessions_.end() && it->second.get() == &sess)
+        sessions_.erase(it);
+}
+
+// --------------------------------------------------------------------------
+
+size_t embedded_broker::num_clients()
+{
+    guard g(lock_);
+    size_t n = 0;
+    for (const auto& p : sessions_) {
+        if (p.second->conn)
+            ++n;
+    }
+    return n;
+}
+
+size_t embedded_broker::num_sessions()
+{
+    guard g(lock_);
+    return sessions_.size();
+}
+
+size_t embedded_broker::num_retained()
+{
+    guard g(lock_);
+    return retained_.size();
+}
+
+embedded_broker::stats embedded_broker::get_stats()
+{
+    guard g(lock_);
+    return stats_;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
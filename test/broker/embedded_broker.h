@@ -0,0 +1,220 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file embedded_broker.h
+/// Declaration of MQTT embedded_broker class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_embedded_broker_h
+#define __mqtt_embedded_broker_h
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mqtt/topic_matcher.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A small MQTT broker that runs inside the process, for tests and
+ * benchmarks.
+ *
+ * It listens on the loopback interface and speaks MQTT v3.1, v3.1.1, and
+ * v5, with QoS 0, 1, and 2, retained messages, wildcard subscriptions,
+ * persistent sessions, and wills. That's enough to run a real client
+ * through connects, reconnects, and message flows on one machine, without
+ * an external broker.
+ *
+ * Each connection gets its own thread, and messages are routed under a
+ * single lock, using a topic_matcher to find the subscribers. There's no
+ * authentication or access control, and the broker doesn't keep anything
+ * on disk.
+ *
+ * @code
+ * mqtt::embedded_broker broker;
+ * mqtt::async_client cli(broker.uri(), "test-client");
+ * cli.connect()->wait();
+ * @endcode
+ */
+class embedded_broker
+{
+public:
+    /** Counts of the broker's activity */
+    struct stats
+    {
+        /** The number of connections accepted */
+        uint64_t connections{0};
+        /** The number of messages published to the broker */
+        uint64_t messagesIn{0};
+        /** The number of messages sent to subscribers */
+        uint64_t messagesOut{0};
+    };
+
+private:
+    /** A client connection */
+    struct connection;
+    /** A client session, which may outlive its connection */
+    struct session;
+    /** A message being routed */
+    struct pub_msg;
+
+    /** Options for a subscription */
+    struct subscription
+    {
+        /** The maximum QoS */
+        int qos{0};
+        /** Don't send the client its own messages (v5) */
+        bool noLocal{false};
+        /** Keep the retain flag on forwarded messages (v5) */
+        bool retainAsPublished{false};
+        /** The subscription identifier, or zero for none (v5) */
+        uint32_t subId{0};
+    };
+
+    /** Lock guard type for this class */
+    using guard = std::lock_guard<std::mutex>;
+    /** The packets to send once the lock is released */
+    using outbox = std::vector<std::pair<std::shared_ptr<connection>, string>>;
+
+    /** Object monitor mutex */
+    std::mutex lock_;
+    /** The listening socket */
+    int listenSock_{-1};
+    /** The port we're listening on */
+    uint16_t port_{0};
+    /** Whether the broker is running */
+    std::atomic<bool> running_{false};
+    /** The sessions, by client ID */
+    std::map<string, std::shared_ptr<session>> sessions_;
+    /** The subscribers to each topic filter */
+    topic_matcher<std::map<session*, subscription>> subs_;
+    /** The retained messages, by topic */
+    std::map<string, std::shared_ptr<pub_msg>> retained_;
+    /** The live connections */
+    std::list<std::shared_ptr<connection>> conns_;
+    /** The number of client IDs we assigned */
+    uint64_t nAssigned_{0};
+    /** Activity counts */
+    stats stats_;
+    /** The thread accepting connections */
+    std::thread acceptThr_;
+
+    /** Non-copyable */
+    embedded_broker(const embedded_broker&) = delete;
+    embedded_broker& operator=(const embedded_broker&) = delete;
+
+    /** The accept thread function */
+    void accept_loop();
+    /** Joins the threads of the connections that have closed */
+    void reap_connections(bool all);
+    /** The thread function for a connection */
+    void serve(std::shared_ptr<connection> conn);
+    /** Handles a CONNECT packet */
+    bool on_connect(const std::shared_ptr<connection>& conn, const string& body);
+    /** Handles a PUBLISH packet */
+    bool on_publish(const std::shared_ptr<connection>& conn, uint8_t hdr, const string& body);
+    /** Handles a SUBSCRIBE packet */
+    bool on_subscribe(const std::shared_ptr<connection>& conn, const string& body);
+    /** Handles an UNSUBSCRIBE packet */
+    bool on_unsubscribe(const std::shared_ptr<connection>& conn, const string& body);
+    /** Handles the acknowledgments for QoS 1 and 2 */
+    bool on_ack(const std::shared_ptr<connection>& conn, uint8_t type, const string& body);
+    /** Cleans up after a connection closes */
+    void on_close(const std::shared_ptr<connection>& conn);
+    /** Routes a message to its subscribers. Must hold the lock. */
+    void route(const std::shared_ptr<pub_msg>& msg, const session* from, outbox& out);
+    /** Sends a message to one session. Must hold the lock. */
+    void deliver(
+        session& sess, const std::shared_ptr<pub_msg>& msg, int qos, bool retain,
+        std::vector<uint32_t> subIds, outbox& out
+    );
+    /** Removes one of a session's subscriptions. Must hold the lock. */
+    bool remove_subscription(session& sess, const string& filter);
+    /** Removes a session and its subscriptions. Must hold the lock. */
+    void remove_session(session& sess);
+    /** Sends the packets in the outbox */
+    static void send_all(outbox& out);
+
+public:
+    /**
+     * Creates a broker and starts it listening on the loopback interface.
+     * @param port The TCP port, or zero to pick a free one.
+     * @throw exception if the port can't be opened.
+     */
+    explicit embedded_broker(uint16_t port = 0);
+    /**
+     * Stops the broker.
+     */
+    ~embedded_broker();
+    /**
+     * Gets the port the broker is listening on.
+     * @return The port the broker is listening on.
+     */
+    uint16_t port() const { return port_; }
+    /**
+     * Gets the URI for clients to connect to the broker.
+     * @return The URI for the broker, like "tcp://127.0.0.1:1883".
+     */
+    string uri() const;
+    /**
+     * Stops the broker, closing all the connections.
+     */
+    void stop();
+    /**
+     * Drops all the client connections, without a DISCONNECT, as if the
+     * network went down. The broker keeps running, so the clients can
+     * reconnect.
+     */
+    void disconnect_clients();
+    /**
+     * Gets the number of clients that are connected.
+     * @return The number of clients that are connected.
+     */
+    size_t num_clients();
+    /**
+     * Gets the number of sessions, including the persistent ones whose
+     * clients aren't connected.
+     * @return The number of sessions.
+     */
+    size_t num_sessions();
+    /**
+     * Gets the number of retained messages.
+     * @return The number of retained messages.
+     */
+    size_t num_retained();
+    /**
+     * Gets the counts of the broker's activity.
+     * @return The counts of the broker's activity.
+     */
+    stats get_stats();
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_embedded_broker_h
@@ -0,0 +1,471 @@
+// fault_proxy.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "fault_proxy.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+#include "mqtt/exception.h"
+
+#if !defined(MSG_NOSIGNAL)
+    #define MSG_NOSIGNAL 0
+#endif
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The most read at a time
+constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+// The most data held in one direction before the reader stops, like the
+// buffers of a real link. Without it, a bandwidth cap wouldn't push back
+// on the sender.
+constexpr size_t MAX_QUEUED = 256 * 1024;
+
+void set_sock_opts(int sock)
+{
+    int on = 1;
+    ::setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+#if defined(SO_NOSIGPIPE)
+    ::setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+bool write_full(int sock, const char* buf, size_t n)
+{
+    while (n > 0) {
+        auto ret = ::send(sock, buf, n, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+        buf += ret;
+        n -= size_t(ret);
+    }
+    return true;
+}
+
+}  // namespace
+
+// --------------------------------------------------------------------------
+
+struct fault_proxy::pipe
+{
+    struct chunk
+    {
+        clock::time_point when;
+        string data;
+    };
+
+    int src;
+    int dst;
+    // Whether this is the client-to-server direction
+    bool up;
+
+    // The scheduling state, under the proxy lock
+    clock::time_point txEnd;
+    clock::time_point lastSend;
+
+    // The data waiting to be sent, under the pipe lock
+    std::mutex lock;
+    std::condition_variable cv;
+    std::deque<chunk> que;
+    size_t nQueued{0};
+    bool eof{false};
+
+    pipe(int s, int d, bool u) : src{s}, dst{d}, up{u} {}
+};
+
+struct fault_proxy::connection
+{
+    int clientSock;
+    int serverSock;
+    pipe upPipe;
+    pipe downPipe;
+    std::thread thrs[4];
+    std::atomic<int> nRunning{4};
+    std::atomic<bool> dropped{false};
+
+    connection(int cli, int srv)
+        : clientSock{cli},
+          serverSock{srv},
+          upPipe{cli, srv, true},
+          downPipe{srv, cli, false} {}
+
+    ~connection() {
+        ::close(clientSock);
+        ::close(serverSock);
+    }
+
+    bool done() const { return nRunning == 0; }
+
+    // Closes both sides. With a reset, the sockets send RST when closed.
+    void drop(bool reset = false) {
+        if (reset) {
+            linger lin{1, 0};
+            ::setsockopt(clientSock, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+            ::setsockopt(serverSock, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+        }
+        dropped = true;
+        ::shutdown(clientSock, SHUT_RDWR);
+        ::shutdown(serverSock, SHUT_RDWR);
+
+        for (auto p : {&upPipe, &downPipe}) {
+            std::lock_guard<std::mutex> g(p->lock);
+            p->cv.notify_all();
+        }
+    }
+};
+
+// --------------------------------------------------------------------------
+
+fault_proxy::fault_proxy(const string& host, uint16_t serverPort)
+    : fault_proxy(host, serverPort, options{})
+{
+}
+
+fault_proxy::fault_proxy(
+    const string& host, uint16_t serverPort, const options& opts, uint16_t port /*=0*/
+)
+    : host_{host}, serverPort_{serverPort}, opts_{opts}, rng_{std::random_device{}()}
+{
+    listenSock_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSock_ < 0)
+        throw exception(MQTTASYNC_FAILURE, "Can't create the proxy socket");
+
+    int on = 1;
+    ::setsockopt(listenSock_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+
+    socklen_t len = sizeof(addr);
+    if (::bind(listenSock_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listenSock_, 64) < 0 ||
+        ::getsockname(listenSock_, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+        ::close(listenSock_);
+        throw exception(MQTTASYNC_FAILURE, "Can't listen on the proxy port");
+    }
+
+    port_ = ntohs(addr.sin_port);
+    running_ = true;
+    acceptThr_ = std::thread(&fault_proxy::accept_loop, this);
+}
+
+fault_proxy::~fault_proxy() { stop(); }
+
+string fault_proxy::uri() const { return "tcp://127.0.0.1:" + std::to_string(port_); }
+
+int fault_proxy::connect_server()
+{
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (::getaddrinfo(host_.c_str(), std::to_string(serverPort_).c_str(), &hints, &res) != 0)
+        return -1;
+
+    int sock = -1;
+    for (auto ai = res; ai; ai = ai->ai_next) {
+        sock = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (sock < 0)
+            continue;
+        if (::connect(sock, ai->ai_addr, ai->ai_addrlen) == 0)
+            break;
+        ::close(sock);
+        sock = -1;
+    }
+    ::freeaddrinfo(res);
+    return sock;
+}
+
+// Each connection gets a reader and a writer thread for each direction,
+// so that the data can be read as it arrives and sent when it's due.
+
+void fault_proxy::accept_loop()
+{
+    while (running_) {
+        pollfd pfd{listenSock_, POLLIN, 0};
+        int rc = ::poll(&pfd, 1, 100);
+
+        reap_connections(false);
+        if (rc <= 0 || !running_)
+            continue;
+
+        int cli = ::accept(listenSock_, nullptr, nullptr);
+        if (cli < 0)
+            continue;
+
+        int srv = connect_server();
+        if (srv < 0) {
+            ::close(cli);
+            continue;
+        }
+
+        set_sock_opts(cli);
+        set_sock_opts(srv);
+
+        auto conn = std::make_shared<connection>(cli, srv);
+        {
+            guard g(lock_);
+            conns_.push_back(conn);
+            ++stats_.connections;
+        }
+        auto& up = conn->upPipe;
+        auto& down = conn->downPipe;
+        conn->thrs[0] = std::thread(&fault_proxy::read_pipe, this, conn, std::ref(up));
+        conn->thrs[1] = std::thread(&fault_proxy::write_pipe, this, conn, std::ref(up));
+        conn->thrs[2] = std::thread(&fault_proxy::read_pipe, this, conn, std::ref(down));
+        conn->thrs[3] = std::thread(&fault_proxy::write_pipe, this, conn, std::ref(down));
+    }
+}
+
+void fault_proxy::reap_connections(bool all)
+{
+    std::vector<std::shared_ptr<connection>> done;
+    {
+        guard g(lock_);
+        for (auto p = conns_.begin(); p != conns_.end();) {
+            if (all || (*p)->done()) {
+                done.push_back(*p);
+                p = conns_.erase(p);
+            }
+            else {
+                ++p;
+            }
+        }
+    }
+    for (auto& conn : done) {
+        for (auto& thr : conn->thrs) {
+            if (thr.joinable())
+                thr.join();
+        }
+    }
+}
+
+// The data is sent when its last byte would have crossed a link of the
+// given bandwidth, plus the delay. It's never sent ahead of earlier data,
+// since a TCP stream stays in order, so a "lost" chunk holds up the ones
+// behind it.
+
+fault_proxy::clock::time_point fault_proxy::schedule(pipe& p, size_t n)
+{
+    guard g(lock_);
+    auto now = clock::now();
+
+    if (opts_.bandwidth) {
+        auto txTime = std::chrono::nanoseconds(uint64_t(n) * 1000000000 / opts_.bandwidth);
+        p.txEnd = std::max(now, p.txEnd) + txTime;
+    }
+    else {
+        p.txEnd = now;
+    }
+
+    auto delay = opts_.latency;
+    if (opts_.jitter.count() > 0) {
+        auto j = opts_.jitter.count();
+        delay += duration(std::uniform_int_distribution<decltype(j)>(-j, j)(rng_));
+        delay = std::max(delay, duration(0));
+    }
+    if (opts_.lossRate > 0.0 && std::uniform_real_distribution<>()(rng_) < opts_.lossRate) {
+        delay += opts_.lossPenalty;
+        ++stats_.losses;
+    }
+
+    p.lastSend = std::max(p.txEnd + delay, p.lastSend);
+    return p.lastSend;
+}
+
+void fault_proxy::read_pipe(std::shared_ptr<connection> conn, pipe& p)
+{
+    string buf(CHUNK_SIZE, '\0');
+
+    while (true) {
+        auto n = ::recv(p.src, &buf[0], buf.size(), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            // A close is passed along once the data is sent, but an error
+            // takes down the whole connection.
+            if (n < 0)
+                conn->drop();
+            break;
+        }
+
+        auto when = schedule(p, size_t(n));
+
+        std::unique_lock<std::mutex> lk(p.lock);
+        p.que.push_back(pipe::chunk{when, buf.substr(0, size_t(n))});
+        p.nQueued += size_t(n);
+        p.cv.notify_all();
+        p.cv.wait(lk, [&] { return p.nQueued < MAX_QUEUED || conn->dropped; });
+        if (conn->dropped)
+            break;
+    }
+
+    {
+        std::lock_guard<std::mutex> g(p.lock);
+        p.eof = true;
+        p.cv.notify_all();
+    }
+    --conn->nRunning;
+}
+
+void fault_proxy::write_pipe(std::shared_ptr<connection> conn, pipe& p)
+{
+    std::unique_lock<std::mutex> lk(p.lock);
+
+    while (!conn->dropped) {
+        if (p.que.empty()) {
+            if (p.eof) {
+                ::shutdown(p.dst, SHUT_WR);
+                break;
+            }
+            p.cv.wait(lk);
+            continue;
+        }
+
+        auto when = std::max(p.que.front().when, stall_until());
+        if (clock::now() < when) {
+            p.cv.wait_until(lk, when);
+            continue;
+        }
+
+        auto data = std::move(p.que.front().data);
+        p.que.pop_front();
+        p.nQueued -= data.size();
+        p.cv.notify_all();
+
+        lk.unlock();
+        bool ok = write_full(p.dst, data.data(), data.size());
+        if (ok) {
+            guard g(lock_);
+            (p.up ? stats_.bytesUp : stats_.bytesDown) += data.size();
+        }
+        else {
+            conn->drop();
+        }
+        lk.lock();
+    }
+
+    --conn->nRunning;
+}
+
+// --------------------------------------------------------------------------
+
+fault_proxy::options fault_proxy::get_options() const
+{
+    guard g(lock_);
+    return opts_;
+}
+
+void fault_proxy::set_options(const options& opts)
+{
+    guard g(lock_);
+    opts_ = opts;
+}
+
+// The writers check the stall time whenever they wake for their next
+// chunk, so they don't need to be woken here.
+
+void fault_proxy::stall(duration d)
+{
+    guard g(lock_);
+    stallUntil_ = std::max(stallUntil_, clock::now() + d);
+}
+
+fault_proxy::clock::time_point fault_proxy::stall_until() const
+{
+    guard g(lock_);
+    return stallUntil_;
+}
+
+// The writers take the proxy lock while holding a pipe lock, so the
+// connections are dropped outside of the proxy lock.
+
+void fault_proxy::reset_connections()
+{
+    std::vector<std::shared_ptr<connection>> conns;
+    {
+        guard g(lock_);
+        for (auto& conn : conns_) {
+            if (!conn->dropped) {
+                conns.push_back(conn);
+                ++stats_.resets;
+            }
+        }
+    }
+    for (auto& conn : conns) conn->drop(true);
+}
+
+void fault_proxy::stop()
+{
+    if (!running_.exchange(false))
+        return;
+
+    if (acceptThr_.joinable())
+        acceptThr_.join();
+
+    ::close(listenSock_);
+    listenSock_ = -1;
+
+    std::list<std::shared_ptr<connection>> conns;
+    {
+        guard g(lock_);
+        conns = conns_;
+    }
+    for (auto& conn : conns) conn->drop();
+    reap_connections(true);
+}
+
+size_t fault_proxy::num_connections() const
+{
+    guard g(lock_);
+    size_t n = 0;
+    for (const auto& conn : conns_) {
+        if (!conn->dropped && !conn->done())
+            ++n;
+    }
+    return n;
+}
+
+fault_proxy::stats fault_proxy::get_stats() const
+{
+    guard g(lock_);
+    return stats_;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
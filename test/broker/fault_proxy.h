@@ -0,0 +1,235 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file fault_proxy.h
+/// Declaration of MQTT fault_proxy class
+/// @date October 18, 2026
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_fault_proxy_h
+#define __mqtt_fault_proxy_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A TCP proxy that makes a link look like a slow or unreliable network.
+ *
+ * The proxy sits between a client and a broker, forwarding the bytes in
+ * each direction after a delay. It can add latency and jitter, cap the
+ * bandwidth, stall the traffic for a while, and reset the connections, so
+ * that client settings like the inflight window, persistence, and
+ * reconnect can be measured under the conditions of a real link.
+ *
+ * TCP doesn't lose data, so packet loss is modelled the way the
+ * application sees it: a lost segment holds up the stream until it's
+ * retransmitted, so a chunk of data is held back for an extra penalty
+ * time, and everything behind it waits.
+ *
+ * The delays are applied in each direction, so the round-trip time is
+ * twice the latency.
+ *
+ * @code
+ * mqtt::fault_proxy::options opts;
+ * opts.latency = 150ms;
+ * opts.lossRate = 0.02;
+ * mqtt::fault_proxy proxy("localhost", 1883, opts);
+ * mqtt::async_client cli(proxy.uri(), "test-client");
+ * @endcode
+ */
+class fault_proxy
+{
+public:
+    /** The clock used for the delays */
+    using clock = std::chrono::steady_clock;
+    /** The type used for the delays */
+    using duration = std::chrono::milliseconds;
+
+    /** The faults to inject into the link */
+    struct options
+    {
+        /** The one-way delay added to the data */
+        duration latency{0};
+        /** The most that the delay varies, up or down */
+        duration jitter{0};
+        /** The bandwidth in bytes per second, in each direction. Zero is unlimited */
+        size_t bandwidth{0};
+        /** The chance, 0 to 1, that a chunk of data is "lost" */
+        double lossRate{0.0};
+        /** The extra delay for a lost chunk, as for a retransmit */
+        duration lossPenalty{200};
+    };
+
+    /** Counts of the proxy's activity */
+    struct stats
+    {
+        /** The number of connections accepted */
+        uint64_t connections{0};
+        /** The bytes forwarded from the clients to the server */
+        uint64_t bytesUp{0};
+        /** The bytes forwarded from the server to the clients */
+        uint64_t bytesDown{0};
+        /** The number of chunks that were delayed as lost */
+        uint64_t losses{0};
+        /** The number of connections reset by the proxy */
+        uint64_t resets{0};
+    };
+
+private:
+    /** One direction of a connection */
+    struct pipe;
+    /** A client connection and its server connection */
+    struct connection;
+
+    /** Lock guard type for this class */
+    using guard = std::lock_guard<std::mutex>;
+
+    /** Object monitor mutex */
+    mutable std::mutex lock_;
+    /** The server host */
+    string host_;
+    /** The server port */
+    uint16_t serverPort_;
+    /** The listening socket */
+    int listenSock_{-1};
+    /** The port we're listening on */
+    uint16_t port_{0};
+    /** Whether the proxy is running */
+    std::atomic<bool> running_{false};
+    /** The faults to inject */
+    options opts_;
+    /** The random numbers for jitter and loss */
+    std::mt19937 rng_;
+    /** Traffic is held until this time */
+    clock::time_point stallUntil_;
+    /** The live connections */
+    std::list<std::shared_ptr<connection>> conns_;
+    /** Activity counts */
+    stats stats_;
+    /** The thread accepting connections */
+    std::thread acceptThr_;
+
+    /** Non-copyable */
+    fault_proxy(const fault_proxy&) = delete;
+    fault_proxy& operator=(const fault_proxy&) = delete;
+
+    /** The accept thread function */
+    void accept_loop();
+    /** Joins the threads of the connections that have closed */
+    void reap_connections(bool all);
+    /** Opens a connection to the server, returning the socket or -1 */
+    int connect_server();
+    /** Reads from one side of a connection, scheduling the data */
+    void read_pipe(std::shared_ptr<connection> conn, pipe& p);
+    /** Writes the scheduled data to the other side of a connection */
+    void write_pipe(std::shared_ptr<connection> conn, pipe& p);
+    /** Gets the time when a chunk of data read now should be sent. */
+    clock::time_point schedule(pipe& p, size_t n);
+    /** Gets the time until which traffic is stalled */
+    clock::time_point stall_until() const;
+
+public:
+    /**
+     * Creates a proxy to a server that doesn't inject any faults, and
+     * starts it listening on a free port on the loopback interface.
+     * @param host The server host name or address.
+     * @param serverPort The server port.
+     * @throw exception if the port can't be opened.
+     */
+    fault_proxy(const string& host, uint16_t serverPort);
+    /**
+     * Creates a proxy to a server and starts it listening on the loopback
+     * interface.
+     * @param host The server host name or address.
+     * @param serverPort The server port.
+     * @param opts The faults to inject.
+     * @param port The port to listen on, or zero to pick a free one.
+     * @throw exception if the port can't be opened.
+     */
+    fault_proxy(
+        const string& host, uint16_t serverPort, const options& opts, uint16_t port = 0
+    );
+    /**
+     * Stops the proxy.
+     */
+    ~fault_proxy();
+    /**
+     * Gets the port the proxy is listening on.
+     * @return The port the proxy is listening on.
+     */
+    uint16_t port() const { return port_; }
+    /**
+     * Gets the URI for clients to connect through the proxy.
+     * @return The URI for the proxy, like "tcp://127.0.0.1:1883".
+     */
+    string uri() const;
+    /**
+     * Gets the faults being injected.
+     * @return The faults being injected.
+     */
+    options get_options() const;
+    /**
+     * Changes the faults to inject. This applies to data read from now on,
+     * on the existing connections and new ones.
+     * @param opts The faults to inject.
+     */
+    void set_options(const options& opts);
+    /**
+     * Holds all the traffic for a time, in both directions, as if the link
+     * went dead without closing. Data keeps being read and is sent when
+     * the stall ends.
+     * @param d How long to stall.
+     */
+    void stall(duration d);
+    /**
+     * Resets all the connections, as if the link dropped. The proxy keeps
+     * running, so the clients can reconnect.
+     */
+    void reset_connections();
+    /**
+     * Stops the proxy, closing all the connections.
+     */
+    void stop();
+    /**
+     * Gets the number of open connections.
+     * @return The number of open connections.
+     */
+    size_t num_connections() const;
+    /**
+     * Gets the counts of the proxy's activity.
+     * @return The counts of the proxy's activity.
+     */
+    stats get_stats() const;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_fault_proxy_h
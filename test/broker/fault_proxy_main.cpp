@@ -0,0 +1,155 @@
+// fault_proxy_main.cpp
+//
+// A command-line TCP proxy that makes the link to a broker look like a
+// slow or unreliable network, for trying out client settings and running
+// the benchmarks under degraded conditions.
+//
+// Point a client at the proxy's port instead of the broker. The faults are
+// set on the command line, and can be changed while it runs by typing
+// commands on the console:
+//
+//  latency <ms>       Set the one-way delay
+//  jitter <ms>        Set the variation in the delay
+//  rate <bytes/s>     Set the bandwidth cap (0 for none)
+//  loss <percent>     Set the chance of a "lost" chunk of data
+//  stall <ms>         Hold all the traffic for a while
+//  reset              Reset all the connections
+//  stats              Print the traffic counts
+//  quit               Exit
+//
+// USAGE:
+//     fault_proxy <host:port> [listen port] [latency ms] [jitter ms]
+//                 [bytes/s] [loss %]
+//
+// To look like a cellular link with a 300ms round trip and 2% loss:
+//     fault_proxy localhost:1883 18830 150 20 0 2
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "fault_proxy.h"
+#include "mqtt/exception.h"
+
+using namespace std;
+using fault_proxy = mqtt::fault_proxy;
+using ms = fault_proxy::duration;
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void print_options(const fault_proxy::options& opts)
+{
+    cout << "  latency: " << opts.latency.count() << "ms, jitter: " << opts.jitter.count()
+         << "ms, rate: ";
+    if (opts.bandwidth)
+        cout << opts.bandwidth << " B/s";
+    else
+        cout << "unlimited";
+    cout << ", loss: " << (opts.lossRate * 100.0) << "%" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        cerr << "USAGE: fault_proxy <host:port> [listen port] [latency ms] "
+                "[jitter ms] [bytes/s] [loss %]"
+             << endl;
+        return 1;
+    }
+
+    string target{argv[1]};
+    auto pos = target.rfind(':');
+    if (pos == string::npos) {
+        cerr << "The server must be given as host:port" << endl;
+        return 1;
+    }
+    string host = target.substr(0, pos);
+    auto serverPort = uint16_t(atoi(target.c_str() + pos + 1));
+
+    auto port = uint16_t((argc > 2) ? atoi(argv[2]) : 0);
+
+    fault_proxy::options opts;
+    if (argc > 3)
+        opts.latency = ms(atoi(argv[3]));
+    if (argc > 4)
+        opts.jitter = ms(atoi(argv[4]));
+    if (argc > 5)
+        opts.bandwidth = size_t(atol(argv[5]));
+    if (argc > 6)
+        opts.lossRate = atof(argv[6]) / 100.0;
+
+    try {
+        fault_proxy proxy(host, serverPort, opts, port);
+
+        cout << "Proxying " << proxy.uri() << " to " << target << endl;
+        print_options(opts);
+
+        string line;
+        while (getline(cin, line)) {
+            istringstream is(line);
+            string cmd;
+            double val = 0.0;
+            is >> cmd >> val;
+
+            if (cmd.empty())
+                continue;
+            if (cmd == "quit" || cmd == "exit")
+                break;
+
+            if (cmd == "stall") {
+                proxy.stall(ms(long(val)));
+            }
+            else if (cmd == "reset") {
+                proxy.reset_connections();
+            }
+            else if (cmd == "stats") {
+                auto st = proxy.get_stats();
+                cout << "  connections: " << proxy.num_connections() << " open, "
+                     << st.connections << " total, " << st.resets << " reset\n"
+                     << "  bytes up: " << st.bytesUp << ", down: " << st.bytesDown
+                     << ", losses: " << st.losses << endl;
+            }
+            else {
+                opts = proxy.get_options();
+                if (cmd == "latency")
+                    opts.latency = ms(long(val));
+                else if (cmd == "jitter")
+                    opts.jitter = ms(long(val));
+                else if (cmd == "rate")
+                    opts.bandwidth = size_t(val);
+                else if (cmd == "loss")
+                    opts.lossRate = val / 100.0;
+                else {
+                    cerr << "Unknown command: " << cmd << endl;
+                    continue;
+                }
+                proxy.set_options(opts);
+                print_options(opts);
+            }
+        }
+    }
+    catch (const mqtt::exception& exc) {
+        cerr << exc.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
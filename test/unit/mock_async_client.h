@@ -59,6 +59,8 @@ public:
         token::on_failure5(tok, rsp);
     }
 
+    static bool expire(mqtt::token* tok) { return tok->on_timeout(); }
+
     // iface
 
     mqtt::token_ptr connect() override { return mqtt::token_ptr{}; }
@@ -22,24 +22,31 @@
  *******************************************************************************/
 #define UNIT_TESTS
 
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
 #include "catch2_version.h"
 #include "mock_action_listener.h"
 #include "mock_callback.h"
 #include "mock_persistence.h"
 #include "mqtt/async_client.h"
 #include "mqtt/iasync_client.h"
+#include "test_util.h"
 
 using namespace mqtt;
+using mqtt::test::server_uri;
 
 /////////////////////////////////////////////////////////////////////////////
 
-// NOTE: This test case requires network access. It uses one of
-//  	 the public available MQTT brokers
+// NOTE: The tests that connect use the broker from server_uri(), which
+//  	 is the embedded test broker when it's built.
+static const std::string GOOD_SERVER_URI{"tcp://localhost:1883"};
 #if defined(TEST_EXTERNAL_SERVER)
-static const std::string GOOD_SERVER_URI{"tcp://mqtt.eclipseprojects.io:1883"};
 static const std::string GOOD_SSL_SERVER_URI{"ssl://mqtt.eclipseprojects.io:1885"};
 #else
-static const std::string GOOD_SERVER_URI{"tcp://localhost:1883"};
 static const std::string GOOD_SSL_SERVER_URI{"ssl://localhost:18885"};
 #endif
 
@@ -126,7 +133,7 @@ TEST_CASE("async_client user constructor 3 args", "[client]")
 
 TEST_CASE("async_client connect 0 arg", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     try {
@@ -142,7 +149,7 @@ TEST_CASE("async_client connect 0 arg", "[client]")
 
 TEST_CASE("async_client connect 1 arg", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     connect_options co;
@@ -154,7 +161,7 @@ TEST_CASE("async_client connect 1 arg", "[client]")
 
 TEST_CASE("async_client connect 1 arg failure", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok;  //{ nullptr };
@@ -177,7 +184,7 @@ TEST_CASE("async_client connect 1 arg failure", "[client]")
 
 TEST_CASE("async_client connect 2 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     mock_action_listener listener;
@@ -191,7 +198,7 @@ TEST_CASE("async_client connect 2 args", "[client]")
 
 TEST_CASE("async_client connect 3 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     connect_options co;
@@ -206,7 +213,7 @@ TEST_CASE("async_client connect 3 args", "[client]")
 
 TEST_CASE("async_client connect 3 args failure", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok;  //{ nullptr };
@@ -262,7 +269,7 @@ TEST_CASE("async_client connect uninitialized ssl", "[client]")
 
 TEST_CASE("async_client disconnect 0 arg", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok{cli.connect()};
@@ -278,7 +285,7 @@ TEST_CASE("async_client disconnect 0 arg", "[client]")
 
 TEST_CASE("async_client disconnect 1 arg", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok{cli.connect()};
@@ -312,7 +319,7 @@ TEST_CASE("async_client disconnect 1 arg failure", "[client]")
 
 TEST_CASE("async_client disconnect 2 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok{cli.connect()};
@@ -330,7 +337,7 @@ TEST_CASE("async_client disconnect 2 args", "[client]")
 
 TEST_CASE("async_client disconnect 3 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok{cli.connect()};
@@ -371,7 +378,7 @@ TEST_CASE("async_client disconnect 3 args failure", "[client]")
 
 TEST_CASE("async_client get pending delivery token", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     REQUIRE(0 == GOOD_QOS_COLL[0]);
@@ -437,7 +444,7 @@ TEST_CASE("async_client get pending delivery token", "[client]")
 
 TEST_CASE("async_client get pending delivery tokens", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     REQUIRE(0 == GOOD_QOS_COLL[0]);
@@ -487,7 +494,7 @@ TEST_CASE("async_client get pending delivery tokens", "[client]")
 
 TEST_CASE("async_client publish 2 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok{cli.connect()};
@@ -526,7 +533,7 @@ TEST_CASE("async_client publish 2 args failure", "[client]")
 
 TEST_CASE("async_client publish 4 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok{cli.connect()};
@@ -568,7 +575,7 @@ TEST_CASE("async_client publish 4 args failure", "[client]")
 
 TEST_CASE("async_client publish 5 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok{cli.connect()};
@@ -592,7 +599,7 @@ TEST_CASE("async_client publish 5 args", "[client]")
 
 TEST_CASE("async_client publish 7 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok{cli.connect()};
@@ -637,7 +644,7 @@ TEST_CASE("async_client set callback", "[client]")
 
 TEST_CASE("async_client subscribe single topic 2 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok{cli.connect()};
@@ -674,7 +681,7 @@ TEST_CASE("async_client subscribe single topic 2 args failure", "[client]")
 
 TEST_CASE("async_client subscribe single topic 4 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok{cli.connect()};
@@ -714,7 +721,7 @@ TEST_CASE("async_client subscribe single topic 4 args failure", "[client]")
 
 TEST_CASE("async_client subscribe many topics 2 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     cli.connect()->wait();
     REQUIRE(cli.is_connected());
 
@@ -734,7 +741,7 @@ TEST_CASE("async_client subscribe many topics 2 args", "[client]")
 // There was an odd failure when subscribe_many was given a single topic.
 TEST_CASE("async_client subscribe many topics 2 args_single", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     cli.connect()->wait();
     REQUIRE(cli.is_connected());
 
@@ -783,7 +790,7 @@ TEST_CASE("async_client subscribe many topics 2 args failure", "[client]")
 
 TEST_CASE("async_client subscribe many topics 4 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok{cli.connect()};
@@ -835,7 +842,7 @@ TEST_CASE("async_client subscribe many topics 4 args failure", "[client]")
 
 TEST_CASE("async_client unsubscribe single topic 1 arg", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok = cli.connect();
@@ -876,7 +883,7 @@ TEST_CASE("async_client unsubscribe single topic 1 arg failure", "[client]")
 
 TEST_CASE("async_client unsubscribe single topic 3 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok = cli.connect();
@@ -920,7 +927,7 @@ TEST_CASE("async_client unsubscribe single topic 3 args failure", "[client]")
 
 TEST_CASE("async_client unsubscribe many topics 1 arg", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok = cli.connect();
@@ -961,7 +968,7 @@ TEST_CASE("async_client unsubscribe many topics 1 arg_failure", "[client]")
 
 TEST_CASE("async_client unsubscribe many topics 3 args", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     token_ptr conn_tok = cli.connect();
@@ -1003,6 +1010,41 @@ TEST_CASE("async_client unsubscribe many topics 3 args failure", "[client]")
     REQUIRE(MQTTASYNC_DISCONNECTED == return_code);
 }
 
+//----------------------------------------------------------------------
+// Test async_client::sync_subscriptions()
+//----------------------------------------------------------------------
+
+TEST_CASE("async_client sync subscriptions nothing to do", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    REQUIRE(cli.get_subscriptions().empty());
+
+    token_ptr tok{cli.sync_subscriptions(subscription_set{})};
+    REQUIRE(tok);
+    REQUIRE(tok->is_complete());
+    REQUIRE(tok->try_wait());
+}
+
+TEST_CASE("async_client sync subscriptions failure", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    REQUIRE(!cli.is_connected());
+
+    subscription_set desired{*TOPIC_COLL, GOOD_QOS};
+
+    int return_code = MQTTASYNC_SUCCESS;
+    try {
+        token_ptr tok{cli.sync_subscriptions(desired)};
+        REQUIRE(tok);
+        tok->wait_for(TIMEOUT);
+    }
+    catch (mqtt::exception& ex) {
+        return_code = ex.get_return_code();
+    }
+    REQUIRE(MQTTASYNC_DISCONNECTED == return_code);
+    REQUIRE(cli.get_subscriptions().empty());
+}
+
 TEST_CASE("async_client consumer timeout", "[client]")
 {
     // This just compiling shows #343 fixed.
@@ -1013,7 +1055,7 @@ TEST_CASE("async_client consumer timeout", "[client]")
 
 TEST_CASE("async_client consumer queue size", "[client]")
 {
-    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    async_client cli{server_uri(), CLIENT_ID};
     cli.start_consuming();
     REQUIRE(0 == cli.consumer_queue_size());
 
@@ -1030,3 +1072,347 @@ TEST_CASE("async_client consumer queue size", "[client]")
     cli.stop_consuming();
     cli.disconnect()->wait();
 }
+
+TEST_CASE("async_client publish policy", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    REQUIRE(!cli.get_publish_policy());
+
+    // Overloaded by latency, with nothing in flight.
+    auto policy = publish_policy::create();
+    policy->max_latency(std::chrono::milliseconds(1)).shed("low/#");
+    policy->on_delivered(std::chrono::seconds(1));
+
+    cli.set_publish_policy(policy);
+    REQUIRE(policy == cli.get_publish_policy());
+
+    // A shed message completes locally, without reaching the library.
+    mock_action_listener listener;
+    auto tok = cli.publish(message::create("low/data", PAYLOAD), &CONTEXT, listener);
+    REQUIRE(tok->is_complete());
+    REQUIRE(listener.failed());
+    REQUIRE(publish_policy::DROPPED == tok->get_return_code());
+    REQUIRE(cli.get_pending_delivery_tokens().empty());
+
+    // Critical topics go through as usual, and fail while disconnected.
+    REQUIRE_THROWS_AS(cli.publish(message::create(TOPIC, PAYLOAD)), mqtt::exception);
+
+    auto m = policy->get_metrics();
+    REQUIRE(1 == m.shed);
+    REQUIRE(1 == m.published);
+}
+
+TEST_CASE("async_client publish policy downgrade", "[client]")
+{
+    using namespace std::chrono;
+
+    auto policy = publish_policy::create();
+    policy->max_latency(milliseconds(1)).downgrade("low/#");
+    policy->on_delivered(seconds(1));
+    auto latency = policy->get_latency();
+
+    delivery_token_ptr lowTok, critTok;
+    {
+        auto createOpts = create_options_builder()
+                              .send_while_disconnected(true, true)
+                              .max_buffered_messages(10)
+                              .finalize();
+        async_client cli{GOOD_SERVER_URI, CLIENT_ID, createOpts};
+        cli.set_publish_policy(policy);
+
+        lowTok = cli.publish(message::create("low/data", PAYLOAD, 1, false));
+        REQUIRE(0 == lowTok->get_message()->get_qos());
+    }
+
+    // Destroying the client completes the downgraded send, which doesn't
+    // count toward the latency.
+    REQUIRE(lowTok->is_complete());
+    REQUIRE(latency == policy->get_latency());
+
+    {
+        auto createOpts = create_options_builder()
+                              .send_while_disconnected(true, true)
+                              .max_buffered_messages(10)
+                              .finalize();
+        async_client cli{GOOD_SERVER_URI, CLIENT_ID, createOpts};
+        cli.set_publish_policy(policy);
+
+        critTok = cli.publish(message::create(TOPIC, PAYLOAD, 1, false));
+        REQUIRE(1 == critTok->get_message()->get_qos());
+    }
+
+    // But a QoS 1 send does
+    REQUIRE(critTok->is_complete());
+    REQUIRE(latency > policy->get_latency());
+}
+
+TEST_CASE("async_client publish template failure", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    REQUIRE(!cli.is_connected());
+
+    publish_template tmpl{TOPIC, 1, false};
+
+    int return_code = MQTTASYNC_SUCCESS;
+    try {
+        cli.publish(tmpl, PAYLOAD.data(), PAYLOAD.size());
+    }
+    catch (mqtt::exception& ex) {
+        return_code = ex.get_return_code();
+    }
+    REQUIRE(MQTTASYNC_DISCONNECTED == return_code);
+    REQUIRE(cli.get_pending_delivery_tokens().empty());
+}
+
+TEST_CASE("async_client publish template delivery complete", "[client]")
+{
+    async_client cli{server_uri(), CLIENT_ID};
+    mock_callback cb;
+    cli.set_callback(cb);
+
+    token_ptr conn_tok{cli.connect()};
+    REQUIRE(conn_tok);
+    conn_tok->wait();
+    REQUIRE(cli.is_connected());
+
+    publish_template tmpl{TOPIC, 1, false};
+
+    delivery_token_ptr tok{cli.publish(tmpl, PAYLOAD.data(), PAYLOAD.size())};
+    REQUIRE(tok);
+    REQUIRE(tok->get_message());
+    REQUIRE(PAYLOAD == tok->get_message()->get_payload_str());
+    tok->wait_for(TIMEOUT);
+
+    REQUIRE(mqtt::test::wait_for([&cb] { return cb.delivery_complete(); }));
+
+    cli.disconnect()->wait();
+}
+
+TEST_CASE("async_client concurrent publish failure", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    REQUIRE(!cli.is_connected());
+    REQUIRE(0 == cli.connection_epoch());
+
+    const int N_THREADS = 4, N_MSG = 100;
+    std::atomic<int> nFailed{0};
+
+    std::vector<std::thread> thrs;
+    for (int i = 0; i < N_THREADS; ++i) {
+        thrs.emplace_back([&] {
+            for (int j = 0; j < N_MSG; ++j) {
+                try {
+                    cli.publish(message::create(TOPIC, PAYLOAD, 1, false));
+                }
+                catch (const mqtt::exception& ex) {
+                    if (ex.get_return_code() == MQTTASYNC_DISCONNECTED)
+                        ++nFailed;
+                }
+                cli.get_connect_options();
+            }
+        });
+    }
+    for (auto& thr : thrs) thr.join();
+
+    REQUIRE(N_THREADS * N_MSG == nFailed);
+    REQUIRE(cli.get_pending_delivery_tokens().empty());
+    REQUIRE(!cli.is_connected());
+}
+
+// Hands a message to the client the way the C library does, in buffers
+// that the client frees.
+static void deliver(async_client& cli, const std::string& topic, const std::string& payload)
+{
+    MQTTAsync_message init = MQTTAsync_message_initializer;
+    auto cmsg = static_cast<MQTTAsync_message*>(MQTTAsync_malloc(sizeof(MQTTAsync_message)));
+    *cmsg = init;
+    cmsg->payload = MQTTAsync_malloc(payload.size() + 1);
+    std::memcpy(cmsg->payload, payload.data(), payload.size());
+    cmsg->payloadlen = int(payload.size());
+
+    auto ctopic = static_cast<char*>(MQTTAsync_malloc(topic.size() + 1));
+    std::memcpy(ctopic, topic.c_str(), topic.size() + 1);
+
+    cli.message_arrived(ctopic, 0, cmsg);
+}
+
+TEST_CASE("async_client message filter", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    REQUIRE(0 == cli.num_filtered_messages());
+
+    std::vector<std::string> handled;
+    cli.set_message_callback([&handled](const_message_ptr msg) {
+        handled.push_back(msg->to_string());
+    });
+    cli.start_consuming();
+
+    cli.set_message_filter([](const message_view& msg) {
+        if (msg.get_topic() == "throw")
+            throw std::runtime_error("filter error");
+        return msg.get_payload().find("\"keep\":true") != std::string_view::npos;
+    });
+
+    deliver(cli, "a", "{\"keep\":true,\"n\":1}");
+    deliver(cli, "a", "{\"keep\":false,\"n\":2}");
+    deliver(cli, "b", "{\"n\":3}");
+    deliver(cli, "b", "{\"keep\":true,\"n\":4}");
+    deliver(cli, "c", "");
+
+    // A filter that throws keeps the message
+    deliver(cli, "throw", "5");
+
+    const std::vector<std::string> kept{
+        "{\"keep\":true,\"n\":1}", "{\"keep\":true,\"n\":4}", "5"
+    };
+
+    REQUIRE(3 == cli.num_filtered_messages());
+    REQUIRE(kept == handled);
+
+    REQUIRE(kept.size() == cli.consumer_queue_size());
+    for (const auto& payload : kept) {
+        const_message_ptr msg;
+        REQUIRE(cli.try_consume_message(&msg));
+        REQUIRE(payload == msg->to_string());
+    }
+
+    // Without the filter, everything comes through
+    cli.set_message_filter(nullptr);
+    deliver(cli, "a", "{\"keep\":false}");
+    REQUIRE(3 == cli.num_filtered_messages());
+    REQUIRE(4 == handled.size());
+    REQUIRE(1 == cli.consumer_queue_size());
+
+    cli.stop_consuming();
+}
+
+TEST_CASE("async_client consumer spin", "[client]")
+{
+    using namespace std::chrono_literals;
+
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    REQUIRE(0ns == cli.get_consumer_spin());
+
+    cli.set_consumer_spin(50us);
+    REQUIRE(50us == cli.get_consumer_spin());
+
+    cli.start_consuming();
+    auto thr = std::thread([&cli] {
+        std::this_thread::sleep_for(10ms);
+        cli.stop_consuming();
+    });
+
+    // Spins, blocks, then wakes up when the consumer is stopped
+    auto evt = cli.consume_event();
+    thr.join();
+    REQUIRE(evt.is_any_disconnect());
+    REQUIRE(!evt.is_message());
+
+    cli.set_consumer_spin(0s);
+    REQUIRE(0ns == cli.get_consumer_spin());
+}
+
+TEST_CASE("async_client publish interceptor", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    std::vector<std::string> taken;
+    cli.set_publish_interceptor([&taken](const message& msg) {
+        if (msg.get_topic() != "sample")
+            return false;
+        taken.push_back(msg.to_string());
+        return true;
+    });
+
+    // An intercepted message isn't sent, so it succeeds while disconnected
+    auto tok = cli.publish("sample", "42");
+    REQUIRE(tok->is_complete());
+    REQUIRE(MQTTASYNC_SUCCESS == tok->get_return_code());
+    REQUIRE(std::vector<std::string>{"42"} == taken);
+
+    // Anything else goes to the C library
+    try {
+        cli.publish("other", "1");
+        FAIL("Publish should fail while disconnected");
+    }
+    catch (const mqtt::exception& ex) {
+        REQUIRE(MQTTASYNC_DISCONNECTED == ex.get_return_code());
+    }
+
+    cli.set_publish_interceptor(nullptr);
+    REQUIRE_THROWS_AS(cli.publish("sample", "1"), mqtt::exception);
+    REQUIRE(1 == taken.size());
+}
+
+TEST_CASE("async_client publish deadline", "[client]")
+{
+    using namespace std::chrono;
+
+    delivery_token_ptr tok;
+
+    // With offline buffering, the publish is accepted but never answered,
+    // so only the deadline can complete the token.
+    auto createOpts = create_options_builder()
+                          .send_while_disconnected(true, true)
+                          .max_buffered_messages(10)
+                          .finalize();
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID, createOpts};
+
+    auto msg = make_message(TOPIC, PAYLOAD, 1, false);
+    auto start = steady_clock::now();
+    tok = cli.publish(msg, start + milliseconds(100));
+    REQUIRE(!tok->is_complete());
+
+    REQUIRE_THROWS_AS(tok->wait_for(seconds(5)), mqtt::exception);
+    REQUIRE(steady_clock::now() - start >= milliseconds(100));
+    REQUIRE(tok->is_timed_out());
+    REQUIRE(MQTTASYNC_FAILURE == tok->get_return_code());
+
+    // The C library keeps the buffered request after the connection is
+    // lost, so the client has to keep holding the expired token.
+    REQUIRE(1 == cli.num_expired_tokens());
+    cli.connection_lost("test");
+    REQUIRE(1 == cli.num_expired_tokens());
+}
+
+TEST_CASE("async_client publish payload deadline", "[client]")
+{
+    using namespace std::chrono;
+
+    auto createOpts = create_options_builder()
+                          .send_while_disconnected(true, true)
+                          .max_buffered_messages(10)
+                          .finalize();
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID, createOpts};
+
+    auto tok = cli.publish(TOPIC, PAYLOAD.data(), PAYLOAD.size(), 1, false, milliseconds(50));
+    REQUIRE(!tok->is_complete());
+
+    REQUIRE_THROWS_AS(tok->wait_for(seconds(5)), mqtt::exception);
+    REQUIRE(tok->is_timed_out());
+    REQUIRE(PAYLOAD == tok->get_message()->get_payload_str());
+}
+
+TEST_CASE("async_client destroyed with a deadline pending", "[client]")
+{
+    using namespace std::chrono;
+
+    delivery_token_ptr tok;
+    {
+        auto createOpts = create_options_builder()
+                              .send_while_disconnected(true, true)
+                              .max_buffered_messages(10)
+                              .finalize();
+        async_client cli{GOOD_SERVER_URI, CLIENT_ID, createOpts};
+
+        auto msg = make_message(TOPIC, PAYLOAD, 1, false);
+        tok = cli.publish(msg, steady_clock::now() + seconds(30));
+        REQUIRE(!tok->is_complete());
+    }
+
+    // Destroying the client fails the buffered request, which has to
+    // cancel its deadline while the timer is still running.
+    REQUIRE(tok->is_complete());
+    REQUIRE(!tok->is_timed_out());
+    REQUIRE(MQTTASYNC_SUCCESS != tok->get_return_code());
+}
@@ -21,7 +21,9 @@
 
 #define UNIT_TESTS
 
+#include <cstdlib>
 #include <cstring>
+#include <vector>
 
 #include "catch2_version.h"
 #include "mqtt/buffer_ref.h"
@@ -258,3 +260,95 @@ TEST_CASE("reset", "[collections]")
     REQUIRE_FALSE(sr);
     REQUIRE(sr.empty());
 }
+
+// ----------------------------------------------------------------------
+// Test adopting external memory
+// ----------------------------------------------------------------------
+
+TEST_CASE("adopt_deleter", "[collections]")
+{
+    char* buf = static_cast<char*>(std::malloc(STR.size()));
+    std::memcpy(buf, STR.data(), STR.size());
+
+    int nDeleted = 0;
+    {
+        binary_ref br = binary_ref::adopt(buf, STR.size(), [&nDeleted](const char* p) {
+            std::free(const_cast<char*>(p));
+            ++nDeleted;
+        });
+
+        REQUIRE(br);
+        REQUIRE(br.is_external());
+        REQUIRE(buf == br.data());
+        REQUIRE(STR.size() == br.size());
+        REQUIRE(STR[1] == br[1]);
+
+        binary_ref br2{br};
+        br.reset();
+        REQUIRE_FALSE(br);
+        REQUIRE(0 == nDeleted);
+
+        // A string copy is made on demand
+        REQUIRE(STR == br2.str());
+        REQUIRE(buf == br2.data());
+    }
+    REQUIRE(1 == nDeleted);
+}
+
+TEST_CASE("adopt_shared_owner", "[collections]")
+{
+    auto owner = std::make_shared<std::vector<char>>(STR.begin(), STR.end());
+    {
+        binary_ref br = binary_ref::adopt(owner, owner->data() + 5, 6);
+
+        REQUIRE(br.is_external());
+        REQUIRE(2 == owner.use_count());
+        REQUIRE(6 == br.size());
+        REQUIRE("random" == br.str());
+    }
+    REQUIRE(1 == owner.use_count());
+}
+
+TEST_CASE("adopt_reassign", "[collections]")
+{
+    binary_ref br = binary_ref::adopt(STR.data(), STR.size(), [](const char*) {});
+    REQUIRE(br.is_external());
+
+    br = BIN;
+    REQUIRE_FALSE(br.is_external());
+    REQUIRE(BIN == br.str());
+
+    binary_ref empty = binary_ref::adopt(STR.data(), 0, [](const char*) {});
+    REQUIRE(empty);
+    REQUIRE(empty.empty());
+}
+
+// ----------------------------------------------------------------------
+// Test referencing static strings
+// ----------------------------------------------------------------------
+
+TEST_CASE("from_static", "[collections]")
+{
+    static const string TOPIC{"sensors/temp"};
+
+    string_ref sr = string_ref::from_static(TOPIC);
+    REQUIRE(sr);
+    REQUIRE(sr.is_static());
+    REQUIRE_FALSE(sr.is_external());
+
+    // The reference points at the string itself, without a copy
+    REQUIRE(&TOPIC == &sr.str());
+    REQUIRE(TOPIC.c_str() == sr.c_str());
+    REQUIRE(TOPIC.size() == sr.size());
+
+    string_ref sr2{sr};
+    REQUIRE(sr2.is_static());
+    REQUIRE(TOPIC.data() == sr2.data());
+
+    sr2 = TOPIC;
+    REQUIRE_FALSE(sr2.is_static());
+    REQUIRE(TOPIC.data() != sr2.data());
+    REQUIRE(TOPIC == sr2.str());
+
+    REQUIRE_FALSE(string_ref{STR}.is_static());
+}
@@ -31,19 +31,17 @@
 #include "mock_callback.h"
 #include "mock_persistence.h"
 #include "mqtt/client.h"
+#include "test_util.h"
 
 using namespace std::chrono;
 using namespace mqtt;
+using mqtt::test::server_uri;
 
 /////////////////////////////////////////////////////////////////////////////
 
-// NOTE: This test case requires network access. It uses one of
-//  	 the public available MQTT brokers
-#if defined(TEST_EXTERNAL_SERVER)
-static const std::string GOOD_SERVER_URI{"tcp://mqtt.eclipseprojects.io:1883"};
-#else
+// NOTE: The tests that connect use the broker from server_uri(), which
+//  	 is the embedded test broker when it's built.
 static const std::string GOOD_SERVER_URI{"tcp://localhost:1883"};
-#endif
 static const std::string BAD_SERVER_URI{"one://invalid.address"};
 static const std::string CLIENT_ID{"client_test"};
 static const std::string TOPIC{"TOPIC"};
@@ -115,7 +113,7 @@ TEST_CASE("client user constructor 3 args", "[client]")
 
 TEST_CASE("client connect 0 arg", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -124,7 +122,7 @@ TEST_CASE("client connect 0 arg", "[client]")
 
 TEST_CASE("client connect 1 arg", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     mqtt::connect_options co;
@@ -134,7 +132,7 @@ TEST_CASE("client connect 1 arg", "[client]")
 
 TEST_CASE("client connect 1 arg failure", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     mqtt::connect_options co;
@@ -158,7 +156,7 @@ TEST_CASE("client connect 1 arg failure", "[client]")
 
 TEST_CASE("client disconnect 0 arg", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -170,7 +168,7 @@ TEST_CASE("client disconnect 0 arg", "[client]")
 
 TEST_CASE("client disconnect 1 arg", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -252,7 +250,7 @@ TEST_CASE("client get topic", "[client]")
 
 TEST_CASE("client publish pointer 2 args", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -283,7 +281,7 @@ TEST_CASE("client publish pointer 2 args failure", "[client]")
 
 TEST_CASE("client publish reference 2 args", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -298,7 +296,7 @@ TEST_CASE("client publish reference 2 args", "[client]")
 
 TEST_CASE("client publish 5 args", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -331,7 +329,7 @@ TEST_CASE("client set callback", "[client]")
 
 TEST_CASE("client subscribe single topic 1 arg", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -360,7 +358,7 @@ TEST_CASE("client subscribe single topic 1 arg failure", "[client]")
 
 TEST_CASE("client subscribe single topic 2 args", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -389,7 +387,7 @@ TEST_CASE("client subscribe single topic 2 args failure", "[client]")
 
 TEST_CASE("client subscribe many topics 1 arg", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -418,7 +416,7 @@ TEST_CASE("client subscribe many topics 1 arg failure", "[client]")
 
 TEST_CASE("client subscribe many topics 2 args", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -457,7 +455,7 @@ TEST_CASE("client subscribe many topics 2 args failure", "[client]")
 
 TEST_CASE("client unsubscribe single topic 1 arg", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -487,7 +485,7 @@ TEST_CASE("client unsubscribe single topic 1 arg failure", "[client]")
 
 TEST_CASE("client unsubscribe many topics 1 arg", "[client]")
 {
-    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    mqtt::client cli{server_uri(), CLIENT_ID};
     REQUIRE(!cli.is_connected());
 
     cli.connect();
@@ -0,0 +1,159 @@
+// test_compressed_persistence.cpp
+//
+// Unit tests for the compressed_persistence class in the Paho MQTT C++
+// library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <map>
+#include <random>
+#include <string>
+
+#include "catch2_version.h"
+#include "mock_persistence.h"
+#include "mqtt/compressed_persistence.h"
+
+using namespace mqtt;
+
+using cp = compressed_persistence;
+
+static string round_trip(const string& data)
+{
+    string out;
+    cp::compress(data.data(), data.size(), out);
+    return cp::decompress(out.data(), out.size(), data.size());
+}
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("compressed_persistence codec", "[persistence]")
+{
+    SECTION("small and empty")
+    {
+        REQUIRE(round_trip("").empty());
+        REQUIRE("a" == round_trip("a"));
+        REQUIRE("abcdefghi" == round_trip("abcdefghi"));
+    }
+
+    SECTION("repetitive")
+    {
+        string data;
+        for (int i = 0; i < 200; ++i)
+            data += "{\"sensor\":\"temp\",\"value\":" + std::to_string(20 + i % 7) + "}";
+
+        string out;
+        cp::compress(data.data(), data.size(), out);
+        REQUIRE(out.size() < data.size() / 4);
+        REQUIRE(data == cp::decompress(out.data(), out.size(), data.size()));
+    }
+
+    SECTION("long runs")
+    {
+        string data(100000, 'x');
+        data += "tail";
+        REQUIRE(data == round_trip(data));
+    }
+
+    SECTION("random")
+    {
+        std::mt19937 rng(42);
+        string data(5000, '\0');
+        for (auto& c : data) c = char(rng());
+        REQUIRE(data == round_trip(data));
+    }
+
+    SECTION("corrupt")
+    {
+        string data(1000, 'z');
+        string out;
+        cp::compress(data.data(), data.size(), out);
+
+        REQUIRE_THROWS_AS(cp::decompress(out.data(), out.size(), 999), persistence_exception);
+
+        // An original size that's too big is rejected before allocating
+        REQUIRE_THROWS_AS(
+            cp::decompress(out.data(), out.size(), size_t(1) << 40), persistence_exception
+        );
+        REQUIRE_THROWS_AS(
+            cp::decompress(out.data(), out.size(), (out.size() + 1) * 256),
+            persistence_exception
+        );
+        REQUIRE_THROWS_AS(
+            cp::decompress(out.data(), out.size() - 1, data.size()), persistence_exception
+        );
+    }
+}
+
+TEST_CASE("compressed_persistence store", "[persistence]")
+{
+    mock_persistence inner;
+    cp per{inner};
+
+    per.open("client", "tcp://localhost:1883");
+
+    string hdr = "header";
+    string body(500, 'q');
+
+    per.put("big", {string_view{hdr}, string_view{body}});
+    per.put("small", {string_view{hdr}});
+
+    REQUIRE(per.contains_key("big"));
+    REQUIRE(per.contains_key("small"));
+    REQUIRE(2 == per.keys().size());
+
+    REQUIRE(hdr + body == per.get("big"));
+    REQUIRE(hdr == per.get("small"));
+
+    // Small data is stored as-is
+    REQUIRE(hdr == inner.get("small"));
+
+    // The inner store has the compressed data
+    REQUIRE(inner.get("big").size() < body.size());
+
+    auto st = per.get_stats();
+    REQUIRE(2 == st.puts);
+    REQUIRE(1 == st.compressed);
+    REQUIRE(hdr.size() * 2 + body.size() == st.bytesIn);
+    REQUIRE(st.ratio() > 1.0);
+
+    per.remove("big");
+    REQUIRE(!per.contains_key("big"));
+    REQUIRE_THROWS_AS(per.get("big"), persistence_exception);
+
+    // Records written without the wrapper are read as-is
+    string legacy = "\x32legacy";
+    inner.put("legacy", {string_view{legacy}});
+    REQUIRE(legacy == per.get("legacy"));
+
+    // Small data that starts with the magic bytes gets a header
+    string magic = "\xB5zz";
+    per.put("magic", {string_view{magic.data(), 1}, string_view{magic.data() + 1, 2}});
+    REQUIRE(magic.size() + 3 == inner.get("magic").size());
+    REQUIRE(magic == per.get("magic"));
+
+    // A record with the magic bytes but a bad header is rejected
+    string bad = "\xB5z\x07junk";
+    inner.put("bad", {string_view{bad}});
+    REQUIRE_THROWS_AS(per.get("bad"), persistence_exception);
+
+    per.clear();
+    REQUIRE(0 == per.keys().size());
+    per.close();
+}
@@ -0,0 +1,199 @@
+// test_consumer_pool.cpp
+//
+// Unit tests for the consumer_pool class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "catch2_version.h"
+#include "mqtt/consumer_pool.h"
+#include "mqtt/message.h"
+#include "test_util.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+using mqtt::test::wait_for;
+
+namespace {
+
+consumer_pool::options test_options()
+{
+    consumer_pool::options opts;
+    opts.minWorkers = 1;
+    opts.maxWorkers = 4;
+    opts.interval = milliseconds(20);
+    opts.highDepth = 10;
+    opts.upPeriods = 1;
+    opts.downPeriods = 2;
+    opts.maxCpu = 2.0;
+    return opts;
+}
+
+}  // namespace
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("consumer_pool options", "[consumer]")
+{
+    thread_queue<event> que;
+    auto handler = [](const event&) {};
+
+    auto opts = test_options();
+    opts.minWorkers = 0;
+    REQUIRE_THROWS_AS(consumer_pool(que, handler, opts), std::invalid_argument);
+
+    opts = test_options();
+    opts.maxWorkers = 0;
+    REQUIRE_THROWS_AS(consumer_pool(que, handler, opts), std::invalid_argument);
+
+    opts = test_options();
+    opts.interval = milliseconds(0);
+    REQUIRE_THROWS_AS(consumer_pool(que, handler, opts), std::invalid_argument);
+}
+
+TEST_CASE("consumer_pool handles events", "[consumer]")
+{
+    thread_queue<event> que;
+    std::atomic<int> n{0};
+
+    consumer_pool pool{que, [&n](const event& ev) {
+                           if (ev.is_message())
+                               ++n;
+                           if (ev.is_connected())
+                               throw std::runtime_error("bad event");
+                       },
+                       test_options()};
+
+    REQUIRE(1 == pool.num_workers());
+
+    for (int i = 0; i < 10; ++i) que.put(event{make_message("a/b", "hello")});
+    que.put(event{connected_event{}});
+
+    REQUIRE(wait_for([&] { return pool.get_metrics().processed == 11; }));
+    REQUIRE(10 == n);
+    REQUIRE(1 == pool.get_metrics().errors);
+
+    pool.stop();
+    REQUIRE(0 == pool.num_workers());
+}
+
+TEST_CASE("consumer_pool scaling", "[consumer]")
+{
+    thread_queue<event> que;
+    std::atomic<int> n{0};
+    std::atomic<size_t> maxSeen{0};
+
+    consumer_pool pool{que, [&n](const event&) {
+                           std::this_thread::sleep_for(milliseconds(5));
+                           ++n;
+                       },
+                       test_options()};
+
+    pool.set_scale_handler([&](consumer_pool::decision dec, const consumer_pool::metrics& m) {
+        if (dec == consumer_pool::decision::SCALE_UP && m.workers > maxSeen)
+            maxSeen = m.workers;
+    });
+
+    const int N = 400;
+    for (int i = 0; i < N; ++i) que.put(event{make_message("a/b", "hello")});
+
+    // The backlog brings up more workers...
+    REQUIRE(wait_for([&] { return pool.num_workers() > 1; }));
+    REQUIRE(wait_for([&] { return n == N; }));
+
+    auto m = pool.get_metrics();
+    REQUIRE(m.scaleUps > 0);
+    REQUIRE(maxSeen > 1);
+    REQUIRE(maxSeen <= 4);
+
+    // ...and they're retired once the queue is idle
+    REQUIRE(wait_for([&] { return pool.num_workers() == 1; }));
+    m = pool.get_metrics();
+    REQUIRE(m.scaleDowns > 0);
+    REQUIRE(m.scaleDowns == m.scaleUps);
+    REQUIRE(consumer_pool::decision::SCALE_DOWN == m.lastDecision);
+}
+
+TEST_CASE("consumer_pool cpu limit", "[consumer]")
+{
+    thread_queue<event> que;
+
+    auto opts = test_options();
+    opts.maxCpu = 0.0;
+
+    consumer_pool pool{que, [](const event&) {
+                           std::this_thread::sleep_for(milliseconds(5));
+                       },
+                       opts};
+
+    for (int i = 0; i < 100; ++i) que.put(event{make_message("a/b", "hello")});
+
+    // With no CPU headroom, the pool holds at the minimum
+    REQUIRE(wait_for([&] { return pool.get_metrics().cpuLimited > 0; }));
+    REQUIRE(1 == pool.num_workers());
+    REQUIRE(0 == pool.get_metrics().scaleUps);
+}
+
+TEST_CASE("consumer_pool closed queue", "[consumer]")
+{
+    thread_queue<event> que;
+    std::atomic<int> n{0};
+
+    consumer_pool pool{que, [&n](const event&) { ++n; }, test_options()};
+
+    for (int i = 0; i < 5; ++i) que.put(event{make_message("a/b", "hello")});
+    que.close();
+
+    // The workers drain the queue, then exit
+    REQUIRE(wait_for([&] { return n == 5; }));
+    REQUIRE(wait_for([&] { return pool.num_workers() == 0; }));
+}
+
+TEST_CASE("consumer_pool closed queue while scaling down", "[consumer]")
+{
+    thread_queue<event> que;
+    std::atomic<int> n{0};
+
+    consumer_pool pool{que, [&n](const event&) {
+                           std::this_thread::sleep_for(milliseconds(5));
+                           ++n;
+                       },
+                       test_options()};
+
+    // Close the queue as soon as a retirement is requested, so the
+    // workers exit before any of them can claim it.
+    pool.set_scale_handler([&que](auto dec, const auto&) {
+        if (dec == consumer_pool::decision::SCALE_DOWN)
+            que.close();
+    });
+
+    const int N = 400;
+    for (int i = 0; i < N; ++i) que.put(event{make_message("a/b", "hello")});
+
+    REQUIRE(wait_for([&] { return pool.num_workers() > 1; }));
+    REQUIRE(wait_for([&] { return n == N; }));
+
+    REQUIRE(wait_for([&] { return pool.get_metrics().scaleDowns > 0; }));
+    REQUIRE(wait_for([&] { return pool.num_workers() == 0; }));
+}
@@ -0,0 +1,480 @@
+// test_embedded_broker.cpp
+//
+// Unit tests for the embedded test broker in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "catch2_version.h"
+#include "embedded_broker.h"
+#include "test_util.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+using mqtt::test::wait_for;
+
+// --------------------------------------------------------------------------
+// A bare MQTT client that speaks the protocol over a raw socket, so the
+// tests check the bytes on the wire.
+
+namespace {
+
+struct raw_client
+{
+    int sock{-1};
+    int version;
+
+    raw_client(uint16_t port, int ver = 4) : version{ver} {
+        sock = ::socket(AF_INET, SOCK_STREAM, 0);
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        ::connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+
+        timeval tv{2, 0};
+        ::setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+    ~raw_client() { close(); }
+
+    void close() {
+        if (sock >= 0)
+            ::close(sock);
+        sock = -1;
+    }
+
+    static void put_u16(string& s, unsigned v) {
+        s.push_back(char(v >> 8));
+        s.push_back(char(v & 0xFF));
+    }
+    static void put_str(string& s, const string& v) {
+        put_u16(s, unsigned(v.size()));
+        s += v;
+    }
+
+    void send_packet(unsigned hdr, const string& body) {
+        string p(1, char(hdr));
+        size_t n = body.size();
+        do {
+            char b = char(n & 0x7F);
+            n >>= 7;
+            if (n)
+                b |= char(0x80);
+            p.push_back(b);
+        } while (n);
+        p += body;
+        ::send(sock, p.data(), p.size(), 0);
+    }
+
+    // Reads a packet, returning the header byte, or -1 on error/timeout.
+    int read_packet(string& body) {
+        unsigned char c;
+        if (::recv(sock, &c, 1, MSG_WAITALL) != 1)
+            return -1;
+        int hdr = c;
+
+        size_t len = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (::recv(sock, &c, 1, MSG_WAITALL) != 1)
+                return -1;
+            len |= size_t(c & 0x7F) << (7 * i);
+            if (!(c & 0x80))
+                break;
+        }
+        body.assign(len, '\0');
+        if (len && ::recv(sock, &body[0], len, MSG_WAITALL) != ssize_t(len))
+            return -1;
+        return hdr;
+    }
+
+    // Connects, returning the CONNACK body
+    string connect(
+        const string& clientId, bool clean = true, uint32_t expiry = 0,
+        const string& willTopic = "", const string& willMsg = ""
+    ) {
+        string b;
+        put_str(b, "MQTT");
+        b.push_back(char(version));
+        uint8_t flags = clean ? 0x02 : 0;
+        if (!willTopic.empty())
+            flags |= 0x04;
+        b.push_back(char(flags));
+        put_u16(b, 30);
+        if (version == 5) {
+            if (expiry) {
+                b.push_back(5);
+                b.push_back(0x11);
+                b.push_back(char(expiry >> 24));
+                b.push_back(char(expiry >> 16));
+                b.push_back(char(expiry >> 8));
+                b.push_back(char(expiry));
+            }
+            else {
+                b.push_back(0);
+            }
+        }
+        put_str(b, clientId);
+        if (!willTopic.empty()) {
+            if (version == 5)
+                b.push_back(0);
+            put_str(b, willTopic);
+            put_str(b, willMsg);
+        }
+        send_packet(0x10, b);
+
+        string ack;
+        REQUIRE(0x20 == read_packet(ack));
+        return ack;
+    }
+
+    void subscribe(const string& filter, int qos, uint16_t id = 1) {
+        string b;
+        put_u16(b, id);
+        if (version == 5)
+            b.push_back(0);
+        put_str(b, filter);
+        b.push_back(char(qos));
+        send_packet(0x82, b);
+
+        string ack;
+        REQUIRE(0x90 == read_packet(ack));
+        REQUIRE(char(qos) == ack.back());
+    }
+
+    void publish(
+        const string& topic, const string& payload, int qos = 0, bool retain = false,
+        uint16_t id = 1
+    ) {
+        string b;
+        put_str(b, topic);
+        if (qos > 0)
+            put_u16(b, id);
+        if (version == 5)
+            b.push_back(0);
+        b += payload;
+        send_packet(0x30 | (qos << 1) | (retain ? 1 : 0), b);
+    }
+
+    // Reads a PUBLISH, returning the topic and payload
+    bool read_publish(int& hdr, uint16_t& id, string& topic, string& payload) {
+        string b;
+        hdr = read_packet(b);
+        if ((hdr >> 4) != 3)
+            return false;
+
+        size_t n = (size_t(uint8_t(b[0])) << 8) | uint8_t(b[1]);
+        topic = b.substr(2, n);
+        size_t pos = 2 + n;
+        id = 0;
+        if (hdr & 0x06) {
+            id = uint16_t((uint8_t(b[pos]) << 8) | uint8_t(b[pos + 1]));
+            pos += 2;
+        }
+        if (version == 5)
+            pos += 1 + uint8_t(b[pos]);
+        payload = b.substr(pos);
+        return true;
+    }
+
+    void ack(unsigned type, uint16_t id) {
+        string b;
+        put_u16(b, id);
+        send_packet(type, b);
+    }
+
+    void disconnect() { send_packet(0xE0, string{}); }
+};
+
+}  // namespace
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("embedded_broker connect", "[broker]")
+{
+    embedded_broker broker;
+    REQUIRE(broker.port() != 0);
+    REQUIRE("tcp://127.0.0.1:" + std::to_string(broker.port()) == broker.uri());
+
+    SECTION("v3.1.1")
+    {
+        raw_client cli{broker.port()};
+        auto ack = cli.connect("cli3");
+        REQUIRE(string{'\0', '\0'} == ack);
+        REQUIRE(wait_for([&] { return broker.num_clients() == 1; }));
+
+        string body;
+        cli.send_packet(0xC0, string{});
+        REQUIRE(0xD0 == cli.read_packet(body));
+
+        cli.disconnect();
+        REQUIRE(wait_for([&] { return broker.num_sessions() == 0; }));
+    }
+
+    SECTION("v5 assigned id")
+    {
+        raw_client cli{broker.port(), 5};
+        auto ack = cli.connect("");
+        REQUIRE(ack.size() > 3);
+        REQUIRE('\0' == ack[1]);
+        REQUIRE(char(0x12) == ack[3]);
+        REQUIRE(ack.find("auto-") != string::npos);
+    }
+
+    SECTION("bad protocol version")
+    {
+        raw_client cli{broker.port(), 9};
+        auto ack = cli.connect("bad");
+        REQUIRE(char(1) == ack[1]);
+    }
+
+    SECTION("empty id with a persistent session")
+    {
+        raw_client cli{broker.port()};
+        auto ack = cli.connect("", false);
+        REQUIRE(char(2) == ack[1]);
+    }
+}
+
+TEST_CASE("embedded_broker publish", "[broker]")
+{
+    embedded_broker broker;
+
+    raw_client sub{broker.port()}, pub{broker.port(), 5};
+    sub.connect("sub");
+    pub.connect("pub");
+
+    int hdr;
+    uint16_t id;
+    string topic, payload;
+
+    SECTION("qos 0")
+    {
+        sub.subscribe("a/b", 0);
+        pub.publish("a/b", "hello");
+
+        REQUIRE(sub.read_publish(hdr, id, topic, payload));
+        REQUIRE(0x30 == hdr);
+        REQUIRE("a/b" == topic);
+        REQUIRE("hello" == payload);
+    }
+
+    SECTION("qos 1")
+    {
+        sub.subscribe("a/b", 1);
+        pub.publish("a/b", "one", 1, false, 7);
+
+        string body;
+        REQUIRE(0x40 == pub.read_packet(body));
+        REQUIRE(string{'\0', '\x07'} == body);
+
+        REQUIRE(sub.read_publish(hdr, id, topic, payload));
+        REQUIRE(0x32 == hdr);
+        REQUIRE(id != 0);
+        REQUIRE("one" == payload);
+        sub.ack(0x40, id);
+    }
+
+    SECTION("qos 2")
+    {
+        sub.subscribe("a/b", 2);
+        pub.publish("a/b", "two", 2, false, 9);
+
+        string body;
+        REQUIRE(0x50 == pub.read_packet(body));
+        // A resend before PUBREL isn't routed twice
+        pub.publish("a/b", "two", 2, false, 9);
+        REQUIRE(0x50 == pub.read_packet(body));
+        pub.ack(0x62, 9);
+        REQUIRE(0x70 == pub.read_packet(body));
+
+        REQUIRE(sub.read_publish(hdr, id, topic, payload));
+        REQUIRE(0x34 == hdr);
+        REQUIRE("two" == payload);
+
+        sub.ack(0x50, id);
+        REQUIRE(0x62 == sub.read_packet(body));
+        sub.ack(0x70, id);
+
+        REQUIRE(1 == broker.get_stats().messagesIn);
+        REQUIRE(1 == broker.get_stats().messagesOut);
+    }
+
+    SECTION("qos downgrade")
+    {
+        sub.subscribe("a/b", 0);
+        pub.publish("a/b", "down", 1, false, 3);
+
+        REQUIRE(sub.read_publish(hdr, id, topic, payload));
+        REQUIRE(0x30 == hdr);
+    }
+
+    SECTION("wildcards")
+    {
+        sub.subscribe("a/+/c", 0, 1);
+        sub.subscribe("x/#", 0, 2);
+
+        pub.publish("a/b/d", "no");
+        pub.publish("a/b/c", "plus");
+        pub.publish("x/y/z", "hash");
+
+        REQUIRE(sub.read_publish(hdr, id, topic, payload));
+        REQUIRE("a/b/c" == topic);
+        REQUIRE(sub.read_publish(hdr, id, topic, payload));
+        REQUIRE("x/y/z" == topic);
+    }
+
+    SECTION("overlapping filters deliver once")
+    {
+        sub.subscribe("a/#", 0, 1);
+        sub.subscribe("a/b", 1, 2);
+
+        pub.publish("a/b", "once");
+        pub.publish("a/c", "marker");
+
+        REQUIRE(sub.read_publish(hdr, id, topic, payload));
+        REQUIRE("once" == payload);
+        REQUIRE(sub.read_publish(hdr, id, topic, payload));
+        REQUIRE("marker" == payload);
+    }
+}
+
+TEST_CASE("embedded_broker retained", "[broker]")
+{
+    embedded_broker broker;
+
+    raw_client pub{broker.port()};
+    pub.connect("pub");
+    pub.publish("r/t", "kept", 0, true);
+    REQUIRE(wait_for([&] { return broker.num_retained() == 1; }));
+
+    raw_client sub{broker.port()};
+    sub.connect("sub");
+    sub.subscribe("r/#", 1);
+
+    int hdr;
+    uint16_t id;
+    string topic, payload;
+    REQUIRE(sub.read_publish(hdr, id, topic, payload));
+    REQUIRE(0x31 == (hdr & 0x31));
+    REQUIRE("kept" == payload);
+
+    // An empty retained message clears it
+    pub.publish("r/t", "", 0, true);
+    REQUIRE(wait_for([&] { return broker.num_retained() == 0; }));
+}
+
+TEST_CASE("embedded_broker will", "[broker]")
+{
+    embedded_broker broker;
+
+    raw_client sub{broker.port()};
+    sub.connect("sub");
+    sub.subscribe("will/#", 0);
+
+    int hdr;
+    uint16_t id;
+    string topic, payload;
+
+    SECTION("abrupt close sends the will")
+    {
+        raw_client cli{broker.port()};
+        cli.connect("dying", true, 0, "will/dying", "gone");
+        cli.close();
+
+        REQUIRE(sub.read_publish(hdr, id, topic, payload));
+        REQUIRE("will/dying" == topic);
+        REQUIRE("gone" == payload);
+    }
+
+    SECTION("clean disconnect drops the will")
+    {
+        raw_client cli{broker.port()};
+        cli.connect("leaving", true, 0, "will/leaving", "gone");
+        cli.disconnect();
+        REQUIRE(wait_for([&] { return broker.num_sessions() == 1; }));
+
+        sub.publish("will/marker", "marker");
+        REQUIRE(sub.read_publish(hdr, id, topic, payload));
+        REQUIRE("will/marker" == topic);
+    }
+}
+
+TEST_CASE("embedded_broker persistent session", "[broker]")
+{
+    embedded_broker broker;
+
+    {
+        raw_client cli{broker.port(), 5};
+        auto ack = cli.connect("keeper", false, 3600);
+        REQUIRE('\0' == ack[0]);
+        cli.subscribe("q/#", 1);
+        cli.disconnect();
+    }
+    REQUIRE(wait_for([&] { return broker.num_clients() == 0; }));
+    REQUIRE(1 == broker.num_sessions());
+
+    raw_client pub{broker.port()};
+    pub.connect("pub");
+    pub.publish("q/1", "while away", 1);
+
+    string body;
+    REQUIRE(0x40 == pub.read_packet(body));
+
+    raw_client cli{broker.port(), 5};
+    auto ack = cli.connect("keeper", false, 3600);
+    REQUIRE('\x01' == ack[0]);
+
+    int hdr;
+    uint16_t id;
+    string topic, payload;
+    REQUIRE(cli.read_publish(hdr, id, topic, payload));
+    REQUIRE("while away" == payload);
+}
+
+TEST_CASE("embedded_broker disconnect_clients", "[broker]")
+{
+    embedded_broker broker;
+
+    raw_client cli{broker.port()};
+    cli.connect("cli");
+    REQUIRE(wait_for([&] { return broker.num_clients() == 1; }));
+
+    broker.disconnect_clients();
+
+    string body;
+    REQUIRE(cli.read_packet(body) < 0);
+    REQUIRE(wait_for([&] { return broker.num_clients() == 0; }));
+
+    // The broker still takes new connections
+    raw_client cli2{broker.port()};
+    cli2.connect("cli2");
+    REQUIRE(wait_for([&] { return broker.num_clients() == 1; }));
+    REQUIRE(2 <= broker.get_stats().connections);
+}
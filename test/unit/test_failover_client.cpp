@@ -0,0 +1,225 @@
+// test_failover_client.cpp
+//
+// Unit tests for the failover_client class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <thread>
+
+#include "catch2_version.h"
+#include "mqtt/failover_client.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+static const overlap_filter::duration WINDOW = seconds(10);
+
+static const_message_ptr msg(const string& topic, const string& payload) {
+    return message::create(topic, payload);
+}
+
+// ----------------------------------------------------------------------
+// overlap_filter
+// ----------------------------------------------------------------------
+
+TEST_CASE("overlap_filter drops standby copies", "[failover]")
+{
+    overlap_filter filt{WINDOW};
+
+    // Active first, then standby
+    REQUIRE(filt.add(msg("a", "1"), 0, true));
+    REQUIRE(!filt.add(msg("a", "1"), 1, false));
+    REQUIRE(0 == filt.num_pending());
+
+    // Standby first, then active
+    REQUIRE(!filt.add(msg("a", "2"), 1, false));
+    REQUIRE(1 == filt.num_pending());
+    REQUIRE(filt.add(msg("a", "2"), 0, true));
+    REQUIRE(0 == filt.num_pending());
+
+    REQUIRE(2 == filt.num_duplicates());
+
+    // Different topic, same payload, isn't a copy
+    REQUIRE(filt.add(msg("a", "3"), 0, true));
+    REQUIRE(!filt.add(msg("b", "3"), 1, false));
+    REQUIRE(1 == filt.num_pending());
+    REQUIRE(2 == filt.num_duplicates());
+}
+
+TEST_CASE("overlap_filter repeated messages", "[failover]")
+{
+    overlap_filter filt{WINDOW};
+
+    REQUIRE(filt.add(msg("a", "on"), 0, true));
+    REQUIRE(filt.add(msg("a", "on"), 0, true));
+
+    REQUIRE(!filt.add(msg("a", "on"), 1, false));
+    REQUIRE(!filt.add(msg("a", "on"), 1, false));
+    REQUIRE(2 == filt.num_duplicates());
+    REQUIRE(0 == filt.num_pending());
+
+    // A third standby copy has nothing to match, so it's held
+    REQUIRE(!filt.add(msg("a", "on"), 1, false));
+    REQUIRE(1 == filt.num_pending());
+}
+
+TEST_CASE("overlap_filter promote", "[failover]")
+{
+    overlap_filter filt{WINDOW};
+
+    // Delivered by the primary, before the loss
+    REQUIRE(filt.add(msg("a", "1"), 0, true));
+
+    // Only the standby got these
+    REQUIRE(!filt.add(msg("a", "2"), 1, false));
+    REQUIRE(!filt.add(msg("a", "3"), 1, false));
+
+    auto msgs = filt.promote();
+    REQUIRE(2 == msgs.size());
+    REQUIRE("2" == msgs[0]->get_payload_str());
+    REQUIRE("3" == msgs[1]->get_payload_str());
+    REQUIRE(0 == filt.num_pending());
+
+    // A late copy of what the old primary delivered is dropped
+    REQUIRE(!filt.add(msg("a", "1"), 1, true));
+    REQUIRE(1 == filt.num_duplicates());
+
+    // New messages from the standby go straight through
+    REQUIRE(filt.add(msg("a", "4"), 1, true));
+
+    // The old primary comes back as the standby
+    REQUIRE(!filt.add(msg("a", "4"), 0, false));
+    REQUIRE(!filt.add(msg("a", "2"), 0, false));
+    REQUIRE(3 == filt.num_duplicates());
+    REQUIRE(0 == filt.num_pending());
+}
+
+TEST_CASE("overlap_filter window", "[failover]")
+{
+    overlap_filter filt{milliseconds(1)};
+
+    REQUIRE(filt.add(msg("a", "1"), 0, true));
+    REQUIRE(!filt.add(msg("a", "2"), 1, false));
+    std::this_thread::sleep_for(milliseconds(10));
+
+    // Too late to match
+    REQUIRE(!filt.add(msg("a", "1"), 1, false));
+    REQUIRE(0 == filt.num_duplicates());
+    REQUIRE(1 == filt.num_pending());
+
+    REQUIRE(filt.add(msg("a", "2"), 0, true));
+    REQUIRE(0 == filt.num_duplicates());
+}
+
+// ----------------------------------------------------------------------
+// failover_client
+// ----------------------------------------------------------------------
+
+TEST_CASE("failover_client disconnected", "[failover]")
+{
+    failover_client cli{
+        create_options{"tcp://localhost:1883", "primary"},
+        create_options{"tcp://localhost:1884", "standby"}
+    };
+
+    REQUIRE(!cli.is_connected());
+    REQUIRE(0 == cli.active_index());
+    REQUIRE(&cli.get_primary() == &cli.active());
+    REQUIRE("tcp://localhost:1884" == cli.get_standby().get_server_uri());
+
+    // Subscriptions are kept until a client connects
+    REQUIRE(!cli.subscribe("data/#", 1));
+    REQUIRE(!cli.subscribe("cmd/#", 2));
+    REQUIRE(!cli.subscribe("data/#", 0));
+
+    auto subs = cli.get_subscriptions();
+    REQUIRE(2 == subs.size());
+    REQUIRE("data/#" == subs[0].first);
+    REQUIRE(0 == subs[0].second);
+
+    REQUIRE(!cli.unsubscribe("data/#"));
+    REQUIRE(1 == cli.get_subscriptions().size());
+
+    const_message_ptr m;
+    REQUIRE(!cli.try_consume_message(&m));
+    REQUIRE(!cli.try_consume_message_for(&m, milliseconds(1)));
+
+    REQUIRE(0 == cli.num_failovers());
+    REQUIRE(0 == cli.num_duplicates());
+}
+
+TEST_CASE("overlap_filter many pending", "[failover]")
+{
+    const int N = 20000;
+    overlap_filter filt{WINDOW};
+
+    for (int i = 0; i < N; ++i) REQUIRE(!filt.add(msg("a", std::to_string(i)), 1, false));
+    REQUIRE(size_t(N) == filt.num_pending());
+
+    // Match them out of order
+    for (int i = 1; i < N; i += 2) REQUIRE(filt.add(msg("a", std::to_string(i)), 0, true));
+    REQUIRE(size_t(N / 2) == filt.num_pending());
+    for (int i = 0; i < N; i += 2) REQUIRE(filt.add(msg("a", std::to_string(i)), 0, true));
+
+    REQUIRE(0 == filt.num_pending());
+    REQUIRE(uint64_t(N) == filt.num_duplicates());
+    REQUIRE(filt.promote().empty());
+}
+
+TEST_CASE("overlap_filter promote after matches", "[failover]")
+{
+    overlap_filter filt{WINDOW};
+
+    for (int i = 0; i < 5; ++i) REQUIRE(!filt.add(msg("a", std::to_string(i)), 1, false));
+    REQUIRE(filt.add(msg("a", "1"), 0, true));
+    REQUIRE(filt.add(msg("a", "3"), 0, true));
+
+    auto msgs = filt.promote();
+    REQUIRE(3 == msgs.size());
+    REQUIRE("0" == msgs[0]->get_payload_str());
+    REQUIRE("2" == msgs[1]->get_payload_str());
+    REQUIRE("4" == msgs[2]->get_payload_str());
+
+    // Held again after the promotion
+    REQUIRE(!filt.add(msg("b", "1"), 0, false));
+    REQUIRE(1 == filt.num_pending());
+    REQUIRE(filt.add(msg("b", "1"), 1, true));
+    REQUIRE(0 == filt.num_pending());
+}
+
+TEST_CASE("failover_client stop consuming", "[failover]")
+{
+    failover_client cli{
+        create_options{"tcp://localhost:1883", "primary"},
+        create_options{"tcp://localhost:1884", "standby"}
+    };
+    REQUIRE(!cli.consumer_closed());
+
+    auto thr = std::thread([&cli] {
+        std::this_thread::sleep_for(milliseconds(10));
+        cli.stop_consuming();
+    });
+
+    // Blocks until the consumer is stopped
+    REQUIRE(!cli.consume_message());
+    thr.join();
+    REQUIRE(cli.consumer_closed());
+}
@@ -0,0 +1,232 @@
+// test_fault_proxy.cpp
+//
+// Unit tests for the fault-injection proxy in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "catch2_version.h"
+#include "embedded_broker.h"
+#include "fault_proxy.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+// --------------------------------------------------------------------------
+// The tests run a bare MQTT v3.1.1 client through the proxy to the
+// embedded broker, and time the round trips.
+
+namespace {
+
+int open_client(uint16_t port)
+{
+    int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    ::connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+
+    timeval tv{5, 0};
+    ::setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return sock;
+}
+
+void send_packet(int sock, unsigned hdr, const string& body)
+{
+    string p(1, char(hdr));
+    size_t n = body.size();
+    do {
+        char b = char(n & 0x7F);
+        n >>= 7;
+        if (n)
+            b |= char(0x80);
+        p.push_back(b);
+    } while (n);
+    p += body;
+    ::send(sock, p.data(), p.size(), 0);
+}
+
+// Reads a packet, returning the header byte, or -1 on error/timeout.
+int read_packet(int sock, string& body)
+{
+    unsigned char c;
+    if (::recv(sock, &c, 1, MSG_WAITALL) != 1)
+        return -1;
+    int hdr = c;
+
+    size_t len = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (::recv(sock, &c, 1, MSG_WAITALL) != 1)
+            return -1;
+        len |= size_t(c & 0x7F) << (7 * i);
+        if (!(c & 0x80))
+            break;
+    }
+    body.assign(len, '\0');
+    if (len && ::recv(sock, &body[0], len, MSG_WAITALL) != ssize_t(len))
+        return -1;
+    return hdr;
+}
+
+string mqtt_str(const string& s)
+{
+    string b{char(s.size() >> 8), char(s.size() & 0xFF)};
+    return b + s;
+}
+
+bool mqtt_connect(int sock, const string& clientId)
+{
+    string b = mqtt_str("MQTT") + string{'\x04', '\x02', '\0', '\x1E'} + mqtt_str(clientId);
+    send_packet(sock, 0x10, b);
+
+    string ack;
+    return read_packet(sock, ack) == 0x20 && ack[1] == 0;
+}
+
+// Times a PINGREQ/PINGRESP round trip
+milliseconds ping(int sock)
+{
+    auto start = steady_clock::now();
+    send_packet(sock, 0xC0, string{});
+
+    string body;
+    REQUIRE(0xD0 == read_packet(sock, body));
+    return duration_cast<milliseconds>(steady_clock::now() - start);
+}
+
+}  // namespace
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("fault_proxy pass through", "[proxy]")
+{
+    embedded_broker broker;
+    fault_proxy proxy{"127.0.0.1", broker.port()};
+
+    REQUIRE(proxy.port() != 0);
+    REQUIRE(proxy.port() != broker.port());
+    REQUIRE("tcp://127.0.0.1:" + std::to_string(proxy.port()) == proxy.uri());
+
+    int sock = open_client(proxy.port());
+    REQUIRE(mqtt_connect(sock, "cli"));
+    ping(sock);
+
+    REQUIRE(1 == proxy.num_connections());
+    REQUIRE(1 == broker.num_clients());
+
+    auto st = proxy.get_stats();
+    REQUIRE(1 == st.connections);
+    REQUIRE(st.bytesUp > 0);
+    REQUIRE(st.bytesDown > 0);
+
+    ::close(sock);
+}
+
+TEST_CASE("fault_proxy latency", "[proxy]")
+{
+    embedded_broker broker;
+
+    fault_proxy::options opts;
+    opts.latency = milliseconds(50);
+    fault_proxy proxy{"127.0.0.1", broker.port(), opts};
+
+    int sock = open_client(proxy.port());
+    REQUIRE(mqtt_connect(sock, "cli"));
+
+    // The delay is added in each direction
+    REQUIRE(ping(sock) >= milliseconds(100));
+
+    SECTION("loss")
+    {
+        opts.latency = milliseconds(0);
+        opts.lossRate = 1.0;
+        opts.lossPenalty = milliseconds(60);
+        proxy.set_options(opts);
+
+        REQUIRE(ping(sock) >= milliseconds(120));
+        REQUIRE(proxy.get_stats().losses >= 2);
+    }
+
+    SECTION("stall")
+    {
+        proxy.set_options(fault_proxy::options{});
+        proxy.stall(milliseconds(200));
+        REQUIRE(ping(sock) >= milliseconds(190));
+    }
+
+    ::close(sock);
+}
+
+TEST_CASE("fault_proxy bandwidth", "[proxy]")
+{
+    embedded_broker broker;
+
+    fault_proxy::options opts;
+    opts.bandwidth = 100 * 1024;
+    fault_proxy proxy{"127.0.0.1", broker.port(), opts};
+
+    int sock = open_client(proxy.port());
+    REQUIRE(mqtt_connect(sock, "cli"));
+
+    send_packet(sock, 0x82, string{'\0', '\x01'} + mqtt_str("bw") + string{'\0'});
+    string body;
+    REQUIRE(0x90 == read_packet(sock, body));
+
+    // 20kB up and back at 100kB/s should take about 400ms
+    auto start = steady_clock::now();
+    send_packet(sock, 0x30, mqtt_str("bw") + string(20 * 1024, 'x'));
+    REQUIRE(0x30 == read_packet(sock, body));
+    REQUIRE(steady_clock::now() - start >= milliseconds(350));
+
+    ::close(sock);
+}
+
+TEST_CASE("fault_proxy reset", "[proxy]")
+{
+    embedded_broker broker;
+    fault_proxy proxy{"127.0.0.1", broker.port()};
+
+    int sock = open_client(proxy.port());
+    REQUIRE(mqtt_connect(sock, "cli"));
+
+    proxy.reset_connections();
+
+    string body;
+    REQUIRE(read_packet(sock, body) < 0);
+    REQUIRE(1 == proxy.get_stats().resets);
+    REQUIRE(0 == proxy.num_connections());
+    ::close(sock);
+
+    // The proxy still takes new connections
+    sock = open_client(proxy.port());
+    REQUIRE(mqtt_connect(sock, "cli"));
+    ::close(sock);
+}
@@ -0,0 +1,112 @@
+// test_json_view.cpp
+//
+// Unit tests for the json_view class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/json_view.h"
+#include "mqtt/message.h"
+
+using namespace mqtt;
+
+static const std::string DOC{R"( {
+    "device": {"id": "dev-17", "name": "Temp \"A\""},
+    "ok": true,
+    "err": null,
+    "count": 42,
+    "readings": [ {"temp": 20.5}, {"temp": -1.25e1}, {"note": "a,b]}"} ],
+    "empty": {}
+} )"};
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("json_view types", "[json]")
+{
+    json_view js{DOC};
+
+    REQUIRE(js);
+    REQUIRE(json_view::OBJECT == js.type());
+    REQUIRE(json_view::OBJECT == js["device"].type());
+    REQUIRE(json_view::ARRAY == js["readings"].type());
+    REQUIRE(json_view::STRING == js["device"]["id"].type());
+    REQUIRE(json_view::NUMBER == js["count"].type());
+    REQUIRE(json_view::BOOLEAN == js["ok"].type());
+    REQUIRE(json_view::NULL_VALUE == js["err"].type());
+    REQUIRE(json_view::NONE == js["missing"].type());
+    REQUIRE(!js["missing"]);
+
+    REQUIRE(json_view::NONE == json_view{}.type());
+    REQUIRE(json_view::NONE == json_view{"   "}.type());
+}
+
+TEST_CASE("json_view values", "[json]")
+{
+    json_view js{DOC};
+
+    REQUIRE("dev-17" == js["device"]["id"].get_string().value());
+    REQUIRE(42 == js["count"].get_int().value());
+    REQUIRE(42.0 == js["count"].get_double().value());
+    REQUIRE(js["ok"].get_bool().value());
+    REQUIRE(20.5 == js["readings"][size_t(0)]["temp"].get_double().value());
+    REQUIRE(-12.5 == js.find("readings.1.temp").get_double().value());
+    REQUIRE(!js.find("readings.1.temp").get_int());
+    REQUIRE("a,b]}" == js.find("readings.2.note").get_string().value());
+
+    REQUIRE(!js["count"].get_string());
+    REQUIRE(!js["device"].get_double());
+    REQUIRE(!js.find("readings.3").exists());
+    REQUIRE(!js.find("readings.x").exists());
+
+    REQUIRE(6 == js.size());
+    REQUIRE(3 == js["readings"].size());
+    REQUIRE(0 == js["empty"].size());
+    REQUIRE(0 == js["count"].size());
+}
+
+TEST_CASE("json_view unescape", "[json]")
+{
+    json_view js{DOC};
+
+    REQUIRE(R"(Temp \"A\")" == js["device"]["name"].get_string().value());
+    REQUIRE("Temp \"A\"" == js["device"]["name"].unescape());
+    REQUIRE("\xC3\xA9\n/" == json_view{R"("é\n\/")"}.unescape());
+    REQUIRE("\xF0\x9F\x98\x80" == json_view{R"("😀")"}.unescape());
+    REQUIRE(js["count"].unescape().empty());
+}
+
+TEST_CASE("json_view malformed", "[json]")
+{
+    REQUIRE(!json_view{R"({"a": )"}["a"]);
+    REQUIRE(!json_view{R"({"a" 1})"}["a"]);
+    REQUIRE(!json_view{R"({"a": "unterminated)"}.exists());
+    REQUIRE(!json_view{R"([1, 2)"}[size_t(1)]);
+}
+
+TEST_CASE("message payload json", "[json]")
+{
+    auto msg = message::create("data", R"({"temp": 21.5})");
+    REQUIRE(21.5 == msg->get_payload_json()["temp"].get_double().value());
+
+    message empty;
+    REQUIRE(!empty.get_payload_json());
+}
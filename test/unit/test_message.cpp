@@ -25,6 +25,7 @@
 
 #include "catch2_version.h"
 #include "mqtt/message.h"
+#include "mqtt/message_view.h"
 
 using namespace mqtt;
 
@@ -365,6 +366,57 @@ TEST_CASE("validate qos", "[message]")
     REQUIRE_NOTHROW(mqtt::message::validate_qos(0));
 }
 
+// --------------------------------------------------------------------------
+// Test a payload in adopted, external memory
+// --------------------------------------------------------------------------
+
+TEST_CASE("adopted payload", "[message]")
+{
+    bool released = false;
+    {
+        auto payload = binary_ref::adopt(BUF, N, [&released](const char*) { released = true; });
+        mqtt::message msg{TOPIC, std::move(payload), QOS, false};
+
+        // The C struct points directly at the external memory
+        const auto& c_struct = msg.c_struct();
+        REQUIRE(BUF == c_struct.payload);
+        REQUIRE(int(N) == c_struct.payloadlen);
+        REQUIRE(PAYLOAD == msg.get_payload_str());
+
+        mqtt::message msg2{msg};
+        REQUIRE(BUF == msg2.c_struct().payload);
+    }
+    REQUIRE(released);
+}
+
+TEST_CASE("message view", "[message]")
+{
+    properties props{
+        {property::RESPONSE_TOPIC, RESPONSE_TOPIC},
+        {property::USER_PROPERTY, "type", "reading"},
+        {property::USER_PROPERTY, "unit", "C"}
+    };
+    mqtt::message msg{TOPIC, PAYLOAD, QOS, true, props};
+
+    message_view view{TOPIC, msg.c_struct()};
+
+    REQUIRE(TOPIC == view.get_topic());
+    REQUIRE(PAYLOAD == view.get_payload());
+    REQUIRE(QOS == view.get_qos());
+    REQUIRE(view.is_retained());
+    REQUIRE(!view.is_duplicate());
+    REQUIRE(&msg.c_struct() == &view.c_struct());
+
+    REQUIRE(view.has_property(property::RESPONSE_TOPIC));
+    REQUIRE(!view.has_property(property::CONTENT_TYPE));
+    REQUIRE(RESPONSE_TOPIC == view.get_string_property(property::RESPONSE_TOPIC));
+    REQUIRE(view.get_string_property(property::CONTENT_TYPE).empty());
+
+    REQUIRE("reading" == view.get_user_property("type"));
+    REQUIRE("C" == view.get_user_property("unit"));
+    REQUIRE(view.get_user_property("other").empty());
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
 // --------------------------------------------------------------------------
@@ -0,0 +1,171 @@
+// test_ordered_stage.cpp
+//
+// Unit tests for the ordered_stage class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/ordered_stage.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("ordered_stage keeps order per topic", "[ordered_stage]")
+{
+    const int N_TOPICS = 4, N_MSGS = 200;
+
+    std::mutex mtx;
+    std::map<string, std::vector<int>> results;
+
+    {
+        ordered_stage<int> stage{
+            4,
+            [](const_message_ptr msg) {
+                int n = std::stoi(msg->to_string());
+                // Make later messages tend to finish first
+                std::this_thread::sleep_for(microseconds((N_MSGS - n) % 7 * 50));
+                return n;
+            },
+            [&](const_message_ptr msg, int n) {
+                std::lock_guard<std::mutex> g(mtx);
+                results[msg->get_topic()].push_back(n);
+            },
+            ordered_stage<int>::by_topic(), 8
+        };
+
+        REQUIRE(4 == stage.num_workers());
+
+        for (int i = 0; i < N_MSGS; ++i) {
+            for (int t = 0; t < N_TOPICS; ++t)
+                stage.put(message::create("topic/" + std::to_string(t), std::to_string(i)));
+        }
+        stage.close();
+    }
+
+    REQUIRE(N_TOPICS == int(results.size()));
+    for (auto& r : results) {
+        REQUIRE(N_MSGS == int(r.second.size()));
+        for (int i = 0; i < N_MSGS; ++i) REQUIRE(i == r.second[i]);
+    }
+}
+
+TEST_CASE("ordered_stage by user property", "[ordered_stage]")
+{
+    std::mutex mtx;
+    std::map<string, std::vector<int>> results;
+
+    ordered_stage<int> stage{
+        3, [](const_message_ptr msg) { return std::stoi(msg->to_string()); },
+        [&](const_message_ptr msg, int n) {
+            std::lock_guard<std::mutex> g(mtx);
+            auto key = ordered_stage<int>::by_user_property("device")(*msg);
+            results[key].push_back(n);
+        },
+        ordered_stage<int>::by_user_property("device")
+    };
+
+    for (int i = 0; i < 50; ++i) {
+        properties props{{property::USER_PROPERTY, "device", i % 2 ? "odd" : "even"}};
+        auto msg = message_ptr_builder()
+                       .topic("data")
+                       .payload(std::to_string(i))
+                       .properties(props)
+                       .finalize();
+        stage.put(msg);
+    }
+    // No property, so keyed by topic
+    stage.put(message::create("other", "99"));
+    stage.close();
+
+    REQUIRE(3 == results.size());
+    REQUIRE(25 == results["odd"].size());
+    REQUIRE(25 == results["even"].size());
+    REQUIRE(1 == results["other"].size());
+
+    for (size_t i = 0; i < 25; ++i) {
+        REQUIRE(int(2 * i) == results["even"][i]);
+        REQUIRE(int(2 * i + 1) == results["odd"][i]);
+    }
+}
+
+TEST_CASE("ordered_stage skips failed transforms", "[ordered_stage]")
+{
+    std::vector<int> results;
+
+    ordered_stage<int> stage{
+        2,
+        [](const_message_ptr msg) {
+            int n = std::stoi(msg->to_string());
+            if (n % 3 == 0)
+                throw std::runtime_error("bad");
+            return n;
+        },
+        [&](const_message_ptr, int n) { results.push_back(n); }
+    };
+
+    for (int i = 1; i <= 9; ++i) stage.put(message::create("topic", std::to_string(i)));
+    stage.close();
+
+    REQUIRE(3 == stage.num_errors());
+    REQUIRE((std::vector<int>{1, 2, 4, 5, 7, 8}) == results);
+
+    REQUIRE_THROWS_AS(stage.put(message::create("topic", "10")), queue_closed);
+}
+
+TEST_CASE("ordered_stage failed transform with a waiting producer", "[ordered_stage]")
+{
+    // With room for one message per key, the second put() blocks until
+    // the first is done. The first fails, so its key goes idle while the
+    // producer is still waiting on it.
+    for (int i = 0; i < 50; ++i) {
+        std::vector<int> results;
+
+        ordered_stage<int> stage{
+            1,
+            [i](const_message_ptr msg) {
+                int n = std::stoi(msg->to_string());
+                if (n == 1) {
+                    std::this_thread::sleep_for(microseconds(i % 5 * 100));
+                    throw std::runtime_error("bad");
+                }
+                return n;
+            },
+            [&](const_message_ptr, int n) { results.push_back(n); },
+            ordered_stage<int>::by_topic(), 1
+        };
+
+        stage.put(message::create("topic", "1"));
+        stage.put(message::create("topic", "2"));
+        stage.put(message::create("topic", "3"));
+        stage.close();
+
+        REQUIRE(1 == stage.num_errors());
+        REQUIRE((std::vector<int>{2, 3}) == results);
+    }
+}
@@ -0,0 +1,155 @@
+// test_payload_integrity.cpp
+//
+// Unit tests for the payload integrity checks in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/async_client.h"
+#include "mqtt/message.h"
+#include "mqtt/payload_integrity.h"
+
+using namespace mqtt;
+
+namespace {
+
+// A plain bit-at-a-time CRC-32C to check against
+uint32_t crc32c_ref(const void* data, size_t n)
+{
+    auto p = static_cast<const uint8_t*>(data);
+    uint32_t crc = ~0u;
+    while (n--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; ++i) crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+    }
+    return ~crc;
+}
+
+}  // namespace
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("crc32c", "[integrity]")
+{
+    // The standard check value
+    REQUIRE(0xE3069283 == crc32c("123456789", 9));
+    REQUIRE(0xE3069283 == crc32c_sw("123456789", 9));
+    REQUIRE(0 == crc32c(nullptr, 0));
+
+    std::vector<uint8_t> buf(1031);
+    for (size_t i = 0; i < buf.size(); ++i) buf[i] = uint8_t(i * 31 + 7);
+
+    // Every length and alignment through the word-at-a-time loops
+    for (size_t off = 0; off < 8; ++off) {
+        for (size_t n = 0; n < 40; ++n) {
+            auto ref = crc32c_ref(&buf[off], n);
+            REQUIRE(ref == crc32c(&buf[off], n));
+            REQUIRE(ref == crc32c_sw(&buf[off], n));
+        }
+    }
+
+    auto ref = crc32c_ref(buf.data(), buf.size());
+    REQUIRE(ref == crc32c(buf.data(), buf.size()));
+    REQUIRE(ref == crc32c_sw(buf.data(), buf.size()));
+
+    // In pieces
+    auto crc = crc32c(buf.data(), 100);
+    REQUIRE(ref == crc32c(buf.data() + 100, buf.size() - 100, crc));
+    crc = crc32c_sw(buf.data(), 13);
+    REQUIRE(ref == crc32c_sw(buf.data() + 13, buf.size() - 13, crc));
+}
+
+TEST_CASE("payload_integrity format", "[integrity]")
+{
+    char buf[payload_integrity::VALUE_LEN];
+    payload_integrity::format(0xE3069283, buf);
+    REQUIRE("e3069283" == std::string(buf, sizeof(buf)));
+
+    payload_integrity::format(0x1A, buf);
+    REQUIRE("0000001a" == std::string(buf, sizeof(buf)));
+}
+
+TEST_CASE("payload_integrity check", "[integrity]")
+{
+    const std::string TOPIC{"a/b"}, PAYLOAD{"123456789"};
+
+    SECTION("valid")
+    {
+        properties props;
+        payload_integrity::add(props, PAYLOAD.data(), PAYLOAD.size());
+        REQUIRE(payload_integrity::has_checksum(props.c_struct()));
+        auto prop = get<string_pair>(props, property::USER_PROPERTY, 0);
+        REQUIRE("e3069283" == std::get<1>(prop));
+
+        message msg{TOPIC, PAYLOAD, 1, false, props};
+        message_view view{TOPIC, msg.c_struct()};
+        REQUIRE(payload_integrity::VALID == payload_integrity::check(view));
+    }
+
+    SECTION("corrupt")
+    {
+        properties props;
+        payload_integrity::add(props, PAYLOAD.data(), PAYLOAD.size());
+
+        message msg{TOPIC, "123456780", 1, false, props};
+        message_view view{TOPIC, msg.c_struct()};
+        REQUIRE(payload_integrity::CORRUPT == payload_integrity::check(view));
+    }
+
+    SECTION("unchecked")
+    {
+        properties props{{property::USER_PROPERTY, "other", "x"}};
+        REQUIRE(!payload_integrity::has_checksum(props.c_struct()));
+
+        message msg{TOPIC, PAYLOAD, 1, false, props};
+        message_view view{TOPIC, msg.c_struct()};
+        REQUIRE(payload_integrity::UNCHECKED == payload_integrity::check(view));
+    }
+
+    SECTION("c properties")
+    {
+        MQTTProperties cprops = MQTTProperties_initializer;
+        payload_integrity::add(cprops, PAYLOAD.data(), PAYLOAD.size());
+        REQUIRE(payload_integrity::has_checksum(cprops));
+
+        properties props{cprops};
+        MQTTProperties_free(&cprops);
+
+        message msg{TOPIC, PAYLOAD, 1, false, props};
+        message_view view{TOPIC, msg.c_struct()};
+        REQUIRE(payload_integrity::VALID == payload_integrity::check(view));
+    }
+}
+
+TEST_CASE("async_client payload integrity", "[integrity]")
+{
+    async_client cli{"tcp://localhost:1883", "test_payload_integrity"};
+
+    REQUIRE(!cli.get_payload_integrity());
+    cli.set_payload_integrity(true);
+    REQUIRE(cli.get_payload_integrity());
+    REQUIRE(0 == cli.num_corrupt_messages());
+    cli.set_payload_integrity(false);
+    REQUIRE(!cli.get_payload_integrity());
+}
@@ -306,3 +306,39 @@ TEST_CASE("persistence", "[persistence]")
     dcp::persistence_clear(handle_);
     dcp::persistence_close(handle_);
 }
+
+// ----------------------------------------------------------------------
+// Test the C struct, which calls through the static methods
+// ----------------------------------------------------------------------
+
+TEST_CASE("persistence c_struct", "[persistence]")
+{
+    dcp per;
+    auto pers = iclient_persistence::c_struct(&per);
+
+    REQUIRE(pers.context == dynamic_cast<iclient_persistence*>(&per));
+
+    void* handle = nullptr;
+    REQUIRE(MQTTASYNC_SUCCESS == pers.popen(&handle, CLIENT_ID, SERVER_URI, pers.context));
+
+    const char* bufs[] = {PAYLOAD, PAYLOAD2};
+    int buflens[] = {int(PAYLOAD_LEN), int(PAYLOAD2_LEN)};
+
+    REQUIRE(
+        MQTTASYNC_SUCCESS ==
+        pers.pput(handle, const_cast<char*>(KEY), 2, const_cast<char**>(bufs), buflens)
+    );
+    REQUIRE(MQTTASYNC_SUCCESS == pers.pcontainskey(handle, const_cast<char*>(KEY)));
+
+    char* buf = nullptr;
+    int n = 0;
+    REQUIRE(MQTTASYNC_SUCCESS == pers.pget(handle, const_cast<char*>(KEY), &buf, &n));
+    REQUIRE(std::string(PAYLOAD) + PAYLOAD2 == std::string(buf, n));
+    persistence_free(buf);
+
+    REQUIRE(MQTTASYNC_SUCCESS == pers.premove(handle, const_cast<char*>(KEY)));
+    REQUIRE(
+        MQTTCLIENT_PERSISTENCE_ERROR == pers.pcontainskey(handle, const_cast<char*>(KEY))
+    );
+    REQUIRE(MQTTASYNC_SUCCESS == pers.pclose(handle));
+}
@@ -0,0 +1,146 @@
+// test_publish_combiner.cpp
+//
+// Unit tests for the publish_combiner class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mock_async_client.h"
+#include "mqtt/publish_combiner.h"
+
+using namespace mqtt;
+
+// ----------------------------------------------------------------------
+// A client that records the messages published through it, and rejects
+// the ones for the "bad" topic.
+
+class recording_client : public mock_async_client
+{
+public:
+    std::mutex lock;
+    std::vector<const_message_ptr> msgs;
+
+    using mock_async_client::publish;
+
+    delivery_token_ptr publish(const_message_ptr msg) override {
+        if (msg->get_topic() == "bad")
+            throw mqtt::exception(MQTTASYNC_BAD_QOS);
+        std::lock_guard<std::mutex> g(lock);
+        msgs.push_back(msg);
+        return delivery_token::create(*this, msg);
+    }
+};
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("publish_combiner single thread", "[combiner]")
+{
+    recording_client cli;
+    publish_combiner pub{cli};
+
+    REQUIRE(&cli == &pub.get_client());
+
+    auto tok = pub.publish("hello", "world", 1, false);
+    REQUIRE(tok);
+    REQUIRE("hello" == tok->get_message()->get_topic());
+
+    REQUIRE_THROWS_AS(pub.publish("bad", "data"), mqtt::exception);
+
+    REQUIRE(1 == cli.msgs.size());
+
+    auto st = pub.get_stats();
+    REQUIRE(2 == st.messages);
+    REQUIRE(2 == st.batches);
+    REQUIRE(1 == st.maxBatch);
+}
+
+TEST_CASE("publish_combiner keeps order per thread", "[combiner]")
+{
+    const int N_THREADS = 8, N_MSG = 500;
+
+    recording_client cli;
+    publish_combiner pub{cli, 4};
+
+    std::atomic<int> nTok{0};
+
+    std::vector<std::thread> thrs;
+    for (int i = 0; i < N_THREADS; ++i) {
+        thrs.emplace_back([&pub, &nTok, i] {
+            auto topic = "thread/" + std::to_string(i);
+            for (int j = 0; j < N_MSG; ++j) {
+                if (pub.publish(topic, std::to_string(j)))
+                    ++nTok;
+            }
+        });
+    }
+    for (auto& thr : thrs) thr.join();
+
+    REQUIRE(N_THREADS * N_MSG == nTok);
+
+    REQUIRE(size_t(N_THREADS * N_MSG) == cli.msgs.size());
+
+    std::map<std::string, int> next;
+    for (const auto& msg : cli.msgs) {
+        int n = std::stoi(msg->to_string());
+        REQUIRE(next[msg->get_topic()]++ == n);
+    }
+
+    auto st = pub.get_stats();
+    REQUIRE(uint64_t(N_THREADS * N_MSG) == st.messages);
+    REQUIRE(st.batches <= st.messages);
+}
+
+TEST_CASE("publish_combiner returns under steady load", "[combiner]")
+{
+    const int N_THREADS = 6, N_MSG = 200;
+
+    recording_client cli;
+    publish_combiner pub{cli, 2};
+
+    // Other threads keep publishing until this one is done, so there's
+    // always more work for whichever thread is combining.
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> thrs;
+    for (int i = 0; i < N_THREADS; ++i) {
+        thrs.emplace_back([&pub, &stop] {
+            while (!stop) pub.publish("load", "x");
+        });
+    }
+
+    for (int j = 0; j < N_MSG; ++j) REQUIRE(pub.publish("main", std::to_string(j)));
+
+    stop = true;
+    for (auto& thr : thrs) thr.join();
+
+    int n = 0;
+    for (const auto& msg : cli.msgs) {
+        if (msg->get_topic() == "main")
+            REQUIRE(n++ == std::stoi(msg->to_string()));
+    }
+    REQUIRE(N_MSG == n);
+    REQUIRE(pub.get_stats().maxBatch <= uint64_t(N_THREADS + 1));
+}
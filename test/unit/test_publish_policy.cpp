@@ -0,0 +1,143 @@
+// test_publish_policy.cpp
+//
+// Unit tests for the publish_policy class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+
+#include "catch2_version.h"
+#include "mqtt/publish_policy.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+static const string PAYLOAD{"payload"};
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("publish_policy default", "[publish_policy]")
+{
+    publish_policy policy;
+    auto msg = message::create("any/topic", PAYLOAD, 1, false);
+
+    REQUIRE(!policy.is_overloaded(1000000));
+    REQUIRE(publish_policy::PUBLISH == policy.decide(*msg, 1000000));
+    REQUIRE(1 == policy.get_metrics().published);
+}
+
+TEST_CASE("publish_policy backlog", "[publish_policy]")
+{
+    publish_policy policy;
+    policy.max_backlog(10).downgrade("telemetry/#").shed("debug/#");
+
+    auto tlm = message::create("telemetry/temp", PAYLOAD, 1, false);
+    auto dbg = message::create("debug/trace", PAYLOAD, 1, false);
+    auto crit = message::create("alarm/fire", PAYLOAD, 1, false);
+
+    SECTION("under the limit") {
+        REQUIRE(!policy.is_overloaded(9));
+        REQUIRE(publish_policy::PUBLISH == policy.decide(*tlm, 9));
+        REQUIRE(publish_policy::PUBLISH == policy.decide(*dbg, 9));
+        REQUIRE(publish_policy::PUBLISH == policy.decide(*crit, 9));
+        REQUIRE(3 == policy.get_metrics().published);
+    }
+
+    SECTION("at the limit") {
+        REQUIRE(policy.is_overloaded(10));
+        REQUIRE(publish_policy::PUBLISH_QOS0 == policy.decide(*tlm, 10));
+        REQUIRE(publish_policy::DROP == policy.decide(*dbg, 10));
+        REQUIRE(publish_policy::PUBLISH == policy.decide(*crit, 10));
+
+        auto m = policy.get_metrics();
+        REQUIRE(1 == m.published);
+        REQUIRE(1 == m.downgraded);
+        REQUIRE(1 == m.shed);
+        REQUIRE(0 == m.sampledOut);
+
+        policy.reset_metrics();
+        m = policy.get_metrics();
+        REQUIRE(0 == m.published);
+        REQUIRE(0 == m.downgraded);
+        REQUIRE(0 == m.shed);
+    }
+}
+
+TEST_CASE("publish_policy downgrade qos0", "[publish_policy]")
+{
+    publish_policy policy;
+    policy.max_backlog(1).downgrade("#");
+
+    // Nothing to downgrade
+    auto msg = message::create("topic", PAYLOAD, 0, false);
+    REQUIRE(publish_policy::PUBLISH == policy.decide(*msg, 5));
+    REQUIRE(0 == policy.get_metrics().downgraded);
+}
+
+TEST_CASE("publish_policy sample", "[publish_policy]")
+{
+    publish_policy policy;
+    policy.max_backlog(1).sample("sensor/+/raw", 4);
+
+    auto msg = message::create("sensor/12/raw", PAYLOAD, 1, false);
+
+    int n = 0;
+    for (int i = 0; i < 20; ++i) {
+        if (policy.decide(*msg, 1) == publish_policy::PUBLISH)
+            ++n;
+    }
+
+    REQUIRE(5 == n);
+    REQUIRE(15 == policy.get_metrics().sampledOut);
+}
+
+TEST_CASE("publish_policy first rule wins", "[publish_policy]")
+{
+    publish_policy policy;
+    policy.max_backlog(1).downgrade("data/important/#").shed("data/#");
+
+    auto imp = message::create("data/important/x", PAYLOAD, 1, false);
+    auto other = message::create("data/other", PAYLOAD, 1, false);
+
+    REQUIRE(publish_policy::PUBLISH_QOS0 == policy.decide(*imp, 1));
+    REQUIRE(publish_policy::DROP == policy.decide(*other, 1));
+}
+
+TEST_CASE("publish_policy latency", "[publish_policy]")
+{
+    publish_policy policy;
+    policy.max_latency(milliseconds(100)).shed("#");
+
+    auto msg = message::create("topic", PAYLOAD, 1, false);
+
+    REQUIRE(!policy.is_overloaded(0));
+    REQUIRE(publish_policy::PUBLISH == policy.decide(*msg, 0));
+
+    // The average moves toward the delivery times
+    for (int i = 0; i < 50; ++i) policy.on_delivered(milliseconds(500));
+
+    REQUIRE(policy.get_latency() >= milliseconds(100));
+    REQUIRE(policy.is_overloaded(0));
+    REQUIRE(publish_policy::DROP == policy.decide(*msg, 0));
+
+    for (int i = 0; i < 50; ++i) policy.on_delivered(milliseconds(1));
+
+    REQUIRE(!policy.is_overloaded(0));
+}
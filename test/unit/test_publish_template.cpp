@@ -0,0 +1,102 @@
+// test_publish_template.cpp
+//
+// Unit tests for the publish_template class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include "catch2_version.h"
+#include "mqtt/publish_template.h"
+
+using namespace mqtt;
+
+static const string TOPIC{"sensors/temp"};
+static const string CONTENT_TYPE{"application/json"};
+static const int QOS = 1;
+
+static const properties PROPS{
+    {property::CONTENT_TYPE, CONTENT_TYPE},
+    {property::MESSAGE_EXPIRY_INTERVAL, 60},
+    {property::USER_PROPERTY, "site", "north"}
+};
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("publish_template dflt", "[publish_template]")
+{
+    publish_template tmpl{TOPIC};
+
+    REQUIRE(TOPIC == tmpl.get_topic());
+    REQUIRE(message::DFLT_QOS == tmpl.get_qos());
+    REQUIRE(!tmpl.is_retained());
+    REQUIRE(tmpl.get_properties().empty());
+
+    const auto& c_struct = tmpl.c_struct();
+    REQUIRE(nullptr == c_struct.payload);
+    REQUIRE(0 == c_struct.payloadlen);
+}
+
+TEST_CASE("publish_template prepared struct", "[publish_template]")
+{
+    publish_template tmpl{TOPIC, QOS, true, PROPS};
+
+    REQUIRE(QOS == tmpl.get_qos());
+    REQUIRE(tmpl.is_retained());
+    REQUIRE(3 == tmpl.get_properties().size());
+
+    const auto& c_struct = tmpl.c_struct();
+    REQUIRE(QOS == c_struct.qos);
+    REQUIRE(c_struct.retained != 0);
+    REQUIRE(3 == c_struct.properties.count);
+    REQUIRE(tmpl.get_properties().c_struct().array == c_struct.properties.array);
+}
+
+TEST_CASE("publish_template copy", "[publish_template]")
+{
+    publish_template org{TOPIC, QOS, false, PROPS};
+    publish_template tmpl{org};
+
+    // The copy has its own properties, and the C struct points to them
+    const auto& c_struct = tmpl.c_struct();
+    REQUIRE(3 == c_struct.properties.count);
+    REQUIRE(tmpl.get_properties().c_struct().array == c_struct.properties.array);
+    REQUIRE(org.c_struct().properties.array != c_struct.properties.array);
+
+    publish_template tmpl2{"other"};
+    tmpl2 = org;
+    REQUIRE(TOPIC == tmpl2.get_topic());
+    REQUIRE(tmpl2.get_properties().c_struct().array == tmpl2.c_struct().properties.array);
+}
+
+TEST_CASE("publish_template bad qos", "[publish_template]")
+{
+    REQUIRE_THROWS_AS(publish_template(TOPIC, 3), exception);
+}
+
+TEST_CASE("publish_template to_message", "[publish_template]")
+{
+    publish_template tmpl{TOPIC, QOS, true, PROPS};
+    auto msg = tmpl.to_message("22.5");
+
+    REQUIRE(TOPIC == msg->get_topic());
+    REQUIRE("22.5" == msg->get_payload_str());
+    REQUIRE(QOS == msg->get_qos());
+    REQUIRE(msg->is_retained());
+    REQUIRE(CONTENT_TYPE == get<string>(msg->get_properties(), property::CONTENT_TYPE));
+}
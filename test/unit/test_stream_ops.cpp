@@ -0,0 +1,151 @@
+// test_stream_ops.cpp
+//
+// Unit tests for the stream operators in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/async_client.h"
+#include "mqtt/stream_ops.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("stream_ops filter and map", "[stream_ops]")
+{
+    std::vector<int> out;
+
+    auto pipeline = ops::filter_topic("data/#") |
+                    ops::map([](const const_message_ptr& msg) {
+                        return std::stoi(msg->to_string());
+                    }) |
+                    ops::filter([](int n) { return n % 2 == 0; });
+
+    auto stage = ops::make_stage(pipeline, [&out](int n) { out.push_back(n); });
+
+    for (int i = 0; i < 10; ++i) {
+        stage.push(make_message("data/x", std::to_string(i)));
+        stage.push(make_message("other/x", std::to_string(i)));
+    }
+    stage.finish();
+
+    REQUIRE(std::vector<int>{0, 2, 4, 6, 8} == out);
+}
+
+TEST_CASE("stream_ops batch by size", "[stream_ops]")
+{
+    std::vector<std::vector<int>> out;
+
+    auto stage = ops::make_stage<int>(ops::batch(3), [&out](std::vector<int> v) {
+        out.push_back(std::move(v));
+    });
+
+    for (int i = 0; i < 7; ++i) stage.push(i);
+    REQUIRE(2 == out.size());
+    REQUIRE(std::vector<int>{3, 4, 5} == out[1]);
+
+    stage.finish();
+    REQUIRE(3 == out.size());
+    REQUIRE(std::vector<int>{6} == out[2]);
+}
+
+TEST_CASE("stream_ops batch by time", "[stream_ops]")
+{
+    std::vector<std::vector<int>> out;
+
+    auto stage = ops::make_stage<int>(ops::batch(100, milliseconds(10)), [&out](auto v) {
+        out.push_back(std::move(v));
+    });
+
+    stage.push(1);
+    stage.push(2);
+    stage.tick(ops::clock::now());
+    REQUIRE(out.empty());
+
+    stage.tick(ops::clock::now() + milliseconds(20));
+    REQUIRE(1 == out.size());
+    REQUIRE(std::vector<int>{1, 2} == out[0]);
+}
+
+TEST_CASE("stream_ops tumbling window", "[stream_ops]")
+{
+    std::vector<std::vector<int>> out;
+
+    auto stage = ops::make_stage<int>(ops::tumbling(milliseconds(10)), [&out](auto v) {
+        out.push_back(std::move(v));
+    });
+
+    stage.push(1);
+    stage.push(2);
+    stage.tick(ops::clock::now() + milliseconds(20));
+    REQUIRE(1 == out.size());
+
+    // No empty windows
+    stage.tick(ops::clock::now() + milliseconds(40));
+    REQUIRE(1 == out.size());
+
+    stage.push(3);
+    stage.finish();
+    REQUIRE(2 == out.size());
+    REQUIRE(std::vector<int>{3} == out[1]);
+}
+
+TEST_CASE("stream_ops sliding window", "[stream_ops]")
+{
+    auto pipeline = ops::sliding(3, 2) | ops::map([](const std::vector<int>& v) {
+                        return v.front() + v.back();
+                    });
+
+    std::vector<int> sums;
+    auto stage = ops::make_stage<int>(pipeline, [&sums](int n) { sums.push_back(n); });
+
+    for (int i = 0; i < 7; ++i) stage.push(i);
+
+    // Windows: [0,1,2] (skipped, step 1), [1,2,3], [2,3,4] (skipped), [3,4,5], ...
+    REQUIRE(std::vector<int>{1 + 3, 3 + 5} == sums);
+}
+
+TEST_CASE("stream_ops run on consumer", "[stream_ops]")
+{
+    async_client cli{"mqtt://localhost:1883", "stream_ops_test"};
+    cli.start_consuming();
+
+    int nMsg = 0, nBatch = 0;
+    std::thread thr([&] {
+        ops::run(cli, ops::batch(10, milliseconds(5)), [&](std::vector<const_message_ptr> v) {
+            ++nBatch;
+            nMsg += int(v.size());
+        });
+    });
+
+    std::this_thread::sleep_for(milliseconds(20));
+    cli.stop_consuming();
+    thr.join();
+
+    REQUIRE(0 == nMsg);
+    REQUIRE(0 == nBatch);
+}
@@ -0,0 +1,129 @@
+// test_subscription_cover.cpp
+//
+// Unit tests for the subscription_cover class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <string>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/subscription_cover.h"
+
+using namespace mqtt;
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("subscription_cover subsumes", "[subscription]")
+{
+    using sc = subscription_cover;
+
+    REQUIRE(sc::subsumes("a/b", "a/b"));
+    REQUIRE(sc::subsumes("a/#", "a/b/+"));
+    REQUIRE(sc::subsumes("a/#", "a"));
+    REQUIRE(sc::subsumes("a/#", "a/#"));
+    REQUIRE(sc::subsumes("a/+", "a/b"));
+    REQUIRE(sc::subsumes("a/+", "a/+"));
+    REQUIRE(sc::subsumes("+/+/c", "a/+/c"));
+    REQUIRE(sc::subsumes("#", "a/b/c"));
+    REQUIRE(sc::subsumes("a/+/#", "a/b/c/d"));
+
+    REQUIRE(!sc::subsumes("a/b/+", "a/#"));
+    REQUIRE(!sc::subsumes("a/+", "a/#"));
+    REQUIRE(!sc::subsumes("a/+", "a"));
+    REQUIRE(!sc::subsumes("a/+", "a/b/c"));
+    REQUIRE(!sc::subsumes("a/+/c", "a/b/+"));
+    REQUIRE(!sc::subsumes("a/+/#", "a"));
+    REQUIRE(!sc::subsumes("a/b", "a/+"));
+    REQUIRE(!sc::subsumes("#", "$SYS/x"));
+    REQUIRE(!sc::subsumes("+/x", "$SYS/x"));
+    REQUIRE(sc::subsumes("$SYS/#", "$SYS/x"));
+}
+
+TEST_CASE("subscription_cover cover", "[subscription]")
+{
+    subscription_set subs;
+    subs.add("a/#", 0)
+        .add("a/b/+", 2)
+        .add("a/b/c", 1)
+        .add("a/+/c", 1)
+        .add("x/y", 1)
+        .add("x/+", 1, subscribe_options{true});
+
+    subscription_cover cover{subs};
+
+    REQUIRE(6 == cover.logical().size());
+
+    // Everything under 'a' collapses into 'a/#'. The 'x' filters have
+    // different options, so both stay.
+    const auto& cov = cover.cover();
+    REQUIRE(3 == cov.size());
+    REQUIRE(cov.contains("a/#"));
+    REQUIRE(cov.contains("x/y"));
+    REQUIRE(cov.contains("x/+"));
+    REQUIRE(3 == cover.num_redundant());
+
+    // The covering filter takes the highest QoS
+    REQUIRE(2 == cov.find("a/#")->qos);
+
+    REQUIRE(1 == cover.subscription_id("a/#"));
+    REQUIRE(2 == cover.subscription_id("x/+"));
+    REQUIRE(3 == cover.subscription_id("x/y"));
+    REQUIRE(0 == cover.subscription_id("a/b/c"));
+
+    std::vector<string> expected{"a/#", "a/+/c", "a/b/+", "a/b/c"};
+    REQUIRE(expected == cover.matches("a/b/c"));
+    REQUIRE(std::vector<string>{"a/#"} == cover.matches("a"));
+    REQUIRE(cover.matches("b/c").empty());
+}
+
+TEST_CASE("subscription_cover duplicates", "[subscription]")
+{
+    subscription_set subs;
+    subs.add("a/+/c", 1).add("a/b/+", 1);
+
+    // Neither subsumes the other, so a message on 'a/b/c' comes twice
+    subscription_cover cover{subs};
+    REQUIRE(2 == cover.cover().size());
+
+    int id1 = cover.subscription_id("a/+/c"), id2 = cover.subscription_id("a/b/+");
+    REQUIRE(1 == id1);
+    REQUIRE(2 == id2);
+
+    properties p1{{property::SUBSCRIPTION_IDENTIFIER, id1}};
+    properties p2{{property::SUBSCRIPTION_IDENTIFIER, id2}};
+    properties both{
+        {property::SUBSCRIPTION_IDENTIFIER, id1}, {property::SUBSCRIPTION_IDENTIFIER, id2}
+    };
+
+    REQUIRE(!cover.is_duplicate("a/b/c", p1));
+    REQUIRE(cover.is_duplicate("a/b/c", p2));
+    REQUIRE(!cover.is_duplicate("a/b/c", both));
+
+    // Only one subscription matches these
+    REQUIRE(!cover.is_duplicate("a/b/d", p2));
+    REQUIRE(!cover.is_duplicate("a/x/c", p1));
+
+    // No identifiers, so it can't tell
+    REQUIRE(!cover.is_duplicate("a/b/c", properties{}));
+
+    auto msg = message::create("a/b/c", "hello", 1, false, p2);
+    REQUIRE(cover.is_duplicate(*msg));
+}
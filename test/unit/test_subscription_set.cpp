@@ -0,0 +1,101 @@
+// test_subscription_set.cpp
+//
+// Unit tests for the subscription_set class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/subscription_set.h"
+
+using namespace mqtt;
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("subscription_set add remove", "[subscription]")
+{
+    subscription_set subs;
+    REQUIRE(subs.empty());
+
+    subs.add("a/b", 1).add("c/#", 2, subscribe_options{true});
+    REQUIRE(2 == subs.size());
+    REQUIRE(subs.contains("a/b"));
+    REQUIRE(!subs.contains("a/c"));
+
+    auto ent = subs.find("c/#");
+    REQUIRE(ent);
+    REQUIRE(2 == ent->qos);
+    REQUIRE(ent->opts.get_no_local());
+    REQUIRE(nullptr == subs.find("x"));
+
+    // Adding again replaces the QoS and options
+    subs.add("c/#", 0);
+    REQUIRE(2 == subs.size());
+    REQUIRE(0 == subs.find("c/#")->qos);
+    REQUIRE(!subs.find("c/#")->opts.get_no_local());
+
+    REQUIRE(subs.remove("a/b"));
+    REQUIRE(!subs.remove("a/b"));
+    REQUIRE(1 == subs.size());
+
+    subs.clear();
+    REQUIRE(subs.empty());
+
+    subscription_set coll{string_collection{"x", "y", "x"}, 1};
+    REQUIRE(2 == coll.size());
+    REQUIRE(1 == coll.find("y")->qos);
+}
+
+TEST_CASE("subscription_set diff", "[subscription]")
+{
+    subscription_set cur;
+    cur.add("a", 1).add("b", 1).add("c", 1).add("d", 1, subscribe_options{true});
+
+    subscription_set desired;
+    desired.add("b", 1).add("c", 2).add("d", 1).add("e", 0);
+
+    auto chg = cur.diff(desired);
+    REQUIRE(!chg.empty());
+
+    // 'a' is gone
+    REQUIRE(1 == chg.unsubscribe.size());
+    REQUIRE("a" == chg.unsubscribe[0]);
+
+    // 'c' has a new QoS, 'd' new options, and 'e' is new
+    REQUIRE(3 == chg.subscribe.size());
+    REQUIRE(2 == chg.subscribe.find("c")->qos);
+    REQUIRE(!chg.subscribe.find("d")->opts.get_no_local());
+    REQUIRE(chg.subscribe.contains("e"));
+    REQUIRE(!chg.subscribe.contains("b"));
+
+    cur.apply(chg);
+    REQUIRE(cur.diff(desired).empty());
+    REQUIRE(4 == cur.size());
+
+    // To and from an empty set
+    auto all = subscription_set{}.diff(desired);
+    REQUIRE(all.unsubscribe.empty());
+    REQUIRE(4 == all.subscribe.size());
+
+    auto none = desired.diff(subscription_set{});
+    REQUIRE(none.subscribe.empty());
+    REQUIRE(4 == none.unsubscribe.size());
+}
@@ -185,3 +185,77 @@ TEST_CASE("thread_queue close_signals", "[thread_queue]")
 
     thr.join();
 }
+
+TEST_CASE("thread_queue get_spin", "[thread_queue]")
+{
+    thread_queue<int> que;
+    int n = 0;
+
+    // An item already in the queue comes right out
+    que.put(1);
+    REQUIRE(que.get_spin(&n, 100us));
+    REQUIRE(n == 1);
+
+    // Items that arrive while spinning, or after the consumer blocks
+    const int N = 1000;
+    auto thr = std::thread([&que] {
+        for (int i = 0; i < N; ++i) {
+            if (i % 100 == 0)
+                std::this_thread::sleep_for(1ms);
+            que.put(i);
+        }
+    });
+
+    for (int i = 0; i < N; ++i) {
+        REQUIRE(que.get_spin(&n, 20us));
+        REQUIRE(n == i);
+    }
+    thr.join();
+
+    // A closed, empty queue fails, whether spinning or blocked
+    auto thr2 = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.close();
+    });
+    REQUIRE(!que.get_spin(&n, 50us));
+    REQUIRE(!que.get_spin(&n, 50us));
+    thr2.join();
+}
+
+TEST_CASE("thread_queue bounded mt", "[thread_queue]")
+{
+    // Producers and consumers both block, and must all be woken
+    const int N = 2000, N_THR = 4;
+    thread_queue<int> que{2};
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < N_THR; ++i) {
+        producers.emplace_back([&que] {
+            for (int j = 0; j < N; ++j) que.put(j);
+        });
+    }
+
+    std::vector<std::future<long>> consumers;
+    for (int i = 0; i < N_THR; ++i) {
+        consumers.push_back(std::async(std::launch::async, [&que, i] {
+            long sum = 0;
+            int n;
+            for (int j = 0; j < N; ++j) {
+                if (i % 2)
+                    que.get(&n);
+                else
+                    que.get_spin(&n, 10us);
+                sum += n;
+            }
+            return sum;
+        }));
+    }
+
+    for (auto& thr : producers) thr.join();
+
+    long sum = 0;
+    for (auto& f : consumers) sum += f.get();
+
+    REQUIRE(sum == long(N_THR) * (N - 1) * N / 2);
+    REQUIRE(que.empty());
+}
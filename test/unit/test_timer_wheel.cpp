@@ -0,0 +1,155 @@
+// test_timer_wheel.cpp
+//
+// Unit tests for the timer_wheel class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mock_async_client.h"
+#include "mqtt/timer_wheel.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+static mock_async_client cli;
+
+static constexpr token::Type TYPE = token::Type::PUBLISH;
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("timer_wheel expires token", "[timer_wheel]")
+{
+    std::promise<token_ptr> prom;
+    auto fut = prom.get_future();
+
+    timer_wheel wheel{[&prom](token_ptr tok) { prom.set_value(std::move(tok)); }};
+    REQUIRE(wheel.empty());
+
+    auto tok = token::create(TYPE, cli);
+    auto start = steady_clock::now();
+    wheel.schedule(tok, 20ms);
+    REQUIRE(1 == wheel.size());
+
+    REQUIRE(fut.wait_for(2s) == std::future_status::ready);
+    REQUIRE(steady_clock::now() - start >= 20ms);
+    REQUIRE(fut.get() == tok);
+    REQUIRE(wheel.empty());
+}
+
+TEST_CASE("timer_wheel expires across levels", "[timer_wheel]")
+{
+    std::promise<steady_clock::time_point> prom;
+    auto fut = prom.get_future();
+
+    timer_wheel wheel{[&prom](token_ptr) { prom.set_value(steady_clock::now()); }};
+
+    // Beyond the range of the lowest level, so it must cascade down.
+    auto tok = token::create(TYPE, cli);
+    auto deadline = steady_clock::now() + 150ms;
+    wheel.schedule(tok, deadline);
+
+    REQUIRE(fut.wait_for(2s) == std::future_status::ready);
+    REQUIRE(fut.get() >= deadline);
+    REQUIRE(wheel.empty());
+}
+
+TEST_CASE("timer_wheel expires in order", "[timer_wheel]")
+{
+    std::mutex mtx;
+    std::vector<token_ptr> expired;
+    std::promise<void> prom;
+
+    timer_wheel wheel{[&](token_ptr tok) {
+        std::lock_guard<std::mutex> g(mtx);
+        expired.push_back(std::move(tok));
+        if (expired.size() == 3)
+            prom.set_value();
+    }};
+
+    auto tok1 = token::create(TYPE, cli), tok2 = token::create(TYPE, cli),
+         tok3 = token::create(TYPE, cli);
+
+    wheel.schedule(tok3, 90ms);
+    wheel.schedule(tok1, 10ms);
+    wheel.schedule(tok2, 40ms);
+
+    REQUIRE(prom.get_future().wait_for(2s) == std::future_status::ready);
+
+    std::lock_guard<std::mutex> g(mtx);
+    REQUIRE(expired[0] == tok1);
+    REQUIRE(expired[1] == tok2);
+    REQUIRE(expired[2] == tok3);
+}
+
+TEST_CASE("timer_wheel cancel", "[timer_wheel]")
+{
+    std::atomic<int> n{0};
+    timer_wheel wheel{[&n](token_ptr) { ++n; }};
+
+    auto tok = token::create(TYPE, cli);
+    wheel.schedule(tok, 10ms);
+    REQUIRE(2 == tok.use_count());
+
+    REQUIRE(wheel.cancel(tok.get()));
+    REQUIRE(wheel.empty());
+    REQUIRE(1 == tok.use_count());
+
+    // Not in the wheel any more
+    REQUIRE(!wheel.cancel(tok.get()));
+
+    std::this_thread::sleep_for(40ms);
+    REQUIRE(0 == n);
+}
+
+TEST_CASE("timer_wheel reschedule", "[timer_wheel]")
+{
+    std::atomic<int> n{0};
+    timer_wheel wheel{[&n](token_ptr) { ++n; }};
+
+    auto tok = token::create(TYPE, cli);
+    wheel.schedule(tok, 10ms);
+    wheel.schedule(tok, 1h);
+
+    REQUIRE(1 == wheel.size());
+    REQUIRE(2 == tok.use_count());
+
+    std::this_thread::sleep_for(40ms);
+    REQUIRE(0 == n);
+}
+
+TEST_CASE("timer_wheel releases tokens on destruction", "[timer_wheel]")
+{
+    auto tok = token::create(TYPE, cli);
+    {
+        timer_wheel wheel{[](token_ptr) {}};
+
+        // Far past the range of the wheel
+        wheel.schedule(tok, hours(24 * 365));
+        REQUIRE(2 == tok.use_count());
+    }
+    REQUIRE(1 == tok.use_count());
+}
@@ -28,6 +28,8 @@
 #define UNIT_TESTS
 
 #include <cstring>
+#include <stdexcept>
+#include <vector>
 
 #include "catch2_version.h"
 #include "mock_action_listener.h"
@@ -358,3 +360,193 @@ TEST_CASE("token wait for timeout", "[token]")
         FAIL("token::wait_until() should not throw on timeout");
     }
 }
+
+// ----------------------------------------------------------------------
+// Test completion from an expired deadline
+// ----------------------------------------------------------------------
+
+TEST_CASE("token deadline timeout", "[token]")
+{
+    mock_action_listener listener;
+    mqtt::token tok{TYPE, cli};
+    tok.set_action_callback(listener);
+
+    REQUIRE(!tok.is_timed_out());
+    REQUIRE(mock_async_client::expire(&tok));
+
+    REQUIRE(tok.is_complete());
+    REQUIRE(tok.is_timed_out());
+    REQUIRE(listener.failed());
+    REQUIRE(MQTTASYNC_FAILURE == tok.get_return_code());
+    REQUIRE_THROWS_AS(tok.wait(), mqtt::timeout_error);
+
+    // Only the first completion counts.
+    REQUIRE(!mock_async_client::expire(&tok));
+
+    // A late response from the library doesn't change the result.
+    mock_async_client::succeed(&tok, nullptr);
+    REQUIRE(tok.is_timed_out());
+    REQUIRE_THROWS_AS(tok.wait(), mqtt::timeout_error);
+}
+
+TEST_CASE("token deadline after complete", "[token]")
+{
+    mqtt::token tok{TYPE, cli};
+    mock_async_client::succeed(&tok, nullptr);
+
+    REQUIRE(!mock_async_client::expire(&tok));
+    REQUIRE(!tok.is_timed_out());
+    REQUIRE_NOTHROW(tok.wait());
+}
+
+// ----------------------------------------------------------------------
+// Test continuations
+// ----------------------------------------------------------------------
+
+TEST_CASE("token then on success", "[token]")
+{
+    mqtt::token tok{TYPE, cli};
+    int n = 0;
+
+    auto last = tok.then([&n](mqtt::token&) { n += 1; })->then([&n](mqtt::token&) {
+        n *= 10;
+    });
+    REQUIRE(0 == n);
+    REQUIRE(!last->is_complete());
+
+    mock_async_client::succeed(&tok, nullptr);
+    REQUIRE(10 == n);
+    REQUIRE(last->is_complete());
+    REQUIRE(MQTTASYNC_SUCCESS == last->get_return_code());
+    REQUIRE_NOTHROW(last->wait());
+}
+
+TEST_CASE("token then on failure", "[token]")
+{
+    mqtt::token tok{TYPE, cli};
+    bool thenRan = false;
+    int rc = 0;
+
+    auto next = tok.then([&](mqtt::token&) { thenRan = true; });
+    next->on_complete([&](mqtt::token& t) { rc = t.get_return_code(); });
+
+    MQTTAsync_failureData data = {};
+    data.code = MQTTASYNC_FAILURE;
+    data.message = "Failed";
+    mock_async_client::fail(&tok, &data);
+
+    // The failure passes down the pipeline, skipping the step
+    REQUIRE(!thenRan);
+    REQUIRE(MQTTASYNC_FAILURE == rc);
+    REQUIRE(next->is_complete());
+    REQUIRE("Failed" == next->get_error_message());
+    REQUIRE_THROWS(next->wait());
+}
+
+TEST_CASE("token then step throws", "[token]")
+{
+    mqtt::token tok{TYPE, cli};
+    bool bRan = false, cRan = false;
+
+    auto last = tok.then([](mqtt::token&) { throw std::runtime_error("step a"); })
+                    ->then([&bRan](mqtt::token&) { bRan = true; });
+    last->on_complete([&cRan](mqtt::token& t) { cRan = !t; });
+
+    mock_async_client::succeed(&tok, nullptr);
+
+    // The step after the throw doesn't run, and the failure reaches the end
+    REQUIRE(!bRan);
+    REQUIRE(cRan);
+    REQUIRE(MQTTASYNC_FAILURE == last->get_return_code());
+    REQUIRE("step a" == last->get_error_message());
+}
+
+TEST_CASE("token then after complete", "[token]")
+{
+    mqtt::token tok{TYPE, cli};
+    mock_async_client::succeed(&tok, nullptr);
+
+    bool ran = false;
+    auto next = tok.then([&ran](mqtt::token&) { ran = true; });
+    REQUIRE(ran);
+    REQUIRE(next->is_complete());
+}
+
+TEST_CASE("token on_complete on timeout", "[token]")
+{
+    mqtt::token tok{TYPE, cli};
+    bool thenRan = false, timedOut = false;
+
+    tok.then([&](mqtt::token&) { thenRan = true; });
+    tok.on_complete([&](mqtt::token& t) { timedOut = t.is_timed_out(); });
+
+    mock_async_client::expire(&tok);
+    REQUIRE(!thenRan);
+    REQUIRE(timedOut);
+}
+
+TEST_CASE("token on_complete", "[token]")
+{
+    mqtt::token tok{TYPE, cli};
+    int n = 0;
+
+    // These attach to the same token, in order, without a new token
+    auto& ret = tok.on_complete([&n](mqtt::token&) { n += 1; })
+                    .on_complete([&n](mqtt::token& t) { n *= t ? 1 : 10; });
+    REQUIRE(&tok == &ret);
+
+    MQTTAsync_failureData data = {};
+    data.code = MQTTASYNC_FAILURE;
+    mock_async_client::fail(&tok, &data);
+    REQUIRE(10 == n);
+}
+
+TEST_CASE("token then with executor", "[token]")
+{
+    struct queue_executor : public mqtt::executor
+    {
+        std::vector<mqtt::continuation_task> tasks;
+        void execute(mqtt::continuation_task task) override {
+            tasks.push_back(std::move(task));
+        }
+    };
+
+    queue_executor exec;
+    auto tok = mqtt::token::create(TYPE, cli);
+    bool ran = false;
+
+    tok->then([&ran](mqtt::token&) { ran = true; }, exec);
+    mock_async_client::succeed(tok.get(), nullptr);
+
+    // Queued, with the task holding the token alive.
+    REQUIRE(!ran);
+    REQUIRE(1 == exec.tasks.size());
+    REQUIRE(exec.tasks[0].get_token() == tok);
+
+    exec.tasks[0]();
+    REQUIRE(ran);
+}
+
+TEST_CASE("token continuation storage", "[token]")
+{
+    int a = 0, b = 0;
+    auto small = [&a, &b](mqtt::token&) { a = b; };
+    REQUIRE(mqtt::continuation::is_inline<decltype(small)>());
+
+    char big[256] = {};
+    auto large = [big](mqtt::token&) { (void)big; };
+    REQUIRE(!mqtt::continuation::is_inline<decltype(large)>());
+
+    // Both kinds survive a move
+    mqtt::token tok{TYPE, cli};
+    mqtt::continuation c1{small}, c2{large};
+    mqtt::continuation m1{std::move(c1)}, m2{std::move(c2)};
+    REQUIRE(!c1);
+    REQUIRE(m1);
+    REQUIRE(m2);
+
+    b = 42;
+    m1(tok);
+    m2(tok);
+    REQUIRE(42 == a);
+}
@@ -91,3 +91,22 @@ TEST_CASE("matcher matches", "[topic_matcher]")
     REQUIRE(!(topic_matcher<int>{{"$BOB/bar", 42}}.has_match("$SYS/bar")));
     REQUIRE(!(topic_matcher<int>{{"+/bar", 42}}.has_match("$SYS/bar")));
 }
+
+TEST_CASE("matcher matches parent and multi-level", "[topic_matcher]")
+{
+    topic_matcher<int> tm{{"foo/bar", 1}, {"foo/bar/#", 2}, {"foo/#", 3}};
+
+    int n = 0, sum = 0;
+    for (auto it = tm.matches("foo/bar"); it != tm.matches_cend(); ++it) {
+        ++n;
+        sum += it->second;
+    }
+    REQUIRE(3 == n);
+    REQUIRE(6 == sum);
+
+    // A removed '#' leaves an empty node, which doesn't end the search
+    tm.remove("foo/#");
+    n = 0;
+    for (auto it = tm.matches("foo/bar"); it != tm.matches_cend(); ++it) ++n;
+    REQUIRE(2 == n);
+}
@@ -0,0 +1,154 @@
+// test_topic_template.cpp
+//
+// Unit tests for the topic_template class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <stdexcept>
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/topic_template.h"
+
+using namespace mqtt;
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("topic_template parse", "[topic]")
+{
+    topic_template tmpl{"site/{site}/dev/{id}/temp"};
+
+    REQUIRE("site/{site}/dev/{id}/temp" == tmpl.pattern());
+    REQUIRE(2 == tmpl.num_args());
+    REQUIRE("site" == tmpl.arg_names()[0]);
+    REQUIRE("id" == tmpl.arg_names()[1]);
+
+    // A repeated placeholder is one argument
+    topic_template rep{"{id}/status/{id}"};
+    REQUIRE(1 == rep.num_args());
+
+    topic_template fixed{"a/b/c"};
+    REQUIRE(0 == fixed.num_args());
+
+    REQUIRE_THROWS_AS(topic_template{""}, std::invalid_argument);
+    REQUIRE_THROWS_AS(topic_template{"site/+/temp"}, std::invalid_argument);
+    REQUIRE_THROWS_AS(topic_template{"site/#"}, std::invalid_argument);
+    REQUIRE_THROWS_AS(topic_template{"site/{id/temp"}, std::invalid_argument);
+    REQUIRE_THROWS_AS(topic_template{"site/id}/temp"}, std::invalid_argument);
+    REQUIRE_THROWS_AS(topic_template{"site/{}/temp"}, std::invalid_argument);
+    REQUIRE_THROWS_AS(topic_template{"site/{a-b}/temp"}, std::invalid_argument);
+}
+
+TEST_CASE("topic_template format", "[topic]")
+{
+    topic_template tmpl{"site/{site}/dev/{id}/temp"};
+
+    REQUIRE("site/north/dev/42/temp" == tmpl.format({"north", "42"}).str());
+    REQUIRE("site/north/dev/42/temp" == tmpl("north", 42).str());
+    REQUIRE("site/south/dev/-7/temp" == tmpl(string{"south"}, -7).str());
+    REQUIRE("site/x/dev/y/temp" == tmpl(string_ref{"x"}, "y").str());
+
+    topic_template rep{"{id}/status/{id}-ack"};
+    REQUIRE("17/status/17-ack" == rep(17).str());
+
+    topic_template fixed{"a/b/c"};
+    REQUIRE("a/b/c" == fixed().str());
+
+    SECTION("bad arguments")
+    {
+        REQUIRE_THROWS_AS(tmpl("north"), std::invalid_argument);
+        REQUIRE_THROWS_AS(tmpl("north", 1, 2), std::invalid_argument);
+        REQUIRE_THROWS_AS(tmpl("a/b", 1), std::invalid_argument);
+        REQUIRE_THROWS_AS(tmpl("+", 1), std::invalid_argument);
+        REQUIRE_THROWS_AS(tmpl("#", 1), std::invalid_argument);
+        REQUIRE_THROWS_AS(tmpl(string{"a\0b", 3}, 1), std::invalid_argument);
+    }
+
+    SECTION("format_to")
+    {
+        std::string_view args[] = {"east", "9"};
+        string out{"prefix:"};
+        tmpl.format_to(out, args, 2);
+        REQUIRE("prefix:site/east/dev/9/temp" == out);
+    }
+}
+
+TEST_CASE("topic_template pool", "[topic]")
+{
+    topic_template tmpl{"dev/{id}"};
+    REQUIRE(0 == tmpl.pool_size());
+
+    const char* data;
+    {
+        auto t = tmpl(1);
+        data = t.data();
+        REQUIRE(0 == tmpl.pool_size());
+    }
+    // The buffer went back to the pool, and is reused
+    REQUIRE(1 == tmpl.pool_size());
+
+    auto t = tmpl(2);
+    REQUIRE(data == t.data());
+    REQUIRE("dev/2" == t.str());
+    REQUIRE(0 == tmpl.pool_size());
+
+    // A topic can outlive its template
+    string_ref kept;
+    {
+        topic_template tmp{"tmp/{id}"};
+        kept = tmp(3);
+    }
+    REQUIRE("tmp/3" == kept.str());
+}
+
+TEST_CASE("topic_template cache", "[topic]")
+{
+    topic_template tmpl{"site/{site}/dev/{id}", 2};
+
+    auto a = tmpl("n", 1);
+    auto b = tmpl("n", 1);
+    REQUIRE(a.data() == b.data());
+    REQUIRE(1 == tmpl.cache_hits());
+    REQUIRE(1 == tmpl.cache_size());
+
+    // The argument boundaries are part of the key
+    auto c = tmpl("n1", "");
+    REQUIRE("site/n1/dev/" == c.str());
+    REQUIRE(1 == tmpl.cache_hits());
+    REQUIRE(2 == tmpl.cache_size());
+
+    // The least recently used topic is evicted
+    tmpl("n", 1);
+    tmpl("s", 2);
+    REQUIRE(2 == tmpl.cache_size());
+    REQUIRE(2 == tmpl.cache_hits());
+
+    auto d = tmpl("n", 1);
+    REQUIRE(a.data() == d.data());
+    REQUIRE(3 == tmpl.cache_hits());
+
+    tmpl("n1", "");
+    REQUIRE(3 == tmpl.cache_hits());
+
+    // Copies share the cache
+    topic_template copy{tmpl};
+    copy("n1", "");
+    REQUIRE(4 == tmpl.cache_hits());
+}
@@ -0,0 +1,82 @@
+// test_util.h
+//
+// Helpers shared by the unit tests in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#ifndef __mqtt_test_util_h
+#define __mqtt_test_util_h
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#if defined(TEST_EMBEDDED_BROKER)
+    #include "embedded_broker.h"
+#endif
+
+namespace mqtt {
+namespace test {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Waits for a condition that another thread makes true.
+ * @param cond The condition, as a callable returning a bool.
+ * @param timeout The longest time to wait.
+ * @return @em true if the condition became true, @em false if the wait
+ *  	   timed out.
+ */
+template <typename F>
+bool wait_for(F cond, std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+    auto until = std::chrono::steady_clock::now() + timeout;
+    while (!cond()) {
+        if (std::chrono::steady_clock::now() > until)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+/**
+ * Gets the URI of the broker for the tests that need a live connection.
+ *
+ * With TEST_EXTERNAL_SERVER this is one of the public brokers. When the
+ * embedded test broker is built, it's started the first time a test asks
+ * for it, and is shared by the rest of the tests in the run. Otherwise
+ * this expects a broker on the local host.
+ *
+ * @return The URI of the broker.
+ */
+inline const std::string& server_uri() {
+#if defined(TEST_EXTERNAL_SERVER)
+    static const std::string uri{"tcp://mqtt.eclipseprojects.io:1883"};
+#elif defined(TEST_EMBEDDED_BROKER)
+    static embedded_broker broker;
+    static const std::string uri{broker.uri()};
+#else
+    static const std::string uri{"tcp://localhost:1883"};
+#endif
+    return uri;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace test
+}  // namespace mqtt
+
+#endif  // __mqtt_test_util_h
@@ -0,0 +1,208 @@
+// test_window_aggregator.cpp
+//
+// Unit tests for the window_aggregator class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mock_async_client.h"
+#include "mqtt/window_aggregator.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+// ----------------------------------------------------------------------
+// A client that records the messages published through it.
+
+class recording_client : public mock_async_client
+{
+public:
+    std::mutex lock;
+    std::vector<const_message_ptr> msgs;
+
+    using mock_async_client::publish;
+
+    delivery_token_ptr publish(const_message_ptr msg) override {
+        std::lock_guard<std::mutex> g(lock);
+        msgs.push_back(msg);
+        return delivery_token::create(*this, msg);
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> g(lock);
+        return msgs.size();
+    }
+};
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("window_aggregator summarizes per topic", "[aggregator]")
+{
+    recording_client cli;
+    window_aggregator agg{cli, hours(1), 1, false};
+
+    REQUIRE(hours(1) == agg.get_window());
+
+    for (int i = 1; i <= 1000; ++i) agg.add("temp", double(i));
+    agg.add("humidity", 42.5);
+    REQUIRE(agg.add(*make_message("humidity", " 41.5\n")));
+    REQUIRE(!agg.add(*make_message("humidity", "high")));
+    REQUIRE(!agg.add(*make_message("humidity", "")));
+
+    REQUIRE(2 == agg.num_topics());
+    REQUIRE(1002 == agg.num_samples());
+    REQUIRE(0 == cli.size());
+
+    agg.flush();
+
+    REQUIRE(2 == cli.size());
+    REQUIRE(2 == agg.num_summaries());
+    REQUIRE(0 == agg.num_topics());
+
+    for (const auto& msg : cli.msgs) {
+        REQUIRE(1 == msg->get_qos());
+        if (msg->get_topic() == "temp") {
+            REQUIRE(
+                "{\"min\":1,\"max\":1000,\"mean\":500.5,\"last\":1000,\"count\":1000}" ==
+                msg->to_string()
+            );
+        }
+        else {
+            REQUIRE("humidity" == msg->get_topic());
+            REQUIRE(
+                "{\"min\":41.5,\"max\":42.5,\"mean\":42,\"last\":41.5,\"count\":2}" ==
+                msg->to_string()
+            );
+        }
+    }
+
+    // An empty window publishes nothing.
+    agg.flush();
+    REQUIRE(2 == cli.size());
+}
+
+TEST_CASE("window_aggregator custom format", "[aggregator]")
+{
+    recording_client cli;
+    window_aggregator agg{
+        cli, hours(1), window_aggregator::json_format(0, true, "/summary")
+    };
+
+    agg.add("a/b", 1.0);
+    agg.stop();
+
+    REQUIRE(1 == cli.size());
+    REQUIRE("a/b/summary" == cli.msgs[0]->get_topic());
+    REQUIRE(cli.msgs[0]->is_retained());
+
+    window_aggregator agg2{cli, hours(1), [](const string& topic, const auto& sum) {
+                               return sum.count > 1 ? make_message(topic, "many") : nullptr;
+                           }};
+    agg2.add("x", 1.0);
+    agg2.add("y", 1.0);
+    agg2.add("y", 2.0);
+    agg2.flush();
+
+    REQUIRE(2 == cli.size());
+    REQUIRE("many" == cli.msgs[1]->to_string());
+    REQUIRE(1 == agg2.num_summaries());
+}
+
+TEST_CASE("window_aggregator flushes on the timer", "[aggregator]")
+{
+    recording_client cli;
+    window_aggregator agg{cli, milliseconds(20)};
+
+    agg.add("t", 1.0);
+
+    auto deadline = steady_clock::now() + seconds(2);
+    while (cli.size() == 0 && steady_clock::now() < deadline)
+        std::this_thread::sleep_for(milliseconds(5));
+
+    REQUIRE(1 == cli.size());
+}
+
+TEST_CASE("window_aggregator aligns windows to the clock", "[aggregator]")
+{
+    recording_client cli;
+    const auto WINDOW = milliseconds(100);
+
+    window_aggregator agg{cli, WINDOW};
+    agg.add("t", 1.0);
+
+    auto deadline = steady_clock::now() + seconds(2);
+    while (cli.size() == 0 && steady_clock::now() < deadline)
+        std::this_thread::sleep_for(milliseconds(1));
+    REQUIRE(1 == cli.size());
+
+    // The summary went out just after a multiple of the window
+    auto t = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
+    REQUIRE((t % WINDOW) < milliseconds(50));
+}
+
+TEST_CASE("window_aggregator intercepts publishes", "[aggregator]")
+{
+    recording_client cli;
+    window_aggregator agg{cli, hours(1)};
+    agg.aggregate("sensors/#");
+
+    auto icpt = agg.interceptor();
+    REQUIRE(icpt(*make_message("sensors/temp", "20.5")));
+    REQUIRE(icpt(*make_message("sensors/temp", "21.5")));
+
+    // Not numeric, or not an aggregated topic
+    REQUIRE(!icpt(*make_message("sensors/temp", "hot")));
+    REQUIRE(!icpt(*make_message("status", "1")));
+    REQUIRE(2 == agg.num_samples());
+
+    // The summaries themselves are never taken, even in a numeric format
+    class intercepting_client : public recording_client
+    {
+    public:
+        window_aggregator* agg{nullptr};
+
+        delivery_token_ptr publish(const_message_ptr msg) override {
+            if (agg && agg->intercept(*msg))
+                return delivery_token::create(*this, msg);
+            return recording_client::publish(msg);
+        }
+    };
+
+    intercepting_client icli;
+    window_aggregator agg3{icli, hours(1), [](const string& topic, const auto& sum) {
+        return make_message(topic, std::to_string(sum.mean()));
+    }};
+    agg3.aggregate("#");
+    icli.agg = &agg3;
+
+    icli.publish(make_message("a", "1"));
+    icli.publish(make_message("a", "3"));
+    REQUIRE(0 == icli.size());
+
+    agg3.flush();
+    REQUIRE(1 == icli.size());
+    REQUIRE(2.0 == std::stod(icli.msgs[0]->to_string()));
+    icli.agg = nullptr;
+}